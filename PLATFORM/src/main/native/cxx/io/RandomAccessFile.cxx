@@ -47,6 +47,9 @@ RandomAccessFile::RandomAccessFile():
 	m_sync_offset(0),
 	m_falloc_to(0),
 	m_safe_read_limit(0),
+	m_rangeSync(false),
+	m_rangeBlock(0),
+	m_forceMaxRangeBlock(false),
 	m_protocol(-1),
 	m_fileIndex(0),
 	m_fileCreationTime(0),
@@ -75,6 +78,9 @@ RandomAccessFile::RandomAccessFile(const char* name, const char* mode, boolean o
 	m_sync_offset(0),
 	m_falloc_to(0),
 	m_safe_read_limit(0),
+	m_rangeSync(false),
+	m_rangeBlock(0),
+	m_forceMaxRangeBlock(false),
 	m_path(name),
 	m_mode(mode),
 	m_protocol(-1),
@@ -109,6 +115,9 @@ RandomAccessFile::RandomAccessFile(const File* file, const char* mode, boolean o
 	m_sync_offset(0),
 	m_falloc_to(0),
 	m_safe_read_limit(0),
+	m_rangeSync(false),
+	m_rangeBlock(0),
+	m_forceMaxRangeBlock(false),
 	m_path(file->getPath()),
 	m_mode(mode),
 	m_protocol(-1),
@@ -0,0 +1,200 @@
+/**
+ *    Copyright (C) 2010 Deep Software Foundation
+ *
+ *    This program is free software: you can redistribute it and/or  modify
+ *    it under the terms of the GNU Affero General Public License, version 3,
+ *    as published by the Free Software Foundation.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU Affero General Public License for more details.
+ *
+ *    You should have received a copy of the GNU Affero General Public License
+ *    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *    As a special exception, the copyright holders give permission to link the
+ *    code of portions of this program with the OpenSSL library under certain
+ *    conditions as described in each individual source file and distribute
+ *    linked combinations including the program with the OpenSSL library. You
+ *    must comply with the GNU Affero General Public License in all respects for
+ *    all of the code used other than as permitted herein. If you modify file(s)
+ *    with this exception, you may extend this exception to your version of the
+ *    file(s), but you are not obligated to do so. If you do not wish to do so,
+ *    delete this exception statement from your version. If you delete this
+ *    exception statement from all source files in the program, then also delete
+ *    it in the license file.
+ */
+#ifndef CXX_UTIL_CARDINALITYSKETCH_H_
+#define CXX_UTIL_CARDINALITYSKETCH_H_
+
+#include <math.h>
+#include <string.h>
+
+#include "cxx/lang/types.h"
+
+#include "cxx/util/Comparator.h"
+#include "cxx/util/Converter.h"
+
+namespace cxx { namespace util {
+
+/**
+ * HyperLogLog distinct count estimator. Each hash sets one of 2^PRECISION registers to the longest run of
+ * leading zero bits seen in the rest of the hash, adds are O(1), sketches over the same hash merge by taking
+ * the register maximum and the standard error is about 1.04 / sqrt(2^PRECISION) (~3% at the default precision).
+ * Removals cannot be taken back, estimates only grow until the sketch is cleared and rebuilt.
+ */
+class CardinalitySketch {
+
+	public:
+		static const inttype PRECISION = 10;
+		static const inttype REGISTERS = 1 << PRECISION;
+
+	private:
+		ubytetype m_registers[REGISTERS];
+
+	public:
+		CardinalitySketch(void) {
+			clear();
+		}
+
+		FORCE_INLINE void clear(void) {
+			memset(m_registers, 0, sizeof(m_registers));
+		}
+
+		FORCE_INLINE void add(ulongtype hash) {
+			inttype index = (inttype) (hash >> (64 - PRECISION));
+
+			// XXX: the guard bit bounds the run when the remaining bits are all zero
+			ubytetype rank = (ubytetype) (__builtin_clzll((hash << PRECISION) | (1ULL << (PRECISION - 1))) + 1);
+			if (rank > m_registers[index]) {
+				m_registers[index] = rank;
+			}
+		}
+
+		FORCE_INLINE void merge(const CardinalitySketch* sketch) {
+			for (inttype i = 0; i < REGISTERS; i++) {
+				if (sketch->m_registers[i] > m_registers[i]) {
+					m_registers[i] = sketch->m_registers[i];
+				}
+			}
+		}
+
+		longtype estimate(void) const {
+			doubletype sum = 0.0;
+			inttype zeros = 0;
+
+			for (inttype i = 0; i < REGISTERS; i++) {
+				sum += ldexp(1.0, -m_registers[i]);
+				if (m_registers[i] == 0) {
+					zeros++;
+				}
+			}
+
+			doubletype alpha = 0.7213 / (1.0 + (1.079 / REGISTERS));
+			doubletype estimate = (alpha * REGISTERS * REGISTERS) / sum;
+
+			// XXX: small ranges are dominated by empty registers, count those instead (linear counting)
+			if ((estimate <= (2.5 * REGISTERS)) && (zeros != 0)) {
+				estimate = REGISTERS * log(((doubletype) REGISTERS) / zeros);
+			}
+
+			return (longtype) (estimate + 0.5);
+		}
+
+		// XXX: 64-bit finalizer (murmur3), spreads weak hash codes over the register index and rank bits
+		FORCE_INLINE static ulongtype mix(ulongtype hash) {
+			hash ^= hash >> 33;
+			hash *= 0xff51afd7ed558ccdULL;
+			hash ^= hash >> 33;
+			hash *= 0xc4ceb9fe1a85ec53ULL;
+			hash ^= hash >> 33;
+
+			return hash;
+		}
+
+		// XXX: FNV-1a over a byte range, seed chains consecutive key parts into one prefix hash
+		FORCE_INLINE static ulongtype hash(const bytearray data, inttype length, ulongtype seed = 0xcbf29ce484222325ULL) {
+			for (inttype i = 0; i < length; i++) {
+				seed ^= (ubytetype) data[i];
+				seed *= 0x100000001b3ULL;
+			}
+
+			return seed;
+		}
+};
+
+/**
+ * Fills hashes[i] with the hash of the key's first i + 1 parts. Keys without parts hash whole, so every prefix
+ * of them is the key itself (which matches how their comparators report the differing position).
+ */
+template<typename K>
+struct KeyPrefixHash {
+	FORCE_INLINE static void hash(const Comparator<K>* comparator, const K key, ulongtype* hashes, inttype parts) {
+		ulongtype hash = CardinalitySketch::mix((ulongtype) Converter<K>::hashCode(key));
+		for (inttype i = 0; i < parts; i++) {
+			hashes[i] = hash;
+		}
+	}
+};
+
+/*
+ * XXX: keys that compare equal must hash equal, so key parts are hashed in their comparison form (i.e. the normalized
+ *      encoding): strings stop at their terminator, -0.0 folds into 0.0 and parts compare ignores add nothing
+ */
+inline ulongtype hashKeyPart(bytetype type, const bytearray data, inttype size, ulongtype hash) {
+	switch(type) {
+		case KeyPart::INTEGER:
+		case KeyPart::LONG:
+		case KeyPart::SHORT:
+		case KeyPart::BYTEARRAY:
+			return CardinalitySketch::hash(data, size, hash);
+		case KeyPart::FLOAT: {
+			bytetype normalized[sizeof(floattype)];
+			normalizeFloat<floattype,uinttype>(data, normalized);
+			return CardinalitySketch::hash(normalized, sizeof(normalized), hash);
+		}
+		case KeyPart::DOUBLE: {
+			bytetype normalized[sizeof(doubletype)];
+			normalizeFloat<doubletype,ulongtype>(data, normalized);
+			return CardinalitySketch::hash(normalized, sizeof(normalized), hash);
+		}
+		case KeyPart::STRING: {
+			inttype length = strnlen((const char*) data, size);
+			hash = CardinalitySketch::hash(data, length, hash);
+			return CardinalitySketch::hash((bytearray) &length, sizeof(length), hash);
+		}
+		default:
+			return hash;
+	}
+}
+
+template<>
+struct KeyPrefixHash<CompositeKey*> {
+	FORCE_INLINE static void hash(const Comparator<CompositeKey*>* comparator, const CompositeKey* key, ulongtype* hashes, inttype parts) {
+		const bytearray data = *key;
+		ulongtype hash = CardinalitySketch::hash(data, 0);
+
+		// XXX: normalized keys are already in comparison form, their raw bytes hash as is
+		const boolean normalized = comparator->getNormalized();
+
+		inttype count = comparator->getKeyPartCount();
+		for (inttype i = 0; i < parts; i++) {
+			if (i < count) {
+				const KeyPart* keyPart = comparator->getKeyPart(i);
+				if (normalized == true) {
+					hash = CardinalitySketch::hash(data + keyPart->getOffset(), keyPart->getSize(), hash);
+
+				} else {
+					hash = hashKeyPart(keyPart->getType(), data + keyPart->getOffset(), keyPart->getSize(), hash);
+				}
+			}
+
+			hashes[i] = CardinalitySketch::mix(hash);
+		}
+	}
+};
+
+} } // namespace
+
+#endif /*CXX_UTIL_CARDINALITYSKETCH_H_*/
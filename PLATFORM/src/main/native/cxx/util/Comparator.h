@@ -279,27 +279,209 @@ class Comparator<nbyte*>  {
 		#endif
 			return o1->compareTo(o2);
 		}
+
+		// XXX: order-preserving prefix, the length then the first four bytes big-endian (see compareTo),
+		//      o1 < o2 implies prefix(o1) <= prefix(o2) and equal prefixes leave the order to compare
+		FORCE_INLINE static ulongtype prefix(const nbyte* o) {
+			const bytearray data = *o;
+
+			ulongtype prefix = ((ulongtype) (uinttype) o->length) << 32;
+			for (inttype i = 0; (i < 4) && (i < o->length); i++) {
+				prefix |= ((ulongtype) (ubytetype) data[i]) << (24 - (i * 8));
+			}
+
+			return prefix;
+		}
 };
 
 template<>
 class Comparator<CompositeKey*>  {
 	private:
 		ArrayList<KeyPart*> m_keyParts;
+		inttype m_keySize;
+		boolean m_normalized;
+
+		#ifdef COM_DEEPIS_DB_CARDINALITY
+		FORCE_INLINE int compareNormalized(const CompositeKey* o1, const CompositeKey* o2, inttype* pos) const {
+			if (pos == null) {
+				return memcmp(*o1, *o2, m_keySize);
+			}
+
+			register int size = m_keyParts.size();
+			register int i = size;
+			register int cmp = 0;
+
+			// XXX: the part-offset table maps the first differing byte back to its key part
+			register int offset = mismatchByteArray(*o1, *o2, m_keySize);
+			if (offset < m_keySize) {
+				cmp = ((ubytetype) (*o1)[offset]) - ((ubytetype) (*o2)[offset]);
+
+				i = 0;
+				while (((i + 1) < size) && (m_keyParts.get(i + 1)->getOffset() <= offset)) {
+					i++;
+				}
+			}
+
+			if (i > *pos) {
+				*pos = i;
+			}
+
+			return cmp;
+		}
+		#endif
 
 	public:
 		Comparator() :
-			m_keyParts(3, true) {
+			m_keyParts(3, true),
+			m_keySize(0),
+			m_normalized(false) {
 		}
 
 		FORCE_INLINE void addKeyPart(bytetype type, int size = -1) {
-			m_keyParts.add(new KeyPart(type, size));
+			KeyPart* keyPart = new KeyPart(type, size, m_keySize);
+			m_keyParts.add(keyPart);
+
+			m_keySize += keyPart->getSize();
+		}
+
+		FORCE_INLINE inttype getKeySize() const {
+			return m_keySize;
+		}
+
+		FORCE_INLINE inttype getKeyPartCount() const {
+			return m_keyParts.size();
+		}
+
+		FORCE_INLINE const KeyPart* getKeyPart(inttype index) const {
+			return m_keyParts.get(index);
+		}
+
+		// XXX: once set, compare expects keys produced by normalize (i.e. at insert and probe time)
+		FORCE_INLINE void setNormalized(boolean flag) {
+			m_normalized = flag;
+		}
+
+		FORCE_INLINE boolean getNormalized() const {
+			return m_normalized;
+		}
+
+		void normalize(const CompositeKey* key, CompositeKey* normalized) const {
+			const bytearray src = *key;
+			bytearray dst = *normalized;
+
+			for (int i = 0; i < m_keyParts.size(); i++) {
+				const KeyPart* keyPart = m_keyParts.get(i);
+				const int offset = keyPart->getOffset();
+
+				switch(keyPart->getType()) {
+					case KeyPart::INTEGER:
+						normalizeInteger<uinttype>(src + offset, dst + offset);
+						break;
+					case KeyPart::LONG:
+						normalizeInteger<ulongtype>(src + offset, dst + offset);
+						break;
+					case KeyPart::SHORT:
+						normalizeInteger<ushorttype>(src + offset, dst + offset);
+						break;
+					case KeyPart::FLOAT:
+						normalizeFloat<floattype,uinttype>(src + offset, dst + offset);
+						break;
+					case KeyPart::DOUBLE:
+						normalizeFloat<doubletype,ulongtype>(src + offset, dst + offset);
+						break;
+					case KeyPart::STRING:
+						normalizeString(src + offset, dst + offset, keyPart->getSize());
+						break;
+					case KeyPart::BYTEARRAY:
+						memcpy(dst + offset, src + offset, keyPart->getSize());
+						break;
+					default:
+						// XXX: parts compare does not order on are encoded as equal
+						memset(dst + offset, 0, keyPart->getSize());
+						break;
+				}
+			}
+		}
+
+		// XXX: order-preserving prefix from a key's leading eight bytes: the normalized encoding of the parts that fit (a string
+		//      may be cut short), zero from the first number that does not. a < b implies prefix(a) <= prefix(b), equal prefixes
+		//      leave the order to compare
+		ulongtype prefix(const bytearray leading) const {
+			bytetype dst[sizeof(ulongtype)];
+
+			if (m_normalized == true) {
+				memcpy(dst, leading, sizeof(dst));
+
+			} else {
+				memset(dst, 0, sizeof(dst));
+
+				for (int i = 0; i < m_keyParts.size(); i++) {
+					const KeyPart* keyPart = m_keyParts.get(i);
+					const int offset = keyPart->getOffset();
+					const int room = (int) sizeof(dst) - offset;
+					if (room <= 0) {
+						break;
+					}
+
+					// XXX: a number cut short has no order-preserving prefix, it and everything after it stay zero
+					const int size = (keyPart->getSize() < room) ? keyPart->getSize() : room;
+					if ((size < keyPart->getSize()) && (keyPart->getType() != KeyPart::STRING) && (keyPart->getType() != KeyPart::BYTEARRAY)) {
+						break;
+					}
+
+					switch(keyPart->getType()) {
+						case KeyPart::STRING:
+							normalizeString(leading + offset, dst + offset, size);
+							break;
+						case KeyPart::BYTEARRAY:
+							memcpy(dst + offset, leading + offset, size);
+							break;
+						case KeyPart::INTEGER:
+							normalizeInteger<uinttype>(leading + offset, dst + offset);
+							break;
+						case KeyPart::LONG:
+							normalizeInteger<ulongtype>(leading + offset, dst + offset);
+							break;
+						case KeyPart::SHORT:
+							normalizeInteger<ushorttype>(leading + offset, dst + offset);
+							break;
+						case KeyPart::FLOAT:
+							normalizeFloat<floattype,uinttype>(leading + offset, dst + offset);
+							break;
+						case KeyPart::DOUBLE:
+							normalizeFloat<doubletype,ulongtype>(leading + offset, dst + offset);
+							break;
+					}
+				}
+			}
+
+			ulongtype prefix = 0;
+			for (int i = 0; i < (int) sizeof(dst); i++) {
+				prefix = (prefix << 8) | (ubytetype) dst[i];
+			}
+
+			return prefix;
+		}
+
+		CompositeKey* normalize(const CompositeKey* key) const {
+			CompositeKey* normalized = new CompositeKey(m_keySize);
+			normalize(key, normalized);
+
+			return normalized;
 		}
 
 		#ifdef COM_DEEPIS_DB_CARDINALITY
 		FORCE_INLINE int compare(const CompositeKey* o1, const CompositeKey* o2, inttype* pos = null) const {
+			if (m_normalized == true) {
+				return compareNormalized(o1, o2, pos);
+			}
 		#else
 		FORCE_INLINE int compare(const CompositeKey* o1, const CompositeKey* o2) const {
+			if (m_normalized == true) {
+				return memcmp(*o1, *o2, m_keySize);
+			}
 		#endif
+
 			register int cursor = 0;
 			register int cmp = 0;
 			register int i = 0;
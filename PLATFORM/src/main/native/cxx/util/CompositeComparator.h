@@ -0,0 +1,242 @@
+/**
+ *    Copyright (C) 2010 Deep Software Foundation
+ *
+ *    This program is free software: you can redistribute it and/or  modify
+ *    it under the terms of the GNU Affero General Public License, version 3,
+ *    as published by the Free Software Foundation.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU Affero General Public License for more details.
+ *
+ *    You should have received a copy of the GNU Affero General Public License
+ *    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *    As a special exception, the copyright holders give permission to link the
+ *    code of portions of this program with the OpenSSL library under certain
+ *    conditions as described in each individual source file and distribute
+ *    linked combinations including the program with the OpenSSL library. You
+ *    must comply with the GNU Affero General Public License in all respects for
+ *    all of the code used other than as permitted herein. If you modify file(s)
+ *    with this exception, you may extend this exception to your version of the
+ *    file(s), but you are not obligated to do so. If you do not wish to do so,
+ *    delete this exception statement from your version. If you delete this
+ *    exception statement from all source files in the program, then also delete
+ *    it in the license file.
+ */
+#ifndef CXX_UTIL_COMPOSITECOMPARATOR_H_
+#define CXX_UTIL_COMPOSITECOMPARATOR_H_
+
+#include "cxx/util/CardinalitySketch.h"
+#include "cxx/util/Comparator.h"
+#include "cxx/util/CompositeKey.h"
+
+namespace cxx { namespace util {
+
+/*
+ * XXX: compile-time alternative to Comparator<CompositeKey*> + KeyPart, each part's type, size and offset is a template
+ *      argument so the comparison below is fully inlined and unrolled (e.g. CompositeComparator<StaticKeyPart<KeyPart::LONG>,
+ *      StaticKeyPart<KeyPart::STRING,32>, StaticKeyPart<KeyPart::INTEGER> >)
+ */
+template<bytetype TYPE, inttype LENGTH = -1>
+struct StaticKeyPart {
+};
+
+template<>
+struct StaticKeyPart<KeyPart::INTEGER> {
+	static const bytetype TYPE = KeyPart::INTEGER;
+	static const inttype SIZE = sizeof(inttype);
+
+	FORCE_INLINE static int compare(const bytearray o1, const bytearray o2) {
+		return compareNumber<inttype>(o1, o2);
+	}
+};
+
+template<>
+struct StaticKeyPart<KeyPart::LONG> {
+	static const bytetype TYPE = KeyPart::LONG;
+	static const inttype SIZE = sizeof(longtype);
+
+	FORCE_INLINE static int compare(const bytearray o1, const bytearray o2) {
+		return compareNumber<longtype>(o1, o2);
+	}
+};
+
+template<>
+struct StaticKeyPart<KeyPart::SHORT> {
+	static const bytetype TYPE = KeyPart::SHORT;
+	static const inttype SIZE = sizeof(shorttype);
+
+	FORCE_INLINE static int compare(const bytearray o1, const bytearray o2) {
+		return compareNumber<shorttype>(o1, o2);
+	}
+};
+
+template<>
+struct StaticKeyPart<KeyPart::FLOAT> {
+	static const bytetype TYPE = KeyPart::FLOAT;
+	static const inttype SIZE = sizeof(floattype);
+
+	FORCE_INLINE static int compare(const bytearray o1, const bytearray o2) {
+		return compareNumber<floattype>(o1, o2);
+	}
+};
+
+template<>
+struct StaticKeyPart<KeyPart::DOUBLE> {
+	static const bytetype TYPE = KeyPart::DOUBLE;
+	static const inttype SIZE = sizeof(doubletype);
+
+	FORCE_INLINE static int compare(const bytearray o1, const bytearray o2) {
+		return compareNumber<doubletype>(o1, o2);
+	}
+};
+
+template<inttype LENGTH>
+struct StaticKeyPart<KeyPart::STRING, LENGTH> {
+	static const bytetype TYPE = KeyPart::STRING;
+	static const inttype SIZE = LENGTH;
+
+	FORCE_INLINE static int compare(const bytearray o1, const bytearray o2) {
+		return compareString(o1, o2, LENGTH);
+	}
+};
+
+template<inttype LENGTH>
+struct StaticKeyPart<KeyPart::BYTEARRAY, LENGTH> {
+	static const bytetype TYPE = KeyPart::BYTEARRAY;
+	static const inttype SIZE = LENGTH;
+
+	FORCE_INLINE static int compare(const bytearray o1, const bytearray o2) {
+		return compareByteArray(o1, o2, LENGTH);
+	}
+};
+
+// XXX: compares the first part at OFFSET, then recurses on the remaining parts (any number of them)
+template<inttype OFFSET, inttype INDEX, typename... Parts>
+struct CompositeCompare;
+
+template<inttype OFFSET, inttype INDEX, typename P0, typename... Parts>
+struct CompositeCompare<OFFSET, INDEX, P0, Parts...> {
+	typedef CompositeCompare<OFFSET + P0::SIZE, INDEX + 1, Parts...> Next;
+
+	static const inttype PARTS = Next::PARTS;
+	static const inttype SIZE = Next::SIZE;
+
+	FORCE_INLINE static int compare(const bytearray o1, const bytearray o2, inttype* pos) {
+		int cmp = P0::compare(o1 + OFFSET, o2 + OFFSET);
+		if (cmp != 0) {
+			#ifdef COM_DEEPIS_DB_CARDINALITY
+			if ((pos != null) && (INDEX > *pos)) {
+				*pos = INDEX;
+			}
+			#endif
+
+			return cmp;
+		}
+
+		return Next::compare(o1, o2, pos);
+	}
+
+	// XXX: chains the hash of part P0 into hash and stores it as the prefix hash ending at this part
+	FORCE_INLINE static void hash(const bytearray data, ulongtype hash, ulongtype* hashes, inttype parts) {
+		if (INDEX < parts) {
+			hash = hashKeyPart(P0::TYPE, data + OFFSET, P0::SIZE, hash);
+			hashes[INDEX] = CardinalitySketch::mix(hash);
+
+			Next::hash(data, hash, hashes, parts);
+		}
+	}
+};
+
+template<inttype OFFSET, inttype INDEX>
+struct CompositeCompare<OFFSET, INDEX> {
+	static const inttype PARTS = INDEX;
+	static const inttype SIZE = OFFSET;
+
+	FORCE_INLINE static int compare(const bytearray o1, const bytearray o2, inttype* pos) {
+		#ifdef COM_DEEPIS_DB_CARDINALITY
+		// XXX: equal keys report the part count, as Comparator<CompositeKey*> does
+		if ((pos != null) && (INDEX > *pos)) {
+			*pos = INDEX;
+		}
+		#endif
+
+		return 0;
+	}
+
+	// XXX: prefixes longer than the schema repeat the whole key
+	FORCE_INLINE static void hash(const bytearray data, ulongtype hash, ulongtype* hashes, inttype parts) {
+		for (inttype i = INDEX; i < parts; i++) {
+			hashes[i] = CardinalitySketch::mix(hash);
+		}
+	}
+};
+
+template<typename P0, typename... Parts>
+class CompositeComparator {
+	private:
+		typedef CompositeCompare<0, 0, P0, Parts...> Schema;
+
+	public:
+		static const inttype PARTS = Schema::PARTS;
+		static const inttype SIZE = Schema::SIZE;
+
+	public:
+		FORCE_INLINE CompositeComparator(void) {
+			// nothing to do
+		}
+
+		#ifdef COM_DEEPIS_DB_CARDINALITY
+		FORCE_INLINE int compare(const CompositeKey* o1, const CompositeKey* o2, inttype* pos = null) const {
+		#else
+		FORCE_INLINE int compare(const CompositeKey* o1, const CompositeKey* o2) const {
+			inttype* pos = null;
+		#endif
+			return Schema::compare(*o1, *o2, pos);
+		}
+
+		FORCE_INLINE static void hash(const CompositeKey* key, ulongtype* hashes, inttype parts) {
+			Schema::hash(*key, CardinalitySketch::hash(*key, 0), hashes, parts);
+		}
+};
+
+/*
+ * XXX: TreeMap orders keys with Comparator<K>, tagging the key with its schema selects the static comparison there
+ *      (i.e. TreeMap<StaticCompositeKey<Schema>*,V>), TreeSet takes a CompositeComparator directly as its comparator
+ */
+template<typename Cmp>
+class StaticCompositeKey : public CompositeKey {
+	public:
+		StaticCompositeKey(void):
+			CompositeKey(Cmp::SIZE) {
+		}
+
+		StaticCompositeKey(const bytearray data):
+			CompositeKey(data, Cmp::SIZE) {
+		}
+
+		StaticCompositeKey(const voidarray data):
+			CompositeKey(data, Cmp::SIZE) {
+		}
+};
+
+template<typename Cmp>
+class Comparator<StaticCompositeKey<Cmp>*> : public Cmp {
+	public:
+		FORCE_INLINE Comparator(void) {
+			// nothing to do
+		}
+};
+
+template<typename Cmp>
+struct KeyPrefixHash<StaticCompositeKey<Cmp>*> {
+	FORCE_INLINE static void hash(const Comparator<StaticCompositeKey<Cmp>*>* comparator, const StaticCompositeKey<Cmp>* key, ulongtype* hashes, inttype parts) {
+		Cmp::hash(key, hashes, parts);
+	}
+};
+
+} } // namespace
+
+#endif /*CXX_UTIL_COMPOSITECOMPARATOR_H_*/
@@ -60,16 +60,81 @@ inline int compareNumber(const bytearray o1, const bytearray o2) {
 	return *((T*) o1) < *((T*) o2) ? -1 : ((*((T*) o1) == *((T*) o2)) ? 0 : 1);
 }
 
+// XXX: same result as nbyte::compareTo for equally sized parts, without the temporaries
 inline int compareByteArray(const bytearray o1, const bytearray o2, int size) {
-	nbyte key1(o1, size);
-	nbyte key2(o2, size);
-	return key1.compareTo(&key2);
+	return memcmp(o1, o2, size);
 }
 
 inline int compareString(const bytearray o1, const bytearray o2, int size) {
 	return strncmp(o1, o2, size);
 }
 
+// XXX: index of the first differing byte (size when equal), words are compared little-endian
+inline int mismatchByteArray(const bytearray o1, const bytearray o2, int size) {
+	int i = 0;
+	for (; (i + (int) sizeof(ulongtype)) <= size; i += sizeof(ulongtype)) {
+		ulongtype diff = *((ulongtype*) (o1 + i)) ^ *((ulongtype*) (o2 + i));
+		if (diff != 0) {
+			return i + (__builtin_ctzll(diff) >> 3);
+		}
+	}
+
+	for (; i < size; i++) {
+		if (o1[i] != o2[i]) {
+			return i;
+		}
+	}
+
+	return size;
+}
+
+/*
+ * XXX: normalized (binary-comparable) encodings of key parts, memcmp of two encodings orders like the part comparators:
+ *      integers are big-endian with the sign bit flipped, floats additionally invert all bits when negative and strings
+ *      are zero padded after their terminator
+ */
+template<typename U>
+inline void encodeBigEndian(U value, bytearray dst) {
+	for (int i = sizeof(U) - 1; i >= 0; i--) {
+		dst[i] = (bytetype) (value & 0xff);
+		value >>= 8;
+	}
+}
+
+template<typename U>
+inline void normalizeInteger(const bytearray src, bytearray dst) {
+	U value;
+	memcpy(&value, src, sizeof(U));
+
+	encodeBigEndian<U>(value ^ (((U) 1) << ((sizeof(U) * 8) - 1)), dst);
+}
+
+template<typename T, typename U>
+inline void normalizeFloat(const bytearray src, bytearray dst) {
+	T number;
+	memcpy(&number, src, sizeof(T));
+
+	// XXX: -0.0 and 0.0 compare equal
+	if (number == 0) {
+		number = 0;
+	}
+
+	U value;
+	memcpy(&value, &number, sizeof(U));
+
+	const U sign = ((U) 1) << ((sizeof(U) * 8) - 1);
+	encodeBigEndian<U>(((value & sign) != 0) ? ~value : (value | sign), dst);
+}
+
+inline void normalizeString(const bytearray src, bytearray dst, int size) {
+	int i = 0;
+	for (; (i < size) && (src[i] != 0); i++) {
+		dst[i] = src[i];
+	}
+
+	memset(dst + i, 0, size - i);
+}
+
 class KeyPart : public Object {
 
 	public:
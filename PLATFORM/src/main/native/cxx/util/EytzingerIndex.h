@@ -0,0 +1,119 @@
+/**
+ *    Copyright (C) 2010 Deep Software Foundation
+ *
+ *    This program is free software: you can redistribute it and/or  modify
+ *    it under the terms of the GNU Affero General Public License, version 3,
+ *    as published by the Free Software Foundation.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU Affero General Public License for more details.
+ *
+ *    You should have received a copy of the GNU Affero General Public License
+ *    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *    As a special exception, the copyright holders give permission to link the
+ *    code of portions of this program with the OpenSSL library under certain
+ *    conditions as described in each individual source file and distribute
+ *    linked combinations including the program with the OpenSSL library. You
+ *    must comply with the GNU Affero General Public License in all respects for
+ *    all of the code used other than as permitted herein. If you modify file(s)
+ *    with this exception, you may extend this exception to your version of the
+ *    file(s), but you are not obligated to do so. If you do not wish to do so,
+ *    delete this exception statement from your version. If you delete this
+ *    exception statement from all source files in the program, then also delete
+ *    it in the license file.
+ */
+#ifndef CXX_UTIL_EYTZINGERINDEX_H_
+#define CXX_UTIL_EYTZINGERINDEX_H_
+
+#include <stdlib.h>
+
+#include "cxx/lang/types.h"
+
+namespace cxx { namespace util {
+
+/**
+ * Static search tree over the maximum key of each fixed-size block of a sorted array. Keys are stored in
+ * Eytzinger (breadth-first) order: the children of slot k sit at 2k and 2k + 1, so a descent walks one
+ * contiguous array without pointers and the four levels below the current slot share a few cache lines,
+ * which are prefetched ahead of the comparisons. Built once, never modified.
+ */
+template<typename K, typename Cmp>
+class EytzingerIndex {
+
+	public:
+		// XXX: entries per block, the owner binary searches inside the block the index selects
+		static const inttype BLOCK = 16;
+
+	private:
+		K* m_keys;
+		inttype* m_blocks;
+		inttype m_count;
+		const Cmp* m_comparator;
+
+		// XXX: in-order walk of the implicit tree hands out the sorted maxima
+		inttype fill(const K* maxima, inttype i, inttype k) {
+			if (k <= m_count) {
+				i = fill(maxima, i, 2 * k);
+
+				m_keys[k] = maxima[i];
+				m_blocks[k] = i;
+				i++;
+
+				i = fill(maxima, i, (2 * k) + 1);
+			}
+
+			return i;
+		}
+
+	public:
+		EytzingerIndex(void):
+			m_keys(null),
+			m_blocks(null),
+			m_count(0),
+			m_comparator(null) {
+		}
+
+		~EytzingerIndex(void) {
+			if (m_keys != null) {
+				free(m_keys);
+				free(m_blocks);
+			}
+		}
+
+		void build(const Cmp* comparator, const K* maxima, inttype count) {
+			m_comparator = comparator;
+			m_count = count;
+
+			// XXX: slot 0 is unused, the root lives at 1
+			m_keys = (K*) malloc((count + 1) * sizeof(K));
+			m_blocks = (inttype*) malloc((count + 1) * sizeof(inttype));
+			m_blocks[0] = count;
+
+			fill(maxima, 0, 1);
+		}
+
+		FORCE_INLINE inttype getBlockCount(void) const {
+			return m_count;
+		}
+
+		// XXX: first block whose maximum is not below key, the block count when every key is below it
+		FORCE_INLINE inttype search(const K key) const {
+			inttype k = 1;
+			while (k <= m_count) {
+				__builtin_prefetch(m_keys + (16 * k));
+				k = (2 * k) + (m_comparator->compare(m_keys[k], key) < 0);
+			}
+
+			// XXX: drop the trailing right turns (and the last left one), leaving the slot the descent last went left at
+			k >>= __builtin_ffs(~k);
+
+			return m_blocks[k];
+		}
+};
+
+} } // namespace
+
+#endif /*CXX_UTIL_EYTZINGERINDEX_H_*/
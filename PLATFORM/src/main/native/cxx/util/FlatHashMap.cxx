@@ -0,0 +1,493 @@
+/**
+ *    Copyright (C) 2010 Deep Software Foundation
+ *
+ *    This program is free software: you can redistribute it and/or  modify
+ *    it under the terms of the GNU Affero General Public License, version 3,
+ *    as published by the Free Software Foundation.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU Affero General Public License for more details.
+ *
+ *    You should have received a copy of the GNU Affero General Public License
+ *    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *    As a special exception, the copyright holders give permission to link the
+ *    code of portions of this program with the OpenSSL library under certain
+ *    conditions as described in each individual source file and distribute
+ *    linked combinations including the program with the OpenSSL library. You
+ *    must comply with the GNU Affero General Public License in all respects for
+ *    all of the code used other than as permitted herein. If you modify file(s)
+ *    with this exception, you may extend this exception to your version of the
+ *    file(s), but you are not obligated to do so. If you do not wish to do so,
+ *    delete this exception statement from your version. If you delete this
+ *    exception statement from all source files in the program, then also delete
+ *    it in the license file.
+ */
+#ifndef CXX_UTIL_FLATHASHMAP_CXX_
+#define CXX_UTIL_FLATHASHMAP_CXX_
+
+#include <new>
+#include <string.h>
+
+#include "cxx/util/FlatHashMap.h"
+
+#if defined(__SSE2__)
+#define CXX_UTIL_FLATHASHMAP_SSE2
+#include <emmintrin.h>
+#endif
+
+#define FLATHASHMAP_GROUP_WIDTH 16
+
+using namespace cxx::util;
+
+// XXX: bit i of the returned mask is set when control byte i of the group equals the given byte
+FORCE_INLINE static uinttype flatGroupMatch(const ubytetype* group, ubytetype what) {
+	#ifdef CXX_UTIL_FLATHASHMAP_SSE2
+	return _mm_movemask_epi8(_mm_cmpeq_epi8(_mm_loadu_si128((const __m128i*) group), _mm_set1_epi8((char) what)));
+	#else
+	uinttype mask = 0;
+	for (inttype i = 0; i < FLATHASHMAP_GROUP_WIDTH; i++) {
+		mask |= ((uinttype) (group[i] == what)) << i;
+	}
+
+	return mask;
+	#endif
+}
+
+// XXX: EMPTY and DELETED are the only control bytes with the high bit set
+FORCE_INLINE static uinttype flatGroupMatchFree(const ubytetype* group) {
+	#ifdef CXX_UTIL_FLATHASHMAP_SSE2
+	return _mm_movemask_epi8(_mm_loadu_si128((const __m128i*) group));
+	#else
+	uinttype mask = 0;
+	for (inttype i = 0; i < FLATHASHMAP_GROUP_WIDTH; i++) {
+		mask |= ((uinttype) (group[i] >> 7)) << i;
+	}
+
+	return mask;
+	#endif
+}
+
+namespace cxx { namespace util {
+
+template<typename K, typename V, typename Ctx>
+const Converter<K> FlatHashMap<K,V,Ctx>::CONVERTER;
+
+template<typename K, typename V, typename Ctx>
+const int FlatHashMap<K,V,Ctx>::GROUP_WIDTH = FLATHASHMAP_GROUP_WIDTH;
+
+template<typename K, typename V, typename Ctx>
+const ubytetype FlatHashMap<K,V,Ctx>::CONTROL_EMPTY = 0x80;
+
+template<typename K, typename V, typename Ctx>
+const ubytetype FlatHashMap<K,V,Ctx>::CONTROL_DELETED = 0xfe;
+
+template<typename K, typename V, typename Ctx>
+const int FlatHashMap<K,V,Ctx>::RESIZE_FACTOR = 2;
+
+template<typename K, typename V, typename Ctx>
+const int FlatHashMap<K,V,Ctx>::RESIZE_HIGH_WATER = 8;
+
+template<typename K, typename V, typename Ctx>
+const int FlatHashMap<K,V,Ctx>::INITIAL_CAPACITY = 16;
+
+template<typename K, typename V, typename Ctx>
+FlatHashMap<K,V,Ctx>::FlatHashMap(int cap, boolean delkey, boolean delval, boolean fixed):
+	m_fill(0),
+	m_size(0),
+	m_entries(0),
+	m_stateFlags(0),
+	m_control(null),
+	m_slots(null),
+	m_converter(&FlatHashMap<K,V,Ctx>::CONVERTER) {
+
+	m_ctx = Converter<Ctx>::NULL_VALUE;
+
+	if (cap != 0) {
+		resize(cap);
+	}
+
+	setDeleteKey(delkey);
+	setDeleteValue(delval);
+
+	setFixed(fixed);
+}
+
+template<typename K, typename V, typename Ctx>
+FlatHashMap<K,V,Ctx>::FlatHashMap(const Converter<K>* converter, int cap, boolean delkey, boolean delval, boolean fixed):
+	m_fill(0),
+	m_size(0),
+	m_entries(0),
+	m_stateFlags(0),
+	m_control(null),
+	m_slots(null),
+	m_converter(converter) {
+
+	m_ctx = Converter<Ctx>::NULL_VALUE;
+
+	if (cap != 0) {
+		resize(cap);
+	}
+
+	setDeleteKey(delkey);
+	setDeleteValue(delval);
+
+	setFixed(fixed);
+}
+
+template<typename K, typename V, typename Ctx>
+FlatHashMap<K,V,Ctx>::~FlatHashMap() {
+	clear();
+}
+
+template<typename K, typename V, typename Ctx>
+ulongtype FlatHashMap<K,V,Ctx>::hashOf(const K key) const {
+	// XXX: converter hash codes are often identity (e.g. primitives), spread them over all 64 bits
+	return ((ulongtype) (uinttype) m_converter->hashCode(key)) * 0x9e3779b97f4a7c15ULL;
+}
+
+template<typename K, typename V, typename Ctx>
+int FlatHashMap<K,V,Ctx>::findIndex(const K key, ulongtype hash) const {
+	uinttype mask = (m_size / FLATHASHMAP_GROUP_WIDTH) - 1;
+	uinttype group = ((uinttype) (hash >> 25)) & mask;
+	ubytetype fingerprint = (ubytetype) (hash >> 57);
+
+	for (uinttype step = 1;; step++) {
+		const ubytetype* control = m_control + (group * FLATHASHMAP_GROUP_WIDTH);
+
+		for (uinttype bits = flatGroupMatch(control, fingerprint); bits != 0; bits &= bits - 1) {
+			int index = (group * FLATHASHMAP_GROUP_WIDTH) + __builtin_ctz(bits);
+			if (m_converter->equals(m_slots[index].getKey(), key)) {
+				return index;
+			}
+		}
+
+		// XXX: a group with an empty slot was never full, so no probe sequence continues past it
+		if (flatGroupMatch(control, CONTROL_EMPTY) != 0) {
+			return -1;
+		}
+
+		// XXX: triangular steps visit every group of a power of two table
+		group = (group + step) & mask;
+	}
+
+	return -1;
+}
+
+template<typename K, typename V, typename Ctx>
+int FlatHashMap<K,V,Ctx>::freeIndex(ulongtype hash) const {
+	uinttype mask = (m_size / FLATHASHMAP_GROUP_WIDTH) - 1;
+	uinttype group = ((uinttype) (hash >> 25)) & mask;
+
+	for (uinttype step = 1;; step++) {
+		uinttype bits = flatGroupMatchFree(m_control + (group * FLATHASHMAP_GROUP_WIDTH));
+		if (bits != 0) {
+			return (group * FLATHASHMAP_GROUP_WIDTH) + __builtin_ctz(bits);
+		}
+
+		group = (group + step) & mask;
+	}
+
+	return -1;
+}
+
+template<typename K, typename V, typename Ctx>
+void FlatHashMap<K,V,Ctx>::removeIndex(int index) {
+	m_slots[index].~MapEntry<K,V,Ctx>();
+
+	// XXX: if the group still has an empty slot, no probe sequence depends on this one
+	if (flatGroupMatch(m_control + (index & ~(FLATHASHMAP_GROUP_WIDTH - 1)), CONTROL_EMPTY) != 0) {
+		m_control[index] = CONTROL_EMPTY;
+		m_fill--;
+
+	} else {
+		m_control[index] = CONTROL_DELETED;
+	}
+
+	m_entries--;
+}
+
+template<typename K, typename V, typename Ctx>
+int FlatHashMap<K,V,Ctx>::resize(int minused) {
+	int i = 0;
+	int size = 0;
+
+	for (size = FLATHASHMAP_GROUP_WIDTH; minused >= fillLimit(size); size <<= 1) {
+		if (size >= (1 << 30)) {
+			return -1;
+		}
+	}
+
+	int oldsize = m_size;
+	ubytetype* oldcontrol = m_control;
+	MapEntry<K,V,Ctx>* oldslots = m_slots;
+
+	m_control = (ubytetype*) malloc(size);
+	memset(m_control, CONTROL_EMPTY, size);
+
+	m_slots = (MapEntry<K,V,Ctx>*) malloc(size * sizeof(MapEntry<K,V,Ctx>));
+
+	m_fill = 0;
+	m_entries = 0;
+	m_size = size;
+
+	for (i = 0; i < oldsize; i++) {
+		if ((oldcontrol[i] & CONTROL_EMPTY) == 0) {
+			MapEntry<K,V,Ctx>* p = &oldslots[i];
+			ulongtype hash = hashOf(p->getKey());
+			int index = freeIndex(hash);
+
+			new (&m_slots[index]) MapEntry<K,V,Ctx>(p->getKey(), p->getValue(), getMapContext());
+			m_control[index] = (ubytetype) (hash >> 57);
+
+			p->~MapEntry<K,V,Ctx>();
+
+			m_fill++;
+			m_entries++;
+		}
+	}
+
+	free(oldcontrol);
+	free(oldslots);
+
+	return m_size;
+}
+
+template<typename K, typename V, typename Ctx>
+V FlatHashMap<K,V,Ctx>::put(K key, V val, K* retkey, boolean* status) {
+	if (m_control == null) {
+		resize(INITIAL_CAPACITY);
+	}
+
+	ulongtype hash = hashOf(key);
+
+	int index = findIndex(key, hash);
+	if (index != -1) {
+		MapEntry<K,V,Ctx>* x = &m_slots[index];
+
+		V old = x->getValue();
+
+		if (status != null) {
+			*status = true;
+		}
+
+		if (retkey != null) {
+			*retkey = x->getKey();
+
+		} else if ((getDeleteKey() == true) && (key != x->getKey())) {
+			m_converter->destroy(x->getKey());
+		}
+
+		x->setKey(key, getMapContext());
+		x->setValue(val, getMapContext());
+
+		return old;
+	}
+
+	index = freeIndex(hash);
+
+	// XXX: reusing a deleted slot does not consume fill, only claiming an empty one can trigger growth
+	if ((m_control[index] == CONTROL_EMPTY) && ((m_fill + 1) > fillLimit(m_size))) {
+		int minused = m_entries * RESIZE_FACTOR;
+		if ((getFixed() == true) && (minused < (fillLimit(m_size) - 1))) {
+			minused = fillLimit(m_size) - 1;
+		}
+
+		resize(minused);
+
+		index = freeIndex(hash);
+	}
+
+	if (m_control[index] == CONTROL_EMPTY) {
+		m_fill++;
+	}
+
+	new (&m_slots[index]) MapEntry<K,V,Ctx>(key, val, getMapContext());
+	m_control[index] = (ubytetype) (hash >> 57);
+	m_entries++;
+
+	if (status != null) {
+		*status = false;
+	}
+
+	return Map<K,V,Ctx>::NULL_VALUE;
+}
+
+template<typename K, typename V, typename Ctx>
+void FlatHashMap<K,V,Ctx>::putAll(const Map<K,V,Ctx>* map, Map<K,V,Ctx>* fillmap) {
+	Set<MapEntry<K,V,Ctx>* >* set = ((Map<K,V,Ctx>*) map)->entrySet();
+
+	K retkey = Map<K,V,Ctx>::NULL_KEY;
+	boolean status;
+	Iterator<MapEntry<K,V,Ctx>* >* iter = set->iterator();
+	while (iter->hasNext()) {
+		const MapEntry<K,V,Ctx>* entry = (const MapEntry<K,V,Ctx>*) iter->next();
+		if (fillmap != null) {
+			V val = put(entry->getKey(), entry->getValue(), &retkey, &status);
+			if (status == true) {
+				fillmap->put(retkey, val);
+			}
+
+		} else {
+			put(entry->getKey(), entry->getValue());
+		}
+	}
+
+	delete iter;
+	delete set;
+}
+
+template<typename K, typename V, typename Ctx>
+V FlatHashMap<K,V,Ctx>::remove(const K key, K* retkey, boolean* status) {
+	int index = (m_control == null) ? -1 : findIndex(key, hashOf(key));
+	if (index == -1) {
+		if (status != null) {
+			*status = false;
+		}
+
+		return Map<K,V,Ctx>::NULL_VALUE;
+	}
+
+	MapEntry<K,V,Ctx>* x = &m_slots[index];
+
+	V val = x->getValue();
+
+	if (status != null) {
+		*status = true;
+	}
+
+	if (retkey != null) {
+		*retkey = x->getKey();
+
+	} else if (getDeleteKey() == true) {
+		m_converter->destroy(x->getKey());
+	}
+
+	// XXX: no shrink here, tombstones and slack are reclaimed by the next growth rehash
+	removeIndex(index);
+
+	return val;
+}
+
+template<typename K, typename V, typename Ctx>
+const V FlatHashMap<K,V,Ctx>::get(const K key, K* retkey, boolean* status) const {
+	int index = (m_control == null) ? -1 : findIndex(key, hashOf(key));
+	if (index == -1) {
+		if (status != null) {
+			*status = false;
+		}
+
+		return Map<K,V,Ctx>::NULL_VALUE;
+	}
+
+	const MapEntry<K,V,Ctx>* x = &m_slots[index];
+
+	if (status != null) {
+		*status = true;
+	}
+
+	if (retkey != null) {
+		*retkey = x->getKey();
+	}
+
+	return x->getValue();
+}
+
+template<typename K, typename V, typename Ctx>
+boolean FlatHashMap<K,V,Ctx>::containsKey(const K key) const {
+	return (m_control != null) && (findIndex(key, hashOf(key)) != -1);
+}
+
+template<typename K, typename V, typename Ctx>
+boolean FlatHashMap<K,V,Ctx>::containsValue(const V val) const {
+	// TODO
+	return false;
+}
+
+template<typename K, typename V, typename Ctx>
+boolean FlatHashMap<K,V,Ctx>::isEmpty() const {
+	return (size() == 0);
+}
+
+template<typename K, typename V, typename Ctx>
+int FlatHashMap<K,V,Ctx>::size() const {
+	return m_entries;
+}
+
+template<typename K, typename V, typename Ctx>
+int FlatHashMap<K,V,Ctx>::capacity() const {
+	return m_size;
+}
+
+template<typename K, typename V, typename Ctx>
+void FlatHashMap<K,V,Ctx>::clear(boolean delkey, boolean delval) {
+	if (m_control == null) {
+		return;
+	}
+
+	ubytetype* control = m_control;
+	MapEntry<K,V,Ctx>* slots = m_slots;
+	m_control = null;
+	m_slots = null;
+
+	int i, n = m_size;
+	m_size = 0;
+
+	m_fill = 0;
+	m_entries = 0;
+
+	for (i = 0; i < n; i++) {
+		if ((control[i] & CONTROL_EMPTY) == 0) {
+			MapEntry<K,V,Ctx>* x = &slots[i];
+			if (delkey == true) {
+				m_converter->destroy(x->getKey());
+			}
+
+			if (delval == true) {
+				Converter<V>::destroy(x->getValue());
+			}
+
+			x->~MapEntry<K,V,Ctx>();
+		}
+	}
+
+	free(control);
+	free(slots);
+}
+
+template<typename K, typename V, typename Ctx>
+Set<MapEntry<K,V,Ctx>* >* FlatHashMap<K,V,Ctx>::entrySet(Set<MapEntry<K,V,Ctx>* >* fillset) {
+	if (fillset != null) {
+		// TODO: check type
+		((EntrySet*) fillset)->reset(this);
+
+	} else {
+		fillset = new EntrySet(this);
+	}
+
+	return fillset;
+}
+
+template<typename K, typename V, typename Ctx>
+Set<K>* FlatHashMap<K,V,Ctx>::keySet(Set<K>* fillset) {
+	if (fillset != null) {
+		// TODO: check type
+		((KeySet*) fillset)->reset(this);
+
+	} else {
+		fillset = new KeySet(this);
+	}
+
+	return fillset;
+}
+
+template<typename K, typename V, typename Ctx>
+Collection<V>* FlatHashMap<K,V,Ctx>::values() {
+	return null;
+}
+
+} } // namespace
+
+#endif /*CXX_UTIL_FLATHASHMAP_CXX_*/
@@ -0,0 +1,501 @@
+/**
+ *    Copyright (C) 2010 Deep Software Foundation
+ *
+ *    This program is free software: you can redistribute it and/or  modify
+ *    it under the terms of the GNU Affero General Public License, version 3,
+ *    as published by the Free Software Foundation.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU Affero General Public License for more details.
+ *
+ *    You should have received a copy of the GNU Affero General Public License
+ *    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *    As a special exception, the copyright holders give permission to link the
+ *    code of portions of this program with the OpenSSL library under certain
+ *    conditions as described in each individual source file and distribute
+ *    linked combinations including the program with the OpenSSL library. You
+ *    must comply with the GNU Affero General Public License in all respects for
+ *    all of the code used other than as permitted herein. If you modify file(s)
+ *    with this exception, you may extend this exception to your version of the
+ *    file(s), but you are not obligated to do so. If you do not wish to do so,
+ *    delete this exception statement from your version. If you delete this
+ *    exception statement from all source files in the program, then also delete
+ *    it in the license file.
+ */
+#ifndef CXX_UTIL_FROZENTREEMAP_H_
+#define CXX_UTIL_FROZENTREEMAP_H_
+
+#include <new>
+#include <stdlib.h>
+#include <string.h>
+
+#include "cxx/lang/UnsupportedOperationException.h"
+
+#include "cxx/util/Comparator.h"
+#include "cxx/util/EytzingerIndex.h"
+#include "cxx/util/SortedMap.h"
+#include "cxx/util/TreeIterator.h"
+
+namespace cxx { namespace util {
+
+/**
+ * Read-only sorted map laid out for lookups: entries are packed in key order in one array and an
+ * EytzingerIndex over the last key of every EytzingerIndex::BLOCK entries leads to the block holding a key.
+ * No parent pointers, no partially filled nodes and no virtual calls on the search path. Typically made by
+ * TreeMap::freeze() once a map stops changing; every write throws UnsupportedOperationException.
+ */
+template<typename K, typename V, typename Ctx = void*>
+class FrozenTreeMap : public SortedMap<K,V,Ctx> {
+
+	private:
+		typedef EytzingerIndex<K,Comparator<K> > Index;
+
+		const Comparator<K>* m_comparator;
+		MapEntry<K,V,Ctx>* m_entries;
+		inttype m_size;
+		Index m_index;
+		boolean m_deleteKey : 1;
+		boolean m_deleteValue : 1;
+		#ifdef COM_DEEPIS_DB_CARDINALITY
+		bytetype m_keyParts;
+		inttype* m_cardinality;
+		#endif
+
+		// XXX: index of the first entry not below key, m_size when there is none
+		FORCE_INLINE inttype ceilingIndex(const K key) const {
+			inttype block = m_index.search(key);
+			if (block == m_index.getBlockCount()) {
+				return m_size;
+			}
+
+			// XXX: the block maximum is not below key, so the answer is inside the block
+			inttype start = block * Index::BLOCK;
+			inttype finish = start + Index::BLOCK - 1;
+			if (finish >= m_size) {
+				finish = m_size - 1;
+			}
+
+			while (start < finish) {
+				inttype mid = (start + finish) >> 1;
+				if (m_comparator->compare(m_entries[mid].getKey(), key) < 0) {
+					start = mid + 1;
+
+				} else {
+					finish = mid;
+				}
+			}
+
+			return start;
+		}
+
+		FORCE_INLINE inttype findIndex(const K key) const {
+			inttype index = ceilingIndex(key);
+			if ((index < m_size) && (m_comparator->compare(m_entries[index].getKey(), key) == 0)) {
+				return index;
+			}
+
+			return -1;
+		}
+
+		FORCE_INLINE const MapEntry<K,V,Ctx>* entryAt(inttype index) const {
+			return ((index >= 0) && (index < m_size)) ? &m_entries[index] : null;
+		}
+
+		FORCE_INLINE static const K keyOf(const MapEntry<K,V,Ctx>* entry, boolean* status) {
+			if (status != null) {
+				*status = (entry != null);
+			}
+
+			return (entry != null) ? entry->getKey() : Map<K,V,Ctx>::NULL_KEY;
+		}
+
+	public:
+		// XXX: takes count entries in ascending key order from iter, keys and values are owned per delkey / delval
+		FrozenTreeMap(const Comparator<K>* comparator, Iterator<MapEntry<K,V,Ctx>*>* iter, inttype count, boolean delkey = false, boolean delval = false):
+			m_comparator(comparator),
+			m_entries(null),
+			m_size(0),
+			m_deleteKey(delkey),
+			#ifdef COM_DEEPIS_DB_CARDINALITY
+			m_deleteValue(delval),
+			m_keyParts(0),
+			m_cardinality(null) {
+			#else
+			m_deleteValue(delval) {
+			#endif
+
+			m_entries = (MapEntry<K,V,Ctx>*) malloc(((count > 0) ? count : 1) * sizeof(MapEntry<K,V,Ctx>));
+
+			while ((m_size < count) && (iter->hasNext() == true)) {
+				const MapEntry<K,V,Ctx>* entry = iter->next();
+				if ((m_size > 0) && (m_comparator->compare(m_entries[m_size - 1].getKey(), entry->getKey()) >= 0)) {
+					free(m_entries);
+					throw new UnsupportedOperationException("Frozen map entries out of order");
+				}
+
+				new (&m_entries[m_size++]) MapEntry<K,V,Ctx>(entry->getKey(), entry->getValue(), (Ctx) Converter<Ctx>::NULL_VALUE);
+			}
+
+			inttype blocks = (m_size + Index::BLOCK - 1) / Index::BLOCK;
+			K* maxima = (K*) malloc(((blocks > 0) ? blocks : 1) * sizeof(K));
+			for (inttype i = 0; i < blocks; i++) {
+				inttype last = ((i + 1) * Index::BLOCK) - 1;
+				maxima[i] = m_entries[(last < m_size) ? last : (m_size - 1)].getKey();
+			}
+
+			m_index.build(m_comparator, maxima, blocks);
+			free(maxima);
+		}
+
+		virtual ~FrozenTreeMap(void) {
+			for (inttype i = 0; ((m_deleteKey == true) || (m_deleteValue == true)) && (i < m_size); i++) {
+				if (m_deleteKey == true) {
+					Converter<K>::destroy(m_entries[i].getKey());
+				}
+
+				if (m_deleteValue == true) {
+					Converter<V>::destroy(m_entries[i].getValue());
+				}
+			}
+
+			free(m_entries);
+
+			#ifdef COM_DEEPIS_DB_CARDINALITY
+			if (m_cardinality != null) {
+				free(m_cardinality);
+			}
+			#endif
+		}
+
+		#ifdef COM_DEEPIS_DB_CARDINALITY
+		void setCardinality(const inttype* cardinality, bytetype keyParts) {
+			if (m_cardinality != null) {
+				free(m_cardinality);
+				m_cardinality = null;
+			}
+
+			m_keyParts = keyParts;
+			if (cardinality != null) {
+				m_cardinality = (inttype*) malloc(keyParts * sizeof(inttype));
+				memcpy(m_cardinality, cardinality, keyParts * sizeof(inttype));
+			}
+		}
+
+		const inttype* getCardinality() const {
+			return m_cardinality;
+		}
+		#endif
+
+		FORCE_INLINE const V get(const K key, K* retkey, boolean* status) const {
+			inttype index = findIndex(key);
+			if (status != null) {
+				*status = (index >= 0);
+			}
+
+			if (index < 0) {
+				return Map<K,V,Ctx>::NULL_VALUE;
+			}
+
+			if (retkey != null) {
+				*retkey = m_entries[index].getKey();
+			}
+
+			return m_entries[index].getValue();
+		}
+
+		virtual const V get(const K key) const {
+			return get(key, null, null);
+		}
+
+		virtual boolean containsKey(const K key) const {
+			return (findIndex(key) >= 0);
+		}
+
+		virtual boolean containsValue(const V val) const {
+			for (inttype i = 0; i < m_size; i++) {
+				if (m_entries[i].getValue() == val) {
+					return true;
+				}
+			}
+
+			return false;
+		}
+
+		const MapEntry<K,V,Ctx>* getEntry(const K key) const {
+			return entryAt(findIndex(key));
+		}
+
+		const MapEntry<K,V,Ctx>* firstEntry(void) const {
+			return entryAt(0);
+		}
+
+		const MapEntry<K,V,Ctx>* lastEntry(void) const {
+			return entryAt(m_size - 1);
+		}
+
+		const MapEntry<K,V,Ctx>* lowerEntry(const K key) const {
+			return entryAt(ceilingIndex(key) - 1);
+		}
+
+		const MapEntry<K,V,Ctx>* higherEntry(const K key) const {
+			inttype index = ceilingIndex(key);
+			if ((index < m_size) && (m_comparator->compare(m_entries[index].getKey(), key) == 0)) {
+				index++;
+			}
+
+			return entryAt(index);
+		}
+
+		const MapEntry<K,V,Ctx>* floorEntry(const K key) const {
+			inttype index = ceilingIndex(key);
+			if ((index < m_size) && (m_comparator->compare(m_entries[index].getKey(), key) == 0)) {
+				return &m_entries[index];
+			}
+
+			return entryAt(index - 1);
+		}
+
+		const MapEntry<K,V,Ctx>* ceilingEntry(const K key) const {
+			return entryAt(ceilingIndex(key));
+		}
+
+		virtual const K firstKey(boolean* status) const {
+			return keyOf(firstEntry(), status);
+		}
+
+		virtual const K firstKey(void) const {
+			return firstKey(null);
+		}
+
+		virtual const K lastKey(boolean* status) const {
+			return keyOf(lastEntry(), status);
+		}
+
+		virtual const K lastKey(void) const {
+			return lastKey(null);
+		}
+
+		const K lowerKey(const K key, boolean* status = null) const {
+			return keyOf(lowerEntry(key), status);
+		}
+
+		const K higherKey(const K key, boolean* status = null) const {
+			return keyOf(higherEntry(key), status);
+		}
+
+		const K floorKey(const K key, boolean* status = null) const {
+			return keyOf(floorEntry(key), status);
+		}
+
+		const K ceilingKey(const K key, boolean* status = null) const {
+			return keyOf(ceilingEntry(key), status);
+		}
+
+		// XXX: same contract as TreeMap::forEachInRange, the range is one contiguous run of the entry array
+		template<typename F>
+		FORCE_INLINE inttype forEachInRange(const K fromKey, const K toKey, F&& visitor) const {
+			return forEachInRange(fromKey, false, toKey, false, visitor);
+		}
+
+		template<typename F>
+		inttype forEachInRange(const K fromKey, boolean fromOpen, const K toKey, boolean toOpen, F&& visitor) const {
+			inttype start = (fromOpen == false) ? ceilingIndex(fromKey) : 0;
+			inttype finish = (toOpen == false) ? ceilingIndex(toKey) : m_size;
+
+			for (inttype i = start; i < finish; i++) {
+				if (visitor((const MapEntry<K,V,Ctx>*) &m_entries[i]) == false) {
+					return i - start + 1;
+				}
+			}
+
+			return (finish > start) ? (finish - start) : 0;
+		}
+
+		virtual boolean isEmpty() const {
+			return (m_size == 0);
+		}
+
+		virtual int size() const {
+			return m_size;
+		}
+
+		virtual V put(K key, V val) {
+			throw new UnsupportedOperationException("Frozen map is read only");
+		}
+
+		virtual void putAll(const Map<K,V,Ctx>* map) {
+			throw new UnsupportedOperationException("Frozen map is read only");
+		}
+
+		virtual V remove(const K key) {
+			throw new UnsupportedOperationException("Frozen map is read only");
+		}
+
+		virtual void clear() {
+			throw new UnsupportedOperationException("Frozen map is read only");
+		}
+
+		virtual SortedMap<K,V,Ctx>* headMap(const K toKey) {
+			throw new UnsupportedOperationException("headMap not supported");
+		}
+
+		virtual SortedMap<K,V,Ctx>* subMap(const K fromKey, const K toKey) {
+			throw new UnsupportedOperationException("subMap not supported");
+		}
+
+		virtual SortedMap<K,V,Ctx>* tailMap(const K fromKey) {
+			throw new UnsupportedOperationException("tailMap not supported");
+		}
+
+	class FrozenIterator : public TreeIterator<MapEntry<K,V,Ctx>*> {
+
+		private:
+			typedef MapEntry<K,V,Ctx>* Entry;
+
+			const FrozenTreeMap<K,V,Ctx>* m_map;
+			inttype m_index;
+
+		public:
+			FrozenIterator(const FrozenTreeMap<K,V,Ctx>* map, inttype index):
+				m_map(map),
+				m_index(index) {
+			}
+
+			virtual ~FrozenIterator() {
+			}
+
+			virtual boolean hasNext() {
+				return (m_index < m_map->m_size);
+			}
+
+			virtual const Entry next() {
+				return (m_index < m_map->m_size) ? (Entry) &m_map->m_entries[m_index++] : null;
+			}
+
+			virtual boolean hasPrevious() {
+				return (m_index > 0);
+			}
+
+			virtual const Entry previous() {
+				return (m_index > 0) ? (Entry) &m_map->m_entries[--m_index] : null;
+			}
+
+			virtual void remove() {
+				throw new UnsupportedOperationException("Remove not supported");
+			}
+	};
+
+	class KeyIterator : public Iterator<K> {
+
+		private:
+			const FrozenTreeMap<K,V,Ctx>* m_map;
+			inttype m_index;
+
+		public:
+			KeyIterator(const FrozenTreeMap<K,V,Ctx>* map, inttype index):
+				m_map(map),
+				m_index(index) {
+			}
+
+			virtual ~KeyIterator() {
+			}
+
+			virtual boolean hasNext() {
+				return (m_index < m_map->m_size);
+			}
+
+			virtual const K next() {
+				return (m_index < m_map->m_size) ? m_map->m_entries[m_index++].getKey() : Map<K,V,Ctx>::NULL_KEY;
+			}
+
+			virtual void remove() {
+				throw new UnsupportedOperationException("Remove not supported");
+			}
+	};
+
+	// XXX: read-only views of the entries (E = MapEntry<K,V,Ctx>*) or of the keys (E = K)
+	template<typename E, typename I>
+	class View : public Set<E> {
+
+		private:
+			const FrozenTreeMap<K,V,Ctx>* m_map;
+
+		public:
+			View(const FrozenTreeMap<K,V,Ctx>* map):
+				m_map(map) {
+			}
+
+			virtual ~View() {
+			}
+
+			virtual int size() const {
+				return m_map->m_size;
+			}
+
+			virtual boolean isEmpty() const {
+				return (m_map->m_size == 0);
+			}
+
+			virtual boolean contains(const E e) const {
+				return m_map->contains(e);
+			}
+
+			virtual Iterator<E>* iterator() {
+				return new I(m_map, 0);
+			}
+
+			virtual boolean add(E e) {
+				throw new UnsupportedOperationException("Frozen map is read only");
+			}
+
+			virtual boolean remove(const E e) {
+				throw new UnsupportedOperationException("Frozen map is read only");
+			}
+
+			virtual void clear() {
+				throw new UnsupportedOperationException("Frozen map is read only");
+			}
+	};
+
+	private:
+		FORCE_INLINE boolean contains(const MapEntry<K,V,Ctx>* entry) const {
+			return (entry >= m_entries) && (entry < (m_entries + m_size));
+		}
+
+		FORCE_INLINE boolean contains(const K key) const {
+			return containsKey(key);
+		}
+
+	public:
+		TreeIterator<MapEntry<K,V,Ctx>*>* iterator(void) const {
+			return new FrozenIterator(this, 0);
+		}
+
+		// XXX: iterates from the first key not below startKey
+		TreeIterator<MapEntry<K,V,Ctx>*>* iterator(const K startKey) const {
+			return new FrozenIterator(this, ceilingIndex(startKey));
+		}
+
+		virtual Set<MapEntry<K,V,Ctx>*>* entrySet() {
+			return new View<MapEntry<K,V,Ctx>*, FrozenIterator>(this);
+		}
+
+		virtual Set<K>* keySet() {
+			return new View<K, KeyIterator>(this);
+		}
+
+		virtual Collection<V>* values() {
+			throw new UnsupportedOperationException("values not supported");
+		}
+
+	friend class FrozenIterator;
+	friend class KeyIterator;
+	template<typename E, typename I> friend class View;
+};
+
+} } // namespace
+
+#endif /*CXX_UTIL_FROZENTREEMAP_H_*/
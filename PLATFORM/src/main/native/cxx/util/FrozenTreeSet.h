@@ -0,0 +1,280 @@
+/**
+ *    Copyright (C) 2010 Deep Software Foundation
+ *
+ *    This program is free software: you can redistribute it and/or  modify
+ *    it under the terms of the GNU Affero General Public License, version 3,
+ *    as published by the Free Software Foundation.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU Affero General Public License for more details.
+ *
+ *    You should have received a copy of the GNU Affero General Public License
+ *    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *    As a special exception, the copyright holders give permission to link the
+ *    code of portions of this program with the OpenSSL library under certain
+ *    conditions as described in each individual source file and distribute
+ *    linked combinations including the program with the OpenSSL library. You
+ *    must comply with the GNU Affero General Public License in all respects for
+ *    all of the code used other than as permitted herein. If you modify file(s)
+ *    with this exception, you may extend this exception to your version of the
+ *    file(s), but you are not obligated to do so. If you do not wish to do so,
+ *    delete this exception statement from your version. If you delete this
+ *    exception statement from all source files in the program, then also delete
+ *    it in the license file.
+ */
+#ifndef CXX_UTIL_FROZENTREESET_H_
+#define CXX_UTIL_FROZENTREESET_H_
+
+#include <stdlib.h>
+
+#include "cxx/lang/UnsupportedOperationException.h"
+
+#include "cxx/util/Comparator.h"
+#include "cxx/util/EytzingerIndex.h"
+#include "cxx/util/SortedSet.h"
+
+namespace cxx { namespace util {
+
+/**
+ * Read-only sorted set with the layout of FrozenTreeMap: elements packed in order in one array, found
+ * through an EytzingerIndex over block maxima. Typically made by TreeSet::freeze(); writes throw.
+ */
+template<typename E, typename Cmp = Comparator<E> >
+class FrozenTreeSet : public SortedSet<E> {
+
+	private:
+		typedef EytzingerIndex<E,Cmp> Index;
+
+		const Cmp* m_comparator;
+		E* m_elements;
+		inttype m_size;
+		Index m_index;
+		boolean m_deleteValue;
+
+		// XXX: index of the first element not below elem, m_size when there is none
+		FORCE_INLINE inttype ceilingIndex(const E elem) const {
+			inttype block = m_index.search(elem);
+			if (block == m_index.getBlockCount()) {
+				return m_size;
+			}
+
+			inttype start = block * Index::BLOCK;
+			inttype finish = start + Index::BLOCK - 1;
+			if (finish >= m_size) {
+				finish = m_size - 1;
+			}
+
+			while (start < finish) {
+				inttype mid = (start + finish) >> 1;
+				if (m_comparator->compare(m_elements[mid], elem) < 0) {
+					start = mid + 1;
+
+				} else {
+					finish = mid;
+				}
+			}
+
+			return start;
+		}
+
+		FORCE_INLINE boolean matches(inttype index, const E elem) const {
+			return (index < m_size) && (m_comparator->compare(m_elements[index], elem) == 0);
+		}
+
+		FORCE_INLINE const E elementAt(inttype index, boolean* status) const {
+			boolean found = (index >= 0) && (index < m_size);
+			if (status != null) {
+				*status = found;
+			}
+
+			return (found == true) ? m_elements[index] : Set<E>::NULL_VALUE;
+		}
+
+	public:
+		// XXX: takes count elements in ascending order from iter, elements are owned per deleteValue
+		FrozenTreeSet(const Cmp* comparator, Iterator<E>* iter, inttype count, boolean deleteValue = false):
+			m_comparator(comparator),
+			m_elements(null),
+			m_size(0),
+			m_deleteValue(deleteValue) {
+
+			m_elements = (E*) malloc(((count > 0) ? count : 1) * sizeof(E));
+
+			while ((m_size < count) && (iter->hasNext() == true)) {
+				E elem = iter->next();
+				if ((m_size > 0) && (m_comparator->compare(m_elements[m_size - 1], elem) >= 0)) {
+					free(m_elements);
+					throw new UnsupportedOperationException("Frozen set elements out of order");
+				}
+
+				m_elements[m_size++] = elem;
+			}
+
+			inttype blocks = (m_size + Index::BLOCK - 1) / Index::BLOCK;
+			E* maxima = (E*) malloc(((blocks > 0) ? blocks : 1) * sizeof(E));
+			for (inttype i = 0; i < blocks; i++) {
+				inttype last = ((i + 1) * Index::BLOCK) - 1;
+				maxima[i] = m_elements[(last < m_size) ? last : (m_size - 1)];
+			}
+
+			m_index.build(m_comparator, maxima, blocks);
+			free(maxima);
+		}
+
+		virtual ~FrozenTreeSet(void) {
+			for (inttype i = 0; (m_deleteValue == true) && (i < m_size); i++) {
+				Converter<E>::destroy(m_elements[i]);
+			}
+
+			free(m_elements);
+		}
+
+		virtual const E first(boolean* status) const {
+			return elementAt(0, status);
+		}
+
+		virtual const E first(void) const {
+			return first(null);
+		}
+
+		virtual const E last(boolean* status) const {
+			return elementAt(m_size - 1, status);
+		}
+
+		virtual const E last(void) const {
+			return last(null);
+		}
+
+		const E lower(const E e, boolean* status = null) const {
+			return elementAt(ceilingIndex(e) - 1, status);
+		}
+
+		const E higher(const E e, boolean* status = null) const {
+			inttype index = ceilingIndex(e);
+			return elementAt(matches(index, e) ? index + 1 : index, status);
+		}
+
+		const E floor(const E e, boolean* status = null) const {
+			inttype index = ceilingIndex(e);
+			return elementAt(matches(index, e) ? index : index - 1, status);
+		}
+
+		const E ceiling(const E e, boolean* status = null) const {
+			return elementAt(ceilingIndex(e), status);
+		}
+
+		virtual boolean contains(const E e, E* retelem) const {
+			inttype index = ceilingIndex(e);
+			if (matches(index, e) == false) {
+				return false;
+			}
+
+			if (retelem != null) {
+				*retelem = m_elements[index];
+			}
+
+			return true;
+		}
+
+		virtual boolean contains(const E e) const {
+			return contains(e, null);
+		}
+
+		// XXX: same contract as TreeSet::forEachInRange, the range is one contiguous run of the element array
+		template<typename F>
+		FORCE_INLINE int forEachInRange(const E fromElement, const E toElement, F&& visitor) const {
+			return forEachInRange(fromElement, false, toElement, false, visitor);
+		}
+
+		template<typename F>
+		int forEachInRange(const E fromElement, boolean fromOpen, const E toElement, boolean toOpen, F&& visitor) const {
+			inttype start = (fromOpen == false) ? ceilingIndex(fromElement) : 0;
+			inttype finish = (toOpen == false) ? ceilingIndex(toElement) : m_size;
+
+			for (inttype i = start; i < finish; i++) {
+				if (visitor((const E) m_elements[i]) == false) {
+					return i - start + 1;
+				}
+			}
+
+			return (finish > start) ? (finish - start) : 0;
+		}
+
+		virtual boolean isEmpty() const {
+			return (m_size == 0);
+		}
+
+		virtual int size() const {
+			return m_size;
+		}
+
+		virtual boolean add(E elem) {
+			throw new UnsupportedOperationException("Frozen set is read only");
+		}
+
+		virtual boolean remove(const E elem) {
+			throw new UnsupportedOperationException("Frozen set is read only");
+		}
+
+		virtual void clear() {
+			throw new UnsupportedOperationException("Frozen set is read only");
+		}
+
+		virtual SortedSet<E>* headSet(const E toElement) {
+			throw new UnsupportedOperationException("headSet not supported");
+		}
+
+		virtual SortedSet<E>* subSet(const E fromElement, const E toElement) {
+			throw new UnsupportedOperationException("subSet not supported");
+		}
+
+		virtual SortedSet<E>* tailSet(const E fromElement) {
+			throw new UnsupportedOperationException("tailSet not supported");
+		}
+
+	class FrozenIterator : public Iterator<E> {
+
+		private:
+			const FrozenTreeSet<E,Cmp>* m_set;
+			inttype m_index;
+
+		public:
+			FrozenIterator(const FrozenTreeSet<E,Cmp>* set, inttype index):
+				m_set(set),
+				m_index(index) {
+			}
+
+			virtual ~FrozenIterator() {
+			}
+
+			virtual boolean hasNext() {
+				return (m_index < m_set->m_size);
+			}
+
+			virtual const E next() {
+				return (m_index < m_set->m_size) ? m_set->m_elements[m_index++] : Set<E>::NULL_VALUE;
+			}
+
+			virtual void remove() {
+				throw new UnsupportedOperationException("Remove not supported");
+			}
+	};
+
+		virtual Iterator<E>* iterator() {
+			return new FrozenIterator(this, 0);
+		}
+
+		// XXX: iterates from the first element not below startElement
+		Iterator<E>* iterator(const E startElement) const {
+			return new FrozenIterator(this, ceilingIndex(startElement));
+		}
+
+	friend class FrozenIterator;
+};
+
+} } // namespace
+
+#endif /*CXX_UTIL_FROZENTREESET_H_*/
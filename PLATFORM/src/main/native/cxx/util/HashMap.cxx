@@ -81,11 +81,17 @@ const int HashMap<K,V,Ctx>::RESIZE_LOW_WATER = 8;
 template<typename K, typename V, typename Ctx>
 const int HashMap<K,V,Ctx>::RESIZE_HIGH_WATER = 3;
 
+template<typename K, typename V, typename Ctx>
+const int HashMap<K,V,Ctx>::RESIZE_SHRINK_FACTOR = 3;
+
+template<typename K, typename V, typename Ctx>
+const int HashMap<K,V,Ctx>::RESIZE_STEP = 16;
+
 template<typename K, typename V, typename Ctx>
 const int HashMap<K,V,Ctx>::INITIAL_CAPACITY = 16;
 
 template<typename K, typename V, typename Ctx>
-HashMap<K,V,Ctx>::HashMap(int cap, boolean delkey, boolean delval, boolean fixed):
+HashMap<K,V,Ctx>::HashMap(int cap, boolean delkey, boolean delval, boolean fixed, boolean incremental):
 #if 0
 	HashMap<K,V,Ctx>(&HashMap<K,V,Ctx>::CONVERTER, cap, delkey, delval) {
 #else
@@ -97,7 +103,11 @@ HashMap<K,V,Ctx>::HashMap(int cap, boolean delkey, boolean delval, boolean fixed
 	m_stateFlags(0),
 	m_table(null),
 	m_converter(&HashMap<K,V,Ctx>::CONVERTER),
-	m_reserve((MapEntry<K,V,Ctx>*) &m_fill) {
+	m_reserve((MapEntry<K,V,Ctx>*) &m_fill),
+	m_oldPoly(0),
+	m_oldSize(0),
+	m_rehashIndex(0),
+	m_oldTable(null) {
 
 	m_ctx = Converter<Ctx>::NULL_VALUE;
 
@@ -109,11 +119,12 @@ HashMap<K,V,Ctx>::HashMap(int cap, boolean delkey, boolean delval, boolean fixed
 	setDeleteValue(delval);
 
 	setFixed(fixed);
+	setIncremental(incremental);
 #endif
 }
 
 template<typename K, typename V, typename Ctx>
-HashMap<K,V,Ctx>::HashMap(const Converter<K>* converter, int cap, boolean delkey, boolean delval, boolean fixed):
+HashMap<K,V,Ctx>::HashMap(const Converter<K>* converter, int cap, boolean delkey, boolean delval, boolean fixed, boolean incremental):
 	m_poly(0),
 	m_fill(0),
 	m_size(0),
@@ -122,7 +133,11 @@ HashMap<K,V,Ctx>::HashMap(const Converter<K>* converter, int cap, boolean delkey
 	m_stateFlags(0),
 	m_table(null),
 	m_converter(converter),
-	m_reserve((MapEntry<K,V,Ctx>*) &m_fill) {
+	m_reserve((MapEntry<K,V,Ctx>*) &m_fill),
+	m_oldPoly(0),
+	m_oldSize(0),
+	m_rehashIndex(0),
+	m_oldTable(null) {
 
 	m_ctx = Converter<Ctx>::NULL_VALUE;
 
@@ -134,6 +149,7 @@ HashMap<K,V,Ctx>::HashMap(const Converter<K>* converter, int cap, boolean delkey
 	setDeleteValue(delval);
 
 	setFixed(fixed);
+	setIncremental(incremental);
 }
 
 template<typename K, typename V, typename Ctx>
@@ -143,6 +159,11 @@ HashMap<K,V,Ctx>::~HashMap() {
 
 template<typename K, typename V, typename Ctx>
 int HashMap<K,V,Ctx>::resize(int minused) {
+	// XXX: finish a migration still in flight, only two tables are ever kept side by side
+	if (m_oldTable != null) {
+		rehash(m_oldSize - m_rehashIndex);
+	}
+
 	register int i = 0;
 	register int size = 0;
 	register long poly = 0;
@@ -166,6 +187,21 @@ int HashMap<K,V,Ctx>::resize(int minused) {
 	MapEntry<K,V,Ctx>** table = (MapEntry<K,V,Ctx>**) malloc(msize);
 	memset(table, 0, msize);
 
+	// XXX: incremental mode leaves the entries in the old table, rehash() migrates them on later operations
+	if ((getIncremental() == true) && (oldtable != null)) {
+		m_oldTable = oldtable;
+		m_oldSize = oldsize;
+		m_oldPoly = m_poly;
+		m_rehashIndex = 0;
+
+		m_fill = 0;
+		m_size = size;
+		m_poly = poly;
+		m_table = table;
+
+		return m_size;
+	}
+
 	m_fill = 0;
 	m_entries = 0;
 	m_size = size;
@@ -184,6 +220,56 @@ int HashMap<K,V,Ctx>::resize(int minused) {
 	return m_size;
 }
 
+template<typename K, typename V, typename Ctx>
+void HashMap<K,V,Ctx>::rehash(int steps) {
+	for (; (steps > 0) && (m_rehashIndex < m_oldSize); steps--, m_rehashIndex++) {
+		MapEntry<K,V,Ctx>* p = m_oldTable[m_rehashIndex];
+		if ((p != null) && (p != m_reserve)) {
+			// XXX: leave a reserve behind so old table probes through this slot keep going
+			m_oldTable[m_rehashIndex] = (MapEntry<K,V,Ctx>*) m_reserve;
+
+			int index = getIndex(p->getKey(), false);
+			if (m_table[index] == null) {
+				m_fill++;
+			}
+
+			m_table[index] = p;
+		}
+	}
+
+	if (m_rehashIndex >= m_oldSize) {
+		free(m_oldTable);
+
+		m_oldPoly = 0;
+		m_oldSize = 0;
+		m_rehashIndex = 0;
+		m_oldTable = null;
+	}
+}
+
+template<typename K, typename V, typename Ctx>
+MapEntry<K,V,Ctx>* HashMap<K,V,Ctx>::getOldObject(const K key) const {
+	int index = getIndex(key, true, m_oldTable, m_oldSize, m_oldPoly);
+	MapEntry<K,V,Ctx>* p = m_oldTable[index];
+	if ((p != null) && (p != m_reserve)) {
+		return p;
+	}
+
+	return null;
+}
+
+template<typename K, typename V, typename Ctx>
+MapEntry<K,V,Ctx>* HashMap<K,V,Ctx>::removeOldObject(const K key) {
+	int index = getIndex(key, true, m_oldTable, m_oldSize, m_oldPoly);
+	MapEntry<K,V,Ctx>* p = m_oldTable[index];
+	if ((p != null) && (p != m_reserve)) {
+		m_oldTable[index] = (MapEntry<K,V,Ctx>*) m_reserve;
+		return p;
+	}
+
+	return null;
+}
+
 template<typename K, typename V, typename Ctx>
 MapEntry<K,V,Ctx>* HashMap<K,V,Ctx>::removeObject(int index) {
 	MapEntry<K,V,Ctx>* p = m_table[index];
@@ -193,11 +279,6 @@ MapEntry<K,V,Ctx>* HashMap<K,V,Ctx>::removeObject(int index) {
 		m_fill++;
 	}
 
-	// TODO: handle external iterator cursors
-	if (((m_entries * RESIZE_LOW_WATER) < m_size) && (getFixed() == false)) {
-		resize(m_entries * RESIZE_FACTOR);
-	}
-
 	return p;
 }
 
@@ -236,12 +317,12 @@ int HashMap<K,V,Ctx>::putIndex(const K key, boolean check) {
 }
 
 template<typename K, typename V, typename Ctx>
-int HashMap<K,V,Ctx>::getIndex(const K key, boolean match) const {
+int HashMap<K,V,Ctx>::getIndex(const K key, boolean match, MapEntry<K,V,Ctx>** table, int size, long poly) const {
 	register long hash = m_converter->hashCode(key);
-	register unsigned int mask = m_size - 1;
+	register unsigned int mask = size - 1;
 	register int i = (~hash) & mask;
 
-	register MapEntry<K,V,Ctx>* p = m_table[i];
+	register MapEntry<K,V,Ctx>* p = table[i];
 	if (p == null) {
 		return i;
 
@@ -257,11 +338,11 @@ int HashMap<K,V,Ctx>::getIndex(const K key, boolean match) const {
 		incr = mask;
 
 	} else if (incr > mask) {
-		incr ^= m_poly;
+		incr ^= poly;
 	}
 
 	for (;;) {
-		p = m_table[(i + incr) &mask];
+		p = table[(i + incr) &mask];
 		if (p == null) {
 			return (i + incr) &mask;
 
@@ -274,7 +355,7 @@ int HashMap<K,V,Ctx>::getIndex(const K key, boolean match) const {
 
 		incr = incr << 1;
 		if (incr > mask) {
-			incr ^= m_poly;
+			incr ^= poly;
 		}
 	}
 
@@ -285,6 +366,9 @@ template<typename K, typename V, typename Ctx>
 V HashMap<K,V,Ctx>::put(K key, V val, K* retkey, boolean* status) {
 	if (m_table == null) {
 		resize(INITIAL_CAPACITY);
+
+	} else if (m_oldTable != null) {
+		rehash(RESIZE_STEP);
 	}
 
 	MapEntry<K,V,Ctx>* p = new MapEntry<K,V,Ctx>(key, val, getMapContext());
@@ -292,6 +376,11 @@ V HashMap<K,V,Ctx>::put(K key, V val, K* retkey, boolean* status) {
 
 	int index = putIndex(key, true);
 	MapEntry<K,V,Ctx>* x = insertObject(p, index);
+	if (((x == null) || (x == m_reserve)) && (m_oldTable != null)) {
+		// XXX: key not migrated yet, pull it out of the old table as the replaced entry
+		x = removeOldObject(key);
+	}
+
 	if ((x != null) && (x != m_reserve)) {
 		val = x->getValue();
 
@@ -346,6 +435,11 @@ void HashMap<K,V,Ctx>::putAll(const Map<K,V>* map, Map<K,V>* fillmap) {
 
 template<typename K, typename V, typename Ctx>
 V HashMap<K,V,Ctx>::remove(const K key, K* retkey, boolean* status) {
+	return removeEntry(key, retkey, status, true);
+}
+
+template<typename K, typename V, typename Ctx>
+V HashMap<K,V,Ctx>::removeEntry(const K key, K* retkey, boolean* status, boolean resizable) {
 	if (m_table == null) {
 		if (status != null) {
 			*status = false;
@@ -354,10 +448,21 @@ V HashMap<K,V,Ctx>::remove(const K key, K* retkey, boolean* status) {
 		return Map<K,V>::NULL_VALUE;
 	}
 
+	if ((resizable == true) && (m_oldTable != null)) {
+		rehash(RESIZE_STEP);
+	}
+
 	V val = Map<K,V>::NULL_VALUE;
 
 	int index = getIndex(key, true);
 	MapEntry<K,V,Ctx>* x = removeObject(index);
+	if (((x == null) || (x == m_reserve)) && (m_oldTable != null)) {
+		x = removeOldObject(key);
+		if (x != null) {
+			m_entries--;
+		}
+	}
+
 	if ((x != null) && (x != m_reserve)) {
 		val = x->getValue();
 
@@ -380,6 +485,13 @@ V HashMap<K,V,Ctx>::remove(const K key, K* retkey, boolean* status) {
 		}
 	}
 
+	// XXX: shrink to a third of the size (i.e. well inside the high/low water band) so that neither
+	// a few more removes nor a few puts right after a shrink resize the table again
+	if ((resizable == true) && ((m_entries * RESIZE_LOW_WATER) < m_size) && (m_size > (INITIAL_CAPACITY << 1)) && (m_oldTable == null) && (getFixed() == false)) {
+		int minused = m_entries * RESIZE_SHRINK_FACTOR;
+		resize((minused > INITIAL_CAPACITY) ? minused : INITIAL_CAPACITY);
+	}
+
 	return val;
 }
 
@@ -397,6 +509,10 @@ const V HashMap<K,V,Ctx>::get(const K key, K* retkey, boolean* status) const {
 
 	int index = getIndex(key, true);
 	MapEntry<K,V,Ctx>* x = m_table[index];
+	if (((x == null) || (x == m_reserve)) && (m_oldTable != null)) {
+		x = getOldObject(key);
+	}
+
 	if ((x != null) && (x != m_reserve)) {
 		if (status != null) {
 			*status = true;
@@ -453,6 +569,11 @@ void HashMap<K,V,Ctx>::clear(boolean delkey, boolean delval) {
 		return;
 	}
 
+	// XXX: finish any migration so every entry sits in the one table
+	if (m_oldTable != null) {
+		rehash(m_oldSize - m_rehashIndex);
+	}
+
 	register MapEntry<K,V,Ctx>** table = m_table;
 	m_table = null;
 
@@ -47,17 +47,51 @@ class HashMap : public Map<K,V,Ctx> {
 		const Converter<K>* m_converter;
 		const MapEntry<K,V,Ctx>* m_reserve;
 
+		// XXX: previous table while an incremental resize migrates it into m_table
+		long m_oldPoly;
+		inttype m_oldSize;
+		inttype m_rehashIndex;
+		MapEntry<K,V,Ctx>** m_oldTable;
+
 		Ctx m_ctx;
 
 		static const Converter<K> CONVERTER;
 
 	private:
 		inline int putIndex(const K key, boolean check);
-		inline int getIndex(const K key, boolean match) const;
+		inline int getIndex(const K key, boolean match, MapEntry<K,V,Ctx>** table, int size, long poly) const;
+
+		FORCE_INLINE int getIndex(const K key, boolean match) const {
+			return getIndex(key, match, m_table, m_size, m_poly);
+		}
 
 		MapEntry<K,V,Ctx>* removeObject(int index);
 		MapEntry<K,V,Ctx>* insertObject(MapEntry<K,V,Ctx>* x, int index);
 
+		MapEntry<K,V,Ctx>* getOldObject(const K key) const;
+		MapEntry<K,V,Ctx>* removeOldObject(const K key);
+
+		void rehash(int steps);
+
+		V removeEntry(const K key, K* retkey, boolean* status, boolean resizable);
+
+		FORCE_INLINE int getSlotCount() const {
+			return m_oldSize + m_size;
+		}
+
+		// XXX: slots of the old table (while resizing) come first, then slots of the current table
+		FORCE_INLINE MapEntry<K,V,Ctx>* getSlot(int index) const {
+			return (index < m_oldSize) ? m_oldTable[index] : m_table[index - m_oldSize];
+		}
+
+		FORCE_INLINE void setIncremental(boolean flag) {
+			m_stateFlags = flag ? m_stateFlags | 0x08 : m_stateFlags & ~0x08;
+		}
+
+		FORCE_INLINE boolean getIncremental() const {
+			return (m_stateFlags & 0x08) != 0;
+		}
+
 		FORCE_INLINE void setDeleteKey(boolean flag) {
 			m_stateFlags = flag ? m_stateFlags | 0x04 : m_stateFlags & ~0x04;
 		}
@@ -94,18 +128,24 @@ class HashMap : public Map<K,V,Ctx> {
 			return m_ctx;
 		}
 
+		FORCE_INLINE boolean isResizing() const {
+			return (m_oldTable != null);
+		}
+
 	public:
 		static const int RESIZE_FACTOR;
 		static const int RESIZE_LOW_WATER;
 		static const int RESIZE_HIGH_WATER;
+		static const int RESIZE_SHRINK_FACTOR;
+		static const int RESIZE_STEP;
 
 		static const int INITIAL_CAPACITY;
 
 		/*
 		HashMap(const Map* map);
 		*/
-		HashMap(int cap = INITIAL_CAPACITY, boolean delkey = false, boolean delval = false, boolean fixed = false);
-		HashMap(const Converter<K>* converter, int cap = INITIAL_CAPACITY, boolean delkey = false, boolean delval = false, boolean fixed = false);
+		HashMap(int cap = INITIAL_CAPACITY, boolean delkey = false, boolean delval = false, boolean fixed = false, boolean incremental = false);
+		HashMap(const Converter<K>* converter, int cap = INITIAL_CAPACITY, boolean delkey = false, boolean delval = false, boolean fixed = false, boolean incremental = false);
 		virtual ~HashMap();
 
 		virtual V put(K key, V val, K* retkey, boolean* status);
@@ -195,8 +235,8 @@ class HashMap : public Map<K,V,Ctx> {
 				}
 
 				FORCE_INLINE void moveNext() {
-					while (m_next < m_map->m_size) {
-						MapEntry<K,V,Ctx>* p = m_map->m_table[m_next];
+					while (m_next < m_map->getSlotCount()) {
+						MapEntry<K,V,Ctx>* p = m_map->getSlot(m_next);
 						if ((p != null) && (p != m_map->m_reserve)) {
 							break;
 						}
@@ -210,21 +250,21 @@ class HashMap : public Map<K,V,Ctx> {
 				}
 
 				FORCE_INLINE virtual boolean hasNext() {
-					return (m_next < m_map->m_size);
+					return (m_next < m_map->getSlotCount());
 				}
 
 				FORCE_INLINE virtual const E next() {
 					// TODO: throw NoSuchElementException when end is each (XXX: check will be a performance hit)
 					m_prev = m_next;
-					MapEntry<K,V,Ctx>* p = m_map->m_table[m_next++];
+					MapEntry<K,V,Ctx>* p = m_map->getSlot(m_next++);
 					moveNext();
 					return p;
 				}
 
 				FORCE_INLINE virtual void remove() {
-					// TODO: address cursor and resize
-					MapEntry<K,V,Ctx>* p = m_map->m_table[m_prev];
-					m_map->remove(p->getKey());
+					// XXX: cursor removes neither resize nor migrate, so slot indices stay put
+					MapEntry<K,V,Ctx>* p = m_map->getSlot(m_prev);
+					m_map->removeEntry(p->getKey(), null, null, false);
 					m_next = m_prev;
 					moveNext();
 				}
@@ -321,8 +361,8 @@ class HashMap : public Map<K,V,Ctx> {
 				}
 
 				FORCE_INLINE void moveNext() {
-					while (m_next < m_map->m_size) {
-						MapEntry<K,V,Ctx>* p = m_map->m_table[m_next];
+					while (m_next < m_map->getSlotCount()) {
+						MapEntry<K,V,Ctx>* p = m_map->getSlot(m_next);
 						if ((p != null) && (p != m_map->m_reserve)) {
 							break;
 						}
@@ -336,21 +376,21 @@ class HashMap : public Map<K,V,Ctx> {
 				}
 
 				FORCE_INLINE virtual boolean hasNext() {
-					return (m_next < m_map->m_size);
+					return (m_next < m_map->getSlotCount());
 				}
 
 				FORCE_INLINE virtual const K next() {
 					// TODO: throw NoSuchElementException when end is each (XXX: check will be a performance hit)
 					m_prev = m_next;
-					MapEntry<K,V,Ctx>* p = m_map->m_table[m_next++];
+					MapEntry<K,V,Ctx>* p = m_map->getSlot(m_next++);
 					moveNext();
 					return p->getKey();
 				}
 
 				FORCE_INLINE virtual void remove() {
-					// TODO: address cursor and resize
-					MapEntry<K,V,Ctx>* p = m_map->m_table[m_prev];
-					m_map->remove(p->getKey());
+					// XXX: cursor removes neither resize nor migrate, so slot indices stay put
+					MapEntry<K,V,Ctx>* p = m_map->getSlot(m_prev);
+					m_map->removeEntry(p->getKey(), null, null, false);
 					m_next = m_prev;
 					moveNext();
 				}
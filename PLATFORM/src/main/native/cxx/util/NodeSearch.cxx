@@ -0,0 +1,319 @@
+/**
+ *    Copyright (C) 2010 Deep Software Foundation
+ *
+ *    This program is free software: you can redistribute it and/or  modify
+ *    it under the terms of the GNU Affero General Public License, version 3,
+ *    as published by the Free Software Foundation.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU Affero General Public License for more details.
+ *
+ *    You should have received a copy of the GNU Affero General Public License
+ *    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *    As a special exception, the copyright holders give permission to link the
+ *    code of portions of this program with the OpenSSL library under certain
+ *    conditions as described in each individual source file and distribute
+ *    linked combinations including the program with the OpenSSL library. You
+ *    must comply with the GNU Affero General Public License in all respects for
+ *    all of the code used other than as permitted herein. If you modify file(s)
+ *    with this exception, you may extend this exception to your version of the
+ *    file(s), but you are not obligated to do so. If you do not wish to do so,
+ *    delete this exception statement from your version. If you delete this
+ *    exception statement from all source files in the program, then also delete
+ *    it in the license file.
+ */
+#ifndef CXX_UTIL_NODESEARCH_CXX_
+#define CXX_UTIL_NODESEARCH_CXX_
+
+#include "cxx/util/NodeSearch.h"
+
+#if defined(__x86_64__) || defined(__i386__)
+#define CXX_UTIL_NODESEARCH_X86
+#include <immintrin.h>
+#endif
+
+using namespace cxx::util;
+
+#define KEY_AT(T, base, stride, i) (*((const T*) (((const char*) (base)) + ((i) * (stride)))))
+
+// XXX: branch-free lower bound, used when no vector unit applies (and for vector tails)
+template<typename T>
+FORCE_INLINE static inttype rankScalar(const T* base, inttype stride, inttype count, const T what) {
+	if (count <= 0) {
+		return 0;
+	}
+
+	inttype low = 0;
+	while (count > 1) {
+		inttype half = count >> 1;
+		low = (KEY_AT(T, base, stride, low + half) < what) ? low + half : low;
+		count -= half;
+	}
+
+	return low + (KEY_AT(T, base, stride, low) < what);
+}
+
+// XXX: large (page sized) nodes are bisected down to a block of a few cache lines before the vector scan
+static const inttype SCAN_BYTES = 256;
+static const inttype SCAN_KEYS = 16;
+
+// XXX: returns the block offset, the rank lies within [offset, offset + *count] on return
+template<typename T>
+FORCE_INLINE static inttype narrow(const T* base, inttype stride, inttype* count, const T what) {
+	const inttype block = ((SCAN_BYTES / stride) < SCAN_KEYS) ? SCAN_KEYS : (SCAN_BYTES / stride);
+
+	inttype low = 0;
+	inttype remaining = *count;
+	while (remaining > block) {
+		inttype half = remaining >> 1;
+		if (KEY_AT(T, base, stride, low + half - 1) < what) {
+			low += half;
+			remaining -= half;
+
+		} else {
+			remaining = half;
+		}
+	}
+
+	*count = remaining;
+	return low;
+}
+
+#ifdef CXX_UTIL_NODESEARCH_X86
+FORCE_INLINE static boolean hasAvx2(void) {
+	return __builtin_cpu_supports("avx2");
+}
+
+__attribute__((target("avx2")))
+static inttype rankAvx2(const longtype* base, inttype stride, inttype count, const longtype what, const longtype flip) {
+	const __m256i key = _mm256_set1_epi64x(what ^ flip);
+	const __m256i bias = _mm256_set1_epi64x(flip);
+	const __m128i offsets = _mm_setr_epi32(0, stride, 2 * stride, 3 * stride);
+	const char* p = (const char*) base;
+
+	inttype i = 0;
+	for (; (i + 4) <= count; i += 4, p += 4 * stride) {
+		__m256i keys = (stride == sizeof(longtype)) ? _mm256_loadu_si256((const __m256i*) p) : _mm256_mask_i32gather_epi64(_mm256_setzero_si256(), (const long long*) p, offsets, _mm256_set1_epi64x(-1), 1);
+		inttype less = __builtin_popcount(_mm256_movemask_pd(_mm256_castsi256_pd(_mm256_cmpgt_epi64(key, _mm256_xor_si256(keys, bias)))));
+		if (less != 4) {
+			return i + less;
+		}
+	}
+
+	if (flip != 0) {
+		return i + rankScalar((const ulongtype*) p, stride, count - i, (ulongtype) what);
+	}
+
+	return i + rankScalar((const longtype*) p, stride, count - i, what);
+}
+
+__attribute__((target("avx2")))
+static inttype rankAvx2(const inttype* base, inttype stride, inttype count, const inttype what) {
+	const __m256i key = _mm256_set1_epi32(what);
+	const __m256i offsets = _mm256_setr_epi32(0, stride, 2 * stride, 3 * stride, 4 * stride, 5 * stride, 6 * stride, 7 * stride);
+	const char* p = (const char*) base;
+
+	inttype i = 0;
+	for (; (i + 8) <= count; i += 8, p += 8 * stride) {
+		__m256i keys = (stride == sizeof(inttype)) ? _mm256_loadu_si256((const __m256i*) p) : _mm256_mask_i32gather_epi32(_mm256_setzero_si256(), (const int*) p, offsets, _mm256_set1_epi32(-1), 1);
+		inttype less = __builtin_popcount(_mm256_movemask_ps(_mm256_castsi256_ps(_mm256_cmpgt_epi32(key, keys))));
+		if (less != 8) {
+			return i + less;
+		}
+	}
+
+	return i + rankScalar((const inttype*) p, stride, count - i, what);
+}
+
+__attribute__((target("avx2")))
+static inttype rankAvx2(const shorttype* base, inttype stride, inttype count, const shorttype what) {
+	const char* p = (const char*) base;
+
+	inttype i = 0;
+	if (stride == sizeof(shorttype)) {
+		const __m256i key = _mm256_set1_epi16(what);
+		for (; (i + 16) <= count; i += 16, p += 16 * stride) {
+			__m256i keys = _mm256_loadu_si256((const __m256i*) p);
+			inttype less = __builtin_popcount(_mm256_movemask_epi8(_mm256_cmpgt_epi16(key, keys))) >> 1;
+			if (less != 16) {
+				return i + less;
+			}
+		}
+
+	} else {
+		// XXX: gather 32 bits per key and sign extend the low 16 (strided items are at least 4 bytes)
+		const __m256i key = _mm256_set1_epi32(what);
+		const __m256i offsets = _mm256_setr_epi32(0, stride, 2 * stride, 3 * stride, 4 * stride, 5 * stride, 6 * stride, 7 * stride);
+		for (; (i + 8) <= count; i += 8, p += 8 * stride) {
+			__m256i keys = _mm256_mask_i32gather_epi32(_mm256_setzero_si256(), (const int*) p, offsets, _mm256_set1_epi32(-1), 1);
+			keys = _mm256_srai_epi32(_mm256_slli_epi32(keys, 16), 16);
+			inttype less = __builtin_popcount(_mm256_movemask_ps(_mm256_castsi256_ps(_mm256_cmpgt_epi32(key, keys))));
+			if (less != 8) {
+				return i + less;
+			}
+		}
+	}
+
+	return i + rankScalar((const shorttype*) p, stride, count - i, what);
+}
+
+__attribute__((target("avx2")))
+static inttype rankAvx2(const doubletype* base, inttype stride, inttype count, const doubletype what) {
+	const __m256d key = _mm256_set1_pd(what);
+	const __m128i offsets = _mm_setr_epi32(0, stride, 2 * stride, 3 * stride);
+	const char* p = (const char*) base;
+
+	inttype i = 0;
+	for (; (i + 4) <= count; i += 4, p += 4 * stride) {
+		__m256d keys = (stride == sizeof(doubletype)) ? _mm256_loadu_pd((const double*) p) : _mm256_mask_i32gather_pd(_mm256_setzero_pd(), (const double*) p, offsets, _mm256_castsi256_pd(_mm256_set1_epi64x(-1)), 1);
+		inttype less = __builtin_popcount(_mm256_movemask_pd(_mm256_cmp_pd(keys, key, _CMP_LT_OQ)));
+		if (less != 4) {
+			return i + less;
+		}
+	}
+
+	return i + rankScalar((const doubletype*) p, stride, count - i, what);
+}
+
+// XXX: SSE2 is baseline on x86-64, only contiguous keys with a native compare are handled
+static inttype rankSse2(const inttype* base, inttype count, const inttype what) {
+	const __m128i key = _mm_set1_epi32(what);
+
+	inttype i = 0;
+	for (; (i + 4) <= count; i += 4) {
+		__m128i keys = _mm_loadu_si128((const __m128i*) (base + i));
+		inttype less = __builtin_popcount(_mm_movemask_ps(_mm_castsi128_ps(_mm_cmpgt_epi32(key, keys))));
+		if (less != 4) {
+			return i + less;
+		}
+	}
+
+	return i + rankScalar(base + i, sizeof(inttype), count - i, what);
+}
+
+static inttype rankSse2(const shorttype* base, inttype count, const shorttype what) {
+	const __m128i key = _mm_set1_epi16(what);
+
+	inttype i = 0;
+	for (; (i + 8) <= count; i += 8) {
+		__m128i keys = _mm_loadu_si128((const __m128i*) (base + i));
+		inttype less = __builtin_popcount(_mm_movemask_epi8(_mm_cmpgt_epi16(key, keys))) >> 1;
+		if (less != 8) {
+			return i + less;
+		}
+	}
+
+	return i + rankScalar(base + i, sizeof(shorttype), count - i, what);
+}
+
+static inttype rankSse2(const doubletype* base, inttype count, const doubletype what) {
+	const __m128d key = _mm_set1_pd(what);
+
+	inttype i = 0;
+	for (; (i + 2) <= count; i += 2) {
+		__m128d keys = _mm_loadu_pd(base + i);
+		inttype less = __builtin_popcount(_mm_movemask_pd(_mm_cmplt_pd(keys, key)));
+		if (less != 2) {
+			return i + less;
+		}
+	}
+
+	return i + rankScalar(base + i, sizeof(doubletype), count - i, what);
+}
+#endif
+
+static inttype rankBlock(const longtype* base, inttype stride, inttype count, const longtype what) {
+	#ifdef CXX_UTIL_NODESEARCH_X86
+	if (hasAvx2() == true) {
+		return rankAvx2(base, stride, count, what, 0);
+	}
+	#endif
+
+	return rankScalar(base, stride, count, what);
+}
+
+static inttype rankBlock(const ulongtype* base, inttype stride, inttype count, const ulongtype what) {
+	#ifdef CXX_UTIL_NODESEARCH_X86
+	if (hasAvx2() == true) {
+		// XXX: flipping the sign bit maps unsigned order onto the signed compare
+		const longtype flip = (longtype) 0x8000000000000000ULL;
+		return rankAvx2((const longtype*) base, stride, count, (longtype) what, flip);
+	}
+	#endif
+
+	return rankScalar(base, stride, count, what);
+}
+
+static inttype rankBlock(const inttype* base, inttype stride, inttype count, const inttype what) {
+	#ifdef CXX_UTIL_NODESEARCH_X86
+	if (hasAvx2() == true) {
+		return rankAvx2(base, stride, count, what);
+
+	} else if (stride == sizeof(inttype)) {
+		return rankSse2(base, count, what);
+	}
+	#endif
+
+	return rankScalar(base, stride, count, what);
+}
+
+static inttype rankBlock(const shorttype* base, inttype stride, inttype count, const shorttype what) {
+	#ifdef CXX_UTIL_NODESEARCH_X86
+	if (hasAvx2() == true) {
+		return rankAvx2(base, stride, count, what);
+
+	} else if (stride == sizeof(shorttype)) {
+		return rankSse2(base, count, what);
+	}
+	#endif
+
+	return rankScalar(base, stride, count, what);
+}
+
+static inttype rankBlock(const doubletype* base, inttype stride, inttype count, const doubletype what) {
+	#ifdef CXX_UTIL_NODESEARCH_X86
+	if (hasAvx2() == true) {
+		return rankAvx2(base, stride, count, what);
+
+	} else if (stride == sizeof(doubletype)) {
+		return rankSse2(base, count, what);
+	}
+	#endif
+
+	return rankScalar(base, stride, count, what);
+}
+
+inttype NodeSearch<longtype, Comparator<longtype> >::rank(const longtype* base, inttype stride, inttype count, const longtype what) {
+	inttype low = narrow(base, stride, &count, what);
+
+	return low + rankBlock(&KEY_AT(longtype, base, stride, low), stride, count, what);
+}
+
+inttype NodeSearch<ulongtype, Comparator<ulongtype> >::rank(const ulongtype* base, inttype stride, inttype count, const ulongtype what) {
+	inttype low = narrow(base, stride, &count, what);
+
+	return low + rankBlock(&KEY_AT(ulongtype, base, stride, low), stride, count, what);
+}
+
+inttype NodeSearch<inttype, Comparator<inttype> >::rank(const inttype* base, inttype stride, inttype count, const inttype what) {
+	inttype low = narrow(base, stride, &count, what);
+
+	return low + rankBlock(&KEY_AT(inttype, base, stride, low), stride, count, what);
+}
+
+inttype NodeSearch<shorttype, Comparator<shorttype> >::rank(const shorttype* base, inttype stride, inttype count, const shorttype what) {
+	inttype low = narrow(base, stride, &count, what);
+
+	return low + rankBlock(&KEY_AT(shorttype, base, stride, low), stride, count, what);
+}
+
+inttype NodeSearch<doubletype, Comparator<doubletype> >::rank(const doubletype* base, inttype stride, inttype count, const doubletype what) {
+	inttype low = narrow(base, stride, &count, what);
+
+	return low + rankBlock(&KEY_AT(doubletype, base, stride, low), stride, count, what);
+}
+
+#endif /*CXX_UTIL_NODESEARCH_CXX_*/
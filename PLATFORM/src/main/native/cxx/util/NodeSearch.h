@@ -0,0 +1,97 @@
+/**
+ *    Copyright (C) 2010 Deep Software Foundation
+ *
+ *    This program is free software: you can redistribute it and/or  modify
+ *    it under the terms of the GNU Affero General Public License, version 3,
+ *    as published by the Free Software Foundation.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU Affero General Public License for more details.
+ *
+ *    You should have received a copy of the GNU Affero General Public License
+ *    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *    As a special exception, the copyright holders give permission to link the
+ *    code of portions of this program with the OpenSSL library under certain
+ *    conditions as described in each individual source file and distribute
+ *    linked combinations including the program with the OpenSSL library. You
+ *    must comply with the GNU Affero General Public License in all respects for
+ *    all of the code used other than as permitted herein. If you modify file(s)
+ *    with this exception, you may extend this exception to your version of the
+ *    file(s), but you are not obligated to do so. If you do not wish to do so,
+ *    delete this exception statement from your version. If you delete this
+ *    exception statement from all source files in the program, then also delete
+ *    it in the license file.
+ */
+#ifndef CXX_UTIL_NODESEARCH_H_
+#define CXX_UTIL_NODESEARCH_H_
+
+#include "cxx/lang/types.h"
+
+#include "cxx/util/Comparator.h"
+
+namespace cxx { namespace util {
+
+/**
+ * In-node key search for tree nodes. For primitive keys in natural order, rank() counts the keys
+ * less than the given key in one branch-free pass (AVX2 or SSE2 when the CPU supports them, scalar
+ * otherwise). Nodes wider than a few cache lines are first bisected down to such a block, so the
+ * vector pass stays short at page sized orders. Keys are read at base + (i * stride), so both contiguous key arrays and keys embedded
+ * in node items/entries are supported.
+ */
+template<typename K, typename Cmp = Comparator<K> >
+class NodeSearch {
+	public:
+		static const boolean VECTORIZED = false;
+
+		// XXX: not reached, callers check VECTORIZED first
+		FORCE_INLINE static inttype rank(const K* base, inttype stride, inttype count, const K what) {
+			return -1;
+		}
+};
+
+template<>
+class NodeSearch<longtype, Comparator<longtype> > {
+	public:
+		static const boolean VECTORIZED = true;
+
+		static inttype rank(const longtype* base, inttype stride, inttype count, const longtype what);
+};
+
+template<>
+class NodeSearch<ulongtype, Comparator<ulongtype> > {
+	public:
+		static const boolean VECTORIZED = true;
+
+		static inttype rank(const ulongtype* base, inttype stride, inttype count, const ulongtype what);
+};
+
+template<>
+class NodeSearch<inttype, Comparator<inttype> > {
+	public:
+		static const boolean VECTORIZED = true;
+
+		static inttype rank(const inttype* base, inttype stride, inttype count, const inttype what);
+};
+
+template<>
+class NodeSearch<shorttype, Comparator<shorttype> > {
+	public:
+		static const boolean VECTORIZED = true;
+
+		static inttype rank(const shorttype* base, inttype stride, inttype count, const shorttype what);
+};
+
+template<>
+class NodeSearch<doubletype, Comparator<doubletype> > {
+	public:
+		static const boolean VECTORIZED = true;
+
+		static inttype rank(const doubletype* base, inttype stride, inttype count, const doubletype what);
+};
+
+} } // namespace
+
+#endif /*CXX_UTIL_NODESEARCH_H_*/
@@ -0,0 +1,149 @@
+/**
+ *    Copyright (C) 2010 Deep Software Foundation
+ *
+ *    This program is free software: you can redistribute it and/or  modify
+ *    it under the terms of the GNU Affero General Public License, version 3,
+ *    as published by the Free Software Foundation.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU Affero General Public License for more details.
+ *
+ *    You should have received a copy of the GNU Affero General Public License
+ *    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *    As a special exception, the copyright holders give permission to link the
+ *    code of portions of this program with the OpenSSL library under certain
+ *    conditions as described in each individual source file and distribute
+ *    linked combinations including the program with the OpenSSL library. You
+ *    must comply with the GNU Affero General Public License in all respects for
+ *    all of the code used other than as permitted herein. If you modify file(s)
+ *    with this exception, you may extend this exception to your version of the
+ *    file(s), but you are not obligated to do so. If you do not wish to do so,
+ *    delete this exception statement from your version. If you delete this
+ *    exception statement from all source files in the program, then also delete
+ *    it in the license file.
+ */
+#ifndef CXX_UTIL_SLABPOOL_H_
+#define CXX_UTIL_SLABPOOL_H_
+
+#include <stdlib.h>
+
+#include "cxx/lang/types.h"
+
+namespace cxx { namespace util {
+
+/**
+ * Fixed-size block allocator. Blocks are carved out of large slabs and recycled through an
+ * intrusive free list; clear() hands every slab back to the heap at once (O(slabs)), without
+ * visiting the blocks. Not thread safe, owners are expected to serialize access.
+ */
+class SlabPool {
+
+	private:
+		static const uinttype SLAB_SIZE = 64 * 1024;
+		static const uinttype MINIMUM_BLOCKS = 16;
+		static const uinttype ALIGNMENT = 16;
+
+		void* m_slabs;
+		void* m_free;
+		char* m_cursor;
+		char* m_limit;
+		uinttype m_blockSize;
+		uinttype m_slabSize;
+		uinttype m_blocks;
+		uinttype m_slabCount;
+
+		void grow(void) {
+			// XXX: first word of each slab links to the previous slab
+			char* slab = (char*) malloc(m_slabSize);
+			*((void**) slab) = m_slabs;
+			m_slabs = slab;
+			m_slabCount++;
+
+			m_cursor = slab + ALIGNMENT;
+			m_limit = slab + m_slabSize;
+		}
+
+	public:
+		SlabPool(uinttype blockSize):
+			m_slabs(null),
+			m_free(null),
+			m_cursor(null),
+			m_limit(null),
+			m_blocks(0),
+			m_slabCount(0) {
+
+			if (blockSize < sizeof(void*)) {
+				blockSize = sizeof(void*);
+			}
+
+			m_blockSize = (blockSize + (ALIGNMENT - 1)) & ~(ALIGNMENT - 1);
+
+			uinttype count = SLAB_SIZE / m_blockSize;
+			if (count < MINIMUM_BLOCKS) {
+				count = MINIMUM_BLOCKS;
+			}
+
+			m_slabSize = ALIGNMENT + (count * m_blockSize);
+		}
+
+		~SlabPool(void) {
+			clear();
+		}
+
+		FORCE_INLINE void* allocate(void) {
+			void* block = m_free;
+			if (block != null) {
+				m_free = *((void**) block);
+
+			} else {
+				if ((m_cursor + m_blockSize) > m_limit) {
+					grow();
+				}
+
+				block = m_cursor;
+				m_cursor += m_blockSize;
+			}
+
+			m_blocks++;
+			return block;
+		}
+
+		FORCE_INLINE void release(void* block) {
+			*((void**) block) = m_free;
+			m_free = block;
+			m_blocks--;
+		}
+
+		void clear(void) {
+			while (m_slabs != null) {
+				void* slab = m_slabs;
+				m_slabs = *((void**) slab);
+				free(slab);
+			}
+
+			m_free = null;
+			m_cursor = null;
+			m_limit = null;
+			m_blocks = 0;
+			m_slabCount = 0;
+		}
+
+		FORCE_INLINE uinttype getBlockSize(void) const {
+			return m_blockSize;
+		}
+
+		FORCE_INLINE uinttype getBlocks(void) const {
+			return m_blocks;
+		}
+
+		FORCE_INLINE uinttype getSlabs(void) const {
+			return m_slabCount;
+		}
+};
+
+} } // namespace
+
+#endif /*CXX_UTIL_SLABPOOL_H_*/
@@ -0,0 +1,526 @@
+/**
+ *    Copyright (C) 2010 Deep Software Foundation
+ *
+ *    This program is free software: you can redistribute it and/or  modify
+ *    it under the terms of the GNU Affero General Public License, version 3,
+ *    as published by the Free Software Foundation.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU Affero General Public License for more details.
+ *
+ *    You should have received a copy of the GNU Affero General Public License
+ *    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *    As a special exception, the copyright holders give permission to link the
+ *    code of portions of this program with the OpenSSL library under certain
+ *    conditions as described in each individual source file and distribute
+ *    linked combinations including the program with the OpenSSL library. You
+ *    must comply with the GNU Affero General Public License in all respects for
+ *    all of the code used other than as permitted herein. If you modify file(s)
+ *    with this exception, you may extend this exception to your version of the
+ *    file(s), but you are not obligated to do so. If you do not wish to do so,
+ *    delete this exception statement from your version. If you delete this
+ *    exception statement from all source files in the program, then also delete
+ *    it in the license file.
+ */
+#ifndef CXX_UTIL_SORTEDRUN_H_
+#define CXX_UTIL_SORTEDRUN_H_
+
+#include <fcntl.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+#include <type_traits>
+
+#include "cxx/lang/nbyte.h"
+
+#include "cxx/io/IOException.h"
+#include "cxx/io/RandomAccessFile.h"
+
+#include "cxx/util/CardinalitySketch.h"
+#include "cxx/util/Comparator.h"
+#include "cxx/util/Converter.h"
+#include "cxx/util/MapEntry.h"
+
+using namespace cxx::io;
+
+namespace cxx { namespace util {
+
+/**
+ * Layout of an immutable on-disk sorted run of fixed width keys and values:
+ *
+ *   [header][block 0] .. [block n - 1][sparse index][bloom filter]
+ *
+ * Records are key bytes then value bytes, ascending by key and BLOCK_ENTRIES to a block. The sparse index holds
+ * the first key of every block and the optional bloom filter answers most misses without touching a block.
+ * Byte order is the writer's, runs are meant to be read back on the host that wrote them.
+ */
+struct SortedRunHeader {
+	static const inttype VERSION = 1;
+	static const inttype BLOCK_ENTRIES = 128;
+	static const inttype BLOOM_BITS_PER_KEY = 10;
+
+	bytetype m_magic[8];
+	inttype m_version;
+	inttype m_keySize;
+	inttype m_valueSize;
+	inttype m_blockEntries;
+	longtype m_count;
+	longtype m_blockCount;
+	longtype m_indexOffset;
+	longtype m_bloomOffset;
+	longtype m_bloomBits;
+	inttype m_bloomHashes;
+	inttype m_reserved;
+
+	FORCE_INLINE static const char* magic(void) {
+		return "DEEPRUN";
+	}
+
+	// XXX: both bloom probes derive from one 64-bit hash (double hashing)
+	FORCE_INLINE static ulongtype hash(const bytearray key, inttype size) {
+		return CardinalitySketch::mix(CardinalitySketch::hash(key, size));
+	}
+
+	FORCE_INLINE static ulongtype probe(ulongtype hash, inttype i, longtype bits) {
+		return (((hash & 0xffffffffULL) + (i * ((hash >> 32) | 1))) % bits);
+	}
+};
+
+/**
+ * Streams ascending entries into a sorted run: records are buffered one block at a time, the sparse index and
+ * bloom filter are written after the last block and the header goes in last. Everything before the header is
+ * synced before it is written and the header is synced after, so a run with a valid header was written
+ * completely.
+ */
+template<typename K, typename V>
+class SortedRunWriter {
+
+	static_assert(std::is_trivially_copyable<K>::value && !std::is_pointer<K>::value, "Sorted run keys are stored by value, they must be trivially copyable and not pointers");
+	static_assert(std::is_trivially_copyable<V>::value && !std::is_pointer<V>::value, "Sorted run values are stored by value, they must be trivially copyable and not pointers");
+
+	private:
+		static const inttype RECORD = sizeof(K) + sizeof(V);
+
+		RandomAccessFile m_file;
+		SortedRunHeader m_header;
+
+		nbyte m_block;
+		inttype m_blockFill;
+
+		nbyte* m_index;
+		nbyte* m_bloom;
+
+		longtype m_expected;
+
+		FORCE_INLINE void flushBlock(void) {
+			if (m_blockFill != 0) {
+				m_file.write(&m_block, 0, m_blockFill * RECORD);
+				m_blockFill = 0;
+			}
+		}
+
+		class Appender {
+			private:
+				SortedRunWriter<K,V>* m_writer;
+
+			public:
+				Appender(SortedRunWriter<K,V>* writer):
+					m_writer(writer) {
+				}
+
+				template<typename Ctx>
+				FORCE_INLINE boolean operator()(const MapEntry<K,V,Ctx>* entry) {
+					m_writer->append(entry->getKey(), entry->getValue());
+					return true;
+				}
+		};
+
+	public:
+		// XXX: expected sizes the index and bloom filter, appending more entries than expected throws
+		SortedRunWriter(const char* path, longtype expected, boolean bloom = true, inttype blockEntries = SortedRunHeader::BLOCK_ENTRIES):
+			m_file(path, "rw"),
+			m_block(blockEntries * RECORD),
+			m_blockFill(0),
+			m_index(null),
+			m_bloom(null),
+			m_expected(expected) {
+
+			memset(&m_header, 0, sizeof(m_header));
+			memcpy(m_header.m_magic, SortedRunHeader::magic(), sizeof(m_header.m_magic));
+			m_header.m_version = SortedRunHeader::VERSION;
+			m_header.m_keySize = sizeof(K);
+			m_header.m_valueSize = sizeof(V);
+			m_header.m_blockEntries = blockEntries;
+
+			longtype blocks = (expected + blockEntries - 1) / blockEntries;
+			m_index = new nbyte((inttype) (((blocks > 0) ? blocks : 1) * sizeof(K)));
+
+			if ((bloom == true) && (expected > 0)) {
+				m_header.m_bloomBits = expected * SortedRunHeader::BLOOM_BITS_PER_KEY;
+				// XXX: ln(2) * bits per key, the false positive optimum
+				m_header.m_bloomHashes = (SortedRunHeader::BLOOM_BITS_PER_KEY * 69) / 100;
+
+				m_bloom = new nbyte((inttype) ((m_header.m_bloomBits + 7) / 8));
+				m_bloom->zero();
+			}
+
+			// XXX: placeholder until finish() knows the offsets, a crashed write leaves no valid magic behind
+			nbyte header(sizeof(SortedRunHeader));
+			header.zero();
+			m_file.setLength(0);
+			m_file.seek(0);
+			m_file.write(&header, 0, header.length);
+		}
+
+		virtual ~SortedRunWriter() {
+			delete m_index;
+			delete m_bloom;
+
+			m_file.close();
+		}
+
+		FORCE_INLINE longtype size(void) const {
+			return m_header.m_count;
+		}
+
+		void append(const K key, const V value) {
+			if (m_header.m_count == m_expected) {
+				throw new IOException("Sorted run exceeds expected size");
+			}
+
+			bytearray record = ((bytearray) m_block) + (m_blockFill * RECORD);
+			memcpy(record, &key, sizeof(K));
+			memcpy(record + sizeof(K), &value, sizeof(V));
+
+			if (m_blockFill == 0) {
+				memcpy(((bytearray) *m_index) + (m_header.m_blockCount * sizeof(K)), &key, sizeof(K));
+				m_header.m_blockCount++;
+			}
+
+			if (m_bloom != null) {
+				ulongtype hash = SortedRunHeader::hash((bytearray) &key, sizeof(K));
+				for (inttype i = 0; i < m_header.m_bloomHashes; i++) {
+					ulongtype bit = SortedRunHeader::probe(hash, i, m_header.m_bloomBits);
+					((bytearray) *m_bloom)[bit >> 3] |= (1 << (bit & 7));
+				}
+			}
+
+			m_header.m_count++;
+
+			if (++m_blockFill == m_header.m_blockEntries) {
+				flushBlock();
+			}
+		}
+
+		// XXX: streams a whole sorted map (e.g. TreeMap) through its forEachInRange, no entry copies on the heap
+		template<typename M>
+		void append(M* map) {
+			Appender appender(this);
+			map->forEachInRange(Converter<K>::NULL_VALUE, true, Converter<K>::NULL_VALUE, true, appender);
+		}
+
+		void finish(void) {
+			flushBlock();
+
+			m_header.m_indexOffset = m_file.getFilePointer();
+			m_file.write(m_index, 0, (inttype) (m_header.m_blockCount * sizeof(K)));
+
+			m_header.m_bloomOffset = m_file.getFilePointer();
+			if (m_bloom != null) {
+				m_file.write(m_bloom, 0, m_bloom->length);
+			}
+
+			// XXX: blocks, index and bloom filter must be durable before the header can vouch for them
+			m_file.getFD()->sync();
+
+			nbyte header((bytearray) &m_header, sizeof(SortedRunHeader));
+			m_file.seek(0);
+			m_file.write(&header, 0, header.length);
+			m_file.getFD()->sync();
+
+			m_file.seek(m_file.length());
+		}
+};
+
+/**
+ * Serves lookups straight from a memory mapped sorted run, nothing is deserialized onto the heap: the sparse
+ * index is binary searched in place, then the one block it names. Opening costs a header check and an mmap
+ * regardless of run size, pages are faulted in by the searches that need them.
+ */
+template<typename K, typename V, typename Cmp = Comparator<K> >
+class SortedRunReader {
+
+	static_assert(std::is_trivially_copyable<K>::value && !std::is_pointer<K>::value, "Sorted run keys are stored by value, they must be trivially copyable and not pointers");
+	static_assert(std::is_trivially_copyable<V>::value && !std::is_pointer<V>::value, "Sorted run values are stored by value, they must be trivially copyable and not pointers");
+
+	private:
+		static const inttype RECORD = sizeof(K) + sizeof(V);
+
+		const Cmp* m_comparator;
+		inttype m_fd;
+		bytearray m_base;
+		longtype m_length;
+
+		SortedRunHeader m_header;
+		bytearray m_records;
+		bytearray m_index;
+		bytearray m_bloom;
+
+		FORCE_INLINE K keyAt(longtype index) const {
+			K key;
+			memcpy(&key, m_records + (index * RECORD), sizeof(K));
+			return key;
+		}
+
+		FORCE_INLINE V valueAt(longtype index) const {
+			V value;
+			memcpy(&value, m_records + (index * RECORD) + sizeof(K), sizeof(V));
+			return value;
+		}
+
+		FORCE_INLINE K blockKey(longtype block) const {
+			K key;
+			memcpy(&key, m_index + (block * sizeof(K)), sizeof(K));
+			return key;
+		}
+
+		// XXX: position of the first record not below key, m_count when there is none
+		longtype ceilingIndex(const K key) const {
+			// XXX: last block whose first key is not above key
+			longtype low = 0;
+			longtype high = m_header.m_blockCount - 1;
+			while (low <= high) {
+				longtype mid = (low + high) >> 1;
+				if (m_comparator->compare(blockKey(mid), key) <= 0) {
+					low = mid + 1;
+
+				} else {
+					high = mid - 1;
+				}
+			}
+
+			if (high < 0) {
+				return 0;
+			}
+
+			longtype start = high * m_header.m_blockEntries;
+			longtype finish = start + m_header.m_blockEntries;
+			if (finish > m_header.m_count) {
+				finish = m_header.m_count;
+			}
+
+			// XXX: falling off the block lands on the first record of the next one
+			while (start < finish) {
+				longtype mid = (start + finish) >> 1;
+				if (m_comparator->compare(keyAt(mid), key) < 0) {
+					start = mid + 1;
+
+				} else {
+					finish = mid;
+				}
+			}
+
+			return start;
+		}
+
+		FORCE_INLINE longtype findIndex(const K key) const {
+			if (mightContain(key) == false) {
+				return -1;
+			}
+
+			longtype index = ceilingIndex(key);
+			if ((index < m_header.m_count) && (m_comparator->compare(keyAt(index), key) == 0)) {
+				return index;
+			}
+
+			return -1;
+		}
+
+		// XXX: every offset and count is checked against the file before anything is mapped, each section must fit
+		// XXX: between the previous one and the end of the file (records, then index, then bloom filter)
+		FORCE_INLINE static boolean valid(const SortedRunHeader& header, longtype length) {
+			if ((memcmp(header.m_magic, SortedRunHeader::magic(), sizeof(header.m_magic)) != 0) ||
+				(header.m_version != SortedRunHeader::VERSION) ||
+				(header.m_keySize != sizeof(K)) || (header.m_valueSize != sizeof(V)) ||
+				(header.m_blockEntries <= 0) || (header.m_count < 0) || (header.m_bloomBits < 0) || (header.m_bloomHashes < 0)) {
+
+				return false;
+			}
+
+			const longtype records = length - (longtype) sizeof(SortedRunHeader);
+			if (header.m_count > (records / RECORD)) {
+				return false;
+			}
+
+			if (header.m_blockCount != ((header.m_count + header.m_blockEntries - 1) / header.m_blockEntries)) {
+				return false;
+			}
+
+			const longtype indexOffset = (longtype) sizeof(SortedRunHeader) + (header.m_count * RECORD);
+			if ((header.m_indexOffset < indexOffset) || (header.m_indexOffset > length)) {
+				return false;
+			}
+
+			const longtype bloomOffset = header.m_indexOffset + (header.m_blockCount * (longtype) sizeof(K));
+			if ((header.m_bloomOffset < bloomOffset) || (header.m_bloomOffset > length)) {
+				return false;
+			}
+
+			return (((header.m_bloomBits + 7) / 8) <= (length - header.m_bloomOffset));
+		}
+
+		void unmap(void) {
+			if (m_base != null) {
+				munmap(m_base, m_length);
+				m_base = null;
+			}
+
+			if (m_fd != -1) {
+				::close(m_fd);
+				m_fd = -1;
+			}
+		}
+
+	public:
+		SortedRunReader(const char* path, const Cmp* comparator):
+			m_comparator(comparator),
+			m_fd(-1),
+			m_base(null),
+			m_length(0),
+			m_records(null),
+			m_index(null),
+			m_bloom(null) {
+
+			m_fd = ::open(path, O_RDONLY);
+			if (m_fd == -1) {
+				throw new IOException("Sorted run failed to open");
+			}
+
+			struct stat st;
+			if ((fstat(m_fd, &st) != 0) || (st.st_size < (off_t) sizeof(SortedRunHeader))) {
+				unmap();
+				throw new IOException("Sorted run truncated");
+			}
+
+			m_length = st.st_size;
+			if ((::pread(m_fd, &m_header, sizeof(SortedRunHeader), 0) != (ssize_t) sizeof(SortedRunHeader)) || (valid(m_header, m_length) == false)) {
+				unmap();
+				throw new IOException("Sorted run header invalid");
+			}
+
+			m_base = (bytearray) mmap(null, m_length, PROT_READ, MAP_SHARED, m_fd, 0);
+			if (m_base == (bytearray) MAP_FAILED) {
+				m_base = null;
+				unmap();
+				throw new IOException("Sorted run failed to map");
+			}
+
+			m_records = m_base + sizeof(SortedRunHeader);
+			m_index = m_base + m_header.m_indexOffset;
+			m_bloom = (m_header.m_bloomBits != 0) ? m_base + m_header.m_bloomOffset : null;
+
+			// XXX: searches hop between the index and one block, read ahead would mostly be wasted
+			madvise(m_base, m_length, MADV_RANDOM);
+		}
+
+		virtual ~SortedRunReader() {
+			unmap();
+		}
+
+		FORCE_INLINE longtype size(void) const {
+			return m_header.m_count;
+		}
+
+		FORCE_INLINE boolean isEmpty(void) const {
+			return (m_header.m_count == 0);
+		}
+
+		FORCE_INLINE longtype getBlockCount(void) const {
+			return m_header.m_blockCount;
+		}
+
+		// XXX: false means absent, true means present or a bloom false positive (always true for a non-empty run without one)
+		FORCE_INLINE boolean mightContain(const K key) const {
+			if (m_bloom == null) {
+				return (m_header.m_count != 0);
+			}
+
+			ulongtype hash = SortedRunHeader::hash((bytearray) &key, sizeof(K));
+			for (inttype i = 0; i < m_header.m_bloomHashes; i++) {
+				ulongtype bit = SortedRunHeader::probe(hash, i, m_header.m_bloomBits);
+				if ((m_bloom[bit >> 3] & (1 << (bit & 7))) == 0) {
+					return false;
+				}
+			}
+
+			return true;
+		}
+
+		FORCE_INLINE boolean containsKey(const K key) const {
+			return (findIndex(key) != -1);
+		}
+
+		V get(const K key, boolean* status = null) const {
+			longtype index = findIndex(key);
+			if (status != null) {
+				*status = (index != -1);
+			}
+
+			return (index != -1) ? valueAt(index) : (V) Converter<V>::NULL_VALUE;
+		}
+
+		K ceilingKey(const K key, boolean* status = null) const {
+			longtype index = ceilingIndex(key);
+			if (status != null) {
+				*status = (index < m_header.m_count);
+			}
+
+			return (index < m_header.m_count) ? keyAt(index) : (K) Converter<K>::NULL_VALUE;
+		}
+
+		K firstKey(boolean* status = null) const {
+			if (status != null) {
+				*status = (m_header.m_count != 0);
+			}
+
+			return (m_header.m_count != 0) ? keyAt(0) : (K) Converter<K>::NULL_VALUE;
+		}
+
+		K lastKey(boolean* status = null) const {
+			if (status != null) {
+				*status = (m_header.m_count != 0);
+			}
+
+			return (m_header.m_count != 0) ? keyAt(m_header.m_count - 1) : (K) Converter<K>::NULL_VALUE;
+		}
+
+		// XXX: visits [fromKey, toKey) in order as visitor(key, value) until it returns false
+		template<typename F>
+		FORCE_INLINE longtype forEachInRange(const K fromKey, const K toKey, F&& visitor) const {
+			return forEachInRange(fromKey, false, toKey, false, visitor);
+		}
+
+		// XXX: an open side runs to that end of the run and its key is not read
+		template<typename F>
+		longtype forEachInRange(const K fromKey, boolean fromOpen, const K toKey, boolean toOpen, F&& visitor) const {
+			longtype start = (fromOpen == false) ? ceilingIndex(fromKey) : 0;
+			longtype finish = (toOpen == false) ? ceilingIndex(toKey) : m_header.m_count;
+
+			for (longtype i = start; i < finish; i++) {
+				if (visitor(keyAt(i), valueAt(i)) == false) {
+					return i - start + 1;
+				}
+			}
+
+			return (finish > start) ? (finish - start) : 0;
+		}
+};
+
+} } // namespace
+
+#endif /*CXX_UTIL_SORTEDRUN_H_*/
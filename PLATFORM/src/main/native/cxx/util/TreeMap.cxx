@@ -31,28 +31,34 @@
 #include <stdio.h>
 
 #include "cxx/util/TreeMap.h"
+#include "cxx/util/TreeSpill.h"
+#include "cxx/lang/Memory.h"
 #include "cxx/lang/UnsupportedOperationException.h"
 
 using namespace cxx::util;
 
-template<typename K, typename V, typename Ctx>
-const bytetype TreeMap<K,V,Ctx>::INITIAL_ORDER = 3;
+template<typename K, typename V, typename Ctx, typename Pol>
+const bytetype TreeMap<K,V,Ctx,Pol>::INITIAL_ORDER = 3;
 
-template<typename K, typename V, typename Ctx>
-const Comparator<K> TreeMap<K,V,Ctx>::COMPARATOR;
+// XXX: leaves hold 2 * (order + 1) entries, which must stay within the shorttype node indexes
+template<typename K, typename V, typename Ctx, typename Pol>
+const inttype TreeMap<K,V,Ctx,Pol>::MAXIMUM_ORDER = 4095;
 
-template<typename K, typename V, typename Ctx>
-TreeMap<K,V,Ctx>::TreeMap(bytetype order, boolean delkey, boolean delval) :
-	m_comparator(&TreeMap<K,V,Ctx>::COMPARATOR) {
+template<typename K, typename V, typename Ctx, typename Pol>
+const Comparator<K> TreeMap<K,V,Ctx,Pol>::COMPARATOR;
+
+template<typename K, typename V, typename Ctx, typename Pol>
+TreeMap<K,V,Ctx,Pol>::TreeMap(inttype order, boolean delkey, boolean delval) :
+	m_comparator(&TreeMap<K,V,Ctx,Pol>::COMPARATOR) {
 
 	initialize(order, delkey, delval);
 }
 
-template<typename K, typename V, typename Ctx>
+template<typename K, typename V, typename Ctx, typename Pol>
 #ifdef COM_DEEPIS_DB_CARDINALITY
-TreeMap<K,V,Ctx>::TreeMap(const Comparator<K>* comparator, bytetype order, boolean delkey, boolean delval, bytetype keyParts) :
+TreeMap<K,V,Ctx,Pol>::TreeMap(const Comparator<K>* comparator, inttype order, boolean delkey, boolean delval, bytetype keyParts) :
 #else
-TreeMap<K,V,Ctx>::TreeMap(const Comparator<K>* comparator, bytetype order, boolean delkey, boolean delval) :
+TreeMap<K,V,Ctx,Pol>::TreeMap(const Comparator<K>* comparator, inttype order, boolean delkey, boolean delval) :
 #endif
 	m_comparator(comparator) {
 
@@ -63,27 +69,79 @@ TreeMap<K,V,Ctx>::TreeMap(const Comparator<K>* comparator, bytetype order, boole
 	#endif
 }
 
-template<typename K, typename V, typename Ctx>
-TreeMap<K,V,Ctx>::~TreeMap() {
+template<typename K, typename V, typename Ctx, typename Pol>
+TreeMap<K,V,Ctx,Pol>::~TreeMap() {
+	if (m_frozen == true) {
+		// XXX: a generation only drops its hold on the nodes, the slabs belong to the live map or its lineage
+		if (m_root != null) {
+			destroySubtree(m_root, false, false);
+			m_root = null;
+		}
+
+		m_lineage = null;
+		m_nodePool = null;
+		m_entryPool = null;
+
+	} else if (m_lineage != null) {
+		reclaim();
+
+		// XXX: generations outlive the map, they take the slabs their nodes were carved from
+		if (m_lineage != null) {
+			if (m_root != null) {
+				destroySubtree(m_root, false, false);
+				m_root = null;
+			}
+
+			Lineage* lineage = m_lineage;
+			m_lineage = null;
+
+			lineage->m_nodePool = m_nodePool;
+			lineage->m_entryPool = m_entryPool;
+			m_nodePool = null;
+			m_entryPool = null;
+
+			leave(lineage);
+		}
+	}
+
 	clear();
 
+	if (m_spill != null) {
+		delete m_spill;
+	}
+
+	if (m_nodePool != null) {
+		delete m_nodePool;
+	}
+
+	if (m_entryPool != null) {
+		delete m_entryPool;
+	}
+
 	#ifdef COM_DEEPIS_DB_CARDINALITY
 	if (m_cardinality != null) {
 		free(m_cardinality);
 	}
+
+	if (m_sketch != null) {
+		delete [] m_sketch;
+	}
 	#endif
 }
 
-template<typename K, typename V, typename Ctx>
+template<typename K, typename V, typename Ctx, typename Pol>
 #ifdef COM_DEEPIS_DB_CARDINALITY
-void TreeMap<K,V,Ctx>::initialize(bytetype order, boolean delkey, boolean delval, bytetype keyParts) {
+void TreeMap<K,V,Ctx,Pol>::initialize(inttype order, boolean delkey, boolean delval, bytetype keyParts) {
 #else
-void TreeMap<K,V,Ctx>::initialize(bytetype order, boolean delkey, boolean delval) {
+void TreeMap<K,V,Ctx,Pol>::initialize(inttype order, boolean delkey, boolean delval) {
 #endif
 	m_ctx = Converter<Ctx>::NULL_VALUE;
 
 	if (order < INITIAL_ORDER) {
 		order = INITIAL_ORDER;
+
+	} else if (order > MAXIMUM_ORDER) {
+		order = MAXIMUM_ORDER;
 	}
 
 	m_branchMaxIndex = order;
@@ -97,6 +155,23 @@ void TreeMap<K,V,Ctx>::initialize(bytetype order, boolean delkey, boolean delval
 	m_modification = 0;
 	#endif
 	m_root = null;
+	m_shared = null;
+	m_lineage = null;
+	m_frozen = false;
+	m_spill = null;
+	m_clock = null;
+
+	if (Pol::POOLED_NODES == true) {
+		uinttype leafSize = sizeof(Leaf) + ((m_leafMaxIndex + 1) * sizeof(Slot));
+		uinttype branchSize = sizeof(Branch) + ((m_branchMaxIndex + 1) * sizeof(Item));
+
+		m_nodePool = new SlabPool((leafSize > branchSize) ? leafSize : branchSize);
+		m_entryPool = (Pol::INLINE_ENTRIES == false) ? new SlabPool(sizeof(MapEntry<K,V,Ctx>)) : null;
+
+	} else {
+		m_nodePool = null;
+		m_entryPool = null;
+	}
 
 	m_stateFlags = 0;
 
@@ -113,33 +188,37 @@ void TreeMap<K,V,Ctx>::initialize(bytetype order, boolean delkey, boolean delval
 		m_cardinality = (inttype*) malloc(m_keyParts * sizeof(inttype));
 		memset(m_cardinality, 0, m_keyParts * sizeof(inttype));
 	}
+
+	m_sketch = null;
 	#endif
 }
 
-template<typename K, typename V, typename Ctx>
-void TreeMap<K,V,Ctx>::notifyRootFull(void) {
+template<typename K, typename V, typename Ctx, typename Pol>
+void TreeMap<K,V,Ctx,Pol>::notifyRootFull(void) {
 	Node* oldroot = m_root;
-	m_root = new Branch(this, null, oldroot);
+	m_root = createBranch(null, oldroot);
 	oldroot->split(this);
+
+	((Branch*) m_root)->recount();
 }
 
-template<typename K, typename V, typename Ctx>
-void TreeMap<K,V,Ctx>::notifyRootEmpty(void) {
+template<typename K, typename V, typename Ctx, typename Pol>
+void TreeMap<K,V,Ctx,Pol>::notifyRootEmpty(void) {
 	if (m_root->isLeaf() == true) {
 		Leaf* root = (Leaf*) m_root;
 		m_root = null;
-		delete root;
+		destroyNode(root);
 
 	} else {
 		Branch* root = (Branch*) m_root;
 		m_root = root->getNode(0);
 		m_root->m_parent = null;
-		delete root;
+		destroyNode(root);
 	}
 }
 
-template<typename K, typename V, typename Ctx>
-const K TreeMap<K,V,Ctx>::firstKey(boolean* status) const {
+template<typename K, typename V, typename Ctx, typename Pol>
+const K TreeMap<K,V,Ctx,Pol>::firstKey(boolean* status) const {
 	const MapEntry<K,V,Ctx>* x = firstEntry();
 
 	if (status != null) {
@@ -149,8 +228,8 @@ const K TreeMap<K,V,Ctx>::firstKey(boolean* status) const {
 	return (x ? x->getKey() : Map<K,V,Ctx>::NULL_KEY);
 }
 
-template<typename K, typename V, typename Ctx>
-const K TreeMap<K,V,Ctx>::lastKey(boolean* status) const {
+template<typename K, typename V, typename Ctx, typename Pol>
+const K TreeMap<K,V,Ctx,Pol>::lastKey(boolean* status) const {
 	const MapEntry<K,V,Ctx>* x = lastEntry();
 
 	if (status != null) {
@@ -160,8 +239,8 @@ const K TreeMap<K,V,Ctx>::lastKey(boolean* status) const {
 	return (x ? x->getKey() : Map<K,V,Ctx>::NULL_KEY);
 }
 
-template<typename K, typename V, typename Ctx>
-const K TreeMap<K,V,Ctx>::lowerKey(const K key, boolean* status) const {
+template<typename K, typename V, typename Ctx, typename Pol>
+const K TreeMap<K,V,Ctx,Pol>::lowerKey(const K key, boolean* status) const {
 	const MapEntry<K,V,Ctx>* x = lowerEntry(key);
 
 	if (status != null) {
@@ -171,8 +250,8 @@ const K TreeMap<K,V,Ctx>::lowerKey(const K key, boolean* status) const {
 	return (x ? x->getKey() : Map<K,V,Ctx>::NULL_KEY);
 }
 
-template<typename K, typename V, typename Ctx>
-const K TreeMap<K,V,Ctx>::higherKey(const K key, boolean* status) const {
+template<typename K, typename V, typename Ctx, typename Pol>
+const K TreeMap<K,V,Ctx,Pol>::higherKey(const K key, boolean* status) const {
 	const MapEntry<K,V,Ctx>* x = higherEntry(key);
 
 	if (status != null) {
@@ -182,8 +261,8 @@ const K TreeMap<K,V,Ctx>::higherKey(const K key, boolean* status) const {
 	return (x ? x->getKey() : Map<K,V,Ctx>::NULL_KEY);
 }
 
-template<typename K, typename V, typename Ctx>
-const K TreeMap<K,V,Ctx>::floorKey(const K key, boolean* status) const {
+template<typename K, typename V, typename Ctx, typename Pol>
+const K TreeMap<K,V,Ctx,Pol>::floorKey(const K key, boolean* status) const {
 	const MapEntry<K,V,Ctx>* x = floorEntry(key);
 
 	if (status != null) {
@@ -193,8 +272,8 @@ const K TreeMap<K,V,Ctx>::floorKey(const K key, boolean* status) const {
 	return (x ? x->getKey() : Map<K,V,Ctx>::NULL_KEY);
 }
 
-template<typename K, typename V, typename Ctx>
-const K TreeMap<K,V,Ctx>::ceilingKey(const K key, boolean* status) const {
+template<typename K, typename V, typename Ctx, typename Pol>
+const K TreeMap<K,V,Ctx,Pol>::ceilingKey(const K key, boolean* status) const {
 	const MapEntry<K,V,Ctx>* x = ceilingEntry(key);
 
 	if (status != null) {
@@ -204,8 +283,8 @@ const K TreeMap<K,V,Ctx>::ceilingKey(const K key, boolean* status) const {
 	return (x ? x->getKey() : Map<K,V,Ctx>::NULL_KEY);
 }
 
-template<typename K, typename V, typename Ctx>
-const MapEntry<K,V,Ctx>* TreeMap<K,V,Ctx>::firstEntry(void) const {
+template<typename K, typename V, typename Ctx, typename Pol>
+const MapEntry<K,V,Ctx>* TreeMap<K,V,Ctx,Pol>::firstEntry(void) const {
 	if (m_root != null) {
 		return m_root->firstLeaf()->getObject(0);
 
@@ -214,8 +293,8 @@ const MapEntry<K,V,Ctx>* TreeMap<K,V,Ctx>::firstEntry(void) const {
 	}
 }
 
-template<typename K, typename V, typename Ctx>
-const MapEntry<K,V,Ctx>* TreeMap<K,V,Ctx>::lastEntry(void) const {
+template<typename K, typename V, typename Ctx, typename Pol>
+const MapEntry<K,V,Ctx>* TreeMap<K,V,Ctx,Pol>::lastEntry(void) const {
 	if (m_root != null) {
 		Node* node = m_root->lastLeaf();
 		return ((Leaf*) node)->getObject(node->m_lastIndex);
@@ -225,8 +304,8 @@ const MapEntry<K,V,Ctx>* TreeMap<K,V,Ctx>::lastEntry(void) const {
 	}
 }
 
-template<typename K, typename V, typename Ctx>
-const MapEntry<K,V,Ctx>* TreeMap<K,V,Ctx>::getEntry(const K key) const {
+template<typename K, typename V, typename Ctx, typename Pol>
+const MapEntry<K,V,Ctx>* TreeMap<K,V,Ctx,Pol>::getEntry(const K key) const {
 	if (m_root != null) {
 		Node* n;
 		inttype index;
@@ -237,8 +316,8 @@ const MapEntry<K,V,Ctx>* TreeMap<K,V,Ctx>::getEntry(const K key) const {
 	}
 }
 
-template<typename K, typename V, typename Ctx>
-const MapEntry<K,V,Ctx>* TreeMap<K,V,Ctx>::lowerEntry(const K key) const {
+template<typename K, typename V, typename Ctx, typename Pol>
+const MapEntry<K,V,Ctx>* TreeMap<K,V,Ctx,Pol>::lowerEntry(const K key) const {
 	if (m_root != null) {
 		Node* n;
 		inttype index;
@@ -250,8 +329,8 @@ const MapEntry<K,V,Ctx>* TreeMap<K,V,Ctx>::lowerEntry(const K key) const {
 	}
 }
 
-template<typename K, typename V, typename Ctx>
-const MapEntry<K,V,Ctx>* TreeMap<K,V,Ctx>::higherEntry(const K key) const {
+template<typename K, typename V, typename Ctx, typename Pol>
+const MapEntry<K,V,Ctx>* TreeMap<K,V,Ctx,Pol>::higherEntry(const K key) const {
 	if (m_root != null) {
 		Node* n;
 		inttype index;
@@ -263,8 +342,8 @@ const MapEntry<K,V,Ctx>* TreeMap<K,V,Ctx>::higherEntry(const K key) const {
 	}
 }
 
-template<typename K, typename V, typename Ctx>
-const MapEntry<K,V,Ctx>* TreeMap<K,V,Ctx>::floorEntry(const K key) const {
+template<typename K, typename V, typename Ctx, typename Pol>
+const MapEntry<K,V,Ctx>* TreeMap<K,V,Ctx,Pol>::floorEntry(const K key) const {
 	if (m_root != null) {
 		Node* n;
 		inttype index;
@@ -283,8 +362,8 @@ const MapEntry<K,V,Ctx>* TreeMap<K,V,Ctx>::floorEntry(const K key) const {
 	}
 }
 
-template<typename K, typename V, typename Ctx>
-const MapEntry<K,V,Ctx>* TreeMap<K,V,Ctx>::ceilingEntry(const K key) const {
+template<typename K, typename V, typename Ctx, typename Pol>
+const MapEntry<K,V,Ctx>* TreeMap<K,V,Ctx,Pol>::ceilingEntry(const K key) const {
 	if (m_root != null) {
 		Node* n;
 		inttype index;
@@ -303,123 +382,167 @@ const MapEntry<K,V,Ctx>* TreeMap<K,V,Ctx>::ceilingEntry(const K key) const {
 	}
 }
 
-template<typename K, typename V, typename Ctx>
-const MapEntry<K,V,Ctx>* TreeMap<K,V,Ctx>::nextEntry(Node* node, inttype index, Node** block, inttype* location) {
-	const MapEntry<K,V,Ctx>* entry = node->nextEntry(index, block, location);
-	if (entry == null) {
-		while (node->m_parent != null) {
-			inttype nextIndex = node->m_parent->instanceIndex(node) + 1;
-			entry = node->m_parent->getEntry(nextIndex);
-			if (entry != null) {
-				*block = node->m_parent;
-				*location = nextIndex;
-				break;
+template<typename K, typename V, typename Ctx, typename Pol>
+const MapEntry<K,V,Ctx>* TreeMap<K,V,Ctx,Pol>::nextEntry(Node* node, inttype index, Node** block, inttype* location) {
+	if (node->isLeaf() == true) {
+		Leaf* leaf = (Leaf*) node;
+		if (index < leaf->m_lastIndex) {
+			*block = leaf;
+			*location = index + 1;
+			return leaf->getObject(index + 1);
+		}
+
+		// XXX: chain links belong to the live map, a generation looks the next entry up from its root
+		if (m_frozen == true) {
+			MapEntry<K,V,Ctx>* prev = null;
+			const MapEntry<K,V,Ctx>* x = m_root->higher(this, leaf->getObject(leaf->m_lastIndex)->getKey(), block, location, &prev);
+			if (x == null) {
+				*block = null;
+				*location = -1;
 			}
 
-			node = node->m_parent;
+			return x;
 		}
-	}
 
-	return entry;
-}
+		Leaf* next = leaf->m_next;
+		if (next == null) {
+			*block = null;
+			*location = -1;
+			return null;
+		}
 
-template<typename K, typename V, typename Ctx>
-const MapEntry<K,V,Ctx>* TreeMap<K,V,Ctx>::previousEntry(Node* node, inttype index, Node** block, inttype* location) {
-	const MapEntry<K,V,Ctx>* entry = node->previousEntry(index, block, location);
-	if (entry == null) {
-		while (node->m_parent != null) {
-			inttype previousIndex = node->m_parent->instanceIndex(node);
-			entry = node->m_parent->getEntry(previousIndex);
-			if (entry != null) {
-				*block = node->m_parent;
-				*location = previousIndex;
-				break;
-			}
+		// XXX: the separator is consumed before the next leaf, pull that leaf in while the caller works on it
+		next->prefetch();
+
+		Branch* parent = separator(leaf, next, location);
+		*block = parent;
+		return parent->getObject(*location);
+	}
 
-			node = node->m_parent;
+	const MapEntry<K,V,Ctx>* entry = node->nextEntry(index, block, location);
+	if ((entry != null) && (m_frozen == false)) {
+		Leaf* next = ((Leaf*) *block)->m_next;
+		if (next != null) {
+			next->prefetch();
 		}
 	}
 
 	return entry;
 }
 
-template<typename K, typename V, typename Ctx>
-const boolean TreeMap<K,V,Ctx>::hasNextEntry(Node* node, inttype index) {
-	boolean hasNext = false;
-
-	if (node != null) {
-		inttype location;
-		Node* block;
-		const MapEntry<K,V,Ctx>* entry = node->nextEntry(index, &block, &location);
-		if (entry == null) {
-			while (node->m_parent != null) {
-				inttype nextIndex = node->m_parent->instanceIndex(node) + 1;
-				entry = node->m_parent->getEntry(nextIndex);
-				if (entry != null) {
-					hasNext = true;
-					break;
-				}
+template<typename K, typename V, typename Ctx, typename Pol>
+const MapEntry<K,V,Ctx>* TreeMap<K,V,Ctx,Pol>::previousEntry(Node* node, inttype index, Node** block, inttype* location) {
+	if (node->isLeaf() == true) {
+		Leaf* leaf = (Leaf*) node;
+		if (index > 0) {
+			*block = leaf;
+			*location = index - 1;
+			return leaf->getObject(index - 1);
+		}
 
-				node = node->m_parent;
+		if (m_frozen == true) {
+			MapEntry<K,V,Ctx>* next = null;
+			const MapEntry<K,V,Ctx>* x = m_root->lower(this, leaf->getObject(0)->getKey(), block, location, &next);
+			if (x == null) {
+				*block = null;
+				*location = -1;
 			}
 
-		} else {
-			hasNext = true;
+			return x;
+		}
+
+		Leaf* previous = leaf->m_prev;
+		if (previous == null) {
+			*block = null;
+			*location = -1;
+			return null;
+		}
+
+		previous->prefetch();
+
+		Branch* parent = separator(previous, leaf, location);
+		*block = parent;
+		return parent->getObject(*location);
+	}
+
+	const MapEntry<K,V,Ctx>* entry = node->previousEntry(index, block, location);
+	if ((entry != null) && (m_frozen == false)) {
+		Leaf* previous = ((Leaf*) *block)->m_prev;
+		if (previous != null) {
+			previous->prefetch();
 		}
 	}
 
-	return hasNext;
+	return entry;
 }
 
-template<typename K, typename V, typename Ctx>
-const boolean TreeMap<K,V,Ctx>::hasPreviousEntry(Node* node, inttype index) {
-	boolean hasPrevious = false;
+template<typename K, typename V, typename Ctx, typename Pol>
+const boolean TreeMap<K,V,Ctx,Pol>::hasNextEntry(Node* node, inttype index) {
+	if (node == null) {
+		return false;
 
-	if (node != null) {
-		inttype location;
-		Node* block;
-		const MapEntry<K,V,Ctx>* entry = node->previousEntry(index, &block, &location);
-		if (entry == null) {
-			while (node->m_parent != null) {
-				inttype previousIndex = node->m_parent->instanceIndex(node);
-				entry = node->m_parent->getEntry(previousIndex);
-				if (entry != null) {
-					hasPrevious = true;
-					break;
-				}
+	} else if (node->isLeaf() == true) {
+		if (m_frozen == true) {
+			return (index < node->m_lastIndex) || (node != m_root->lastLeaf());
+		}
 
-				node = node->m_parent;
-			}
+		return (index < node->m_lastIndex) || (((Leaf*) node)->m_next != null);
 
-		} else {
-			hasPrevious = true;
-		}
+	} else {
+		return (index <= node->m_lastIndex);
 	}
+}
+
+template<typename K, typename V, typename Ctx, typename Pol>
+const boolean TreeMap<K,V,Ctx,Pol>::hasPreviousEntry(Node* node, inttype index) {
+	if (node == null) {
+		return false;
+
+	} else if (node->isLeaf() == true) {
+		if (m_frozen == true) {
+			return (index > 0) || (node != m_root->firstLeaf());
+		}
+
+		return (index > 0) || (((Leaf*) node)->m_prev != null);
 
-	return hasPrevious;
+	} else {
+		return (index > 0);
+	}
 }
 
 #ifdef COM_DEEPIS_DB_INDEX_REF
-template<typename K, typename V, typename Ctx>
-void TreeMap<K,V,Ctx>::add(K key, V val, MapEntry<K,V,Ctx>** retentry) {
-	MapEntry<K,V,Ctx>* p = new MapEntry<K,V,Ctx>(key, val, getMapContext());
+template<typename K, typename V, typename Ctx, typename Pol>
+void TreeMap<K,V,Ctx,Pol>::add(K key, V val, MapEntry<K,V,Ctx>** retentry) {
+	unshare();
+
+	if ((m_lineage != null) && (m_root != null)) {
+		own(m_root->lastLeaf());
+	}
+	checkSpill();
+
+	Slot p = Entries::create(key, val, getMapContext(), m_entryPool);
 	if (m_root != null) {
 		Node* node = m_root->lastLeaf();
 
 		#ifdef COM_DEEPIS_DB_CARDINALITY
 		inttype pos = 0;
-		if (getCardinalityEnabled() == true) {
+		if ((getCardinalityEnabled() == true) && (m_sketch == null)) {
 			const MapEntry<K,V,Ctx>* x = node->getEntry(node->m_lastIndex);
 			m_comparator->compare(key, x->getKey(), &pos);
 		}
 		#endif
 
-		node->insert(this, p, node->m_lastIndex + 1, true);
+		inttype index = node->m_lastIndex + 1;
+		node->insert(this, p, index, true);
+
+		if (retentry != null) {
+			*retentry = insertedEntry(key, p, node, index);
+		}
 
 		#ifdef COM_DEEPIS_DB_CARDINALITY
 		if (getCardinalityEnabled() == true) {
 			if (m_cardinality != null) {
-				m_cardinality[pos]++;
+				countCardinality(key, pos);
 
 				#ifdef COM_DEEPIS_DB_CARDINALITY_VERIFY
 				Node* nnn;
@@ -436,13 +559,17 @@ void TreeMap<K,V,Ctx>::add(K key, V val, MapEntry<K,V,Ctx>** retentry) {
 		#endif
 
 	} else {
-		m_root = new Leaf(this, null, p);
+		m_root = createLeaf(null, &p);
 		incrementEntries();
 
+		if (retentry != null) {
+			*retentry = insertedEntry(key, p, m_root, 0);
+		}
+
 		#ifdef COM_DEEPIS_DB_CARDINALITY
 		if (getCardinalityEnabled() == true) {
 			if (m_cardinality != null) {
-				m_cardinality[0]++;
+				countCardinality(key, 0);
 
 				#ifdef COM_DEEPIS_DB_CARDINALITY_VERIFY
 				verifyCardinality();
@@ -451,13 +578,13 @@ void TreeMap<K,V,Ctx>::add(K key, V val, MapEntry<K,V,Ctx>** retentry) {
 		}
 		#endif
 	}
-	if (retentry != null) {
-		*retentry = p;
-	}
 }
 
-template<typename K, typename V, typename Ctx>
-V TreeMap<K,V,Ctx>::add(K key, V val, K* retkey, boolean* last, boolean replace, MapEntry<K,V,Ctx>** retentry) {
+template<typename K, typename V, typename Ctx, typename Pol>
+V TreeMap<K,V,Ctx,Pol>::add(K key, V val, K* retkey, boolean* last, boolean replace, MapEntry<K,V,Ctx>** retentry) {
+	unshare(key);
+	checkSpill();
+
 	V retval = Map<K,V,Ctx>::NULL_VALUE;
 
 	if (m_root != null) {
@@ -483,17 +610,17 @@ V TreeMap<K,V,Ctx>::add(K key, V val, K* retkey, boolean* last, boolean replace,
 			}
 
 		} else {
-			MapEntry<K,V,Ctx>* p = new MapEntry<K,V,Ctx>(key, val, getMapContext());
+			Slot p = Entries::create(key, val, getMapContext(), m_entryPool);
 			n->insert(this, p, index, *last);
 
 			if (retentry != null) {
-				*retentry = p;
+				*retentry = insertedEntry(key, p, n, index);
 			}
 
 			#ifdef COM_DEEPIS_DB_CARDINALITY
 			if (getCardinalityEnabled() == true) {
 				if (m_cardinality != null) {
-					m_cardinality[pos]++;
+					countCardinality(key, pos);
 
 					#ifdef COM_DEEPIS_DB_CARDINALITY_VERIFY
 					Node* nnn;
@@ -513,18 +640,18 @@ V TreeMap<K,V,Ctx>::add(K key, V val, K* retkey, boolean* last, boolean replace,
 		}
 
 	} else {
-		MapEntry<K,V,Ctx>* p = new MapEntry<K,V,Ctx>(key, val, getMapContext());
-		m_root = new Leaf(this, null, p);
+		Slot p = Entries::create(key, val, getMapContext(), m_entryPool);
+		m_root = createLeaf(null, &p);
 		incrementEntries();
 
 		if (retentry != null) {
-			*retentry = p;
+			*retentry = insertedEntry(key, p, m_root, 0);
 		}
 
 		#ifdef COM_DEEPIS_DB_CARDINALITY
 		if (getCardinalityEnabled() == true) {
 			if (m_cardinality != null) {
-				m_cardinality[0]++;
+				countCardinality(key, 0);
 
 				#ifdef COM_DEEPIS_DB_CARDINALITY_VERIFY
 				verifyCardinality();
@@ -545,8 +672,11 @@ V TreeMap<K,V,Ctx>::add(K key, V val, K* retkey, boolean* last, boolean replace,
 }
 #endif
 
-template<typename K, typename V, typename Ctx>
-V TreeMap<K,V,Ctx>::put(K key, V val, K* retkey, boolean* status, MapEntry<K,V,Ctx>** retentry) {
+template<typename K, typename V, typename Ctx, typename Pol>
+V TreeMap<K,V,Ctx,Pol>::putEntry(K key, V val, K* retkey, boolean* status, MapEntry<K,V,Ctx>** retentry, Node** block, inttype* location) {
+	unshare(key);
+	checkSpill();
+
 	V retval = Map<K,V,Ctx>::NULL_VALUE;
 
 	if (m_root != null) {
@@ -579,26 +709,39 @@ V TreeMap<K,V,Ctx>::put(K key, V val, K* retkey, boolean* status, MapEntry<K,V,C
 				*retentry = x;
 			}
 
+			if (block != null) {
+				*block = (n->isLeaf() == true) ? n : null;
+				*location = index;
+			}
+
 			#ifdef COM_DEEPIS_DB_INDEX_REF
 			m_modification++;
 			#endif
 
 		} else {
-			MapEntry<K,V,Ctx>* p = new MapEntry<K,V,Ctx>(key, val, getMapContext());
+			inttype last = n->m_lastIndex;
+
+			Slot p = Entries::create(key, val, getMapContext(), m_entryPool);
 			n->insert(this, p, index, false);
 
 			if (status != null) {
 				*status = false;
 			}
 
+			// XXX: a split moves entries between nodes, report no position rather than search for it
+			if (block != null) {
+				*block = (n->m_lastIndex == (last + 1)) ? n : null;
+				*location = index;
+			}
+
 			if (retentry != null) {
-				*retentry = p;
+				*retentry = insertedEntry(key, p, n, index);
 			}
 
 			#ifdef COM_DEEPIS_DB_CARDINALITY
 			if (getCardinalityEnabled() == true) {
 				if (m_cardinality != null) {
-					m_cardinality[pos]++;
+					countCardinality(key, pos);
 
 					#ifdef COM_DEEPIS_DB_CARDINALITY_VERIFY
 					Node* nnn;
@@ -616,22 +759,27 @@ V TreeMap<K,V,Ctx>::put(K key, V val, K* retkey, boolean* status, MapEntry<K,V,C
 		}
 
 	} else {
-		MapEntry<K,V,Ctx>* p = new MapEntry<K,V,Ctx>(key, val, getMapContext());
-		m_root = new Leaf(this, null, p);
+		Slot p = Entries::create(key, val, getMapContext(), m_entryPool);
+		m_root = createLeaf(null, &p);
 		incrementEntries();
 
 		if (status != null) {
 			*status = false;
 		}
 
+		if (block != null) {
+			*block = m_root;
+			*location = 0;
+		}
+
 		if (retentry != null) {
-			*retentry = p;
+			*retentry = insertedEntry(key, p, m_root, 0);
 		}
 
 		#ifdef COM_DEEPIS_DB_CARDINALITY
 		if (getCardinalityEnabled() == true) {
 			if (m_cardinality != null) {
-				m_cardinality[0]++;
+				countCardinality(key, 0);
 
 				#ifdef COM_DEEPIS_DB_CARDINALITY_VERIFY
 				verifyCardinality();
@@ -644,15 +792,122 @@ V TreeMap<K,V,Ctx>::put(K key, V val, K* retkey, boolean* status, MapEntry<K,V,C
 	return retval;
 }
 
-template<typename K, typename V, typename Ctx>
-void TreeMap<K,V,Ctx>::putAll(const Map<K,V,Ctx>* map, Map<K,V,Ctx>* fillmap) {
+#ifdef COM_DEEPIS_DB_INDEX_REF
+template<typename K, typename V, typename Ctx, typename Pol>
+V TreeMap<K,V,Ctx,Pol>::put(Hint* hint, K key, V val, boolean* status) {
+	unshare(key);
+	checkSpill();
+
+	// XXX: a stale hint may name a released node, only touch it once the stamp proves the map is unchanged
+	if ((hint->m_modification == m_modification) && (hint->m_node != null) && (getPositionedInsert() == true)) {
+		Leaf* leaf = (Leaf*) hint->m_node;
+		boolean exists = false;
+		inttype index = probeHint(leaf, hint->m_index, key, &exists);
+		if (index != -1) {
+			V retval = Map<K,V,Ctx>::NULL_VALUE;
+
+			if (exists == true) {
+				MapEntry<K,V,Ctx>* x = leaf->getObject(index);
+				retval = x->getValue();
+
+				if ((getDeleteKey() == true) && (key != x->getKey())) {
+					Converter<K>::destroy(x->getKey());
+				}
+
+				x->setKey(key, getMapContext());
+				x->setValue(val, getMapContext());
+
+				m_modification++;
+
+			} else {
+				inttype last = leaf->m_lastIndex;
+				insertAt(leaf, index, key, val, (index > last) && (leaf->m_next == null));
+
+				// XXX: after a split the next hinted put descends once and settles again
+				if (leaf->m_lastIndex != (last + 1)) {
+					hint->m_node = null;
+				}
+			}
+
+			if (status != null) {
+				*status = exists;
+			}
+
+			hint->m_index = index;
+			hint->m_modification = m_modification;
+
+			return retval;
+		}
+	}
+
+	V retval = putEntry(key, val, null, status, null, &hint->m_node, &hint->m_index);
+	hint->m_modification = m_modification;
+
+	return retval;
+}
+#endif
+
+template<typename K, typename V, typename Ctx, typename Pol>
+void TreeMap<K,V,Ctx,Pol>::insertAt(Leaf* leaf, inttype index, K key, V val, boolean sequential) {
+	Slot p = Entries::create(key, val, getMapContext(), m_entryPool);
+	leaf->insert(this, p, index, sequential);
+
+	#ifdef COM_DEEPIS_DB_CARDINALITY
+	// XXX: only reached without exact counts (see getPositionedInsert), sketches ignore the position
+	if ((getCardinalityEnabled() == true) && (m_cardinality != null)) {
+		countCardinality(key, 0);
+	}
+	#endif
+}
+
+template<typename K, typename V, typename Ctx, typename Pol>
+inttype TreeMap<K,V,Ctx,Pol>::probeHint(Leaf* leaf, inttype index, const K key, boolean* exists) const {
+	inttype weight = m_comparator->compare(leaf->getObject(index)->getKey(), key);
+	if (weight == 0) {
+		*exists = true;
+		return index;
+	}
+
+	// XXX: between two entries of one leaf is always the right spot, its edges border separators held above it
+	if (weight < 0) {
+		if (index < leaf->m_lastIndex) {
+			weight = m_comparator->compare(leaf->getObject(index + 1)->getKey(), key);
+			*exists = (weight == 0);
+			return (weight >= 0) ? (index + 1) : -1;
+		}
+
+		return (leaf->m_next == null) ? (index + 1) : -1;
+	}
+
+	if (index > 0) {
+		weight = m_comparator->compare(leaf->getObject(index - 1)->getKey(), key);
+		if (weight == 0) {
+			*exists = true;
+			return index - 1;
+		}
+
+		return (weight < 0) ? index : -1;
+	}
+
+	return (leaf->m_prev == null) ? 0 : -1;
+}
+
+template<typename K, typename V, typename Ctx, typename Pol>
+void TreeMap<K,V,Ctx,Pol>::putAll(const Map<K,V,Ctx>* map, Map<K,V,Ctx>* fillmap) {
 	EntrySet<> set(true);
 	// TODO: check type
-	((TreeMap<K,V,Ctx>*) map)->entrySet(&set);
+	((TreeMap<K,V,Ctx,Pol>*) map)->entrySet(&set);
 
 	K retkey = Map<K,V,Ctx>::NULL_KEY;
 	boolean status;
 	Iterator<MapEntry<K,V,Ctx>* >* iter = set.iterator();
+
+	// XXX: nothing can be replaced in an empty tree, build it bottom-up instead
+	if (m_root == null) {
+		bulkLoad(iter);
+		return;
+	}
+
 	while (iter->hasNext()) {
 		MapEntry<K,V,Ctx>* entry = (MapEntry<K,V,Ctx>*) iter->next();
 		if (fillmap != null) {
@@ -667,165 +922,1669 @@ void TreeMap<K,V,Ctx>::putAll(const Map<K,V,Ctx>* map, Map<K,V,Ctx>* fillmap) {
 	}
 }
 
-template<typename K, typename V, typename Ctx>
-V TreeMap<K,V,Ctx>::remove(const K key, K* retkey, boolean* status) {
-	if (m_root != null) {
-		V val = Map<K,V,Ctx>::NULL_VALUE;
-
-		Node* n;
-		inttype index;
-		const MapEntry<K,V,Ctx>* x = m_root->find(this, key, &n, &index);
-		if (x != null) {
-			val = x->getValue();
+template<typename K, typename V, typename Ctx, typename Pol>
+void TreeMap<K,V,Ctx,Pol>::bulkLoad(const K* keys, const V* vals, inttype count, doubletype fillFactor) {
+	unshare();
 
-			#ifdef COM_DEEPIS_DB_CARDINALITY
-			if (getCardinalityEnabled() == true) {
-				if (m_cardinality != null) {
-					m_cardinality[getCardinalityPosition(key, n, index)]--;
-				}
-			}
-			#endif
+	inttype i = 0;
 
-			n->remove(this, index);
-
-			#ifdef COM_DEEPIS_DB_CARDINALITY_VERIFY
-			if (getCardinalityEnabled() == true) {
-				verifyCardinality();
-			}
-			#endif
+	if (m_root == null) {
+		BulkState state;
+		bulkBegin(state, fillFactor);
 
-			if (size() == 0) {
-				clear();
+		for (; i < count; i++) {
+			if (bulkAppend(state, keys[i], vals[i]) == false) {
+				break;
 			}
+		}
 
-			if (status != null) {
-				*status = true;
-			}
+		bulkEnd(state);
+	}
 
-			K key = (K)Converter<K>::NULL_VALUE;
-			if ((retkey != null) || (getDeleteKey() == true)) {
-				key = x->getKey();
-			}
+	for (; i < count; i++) {
+		put(keys[i], vals[i]);
+	}
+}
 
-			Converter<MapEntry<K,V,Ctx>*>::destroy(const_cast<MapEntry<K,V,Ctx>*>(x), getMapContext());
+template<typename K, typename V, typename Ctx, typename Pol>
+void TreeMap<K,V,Ctx,Pol>::bulkLoad(Iterator<MapEntry<K,V,Ctx>*>* iter, doubletype fillFactor) {
+	unshare();
 
-			if (retkey != null) {
-				*retkey = key;
+	if (m_root == null) {
+		BulkState state;
+		bulkBegin(state, fillFactor);
 
-			} else if (getDeleteKey() == true) {
-				Converter<K>::destroy(key);
-			}
+		while (iter->hasNext()) {
+			MapEntry<K,V,Ctx>* entry = iter->next();
+			if (bulkAppend(state, entry->getKey(), entry->getValue()) == false) {
+				bulkEnd(state);
 
-		} else {
-			if (status != null) {
-				*status = false;
+				put(entry->getKey(), entry->getValue());
+				break;
 			}
 		}
 
-		return val;
-
-	} else {
-		if (status != null) {
-			*status = false;
-		}
+		bulkEnd(state);
+	}
 
-		return Map<K,V,Ctx>::NULL_VALUE;
+	while (iter->hasNext()) {
+		MapEntry<K,V,Ctx>* entry = iter->next();
+		put(entry->getKey(), entry->getValue());
 	}
 }
 
-template<typename K, typename V, typename Ctx>
-const V TreeMap<K,V,Ctx>::get(const K key, K* retkey, boolean* status) const {
-	if (m_root != null) {
-		V val = Map<K,V,Ctx>::NULL_VALUE;
+template<typename K, typename V, typename Ctx, typename Pol>
+inttype TreeMap<K,V,Ctx,Pol>::putBatch(const K* keys, const V* vals, inttype count, V* retvals) {
+	if (count <= 0) {
+		return 0;
+	}
 
-		Node* n;
-		inttype index;
-		const MapEntry<K,V,Ctx>* x = m_root->find(this, key, &n, &index);
-		if (x != null) {
-			val = x->getValue();
+	unshare();
+	checkSpill();
 
-			if (status != null) {
-				*status = true;
+	inttype* order = (inttype*) malloc(count * 2 * sizeof(inttype));
+	sortBatch(keys, order, order + count, count);
+
+	// XXX: a run of equal keys collapses to its last, each earlier one replaced by its successor as repeated puts would
+	inttype* first = order + count;
+	inttype unique = 0;
+	for (inttype i = 0; i < count; i++) {
+		if ((unique > 0) && (m_comparator->compare(keys[order[unique - 1]], keys[order[i]]) == 0)) {
+			inttype previous = order[unique - 1];
+			if (retvals != null) {
+				retvals[order[i]] = vals[previous];
 			}
 
-			if (retkey != null) {
-				*retkey = x->getKey();
+			if ((getDeleteKey() == true) && (keys[previous] != keys[order[i]])) {
+				Converter<K>::destroy(keys[previous]);
 			}
 
+			order[unique - 1] = order[i];
+
 		} else {
-			if (status != null) {
-				*status = false;
-			}
+			first[unique] = order[i];
+			order[unique++] = order[i];
 		}
+	}
 
-		return val;
+	inttype added = 0;
 
-	} else {
-		if (status != null) {
-			*status = false;
-		}
+	if (m_root == null) {
+		BulkState state;
+		bulkBegin(state, 1.0);
 
-		return Map<K,V,Ctx>::NULL_VALUE;
-	}
-}
+		for (inttype u = 0; u < unique; u++) {
+			bulkAppend(state, keys[order[u]], vals[order[u]]);
 
-template<typename K, typename V, typename Ctx>
-boolean TreeMap<K,V,Ctx>::containsKey(const K key) const {
-	if (m_root != null) {
-		Node* n;
-		inttype index;
-		const MapEntry<K,V,Ctx>* x = m_root->find(this, key, &n, &index);
-		return (x != null);
+			if (retvals != null) {
+				retvals[first[u]] = Map<K,V,Ctx>::NULL_VALUE;
+			}
+		}
 
-	} else {
-		return false;
+		bulkEnd(state);
+
+		free(order);
+		return unique;
 	}
-}
 
-template<typename K, typename V, typename Ctx>
-boolean TreeMap<K,V,Ctx>::containsValue(const V val) const {
-	// TODO
-	return false;
-}
+	Slot* slots = (Slot*) malloc((m_leafMaxIndex + 1) * sizeof(Slot));
+	inttype* indexes = (inttype*) malloc((m_leafMaxIndex + 1) * sizeof(inttype));
 
-template<typename K, typename V, typename Ctx>
-void TreeMap<K,V,Ctx>::clear(boolean delkey, boolean delval) {
+	inttype u = 0;
+	while (u < unique) {
+		K key = keys[order[u]];
 
-	if (m_root != null) {
-		typename EntrySet<MapEntry<K,V,Ctx>*>::EntrySetIterator iter(this);
-		while (iter.EntrySet<MapEntry<K,V,Ctx>*>::EntrySetIterator::hasNext()) {
-			MapEntry<K,V,Ctx>* x = iter.EntrySet<MapEntry<K,V,Ctx>*>::EntrySetIterator::next();
+		if (m_lineage != null) {
+			ownPath(key);
+		}
 
-			K key = (K)Converter<K>::NULL_VALUE;
-			V value = (V)Converter<V>::NULL_VALUE;
-			if (delkey == true) {
-				key = x->getKey();
-			}
-			if (delval == true) {
-				value = x->getValue();
+		Node* n;
+		inttype index;
+		MapEntry<K,V,Ctx>* x = (MapEntry<K,V,Ctx>*) m_root->find(this, key, &n, &index);
+		if (x != null) {
+			V old = replaceEntry(x, key, vals[order[u]], keys[first[u]]);
+			if (retvals != null) {
+				retvals[first[u]] = old;
 			}
 
-			Converter<MapEntry<K,V,Ctx>*>::destroy(x, getMapContext());
+			u++;
 
-			if (delkey == true) {
-				Converter<K>::destroy(key);
+			// XXX: separators sit above the leaves, the next key descends again
+			if (n->isLeaf() == false) {
+				continue;
 			}
 
-			if (delval == true) {
-				Converter<V>::destroy(value);
-			}
+			index++;
 		}
 
-		#ifdef COM_DEEPIS_DB_INDEX_REF
-		m_modification++;
+		// XXX: a key lies in this leaf while an entry of it follows; the leaf edge only belongs to the first key, found by the descent
+		Leaf* leaf = (Leaf*) n;
+		inttype last = leaf->m_lastIndex;
+		inttype room = m_leafMaxIndex - last;
+		inttype gathered = 0;
+		boolean edge = (x == null);
 
-		if (getVirtualSizeEnabled() == true) {
-			m_vEntries = 0;
-		}
+		for (; u < unique; u++, edge = false) {
+			key = keys[order[u]];
+
+			while ((index <= last) && (m_comparator->compare(leaf->getObject(index)->getKey(), key) < 0)) {
+				index++;
+			}
+
+			if (index <= last) {
+				x = leaf->getObject(index);
+				if (m_comparator->compare(x->getKey(), key) == 0) {
+					V old = replaceEntry(x, key, vals[order[u]], keys[first[u]]);
+					if (retvals != null) {
+						retvals[first[u]] = old;
+					}
+
+					index++;
+					continue;
+				}
+
+			} else if ((edge == false) && (leaf->m_next != null)) {
+				break;
+			}
+
+			// XXX: filled up to the brim, the split (or balance) this triggers happens once for the whole group
+			if (gathered == room) {
+				break;
+			}
+
+			#ifdef COM_DEEPIS_DB_CARDINALITY
+			if ((getCardinalityEnabled() == true) && (m_cardinality != null)) {
+				const K* previous = ((gathered > 0) && (indexes[gathered - 1] == index)) ? &keys[order[u - 1]] : null;
+				countCardinality(key, (m_sketch == null) ? insertPosition(leaf, index, key, previous) : 0);
+			}
+			#endif
+
+			slots[gathered] = Entries::create(key, vals[order[u]], getMapContext(), m_entryPool);
+			indexes[gathered++] = index;
+
+			if (retvals != null) {
+				retvals[first[u]] = Map<K,V,Ctx>::NULL_VALUE;
+			}
+		}
+
+		if (gathered > 0) {
+			leaf->insert(this, slots, indexes, gathered, (leaf->m_next == null) && (indexes[gathered - 1] > last));
+			added += gathered;
+		}
+
+		#ifdef COM_DEEPIS_DB_CARDINALITY_VERIFY
+		if (getCardinalityEnabled() == true) {
+			verifyCardinality();
+		}
+		#endif
+	}
+
+	free(indexes);
+	free(slots);
+	free(order);
+
+	return added;
+}
+
+template<typename K, typename V, typename Ctx, typename Pol>
+void TreeMap<K,V,Ctx,Pol>::sortBatch(const K* keys, inttype* order, inttype* scratch, inttype count) const {
+	boolean sorted = true;
+	for (inttype i = 0; i < count; i++) {
+		order[i] = i;
+
+		if ((i > 0) && (sorted == true) && (m_comparator->compare(keys[i - 1], keys[i]) > 0)) {
+			sorted = false;
+		}
+	}
+
+	if (sorted == true) {
+		return;
+	}
+
+	// XXX: bottom up and stable, equal keys keep their batch order so the last one wins
+	inttype* source = order;
+	inttype* target = scratch;
+	for (inttype width = 1; width < count; width <<= 1) {
+		for (inttype lo = 0; lo < count; lo += (width << 1)) {
+			inttype mid = ((lo + width) < count) ? (lo + width) : count;
+			inttype hi = ((lo + (width << 1)) < count) ? (lo + (width << 1)) : count;
+
+			inttype l = lo;
+			inttype r = mid;
+			for (inttype i = lo; i < hi; i++) {
+				if ((l < mid) && ((r >= hi) || (m_comparator->compare(keys[source[l]], keys[source[r]]) <= 0))) {
+					target[i] = source[l++];
+
+				} else {
+					target[i] = source[r++];
+				}
+			}
+		}
+
+		inttype* swap = source;
+		source = target;
+		target = swap;
+	}
+
+	if (source != order) {
+		memcpy(order, source, count * sizeof(inttype));
+	}
+}
+
+template<typename K, typename V, typename Ctx, typename Pol>
+V TreeMap<K,V,Ctx,Pol>::replaceEntry(MapEntry<K,V,Ctx>* x, K key, V val, K firstKey) {
+	V retval = x->getValue();
+
+	// XXX: the first key of a batch run is the one that replaced the stored key (see putBatch)
+	if ((getDeleteKey() == true) && (firstKey != x->getKey())) {
+		Converter<K>::destroy(x->getKey());
+	}
+
+	x->setKey(key, getMapContext());
+	x->setValue(val, getMapContext());
+
+	#ifdef COM_DEEPIS_DB_INDEX_REF
+	m_modification++;
+	#endif
+
+	return retval;
+}
+
+#ifdef COM_DEEPIS_DB_CARDINALITY
+template<typename K, typename V, typename Ctx, typename Pol>
+inttype TreeMap<K,V,Ctx,Pol>::insertPosition(Leaf* leaf, inttype index, const K key, const K* previous) {
+	Node* block;
+	inttype location;
+
+	inttype prevPos = 0;
+	if (previous != null) {
+		m_comparator->compare(*previous, key, &prevPos);
+
+	} else {
+		const MapEntry<K,V,Ctx>* pe = previousEntry(leaf, index, &block, &location);
+		if (pe != null) {
+			m_comparator->compare(pe->getKey(), key, &prevPos);
+		}
+	}
+
+	inttype nextPos = 0;
+	const MapEntry<K,V,Ctx>* ne = (index <= leaf->m_lastIndex) ? leaf->getObject(index) : nextEntry(leaf, leaf->m_lastIndex, &block, &location);
+	if (ne != null) {
+		m_comparator->compare(key, ne->getKey(), &nextPos);
+	}
+
+	return (prevPos > nextPos) ? prevPos : nextPos;
+}
+#endif
+
+template<typename K, typename V, typename Ctx, typename Pol>
+void TreeMap<K,V,Ctx,Pol>::bulkBegin(BulkState& state, doubletype fillFactor) {
+	if ((fillFactor <= 0.0) || (fillFactor > 1.0)) {
+		fillFactor = 1.0;
+	}
+
+	// XXX: a node holding max index entries is one insert away from full, never pack beyond that
+	state.m_leafTarget = (inttype) (m_leafMaxIndex * fillFactor);
+	if (state.m_leafTarget <= m_leafLowWater) {
+		state.m_leafTarget = m_leafLowWater + 1;
+	}
+
+	state.m_branchTarget = (inttype) (m_branchMaxIndex * fillFactor);
+	if (state.m_branchTarget <= m_branchLowWater) {
+		state.m_branchTarget = m_branchLowWater + 1;
+	}
+	if (state.m_branchTarget < 2) {
+		state.m_branchTarget = 2;
+	}
+
+	memset(state.m_spine, 0, sizeof(state.m_spine));
+	state.m_count = 0;
+	state.m_pending = false;
+}
+
+template<typename K, typename V, typename Ctx, typename Pol>
+boolean TreeMap<K,V,Ctx,Pol>::bulkAppend(BulkState& state, K key, V val) {
+	inttype pos = 0;
+
+	if (state.m_count != 0) {
+		#ifdef COM_DEEPIS_DB_CARDINALITY
+		if (m_comparator->compare(state.m_lastKey, key, &pos) >= 0) {
+		#else
+		if (m_comparator->compare(state.m_lastKey, key) >= 0) {
+		#endif
+			return false;
+		}
+	}
+
+	#ifdef COM_DEEPIS_DB_CARDINALITY
+	if ((getCardinalityEnabled() == true) && (m_cardinality != null)) {
+		countCardinality(key, pos);
+	}
+	#endif
+
+	// XXX: the entry following a packed leaf becomes its separator, held back until a new leaf can take its successor
+	if (state.m_pending == true) {
+		Slot s = Entries::create(state.m_pendingKey, state.m_pendingVal, getMapContext(), m_entryPool);
+		Slot p = Entries::create(key, val, getMapContext(), m_entryPool);
+
+		Leaf* leaf = createLeaf(null, &p);
+		leaf->linkAfter((Leaf*) state.m_spine[0]);
+		bulkAttach(state, 1, s, leaf);
+		state.m_spine[0] = leaf;
+
+		state.m_pending = false;
+
+	} else if (state.m_spine[0] == null) {
+		Slot p = Entries::create(key, val, getMapContext(), m_entryPool);
+		state.m_spine[0] = createLeaf(null, &p);
+
+	} else if (((Leaf*) state.m_spine[0])->getPhysicalEntries() < state.m_leafTarget) {
+		Slot p = Entries::create(key, val, getMapContext(), m_entryPool);
+		((Leaf*) state.m_spine[0])->append(p);
+
+	} else {
+		state.m_pendingKey = key;
+		state.m_pendingVal = val;
+		state.m_pending = true;
+	}
+
+	state.m_lastKey = key;
+	state.m_count++;
+
+	return true;
+}
+
+template<typename K, typename V, typename Ctx, typename Pol>
+void TreeMap<K,V,Ctx,Pol>::bulkAttach(BulkState& state, inttype level, const Slot& obj, Node* node) {
+	Branch* branch = (Branch*) state.m_spine[level];
+	if (branch == null) {
+		branch = createBranch(null, state.m_spine[level - 1]);
+		state.m_spine[level] = branch;
+	}
+
+	if (branch->getVirtualEntries() < state.m_branchTarget) {
+		branch->append(node, obj);
+
+	} else {
+		Branch* next = createBranch(null, node);
+		bulkAttach(state, level + 1, obj, next);
+		state.m_spine[level] = next;
+	}
+}
+
+template<typename K, typename V, typename Ctx, typename Pol>
+void TreeMap<K,V,Ctx,Pol>::bulkEnd(BulkState& state) {
+	if (state.m_spine[0] == null) {
+		return;
+	}
+
+	inttype level = 0;
+	while ((level < 63) && (state.m_spine[level + 1] != null)) {
+		level++;
+	}
+
+	m_root = state.m_spine[level];
+	state.m_spine[0] = null;
+
+	recount(m_root);
+
+	inttype count = state.m_count - ((state.m_pending == true) ? 1 : 0);
+	m_pEntries += count;
+
+	#ifdef COM_DEEPIS_DB_INDEX_REF
+	if (getVirtualSizeEnabled() == true) {
+		m_vEntries += count;
+	}
+
+	m_modification++;
+	#endif
+
+	// XXX: only the right edge can be under-filled, rebalance it top down until it settles
+	boolean settled = false;
+	while (settled == false) {
+		settled = true;
+
+		Node* node = m_root;
+		while (node->isLeaf() == false) {
+			Branch* branch = (Branch*) node;
+			Node* child = branch->getNode(branch->Node::m_lastIndex);
+
+			boolean low = (child->isLeaf() == true) ? ((Leaf*) child)->isLow(this) : ((Branch*) child)->isLow(this);
+			if ((low == true) && (branch->Node::m_lastIndex > 0)) {
+				branch->isLow(this, child);
+				settled = false;
+				break;
+			}
+
+			node = child;
+		}
+	}
+
+	// XXX: the trailing separator had no leaf to follow it, insert it through the regular path
+	if (state.m_pending == true) {
+		Slot p = Entries::create(state.m_pendingKey, state.m_pendingVal, getMapContext(), m_entryPool);
+
+		Leaf* leaf = m_root->lastLeaf();
+		leaf->insert(this, p, leaf->Node::m_lastIndex + 1, true);
+
+		state.m_pending = false;
+	}
+}
+
+template<typename K, typename V, typename Ctx, typename Pol>
+V TreeMap<K,V,Ctx,Pol>::remove(const K key, K* retkey, boolean* status) {
+	unshare(key);
+
+	if (m_root != null) {
+		V val = Map<K,V,Ctx>::NULL_VALUE;
+
+		Node* n;
+		inttype index;
+		const MapEntry<K,V,Ctx>* x = m_root->find(this, key, &n, &index);
+		if (x != null) {
+			val = removeEntry(n, index, retkey);
+
+			if (status != null) {
+				*status = true;
+			}
+
+		} else {
+			if (status != null) {
+				*status = false;
+			}
+		}
+
+		return val;
+
+	} else {
+		if (status != null) {
+			*status = false;
+		}
+
+		return Map<K,V,Ctx>::NULL_VALUE;
+	}
+}
+
+template<typename K, typename V, typename Ctx, typename Pol>
+V TreeMap<K,V,Ctx,Pol>::removeEntry(Node* node, inttype index, K* retkey) {
+	const MapEntry<K,V,Ctx>* x = node->getEntry(index);
+	V val = x->getValue();
+
+	// XXX: inline entries are overwritten by the removal, capture the key up front
+	K oldkey = (K)Converter<K>::NULL_VALUE;
+	#ifdef COM_DEEPIS_DB_CARDINALITY
+	if ((retkey != null) || (getDeleteKey() == true) || (getCardinalityEnabled() == true)) {
+	#else
+	if ((retkey != null) || (getDeleteKey() == true)) {
+	#endif
+		oldkey = x->getKey();
+	}
+
+	#ifdef COM_DEEPIS_DB_CARDINALITY
+	if (getCardinalityEnabled() == true) {
+		// XXX: sketches cannot take a key back, skip locating its neighbors (see recalculateCardinality)
+		if ((m_cardinality != null) && (m_sketch == null)) {
+			m_cardinality[getCardinalityPosition(oldkey, node, index)]--;
+		}
+	}
+	#endif
+
+	node->remove(this, index);
+
+	#ifdef COM_DEEPIS_DB_CARDINALITY_VERIFY
+	if (getCardinalityEnabled() == true) {
+		verifyCardinality();
+	}
+	#endif
+
+	if (size() == 0) {
+		clear();
+	}
+
+	Entries::destroy(const_cast<MapEntry<K,V,Ctx>*>(x), getMapContext(), m_entryPool);
+
+	if (retkey != null) {
+		*retkey = oldkey;
+
+	} else if (getDeleteKey() == true) {
+		Converter<K>::destroy(oldkey);
+	}
+
+	return val;
+}
+
+template<typename K, typename V, typename Ctx, typename Pol>
+inttype TreeMap<K,V,Ctx,Pol>::recount(Node* node) {
+	if (node->isLeaf() == true) {
+		return countOf(node);
+	}
+
+	Branch* branch = (Branch*) node;
+	inttype count = branch->m_lastIndex;
+	for (inttype i = 0; i <= branch->m_lastIndex; i++) {
+		count += recount(branch->getNode(i));
+	}
+
+	branch->m_count = count;
+
+	return count;
+}
+
+template<typename K, typename V, typename Ctx, typename Pol>
+FrozenTreeMap<K,V,Ctx>* TreeMap<K,V,Ctx,Pol>::freeze(void) {
+	unshare();
+
+	typename EntrySet<MapEntry<K,V,Ctx>*>::EntrySetIterator iter(this);
+	FrozenTreeMap<K,V,Ctx>* frozen = new FrozenTreeMap<K,V,Ctx>(m_comparator, &iter, size(), getDeleteKey(), getDeleteValue());
+
+	#ifdef COM_DEEPIS_DB_CARDINALITY
+	if (m_cardinality != null) {
+		inttype cardinality[128];
+		getCardinalityEstimate(cardinality);
+		frozen->setCardinality(cardinality, m_keyParts);
+	}
+	#endif
+
+	// XXX: keys and values belong to the frozen map now
+	clear(false, false);
+
+	return frozen;
+}
+
+template<typename K, typename V, typename Ctx, typename Pol>
+typename TreeMap<K,V,Ctx,Pol>::Snapshot* TreeMap<K,V,Ctx,Pol>::snapshot(void) {
+	if ((getDeleteKey() == true) || (getDeleteValue() == true)) {
+		throw new UnsupportedOperationException("Snapshot of a map owning its keys or values");
+	}
+
+	if (m_spill != null) {
+		throw new UnsupportedOperationException("Snapshot of a map spilling its leaves");
+	}
+
+	if (m_shared == null) {
+		if (m_lineage != null) {
+			reclaim();
+		}
+
+		if (m_lineage == null) {
+			m_lineage = new Lineage();
+			m_lineage->m_retired = null;
+			m_lineage->m_references = 1;
+			m_lineage->m_generations = 0;
+			m_lineage->m_nodePool = null;
+			m_lineage->m_entryPool = null;
+
+		} else if (m_lineage->m_generations >= USHRT_MAX) {
+			// XXX: every generation not yet reclaimed may hold a share of the same node
+			throw new UnsupportedOperationException("Snapshot generations exhausted");
+		}
+
+		#ifdef COM_DEEPIS_DB_CARDINALITY
+		TreeMap<K,V,Ctx,Pol>* frozen = new TreeMap<K,V,Ctx,Pol>(m_comparator, m_branchMaxIndex, false, false, m_keyParts);
+		if ((m_cardinality != null) && (frozen->m_cardinality != null)) {
+			memcpy(frozen->m_cardinality, m_cardinality, m_keyParts * sizeof(inttype));
+		}
+		#else
+		TreeMap<K,V,Ctx,Pol>* frozen = new TreeMap<K,V,Ctx,Pol>(m_comparator, m_branchMaxIndex, false, false);
+		#endif
+
+		frozen->m_stateFlags = m_stateFlags;
+		frozen->m_ctx = m_ctx;
+
+		// XXX: pooled nodes stay in the slabs they were carved from, a generation releases into this map's pools
+		if (frozen->m_nodePool != null) {
+			delete frozen->m_nodePool;
+		}
+
+		if (frozen->m_entryPool != null) {
+			delete frozen->m_entryPool;
+		}
+
+		frozen->m_nodePool = m_nodePool;
+		frozen->m_entryPool = m_entryPool;
+
+		frozen->m_root = m_root;
+		if (m_root != null) {
+			m_root->m_shares++;
+		}
+
+		frozen->m_pEntries = m_pEntries;
+		#ifdef COM_DEEPIS_DB_INDEX_REF
+		frozen->m_vEntries = m_vEntries;
+		#endif
+		frozen->m_lineage = m_lineage;
+		frozen->m_frozen = true;
+
+		m_shared = new Shared();
+		m_shared->m_map = frozen;
+		m_shared->m_references = 1;
+		m_shared->m_lineage = m_lineage;
+		m_shared->m_next = null;
+
+		m_lineage->m_generations++;
+		__sync_add_and_fetch(&m_lineage->m_references, 1);
+	}
+
+	__sync_add_and_fetch(&m_shared->m_references, 1);
+
+	return new Snapshot(m_shared);
+}
+
+template<typename K, typename V, typename Ctx, typename Pol>
+void TreeMap<K,V,Ctx,Pol>::reclaim(void) {
+	if (m_frozen == true) {
+		throw new UnsupportedOperationException("Change of a snapshot");
+	}
+
+	// XXX: the current generation stays with its snapshots, the next snapshot starts another one
+	if (m_shared != null) {
+		Shared* shared = m_shared;
+		m_shared = null;
+
+		release(shared);
+	}
+
+	// XXX: read before the drain, a generation retires before it lets go of the lineage
+	Lineage* lineage = m_lineage;
+	boolean alone = (__sync_fetch_and_add(&lineage->m_references, 0) == 1);
+
+	Shared* retired = __sync_lock_test_and_set(&lineage->m_retired, (Shared*) null);
+	while (retired != null) {
+		Shared* next = retired->m_next;
+
+		delete retired->m_map;
+		delete retired;
+
+		lineage->m_generations--;
+		retired = next;
+	}
+
+	// XXX: no generation is left, every node belongs to this map again
+	if (alone == true) {
+		delete lineage;
+		m_lineage = null;
+	}
+}
+
+template<typename K, typename V, typename Ctx, typename Pol>
+void TreeMap<K,V,Ctx,Pol>::release(Shared* shared) {
+	if (__sync_sub_and_fetch(&shared->m_references, 1) == 0) {
+		// XXX: nodes are only freed by the live map (or the last one out), readers of other generations never see a free
+		Lineage* lineage = shared->m_lineage;
+
+		Shared* head;
+		do {
+			head = lineage->m_retired;
+			shared->m_next = head;
+
+		} while (__sync_bool_compare_and_swap(&lineage->m_retired, head, shared) == false);
+
+		leave(lineage);
+	}
+}
+
+template<typename K, typename V, typename Ctx, typename Pol>
+void TreeMap<K,V,Ctx,Pol>::leave(Lineage* lineage) {
+	if (__sync_sub_and_fetch(&lineage->m_references, 1) == 0) {
+		collect(lineage);
+	}
+}
+
+template<typename K, typename V, typename Ctx, typename Pol>
+void TreeMap<K,V,Ctx,Pol>::collect(Lineage* lineage) {
+	Shared* retired = lineage->m_retired;
+	while (retired != null) {
+		Shared* next = retired->m_next;
+
+		delete retired->m_map;
+		delete retired;
+
+		retired = next;
+	}
+
+	if (lineage->m_nodePool != null) {
+		delete lineage->m_nodePool;
+	}
+
+	if (lineage->m_entryPool != null) {
+		delete lineage->m_entryPool;
+	}
+
+	delete lineage;
+}
+
+template<typename K, typename V, typename Ctx, typename Pol>
+typename TreeMap<K,V,Ctx,Pol>::Node* TreeMap<K,V,Ctx,Pol>::copyNode(Node* node) {
+	Node* copy;
+
+	if (node->isLeaf() == true) {
+		Leaf* leaf = (Leaf*) node;
+		Leaf* nLeaf = createLeaf(leaf->m_parent, null);
+
+		for (inttype i = 0; i <= leaf->m_lastIndex; i++) {
+			nLeaf->setObject(i, Entries::copy(leaf->getSlot(i), getMapContext(), m_entryPool));
+		}
+
+		// XXX: the copy takes the original's place in the chain, generations never walk it
+		nLeaf->m_prev = leaf->m_prev;
+		nLeaf->m_next = leaf->m_next;
+		if (nLeaf->m_prev != null) {
+			nLeaf->m_prev->m_next = nLeaf;
+		}
+		if (nLeaf->m_next != null) {
+			nLeaf->m_next->m_prev = nLeaf;
+		}
+
+		copy = nLeaf;
+
+	} else {
+		Branch* branch = (Branch*) node;
+		Branch* nBranch = createBranch(branch->m_parent);
+
+		// XXX: children are shared one level further down instead of copied
+		for (inttype i = 0; i <= branch->m_lastIndex; i++) {
+			Node* child = branch->getNode(i);
+			child->m_shares++;
+
+			nBranch->setNode(i, child);
+			if (i > 0) {
+				nBranch->setObject(i, Entries::copy(branch->getSlot(i), getMapContext(), m_entryPool));
+			}
+		}
+
+		nBranch->m_count = branch->m_count;
+
+		copy = nBranch;
+	}
+
+	copy->m_lastIndex = node->m_lastIndex;
+	copy->m_slotIndex = node->m_slotIndex;
+
+	node->m_shares--;
+
+	// XXX: hints and iterators may still name the original
+	#ifdef COM_DEEPIS_DB_INDEX_REF
+	m_modification++;
+	#endif
+
+	return copy;
+}
+
+template<typename K, typename V, typename Ctx, typename Pol>
+typename TreeMap<K,V,Ctx,Pol>::Node* TreeMap<K,V,Ctx,Pol>::ownChild(Branch* parent, inttype index) {
+	if ((index < 0) || (index > parent->m_lastIndex)) {
+		return null;
+	}
+
+	Node* child = parent->getNode(index);
+	if (child->m_shares > 0) {
+		child = copyNode(child);
+		parent->setNode(index, child);
+	}
+
+	return child;
+}
+
+template<typename K, typename V, typename Ctx, typename Pol>
+typename TreeMap<K,V,Ctx,Pol>::Node* TreeMap<K,V,Ctx,Pol>::own(Node* node) {
+	Branch* parent = node->m_parent;
+	if (parent == null) {
+		if (m_root->m_shares > 0) {
+			m_root = copyNode(m_root);
+		}
+
+		return m_root;
+	}
+
+	// XXX: owns the path from the root and the siblings a split, merge or redistribution on the way may reach
+	parent = (Branch*) own(parent);
+
+	inttype index = parent->instanceIndex(node);
+	ownChild(parent, index - 1);
+	ownChild(parent, index + 1);
+
+	return ownChild(parent, index);
+}
+
+template<typename K, typename V, typename Ctx, typename Pol>
+void TreeMap<K,V,Ctx,Pol>::ownPath(const K key) {
+	Node* node;
+	inttype index;
+	if ((m_root->find(this, key, &node, &index) != null) && (node->isLeaf() == false)) {
+		// XXX: a separator is refilled from its successor leaf (see Branch::remove)
+		node = ((Branch*) node)->getNode(index)->firstLeaf();
+	}
+
+	own(node);
+}
+
+template<typename K, typename V, typename Ctx, typename Pol>
+void TreeMap<K,V,Ctx,Pol>::setSpillFile(const char* path, ulongtype highWater, ulongtype lowWater) {
+	// XXX: referenced entries and pooled nodes would keep most of a leaf on the heap
+	if ((Pol::SPILL_LEAVES == false) || (Pol::INLINE_ENTRIES == false) || (Pol::POOLED_NODES == true)) {
+		throw new UnsupportedOperationException("Spill of a map without inline, unpooled leaves");
+	}
+
+	if (m_lineage != null) {
+		throw new UnsupportedOperationException("Spill of a map with snapshots");
+	}
+
+	if (m_spill != null) {
+		for (Leaf* leaf = (m_root != null) ? m_root->firstLeaf() : null; leaf != null; leaf = leaf->m_next) {
+			leaf->touch();
+		}
+
+		delete m_spill;
+		m_spill = null;
+		m_clock = null;
+	}
+
+	if (path != null) {
+		m_spill = new TreeSpill(path, (m_leafMaxIndex + 1) * sizeof(Slot), highWater, lowWater);
+	}
+}
+
+template<typename K, typename V, typename Ctx, typename Pol>
+inttype TreeMap<K,V,Ctx,Pol>::spill(inttype count) {
+	if ((m_spill == null) || (m_root == null)) {
+		return 0;
+	}
+
+	// XXX: CLOCK over the leaf chain, a referenced leaf loses its bit and is passed over until the hand comes back;
+	//      two laps without enough victims means everything else is already on disk
+	Leaf* first = m_root->firstLeaf();
+	Leaf* leaf = (m_clock != null) ? m_clock : first;
+	Leaf* start = leaf;
+
+	inttype spilled = 0;
+	inttype laps = 0;
+	while ((spilled < count) && (laps < 2)) {
+		if (leaf->m_spilled == false) {
+			if (leaf->m_referenced == true) {
+				leaf->m_referenced = false;
+
+			} else {
+				spillLeaf(leaf);
+				spilled++;
+			}
+		}
+
+		leaf = (leaf->m_next != null) ? leaf->m_next : first;
+		if (leaf == start) {
+			laps++;
+		}
+	}
+
+	m_clock = leaf;
+
+	return spilled;
+}
+
+template<typename K, typename V, typename Ctx, typename Pol>
+longtype TreeMap<K,V,Ctx,Pol>::getSpilledLeaves(void) const {
+	return (m_spill != null) ? m_spill->getSpilledPages() : 0;
+}
+
+template<typename K, typename V, typename Ctx, typename Pol>
+void TreeMap<K,V,Ctx,Pol>::relieve(void) {
+	if (m_spill->sample() == false) {
+		return;
+	}
+
+	ulongtype allocated = Memory::getProcessAllocatedBytes();
+	if (allocated > m_spill->getHighWater()) {
+		// XXX: freed arrays do not always show in the allocator at once, size the sweep from the overshoot instead of sampling again
+		ulongtype excess = (allocated > m_spill->getLowWater()) ? (allocated - m_spill->getLowWater()) : 0;
+		ulongtype leaves = (excess / m_spill->getPageSize()) + 1;
+
+		spill((leaves < (ulongtype) m_pEntries) ? (inttype) leaves : m_pEntries);
+	}
+}
+
+template<typename K, typename V, typename Ctx, typename Pol>
+void TreeMap<K,V,Ctx,Pol>::spillLeaf(Leaf* leaf) {
+	Slot* objects = leaf->m_objects;
+
+	leaf->m_objects = (Slot*) m_spill->write(objects);
+	leaf->m_spilled = true;
+
+	free(objects);
+}
+
+#ifdef COM_DEEPIS_DB_CARDINALITY
+template<typename K, typename V, typename Ctx, typename Pol>
+void TreeMap<K,V,Ctx,Pol>::setCardinalitySketchEnabled(boolean flag) {
+	if (m_cardinality == null) {
+		return;
+	}
+
+	if (flag == true) {
+		if (m_sketch == null) {
+			m_sketch = new CardinalitySketch[m_keyParts];
+
+			// XXX: seed from the current entries, inserts keep the sketches current from here on
+			typename EntrySet<MapEntry<K,V,Ctx>*>::EntrySetIterator iter(this);
+			while (iter.EntrySet<MapEntry<K,V,Ctx>*>::EntrySetIterator::hasNext()) {
+				sketchKey(iter.EntrySet<MapEntry<K,V,Ctx>*>::EntrySetIterator::next()->getKey());
+			}
+		}
+
+	} else if (m_sketch != null) {
+		delete [] m_sketch;
+		m_sketch = null;
+
+		// XXX: exact counts were not maintained while sketching
+		recalculateCardinality();
+	}
+}
+
+template<typename K, typename V, typename Ctx, typename Pol>
+void TreeMap<K,V,Ctx,Pol>::getCardinalityEstimate(inttype* cardinality) const {
+	if (m_cardinality == null) {
+		return;
+	}
+
+	if (m_sketch == null) {
+		memcpy(cardinality, m_cardinality, m_keyParts * sizeof(inttype));
+		return;
+	}
+
+	// XXX: sketch i counts distinct prefixes of i + 1 parts, the keys first differing at part i are the increase over i - 1
+	longtype previous = 0;
+	for (inttype i = 0; i < m_keyParts; i++) {
+		longtype distinct = m_sketch[i].estimate();
+		if (distinct < previous) {
+			distinct = previous;
+		}
+
+		cardinality[i] = (inttype) (distinct - previous);
+		previous = distinct;
+	}
+}
+
+template<typename K, typename V, typename Ctx, typename Pol>
+void TreeMap<K,V,Ctx,Pol>::mergeCardinality(const TreeMap* tree) {
+	if ((m_sketch == null) || (tree->m_sketch == null)) {
+		return;
+	}
+
+	for (inttype i = 0; (i < m_keyParts) && (i < tree->m_keyParts); i++) {
+		m_sketch[i].merge(&tree->m_sketch[i]);
+	}
+}
+#endif
+
+template<typename K, typename V, typename Ctx, typename Pol>
+inttype TreeMap<K,V,Ctx,Pol>::rank(const K key) const {
+	inttype rank = 0;
+
+	Node* node = m_root;
+	while (node != null) {
+		if (node->isLeaf() == true) {
+			return rank + ((Leaf*) node)->bound(this, key);
+		}
+
+		Branch* branch = (Branch*) node;
+		inttype index = branch->bound(this, key);
+
+		// XXX: separators 1 .. index-1 and the children left of them all fall below key
+		rank += index - 1;
+		for (inttype i = 0; i < index - 1; i++) {
+			rank += countOf(branch->getNode(i));
+		}
+
+		if ((index <= branch->m_lastIndex) && (m_comparator->compare(branch->getKey(index), key) == 0)) {
+			return rank + countOf(branch->getNode(index - 1));
+		}
+
+		node = branch->getNode(index - 1);
+	}
+
+	return rank;
+}
+
+template<typename K, typename V, typename Ctx, typename Pol>
+const MapEntry<K,V,Ctx>* TreeMap<K,V,Ctx,Pol>::select(inttype index) const {
+	if ((index < 0) || (index >= m_pEntries)) {
+		return null;
+	}
+
+	Node* node = m_root;
+	while (node->isLeaf() == false) {
+		Branch* branch = (Branch*) node;
+
+		inttype i = 0;
+		for (; i < branch->m_lastIndex; i++) {
+			inttype count = countOf(branch->getNode(i));
+			if (index < count) {
+				break;
+			}
+
+			index -= count;
+			if (index == 0) {
+				return branch->getObject(i + 1);
+			}
+
+			index--;
+		}
+
+		node = branch->getNode(i);
+	}
+
+	return ((Leaf*) node)->getObject(index);
+}
+
+template<typename K, typename V, typename Ctx, typename Pol>
+inttype TreeMap<K,V,Ctx,Pol>::countRange(const K fromKey, const K toKey) const {
+	if (m_comparator->compare(fromKey, toKey) >= 0) {
+		return 0;
+	}
+
+	return rank(toKey) - rank(fromKey);
+}
+
+template<typename K, typename V, typename Ctx, typename Pol>
+inttype TreeMap<K,V,Ctx,Pol>::removeRange(const K fromKey, const K toKey, boolean delkey, boolean delval) {
+	unshare();
+
+	if ((m_root == null) || (m_comparator->compare(fromKey, toKey) >= 0)) {
+		return 0;
+	}
+
+	#ifdef COM_DEEPIS_DB_CARDINALITY
+	if ((getCardinalityEnabled() == true) && (m_cardinality != null) && (m_sketch == null)) {
+		removeRangeCardinality(fromKey, toKey);
+	}
+	#endif
+
+	// XXX: every unit restarts from the root, rebalancing after a unit may reshape the boundary paths
+	inttype removed = 0;
+	while (m_root != null) {
+		inttype count = removeUnit(m_root, fromKey, toKey, delkey, delval);
+		if (count == 0) {
+			break;
+		}
+
+		removed += count;
+	}
+
+	#ifdef COM_DEEPIS_DB_CARDINALITY_VERIFY
+	if (getCardinalityEnabled() == true) {
+		verifyCardinality();
+	}
+	#endif
+
+	if (size() == 0) {
+		clear();
+	}
+
+	return removed;
+}
+
+#ifdef COM_DEEPIS_DB_CARDINALITY
+template<typename K, typename V, typename Ctx, typename Pol>
+void TreeMap<K,V,Ctx,Pol>::removeRangeCardinality(const K fromKey, const K toKey) {
+	Node* node;
+	inttype index;
+	const MapEntry<K,V,Ctx>* x = ceilingPosition(fromKey, &node, &index);
+	if ((x == null) || (m_comparator->compare(x->getKey(), toKey) >= 0)) {
+		return;
+	}
+
+	Node* block;
+	inttype location;
+	const MapEntry<K,V,Ctx>* previous = previousEntry(node, index, &block, &location);
+	const MapEntry<K,V,Ctx>* next = ceilingPosition(toKey, &block, &location);
+
+	// XXX: account as if removed from the highest key down, each key then sits between its predecessor and the range successor
+	while ((x != null) && (m_comparator->compare(x->getKey(), toKey) < 0)) {
+		inttype prevPos = 0;
+		if (previous != null) {
+			m_comparator->compare(x->getKey(), previous->getKey(), &prevPos);
+		}
+
+		inttype nextPos = 0;
+		if (next != null) {
+			m_comparator->compare(x->getKey(), next->getKey(), &nextPos);
+		}
+
+		m_cardinality[(prevPos > nextPos) ? prevPos : nextPos]--;
+
+		previous = x;
+		x = nextEntry(node, index, &node, &index);
+	}
+}
+#endif
+
+template<typename K, typename V, typename Ctx, typename Pol>
+const MapEntry<K,V,Ctx>* TreeMap<K,V,Ctx,Pol>::ceilingPosition(const K key, Node** block, inttype* location) {
+	const MapEntry<K,V,Ctx>* x = m_root->find(this, key, block, location);
+	if (x == null) {
+		// XXX: a miss ends in a leaf at the insertion index
+		Leaf* leaf = (Leaf*) *block;
+		if (*location <= leaf->m_lastIndex) {
+			x = leaf->getObject(*location);
+
+		} else {
+			x = nextEntry(leaf, leaf->m_lastIndex, block, location);
+		}
+	}
+
+	return x;
+}
+
+template<typename K, typename V, typename Ctx, typename Pol>
+template<typename F>
+inttype TreeMap<K,V,Ctx,Pol>::forEachInRange(const K fromKey, boolean fromOpen, const K toKey, boolean toOpen, F&& visitor) {
+	if (m_root == null) {
+		return 0;
+	}
+
+	Node* node;
+	inttype index;
+	const MapEntry<K,V,Ctx>* x;
+	if (fromOpen == false) {
+		x = ceilingPosition(fromKey, &node, &index);
+
+	} else {
+		node = m_root->firstLeaf();
+		index = 0;
+		x = ((Leaf*) node)->getObject(0);
+	}
+
+	boolean bounded = (toOpen == false);
+	inttype count = 0;
+
+	while (x != null) {
+		if (node->isLeaf() == true) {
+			Leaf* leaf = (Leaf*) node;
+			inttype last = leaf->m_lastIndex;
+
+			// XXX: only the leaf holding toKey needs per entry checks, every entry after it is out of range
+			if ((bounded == true) && (m_comparator->compare(leaf->getObject(last)->getKey(), toKey) >= 0)) {
+				for (; index <= last; index++) {
+					x = leaf->getObject(index);
+					if (m_comparator->compare(x->getKey(), toKey) >= 0) {
+						break;
+					}
+
+					count++;
+					if (visitor(x) == false) {
+						break;
+					}
+				}
+
+				return count;
+			}
+
+			for (; index <= last; index++) {
+				count++;
+				if (visitor(leaf->getObject(index)) == false) {
+					return count;
+				}
+			}
+
+			x = nextEntry(leaf, last, &node, &index);
+
+		} else {
+			if ((bounded == true) && (m_comparator->compare(x->getKey(), toKey) >= 0)) {
+				break;
+			}
+
+			count++;
+			if (visitor(x) == false) {
+				break;
+			}
+
+			x = nextEntry(node, index, &node, &index);
+		}
+	}
+
+	return count;
+}
+
+template<typename K, typename V, typename Ctx, typename Pol>
+inttype TreeMap<K,V,Ctx,Pol>::destroySubtree(Node* node, boolean delkey, boolean delval) {
+	// XXX: a subtree generations still hold is only let go of, the last tree holding it frees it
+	if (node->m_shares > 0) {
+		node->m_shares--;
+		return countOf(node);
+	}
+
+	// XXX: inline entries are released with their nodes, only walk them when keys or values are owned
+	boolean walk = (Pol::INLINE_ENTRIES == false) || (delkey == true) || (delval == true);
+	inttype count = 0;
+
+	if (node->isLeaf() == true) {
+		Leaf* leaf = (Leaf*) node;
+		count = leaf->getPhysicalEntries();
+
+		for (inttype i = 0; (walk == true) && (i <= leaf->m_lastIndex); i++) {
+			destroyEntry(leaf->getObject(i), delkey, delval);
+		}
+
+	} else {
+		Branch* branch = (Branch*) node;
+		for (inttype i = 0; i <= branch->m_lastIndex; i++) {
+			count += destroySubtree(branch->getNode(i), delkey, delval);
+
+			if (i > 0) {
+				if (walk == true) {
+					destroyEntry(branch->getObject(i), delkey, delval);
+				}
+
+				count++;
+			}
+		}
+
+		// XXX: children are already released, keep the destructor from visiting them again
+		branch->m_lastIndex = -1;
+	}
+
+	destroyNode(node);
+
+	return count;
+}
+
+template<typename K, typename V, typename Ctx, typename Pol>
+inttype TreeMap<K,V,Ctx,Pol>::removeUnit(Node* node, const K fromKey, const K toKey, boolean delkey, boolean delval) {
+	// XXX: a unit only reshapes the node it sits on and that node's neighbors, own them before a generation sees the change
+	if (m_lineage != null) {
+		node = own(node);
+	}
+
+	if (node->isLeaf() == true) {
+		Leaf* leaf = (Leaf*) node;
+		inttype begin = leaf->bound(this, fromKey);
+		inttype count = leaf->bound(this, toKey) - begin;
+		if (count <= 0) {
+			return 0;
+		}
+
+		// XXX: trim what the leaf can spare in one shift, a leaf at low water is trimmed down to one entry and rebalanced once below
+		if (leaf->m_parent != null) {
+			inttype spare = leaf->m_lastIndex - m_leafLowWater;
+			if (spare <= 0) {
+				spare = leaf->m_lastIndex;
+			}
+
+			if (spare <= 0) {
+				MapEntry<K,V,Ctx>* x = leaf->getObject(begin);
+				K key = x->getKey();
+				V val = x->getValue();
+
+				leaf->remove(this, begin);
+
+				Entries::destroy(x, getMapContext(), m_entryPool);
+				if (delkey == true) {
+					Converter<K>::destroy(key);
+				}
+				if (delval == true) {
+					Converter<V>::destroy(val);
+				}
+
+				return 1;
+			}
+
+			if (count > spare) {
+				count = spare;
+			}
+		}
+
+		for (inttype i = begin; i < begin + count; i++) {
+			destroyEntry(leaf->getObject(i), delkey, delval);
+		}
+
+		leaf->cut(begin, count);
+		decrementEntries(count);
+		adjustCounts(leaf->m_parent, -count);
+
+		if (leaf->m_parent == null) {
+			if (leaf->getPhysicalEntries() == 0) {
+				notifyRootEmpty();
+			}
+
+		} else if (leaf->isLow(this) == true) {
+			// XXX: the retained entry keeps a merge into the left sibling well formed
+			leaf->m_parent->isLow(this, leaf);
+		}
+
+		return count;
+	}
+
+	Branch* branch = (Branch*) node;
+	inttype first = branch->bound(this, fromKey);
+	inttype last = branch->bound(this, toKey) - 1;
+
+	if (first < last) {
+		// XXX: the child between two covered separators is covered whole, release it with its left separator
+		Node* child = branch->getNode(first);
+
+		Leaf* lLeaf = child->firstLeaf();
+		Leaf* rLeaf = child->lastLeaf();
+		if (lLeaf->m_prev != null) {
+			lLeaf->m_prev->m_next = rLeaf->m_next;
+		}
+		if (rLeaf->m_next != null) {
+			rLeaf->m_next->m_prev = lLeaf->m_prev;
+		}
+
+		inttype count = destroySubtree(child, delkey, delval) + 1;
+		destroyEntry(branch->getObject(first), delkey, delval);
+		decrementEntries(count);
+		adjustCounts(branch, -count);
+
+		branch->removeItem(this, first);
+
+		return count;
+
+	} else if (first == last) {
+		// XXX: drain the children on either side before the covered separator itself
+		inttype count = removeUnit(branch->getNode(first), fromKey, toKey, delkey, delval);
+		if (count == 0) {
+			count = removeUnit(branch->getNode(first - 1), fromKey, toKey, delkey, delval);
+		}
+
+		if (count == 0) {
+			MapEntry<K,V,Ctx>* x = branch->getObject(first);
+			K key = x->getKey();
+			V val = x->getValue();
+
+			// XXX: the separator is refilled from its successor leaf (see Branch::remove)
+			if (m_lineage != null) {
+				own(branch->getNode(first)->firstLeaf());
+			}
+
+			branch->remove(this, first);
+
+			Entries::destroy(x, getMapContext(), m_entryPool);
+			if (delkey == true) {
+				Converter<K>::destroy(key);
+			}
+			if (delval == true) {
+				Converter<V>::destroy(val);
+			}
+
+			count = 1;
+		}
+
+		return count;
+
+	} else {
+		return removeUnit(branch->getNode(first - 1), fromKey, toKey, delkey, delval);
+	}
+}
+
+template<typename K, typename V, typename Ctx, typename Pol>
+const V TreeMap<K,V,Ctx,Pol>::get(const K key, K* retkey, boolean* status) const {
+	if (m_root != null) {
+		V val = Map<K,V,Ctx>::NULL_VALUE;
+
+		Node* n;
+		inttype index;
+		const MapEntry<K,V,Ctx>* x = m_root->find(this, key, &n, &index);
+		if (x != null) {
+			val = x->getValue();
+
+			if (status != null) {
+				*status = true;
+			}
+
+			if (retkey != null) {
+				*retkey = x->getKey();
+			}
+
+		} else {
+			if (status != null) {
+				*status = false;
+			}
+		}
+
+		return val;
+
+	} else {
+		if (status != null) {
+			*status = false;
+		}
+
+		return Map<K,V,Ctx>::NULL_VALUE;
+	}
+}
+
+template<typename K, typename V, typename Ctx, typename Pol>
+boolean TreeMap<K,V,Ctx,Pol>::containsKey(const K key) const {
+	if (m_root != null) {
+		Node* n;
+		inttype index;
+		const MapEntry<K,V,Ctx>* x = m_root->find(this, key, &n, &index);
+		return (x != null);
+
+	} else {
+		return false;
+	}
+}
+
+template<typename K, typename V, typename Ctx, typename Pol>
+const MapEntry<K,V,Ctx>* TreeMap<K,V,Ctx,Pol>::fingerFind(const K key, Node** finger) const {
+	Node* node = *finger;
+
+	// XXX: the previous key lies within the finger, so the finger covers this key when it does not exceed its last entry;
+	//      parent links belong to the live map, a generation starts over from its root
+	if (m_frozen == true) {
+		node = m_root;
+	}
+
+	while ((node != m_root) && (node->m_parent != null)) {
+		const MapEntry<K,V,Ctx>* last = node->isLeaf() ? ((Leaf*) node)->getObject(node->m_lastIndex) : ((Branch*) node)->getObject(node->m_lastIndex);
+		if (m_comparator->compare(last->getKey(), key) >= 0) {
+			break;
+		}
+
+		node = node->m_parent;
+	}
+
+	inttype index;
+	const MapEntry<K,V,Ctx>* x = node->find(this, key, finger, &index);
+	if (*finger == null) {
+		*finger = m_root;
+	}
+
+	return x;
+}
+
+template<typename K, typename V, typename Ctx, typename Pol>
+void TreeMap<K,V,Ctx,Pol>::probeGroup(const K* keys, inttype count, const MapEntry<K,V,Ctx>** entries) const {
+	Node* nodes[PROBE_GROUP];
+	for (inttype i = 0; i < count; i++) {
+		nodes[i] = m_root;
+		entries[i] = null;
+	}
+
+	// XXX: advance every probe one level per pass, each descent prefetches its child while the others compare
+	inttype active = count;
+	while (active > 0) {
+		active = 0;
+
+		for (inttype i = 0; i < count; i++) {
+			Node* node = nodes[i];
+			if (node == null) {
+				continue;
+			}
+
+			if (node->isLeaf() == true) {
+				inttype index;
+				entries[i] = node->find(this, keys[i], &node, &index);
+				nodes[i] = null;
+
+			} else {
+				nodes[i] = ((Branch*) node)->step(this, keys[i], &entries[i]);
+				if (nodes[i] != null) {
+					__builtin_prefetch(nodes[i]);
+					active++;
+				}
+			}
+		}
+	}
+}
+
+template<typename K, typename V, typename Ctx, typename Pol>
+inttype TreeMap<K,V,Ctx,Pol>::getAll(const K* keys, inttype count, V* vals, boolean* found, boolean sorted) const {
+	inttype hits = 0;
+
+	if (m_root == null) {
+		for (inttype i = 0; i < count; i++) {
+			vals[i] = Map<K,V,Ctx>::NULL_VALUE;
+			if (found != null) {
+				found[i] = false;
+			}
+		}
+
+		return hits;
+	}
+
+	if (sorted == true) {
+		Node* finger = m_root;
+		for (inttype i = 0; i < count; i++) {
+			// XXX: out of order keys restart from the root
+			if ((i > 0) && (m_comparator->compare(keys[i], keys[i - 1]) < 0)) {
+				finger = m_root;
+			}
+
+			const MapEntry<K,V,Ctx>* x = fingerFind(keys[i], &finger);
+			vals[i] = (x != null) ? x->getValue() : Map<K,V,Ctx>::NULL_VALUE;
+			if (found != null) {
+				found[i] = (x != null);
+			}
+
+			if (x != null) {
+				hits++;
+			}
+		}
+
+	} else {
+		const MapEntry<K,V,Ctx>* entries[PROBE_GROUP];
+		for (inttype i = 0; i < count; i += PROBE_GROUP) {
+			inttype group = ((count - i) < PROBE_GROUP) ? (count - i) : PROBE_GROUP;
+			probeGroup(keys + i, group, entries);
+
+			for (inttype j = 0; j < group; j++) {
+				vals[i + j] = (entries[j] != null) ? entries[j]->getValue() : Map<K,V,Ctx>::NULL_VALUE;
+				if (found != null) {
+					found[i + j] = (entries[j] != null);
+				}
+
+				if (entries[j] != null) {
+					hits++;
+				}
+			}
+		}
+	}
+
+	return hits;
+}
+
+template<typename K, typename V, typename Ctx, typename Pol>
+boolean TreeMap<K,V,Ctx,Pol>::containsAll(const K* keys, inttype count, boolean sorted) const {
+	if (count == 0) {
+		return true;
+
+	} else if (m_root == null) {
+		return false;
+	}
+
+	if (sorted == true) {
+		Node* finger = m_root;
+		for (inttype i = 0; i < count; i++) {
+			if ((i > 0) && (m_comparator->compare(keys[i], keys[i - 1]) < 0)) {
+				finger = m_root;
+			}
+
+			if (fingerFind(keys[i], &finger) == null) {
+				return false;
+			}
+		}
+
+	} else {
+		const MapEntry<K,V,Ctx>* entries[PROBE_GROUP];
+		for (inttype i = 0; i < count; i += PROBE_GROUP) {
+			inttype group = ((count - i) < PROBE_GROUP) ? (count - i) : PROBE_GROUP;
+			probeGroup(keys + i, group, entries);
+
+			for (inttype j = 0; j < group; j++) {
+				if (entries[j] == null) {
+					return false;
+				}
+			}
+		}
+	}
+
+	return true;
+}
+
+template<typename K, typename V, typename Ctx, typename Pol>
+boolean TreeMap<K,V,Ctx,Pol>::containsValue(const V val) const {
+	// TODO
+	return false;
+}
+
+template<typename K, typename V, typename Ctx, typename Pol>
+void TreeMap<K,V,Ctx,Pol>::clear(boolean delkey, boolean delval) {
+	unshare();
+
+	if (m_root != null) {
+		// XXX: inline and pooled entries are released with their nodes, only walk when keys or values are owned
+		boolean walk = (m_lineage == null) && (((Pol::INLINE_ENTRIES == false) && (Pol::POOLED_NODES == false)) || (delkey == true) || (delval == true));
+
+		typename EntrySet<MapEntry<K,V,Ctx>*>::EntrySetIterator iter(this);
+		while ((walk == true) && iter.EntrySet<MapEntry<K,V,Ctx>*>::EntrySetIterator::hasNext()) {
+			MapEntry<K,V,Ctx>* x = iter.EntrySet<MapEntry<K,V,Ctx>*>::EntrySetIterator::next();
+
+			K key = (K)Converter<K>::NULL_VALUE;
+			V value = (V)Converter<V>::NULL_VALUE;
+			if (delkey == true) {
+				key = x->getKey();
+			}
+			if (delval == true) {
+				value = x->getValue();
+			}
+
+			if (Pol::POOLED_NODES == false) {
+				Entries::destroy(x, getMapContext(), null);
+			}
+
+			if (delkey == true) {
+				Converter<K>::destroy(key);
+			}
+
+			if (delval == true) {
+				Converter<V>::destroy(value);
+			}
+		}
+
+		#ifdef COM_DEEPIS_DB_INDEX_REF
+		m_modification++;
+
+		if (getVirtualSizeEnabled() == true) {
+			m_vEntries = 0;
+		}
 		#endif
 
 		m_pEntries = 0;
-		delete m_root;
+
+		if (m_lineage != null) {
+			// XXX: generations still hold parts of the tree, let go of it node by node
+			destroySubtree(m_root, delkey, delval);
+
+		} else if (Pol::POOLED_NODES == true) {
+			m_nodePool->clear();
+
+			if (m_entryPool != null) {
+				m_entryPool->clear();
+			}
+
+		} else {
+			delete m_root;
+		}
 	}
 
 	#ifdef COM_DEEPIS_DB_CARDINALITY
@@ -833,14 +2592,22 @@ void TreeMap<K,V,Ctx>::clear(boolean delkey, boolean delval) {
 		if (m_cardinality != null) {
 			memset(m_cardinality, 0, m_keyParts * sizeof(inttype));
 		}
+
+		clearSketch();
 	}
 	#endif
 
+	// XXX: spilled leaves released their pages with the nodes
+	if (m_spill != null) {
+		m_spill->clear();
+	}
+
 	m_root = null;
+	m_clock = null;
 }
 
-template<typename K, typename V, typename Ctx>
-Set<MapEntry<K,V,Ctx>* >* TreeMap<K,V,Ctx>::entrySet(Set<MapEntry<K,V,Ctx>* >* fillset) {
+template<typename K, typename V, typename Ctx, typename Pol>
+Set<MapEntry<K,V,Ctx>* >* TreeMap<K,V,Ctx,Pol>::entrySet(Set<MapEntry<K,V,Ctx>* >* fillset) {
 	if (fillset != null) {
 		// TODO: check type
 		((EntrySet<>*) fillset)->reset(this);
@@ -852,8 +2619,8 @@ Set<MapEntry<K,V,Ctx>* >* TreeMap<K,V,Ctx>::entrySet(Set<MapEntry<K,V,Ctx>* >* f
 	return fillset;
 }
 
-template<typename K, typename V, typename Ctx>
-Set<K>* TreeMap<K,V,Ctx>::keySet(Set<K>* fillset) {
+template<typename K, typename V, typename Ctx, typename Pol>
+Set<K>* TreeMap<K,V,Ctx,Pol>::keySet(Set<K>* fillset) {
 	if (fillset != null) {
 		// TODO: check type
 		((KeySet*) fillset)->reset(this);
@@ -865,13 +2632,13 @@ Set<K>* TreeMap<K,V,Ctx>::keySet(Set<K>* fillset) {
 	return fillset;
 }
 
-template<typename K, typename V, typename Ctx>
-Collection<V>* TreeMap<K,V,Ctx>::values() {
+template<typename K, typename V, typename Ctx, typename Pol>
+Collection<V>* TreeMap<K,V,Ctx,Pol>::values() {
 	return null; // TODO
 }
 
-template<typename K, typename V, typename Ctx>
-SortedMap<K,V,Ctx>* TreeMap<K,V,Ctx>::headMap(const K toKey, SortedMap<K,V,Ctx>* fillmap) {
+template<typename K, typename V, typename Ctx, typename Pol>
+SortedMap<K,V,Ctx>* TreeMap<K,V,Ctx,Pol>::headMap(const K toKey, SortedMap<K,V,Ctx>* fillmap) {
 	inttype endIndex = -1;
 	Node* endNode = null;
 	if (m_root != null) {
@@ -889,8 +2656,8 @@ SortedMap<K,V,Ctx>* TreeMap<K,V,Ctx>::headMap(const K toKey, SortedMap<K,V,Ctx>*
 	return fillmap;
 }
 
-template<typename K, typename V, typename Ctx>
-SortedMap<K,V,Ctx>* TreeMap<K,V,Ctx>::subMap(const K fromKey, const K toKey, SortedMap<K,V,Ctx>* fillmap) {
+template<typename K, typename V, typename Ctx, typename Pol>
+SortedMap<K,V,Ctx>* TreeMap<K,V,Ctx,Pol>::subMap(const K fromKey, const K toKey, SortedMap<K,V,Ctx>* fillmap) {
 	inttype startIndex = -1;
 	inttype endIndex = -1;
 	Node* startNode = null;
@@ -912,8 +2679,8 @@ SortedMap<K,V,Ctx>* TreeMap<K,V,Ctx>::subMap(const K fromKey, const K toKey, Sor
 	return fillmap;
 }
 
-template<typename K, typename V, typename Ctx>
-SortedMap<K,V,Ctx>* TreeMap<K,V,Ctx>::tailMap(const K fromKey, SortedMap<K,V,Ctx>* fillmap) {
+template<typename K, typename V, typename Ctx, typename Pol>
+SortedMap<K,V,Ctx>* TreeMap<K,V,Ctx,Pol>::tailMap(const K fromKey, SortedMap<K,V,Ctx>* fillmap) {
 	inttype startIndex = -1;
 	Node* startNode = null;
 	if (m_root != null) {
@@ -932,8 +2699,8 @@ SortedMap<K,V,Ctx>* TreeMap<K,V,Ctx>::tailMap(const K fromKey, SortedMap<K,V,Ctx
 	return fillmap;
 }
 
-template<typename K, typename V, typename Ctx>
-TreeIterator<MapEntry<K,V,Ctx>* >* TreeMap<K,V,Ctx>::iterator(const K startKey, TreeIterator<MapEntry<K,V,Ctx>* >* filliter, boolean ceiling, boolean* status) {
+template<typename K, typename V, typename Ctx, typename Pol>
+TreeIterator<MapEntry<K,V,Ctx>* >* TreeMap<K,V,Ctx,Pol>::iterator(const K startKey, TreeIterator<MapEntry<K,V,Ctx>* >* filliter, boolean ceiling, boolean* status) {
 	if (filliter != null) {
 		// TODO: check type
 		((TreeMapIterator<>*) filliter)->reset(this, startKey, ceiling, status);
@@ -945,42 +2712,64 @@ TreeIterator<MapEntry<K,V,Ctx>* >* TreeMap<K,V,Ctx>::iterator(const K startKey,
 	return filliter;
 }
 
-template<typename K, typename V, typename Ctx>
-TreeMap<K,V,Ctx>::Node::Node(Branch* parent, boolean isleaf):
+template<typename K, typename V, typename Ctx, typename Pol>
+TreeMap<K,V,Ctx,Pol>::Node::Node(Branch* parent, boolean isleaf):
 	m_parent(parent),
 	m_lastIndex(-1),
-	#ifdef CXX_UTIL_TREE_SLOTTED
 	m_slotIndex(-1),
-	#endif
-	m_isLeaf(isleaf) {
+	m_shares(0),
+	m_isLeaf(isleaf),
+	m_spilled(false),
+	m_referenced(false) {
 }
 
-template<typename K, typename V, typename Ctx>
-TreeMap<K,V,Ctx>::Branch::Branch(TreeMap<K,V,Ctx>* self, Branch* parent) :
-	Node(parent, false) {
+template<typename K, typename V, typename Ctx, typename Pol>
+TreeMap<K,V,Ctx,Pol>::Branch::Branch(TreeMap<K,V,Ctx,Pol>* self, Branch* parent) :
+	Node(parent, false),
+	m_count(0) {
 
-	#ifdef DEEP_DEBUG
-	m_items = (Item*) calloc(1, sizeof(Item) * (getMaxIndex(self) + 1));
-	#else
-	m_items = (Item*) malloc(sizeof(Item) * (getMaxIndex(self) + 1));
-	#endif
+	if (Pol::POOLED_NODES == true) {
+		// XXX: pooled blocks carry the item array right behind the node (see createBranch)
+		m_items = (Item*) (this + 1);
+		#ifdef DEEP_DEBUG
+		memset(m_items, 0, sizeof(Item) * (getMaxIndex(self) + 1));
+		#endif
+
+	} else {
+		#ifdef DEEP_DEBUG
+		m_items = (Item*) calloc(1, sizeof(Item) * (getMaxIndex(self) + 1));
+		#else
+		m_items = (Item*) malloc(sizeof(Item) * (getMaxIndex(self) + 1));
+		#endif
+	}
 }
 
-template<typename K, typename V, typename Ctx>
-TreeMap<K,V,Ctx>::Branch::Branch(TreeMap<K,V,Ctx>* self, Branch* parent, Node* oldroot) :
-	Node(parent, false) {
+template<typename K, typename V, typename Ctx, typename Pol>
+TreeMap<K,V,Ctx,Pol>::Branch::Branch(TreeMap<K,V,Ctx,Pol>* self, Branch* parent, Node* oldroot) :
+	Node(parent, false),
+	m_count(0) {
 
-	#ifdef DEEP_DEBUG
-	m_items = (Item*) calloc(1, sizeof(Item) * (getMaxIndex(self) + 1));
-	#else
-	m_items = (Item*) malloc(sizeof(Item) * (getMaxIndex(self) + 1));
-	#endif
+	if (Pol::POOLED_NODES == true) {
+		// XXX: pooled blocks carry the item array right behind the node (see createBranch)
+		m_items = (Item*) (this + 1);
+		#ifdef DEEP_DEBUG
+		memset(m_items, 0, sizeof(Item) * (getMaxIndex(self) + 1));
+		#endif
+
+	} else {
+		#ifdef DEEP_DEBUG
+		m_items = (Item*) calloc(1, sizeof(Item) * (getMaxIndex(self) + 1));
+		#else
+		m_items = (Item*) malloc(sizeof(Item) * (getMaxIndex(self) + 1));
+		#endif
+	}
 
-	append(oldroot, null);
+	setNode(++Node::m_lastIndex, oldroot);
+	m_count = TreeMap<K,V,Ctx,Pol>::countOf(oldroot);
 }
 
-template<typename K, typename V, typename Ctx>
-TreeMap<K,V,Ctx>::Branch::~Branch(void) {
+template<typename K, typename V, typename Ctx, typename Pol>
+TreeMap<K,V,Ctx,Pol>::Branch::~Branch(void) {
 	if (Node::m_lastIndex > 0) {
 		delete m_items[0].m_node;
 	}
@@ -989,33 +2778,36 @@ TreeMap<K,V,Ctx>::Branch::~Branch(void) {
 		delete m_items[i].m_node;
 	}
 
-	free(m_items);
+	if (Pol::POOLED_NODES == false) {
+		free(m_items);
+	}
 	#ifdef DEEP_DEBUG
 	m_items = null;
 	#endif
 }
 
-template<typename K, typename V, typename Ctx>
-void TreeMap<K,V,Ctx>::Branch::insert(TreeMap<K,V,Ctx>* self, const MapEntry<K,V,Ctx>* obj, inttype index, boolean sequential) {
+template<typename K, typename V, typename Ctx, typename Pol>
+void TreeMap<K,V,Ctx,Pol>::Branch::insert(TreeMap<K,V,Ctx,Pol>* self, const Slot& obj, inttype index, boolean sequential) {
 	Leaf* leaf = getNode(index - 1)->lastLeaf();
 	leaf->insert(self, obj, leaf->m_lastIndex + 1, sequential);
 }
 
-template<typename K, typename V, typename Ctx>
-void TreeMap<K,V,Ctx>::Branch::insert(TreeMap<K,V,Ctx>* self, Node* node, MapEntry<K,V,Ctx>* obj, inttype index) {
+template<typename K, typename V, typename Ctx, typename Pol>
+void TreeMap<K,V,Ctx,Pol>::Branch::insert(TreeMap<K,V,Ctx,Pol>* self, Node* node, const Slot& obj, inttype index) {
 	Item newitem(node, obj);
 
 	insert(self, newitem, index);
 }
 
-template<typename K, typename V, typename Ctx>
-void TreeMap<K,V,Ctx>::Branch::insertElement(Item& item, inttype index) {
+template<typename K, typename V, typename Ctx, typename Pol>
+void TreeMap<K,V,Ctx,Pol>::Branch::insertElement(Item& item, inttype index) {
 	for (inttype i = Node::m_lastIndex + 1; i > index; i--) {
-		#ifdef CXX_UTIL_TREE_SLOTTED
-		getItem(i).assign(i, getItem(i - 1));
-		#else
-		getItem(i) = getItem(i - 1);
-		#endif
+		if (Pol::SLOTTED_NODES == true) {
+			getItem(i).assign(i, getItem(i - 1));
+
+		} else {
+			getItem(i) = getItem(i - 1);
+		}
 	}
 
 	setItem(index, item);
@@ -1023,15 +2815,15 @@ void TreeMap<K,V,Ctx>::Branch::insertElement(Item& item, inttype index) {
 	Node::m_lastIndex++;
 }
 
-template<typename K, typename V, typename Ctx>
-void TreeMap<K,V,Ctx>::Branch::insertElement(Node* node, MapEntry<K,V,Ctx>* obj, inttype index) {
+template<typename K, typename V, typename Ctx, typename Pol>
+void TreeMap<K,V,Ctx,Pol>::Branch::insertElement(Node* node, const Slot& obj, inttype index) {
 	Item newitem(node, obj);
 
 	insertElement(newitem, index);
 }
 
-template<typename K, typename V, typename Ctx>
-void TreeMap<K,V,Ctx>::Branch::insert(TreeMap<K,V,Ctx>* self, Item& item, inttype index) {
+template<typename K, typename V, typename Ctx, typename Pol>
+void TreeMap<K,V,Ctx,Pol>::Branch::insert(TreeMap<K,V,Ctx,Pol>* self, Item& item, inttype index) {
 	insertElement(item, index);
 
 	if (isFull(self) == true) {
@@ -1039,8 +2831,8 @@ void TreeMap<K,V,Ctx>::Branch::insert(TreeMap<K,V,Ctx>* self, Item& item, inttyp
 	}
 }
 
-template<typename K, typename V, typename Ctx>
-void TreeMap<K,V,Ctx>::Branch::appendFrom(Branch* source, inttype begin, inttype end) {
+template<typename K, typename V, typename Ctx, typename Pol>
+void TreeMap<K,V,Ctx,Pol>::Branch::appendFrom(Branch* source, inttype begin, inttype end) {
 	if (begin > end) {
 		return;
 	}
@@ -1050,32 +2842,32 @@ void TreeMap<K,V,Ctx>::Branch::appendFrom(Branch* source, inttype begin, inttype
 	}
 }
 
-template<typename K, typename V, typename Ctx>
-void TreeMap<K,V,Ctx>::Branch::append(Node* node, MapEntry<K,V,Ctx>* obj) {
+template<typename K, typename V, typename Ctx, typename Pol>
+void TreeMap<K,V,Ctx,Pol>::Branch::append(Node* node, const Slot& obj) {
 	setItem(++Node::m_lastIndex, obj, node);
 }
 
-template<typename K, typename V, typename Ctx>
-void TreeMap<K,V,Ctx>::Branch::append(Item& item) {
+template<typename K, typename V, typename Ctx, typename Pol>
+void TreeMap<K,V,Ctx,Pol>::Branch::append(Item& item) {
 	setItem(++Node::m_lastIndex, item);
 }
 
-template<typename K, typename V, typename Ctx>
-void TreeMap<K,V,Ctx>::Branch::balanceWithLeft(Branch* lNode, inttype pIndex) {
+template<typename K, typename V, typename Ctx, typename Pol>
+void TreeMap<K,V,Ctx,Pol>::Branch::balanceWithLeft(Branch* lNode, inttype pIndex) {
 	inttype newSize = (getVirtualEntries() + lNode->getPhysicalEntries()) / 2;
 	inttype indexFromHere = getPhysicalEntries() - newSize;
 	pushLeft(indexFromHere, lNode, pIndex);
 }
 
-template<typename K, typename V, typename Ctx>
-void TreeMap<K,V,Ctx>::Branch::balanceWithRight(Branch* rNode, inttype pIndex) {
+template<typename K, typename V, typename Ctx, typename Pol>
+void TreeMap<K,V,Ctx,Pol>::Branch::balanceWithRight(Branch* rNode, inttype pIndex) {
 	inttype newSize = (getPhysicalEntries() + rNode->getVirtualEntries()) / 2;
 	inttype indexFromHere = getPhysicalEntries() - newSize;
 	pushRight(indexFromHere, rNode, pIndex);
 }
 
-template<typename K, typename V, typename Ctx>
-void TreeMap<K,V,Ctx>::Branch::balanceWith(Branch* rNode, inttype pindx) {
+template<typename K, typename V, typename Ctx, typename Pol>
+void TreeMap<K,V,Ctx,Pol>::Branch::balanceWith(Branch* rNode, inttype pindx) {
 	if (getPhysicalEntries() < rNode->getVirtualEntries()) {
 		rNode->balanceWithLeft(this, pindx);
 
@@ -1084,46 +2876,96 @@ void TreeMap<K,V,Ctx>::Branch::balanceWith(Branch* rNode, inttype pindx) {
 	}
 }
 
-template<typename K, typename V, typename Ctx>
-#ifdef COM_DEEPIS_DB_CARDINALITY /* || COM_DEEPIS_DB_INDEX_REF */
-const MapEntry<K,V,Ctx>* TreeMap<K,V,Ctx>::Branch::find(const TreeMap<K,V,Ctx>* self, const K what, Node** block, inttype* location, inttype* pos, boolean* end) {
-#else
-const MapEntry<K,V,Ctx>* TreeMap<K,V,Ctx>::Branch::find(const TreeMap<K,V,Ctx>* self, const K what, Node** block, inttype* location) {
-#endif
+template<typename K, typename V, typename Ctx, typename Pol>
+#ifdef COM_DEEPIS_DB_CARDINALITY /* || COM_DEEPIS_DB_INDEX_REF */
+const MapEntry<K,V,Ctx>* TreeMap<K,V,Ctx,Pol>::Branch::find(const TreeMap<K,V,Ctx,Pol>* self, const K what, Node** block, inttype* location, inttype* pos, boolean* end) {
+#else
+const MapEntry<K,V,Ctx>* TreeMap<K,V,Ctx,Pol>::Branch::find(const TreeMap<K,V,Ctx,Pol>* self, const K what, Node** block, inttype* location) {
+#endif
+
+	// XXX: prefixed separators compare against the probe's prefix, taken once per node (see TreeSeparator)
+	const typename Separator::Probe probe = Separator::probe(self->m_comparator, what);
+
+	if ((Pol::VECTOR_SEARCH == true) && ((Pol::INLINE_ENTRIES == true) || (SEPARATORS == true)) && (NodeSearch<K>::VECTORIZED == true)) {
+		// XXX: separator keys sit at the same offset in every item, rank them in place (see NodeSearch)
+		inttype i = NodeSearch<K>::rank(m_items[1].getKeyAddress(), sizeof(Item), Node::m_lastIndex, what) + 1;
+		if (i <= Node::m_lastIndex) {
+			if (compareKey(self, i, what, probe) == 0) {
+				*block = this;
+				*location = i;
+				return getObject(i);
+			}
+
+			#ifdef COM_DEEPIS_DB_CARDINALITY /* || COM_DEEPIS_DB_INDEX_REF */
+			return getNode(i - 1)->find(self, what, block, location, pos, null);
+			#else
+			return getNode(i - 1)->find(self, what, block, location);
+			#endif
+		}
 
-	#ifdef CXX_UTIL_TREE_BSEARCH
-	register inttype last = -1;
-	register inttype start = 1;
-	register inttype finish = Node::m_lastIndex;
-	while (start <= finish) {
-		inttype mid = (start + finish) >> 1;
-		#ifdef COM_DEEPIS_DB_CARDINALITY
-		inttype weight = self->m_comparator->compare(getObject(mid)->getKey(), what, pos);
+		#ifdef COM_DEEPIS_DB_CARDINALITY /* || COM_DEEPIS_DB_INDEX_REF */
+		return getNode(Node::m_lastIndex)->find(self, what, block, location, pos, end);
 		#else
-		inttype weight = self->m_comparator->compare(getObject(mid)->getKey(), what);
+		return getNode(Node::m_lastIndex)->find(self, what, block, location);
 		#endif
-		if (weight == 0) {
-			*block = this;
-			*location = mid;
-			return getObject(mid);
-		}
+	}
 
-		if (weight < 0) {
-			start = mid + 1;
+	if (Pol::BINARY_SEARCH == true) {
+		register inttype last = -1;
+		register inttype start = 1;
+		register inttype finish = Node::m_lastIndex;
+		while (start <= finish) {
+			inttype mid = (start + finish) >> 1;
+			#ifdef COM_DEEPIS_DB_CARDINALITY
+			inttype weight = (pos != null) ? self->m_comparator->compare(getKey(mid), what, pos) : compareKey(self, mid, what, probe);
+			#else
+			inttype weight = compareKey(self, mid, what, probe);
+			#endif
+			if (weight == 0) {
+				*block = this;
+				*location = mid;
+				return getObject(mid);
+			}
 
-		} else {
-			last = finish;
-			finish = mid - 1;
+			if (weight < 0) {
+				start = mid + 1;
+
+			} else {
+				last = finish;
+				finish = mid - 1;
+			}
+		}
+
+		if (last != -1) {
+			for (inttype i = start; i <= last; i++) {
+				#ifdef COM_DEEPIS_DB_CARDINALITY
+				inttype weight = (pos != null) ? self->m_comparator->compare(getKey(i), what, pos) : compareKey(self, i, what, probe);
+				#else
+				inttype weight = compareKey(self, i, what, probe);
+				#endif
+				if (weight > 0) {
+					#ifdef COM_DEEPIS_DB_CARDINALITY /* || COM_DEEPIS_DB_INDEX_REF */
+					return getNode(i - 1)->find(self, what, block, location, pos, null);
+					#else
+					return getNode(i - 1)->find(self, what, block, location);
+					#endif
+				}
+			}
 		}
-	}
 
-	if (last != -1) {
-		for (inttype i = start; i <= last; i++) {
+	} else {
+		for (inttype i = 1 ; i <= Node::m_lastIndex; i++) {
 			#ifdef COM_DEEPIS_DB_CARDINALITY
-			inttype weight = self->m_comparator->compare(getObject(i)->getKey(), what, pos);
+			inttype weight = (pos != null) ? self->m_comparator->compare(getKey(i), what, pos) : compareKey(self, i, what, probe);
 			#else
-			inttype weight = self->m_comparator->compare(getObject(i)->getKey(), what);
+			inttype weight = compareKey(self, i, what, probe);
 			#endif
+			if (weight == 0) {
+				*block = this;
+				*location = i;
+				return getObject(i);
+			}
+
 			if (weight > 0) {
 				#ifdef COM_DEEPIS_DB_CARDINALITY /* || COM_DEEPIS_DB_INDEX_REF */
 				return getNode(i - 1)->find(self, what, block, location, pos, null);
@@ -1133,28 +2975,6 @@ const MapEntry<K,V,Ctx>* TreeMap<K,V,Ctx>::Branch::find(const TreeMap<K,V,Ctx>*
 			}
 		}
 	}
-	#else
-	for (inttype i = 1 ; i <= Node::m_lastIndex; i++) {
-		#ifdef COM_DEEPIS_DB_CARDINALITY
-		inttype weight = self->m_comparator->compare(getObject(i)->getKey(), what, pos);
-		#else
-		inttype weight = self->m_comparator->compare(getObject(i)->getKey(), what);
-		#endif
-		if (weight == 0) {
-			*block = this;
-			*location = i;
-			return getObject(i);
-		}
-
-		if (weight > 0) {
-			#ifdef COM_DEEPIS_DB_CARDINALITY /* || COM_DEEPIS_DB_INDEX_REF */
-			return getNode(i - 1)->find(self, what, block, location, pos, null);
-			#else
-			return getNode(i - 1)->find(self, what, block, location);
-			#endif
-		}
-	}
-	#endif
 
 	#ifdef COM_DEEPIS_DB_CARDINALITY /* || COM_DEEPIS_DB_INDEX_REF */
 	return getNode(Node::m_lastIndex)->find(self, what, block, location, pos, end);
@@ -1163,10 +2983,12 @@ const MapEntry<K,V,Ctx>* TreeMap<K,V,Ctx>::Branch::find(const TreeMap<K,V,Ctx>*
 	#endif
 }
 
-template<typename K, typename V, typename Ctx>
-const MapEntry<K,V,Ctx>* TreeMap<K,V,Ctx>::Branch::lower(const TreeMap<K,V,Ctx>* self, const K what, Node** block, inttype* location, MapEntry<K,V,Ctx>** next) {
+template<typename K, typename V, typename Ctx, typename Pol>
+const MapEntry<K,V,Ctx>* TreeMap<K,V,Ctx,Pol>::Branch::lower(const TreeMap<K,V,Ctx,Pol>* self, const K what, Node** block, inttype* location, MapEntry<K,V,Ctx>** next) {
+	const typename Separator::Probe probe = Separator::probe(self->m_comparator, what);
+
 	for (inttype i = Node::m_lastIndex; i > 0; i--) {
-		inttype weight = self->m_comparator->compare(getObject(i)->getKey(), what);
+		inttype weight = compareKey(self, i, what, probe);
 		if (weight < 0) {
 			const MapEntry<K,V,Ctx>* object = getNode(i)->lower(self, what, block, location, next);
 			if (object == null) {
@@ -1192,10 +3014,12 @@ const MapEntry<K,V,Ctx>* TreeMap<K,V,Ctx>::Branch::lower(const TreeMap<K,V,Ctx>*
 	return object;
 }
 
-template<typename K, typename V, typename Ctx>
-const MapEntry<K,V,Ctx>* TreeMap<K,V,Ctx>::Branch::higher(const TreeMap<K,V,Ctx>* self, const K what, Node** block, inttype* location, MapEntry<K,V,Ctx>** prev) {
+template<typename K, typename V, typename Ctx, typename Pol>
+const MapEntry<K,V,Ctx>* TreeMap<K,V,Ctx,Pol>::Branch::higher(const TreeMap<K,V,Ctx,Pol>* self, const K what, Node** block, inttype* location, MapEntry<K,V,Ctx>** prev) {
+	const typename Separator::Probe probe = Separator::probe(self->m_comparator, what);
+
 	for (inttype i = 1 ; i <= Node::m_lastIndex; i++) {
-		inttype weight = self->m_comparator->compare(getObject(i)->getKey(), what);
+		inttype weight = compareKey(self, i, what, probe);
 		if (weight > 0) {
 			const MapEntry<K,V,Ctx>* object = getNode(i - 1)->higher(self, what, block, location, prev);
 			if (object == null) {
@@ -1221,8 +3045,8 @@ const MapEntry<K,V,Ctx>* TreeMap<K,V,Ctx>::Branch::higher(const TreeMap<K,V,Ctx>
 	return object;
 }
 
-template<typename K, typename V, typename Ctx>
-const MapEntry<K,V,Ctx>* TreeMap<K,V,Ctx>::Branch::getEntry(inttype index) {
+template<typename K, typename V, typename Ctx, typename Pol>
+const MapEntry<K,V,Ctx>* TreeMap<K,V,Ctx,Pol>::Branch::getEntry(inttype index) {
 	if ((index > 0) && (index <= Node::m_lastIndex)) {
 		return getObject(index);
 	}
@@ -1230,8 +3054,8 @@ const MapEntry<K,V,Ctx>* TreeMap<K,V,Ctx>::Branch::getEntry(inttype index) {
 	return null;
 }
 
-template<typename K, typename V, typename Ctx>
-const MapEntry<K,V,Ctx>* TreeMap<K,V,Ctx>::Branch::nextEntry(inttype index, Node** block, inttype* location) {
+template<typename K, typename V, typename Ctx, typename Pol>
+const MapEntry<K,V,Ctx>* TreeMap<K,V,Ctx,Pol>::Branch::nextEntry(inttype index, Node** block, inttype* location) {
 	if (index <= Node::m_lastIndex) {
 		*block = getNode(index)->firstLeaf();
 		*location = 0;
@@ -1243,8 +3067,8 @@ const MapEntry<K,V,Ctx>* TreeMap<K,V,Ctx>::Branch::nextEntry(inttype index, Node
 	return null;
 }
 
-template<typename K, typename V, typename Ctx>
-const MapEntry<K,V,Ctx>* TreeMap<K,V,Ctx>::Branch::previousEntry(inttype index, Node** block, inttype* location) {
+template<typename K, typename V, typename Ctx, typename Pol>
+const MapEntry<K,V,Ctx>* TreeMap<K,V,Ctx,Pol>::Branch::previousEntry(inttype index, Node** block, inttype* location) {
 	if (index > 0) {
 		*block = getNode(index-1)->lastLeaf();
 		*location = ((Leaf*)*block)->m_lastIndex;
@@ -1256,23 +3080,78 @@ const MapEntry<K,V,Ctx>* TreeMap<K,V,Ctx>::Branch::previousEntry(inttype index,
 	return null;
 }
 
-template<typename K, typename V, typename Ctx>
-inttype TreeMap<K,V,Ctx>::Branch::instanceIndex(const Node* node) const {
-	#ifdef CXX_UTIL_TREE_SLOTTED
-	return node->m_slotIndex;
-	#else
+template<typename K, typename V, typename Ctx, typename Pol>
+typename TreeMap<K,V,Ctx,Pol>::Node* TreeMap<K,V,Ctx,Pol>::Branch::step(const TreeMap<K,V,Ctx,Pol>* self, const K what, const MapEntry<K,V,Ctx>** entry) const {
+	const typename Separator::Probe probe = Separator::probe(self->m_comparator, what);
+
+	inttype start = 1;
+	inttype finish = Node::m_lastIndex;
+	while (start <= finish) {
+		inttype mid = (start + finish) >> 1;
+		inttype weight = compareKey(self, mid, what, probe);
+		if (weight == 0) {
+			*entry = getObject(mid);
+			return null;
+		}
+
+		if (weight < 0) {
+			start = mid + 1;
+
+		} else {
+			finish = mid - 1;
+		}
+	}
+
+	return getNode(start - 1);
+}
+
+template<typename K, typename V, typename Ctx, typename Pol>
+void TreeMap<K,V,Ctx,Pol>::Branch::recount(void) {
+	inttype count = Node::m_lastIndex;
 	for (inttype i = 0; i <= Node::m_lastIndex; i++) {
-		if (getNode(i) == node) {
-			return i;
+		count += TreeMap<K,V,Ctx,Pol>::countOf(getNode(i));
+	}
+
+	m_count = count;
+}
+
+template<typename K, typename V, typename Ctx, typename Pol>
+inttype TreeMap<K,V,Ctx,Pol>::Branch::bound(const TreeMap<K,V,Ctx,Pol>* self, const K what) const {
+	const typename Separator::Probe probe = Separator::probe(self->m_comparator, what);
+
+	inttype start = 1;
+	inttype finish = Node::m_lastIndex;
+	while (start <= finish) {
+		inttype mid = (start + finish) >> 1;
+		if (compareKey(self, mid, what, probe) < 0) {
+			start = mid + 1;
+
+		} else {
+			finish = mid - 1;
 		}
 	}
 
-	return 0;
-	#endif
+	return start;
+}
+
+template<typename K, typename V, typename Ctx, typename Pol>
+inttype TreeMap<K,V,Ctx,Pol>::Branch::instanceIndex(const Node* node) const {
+	if (Pol::SLOTTED_NODES == true) {
+		return node->m_slotIndex;
+
+	} else {
+		for (inttype i = 0; i <= Node::m_lastIndex; i++) {
+			if (getNode(i) == node) {
+				return i;
+			}
+		}
+
+		return 0;
+	}
 }
 
-template<typename K, typename V, typename Ctx>
-void TreeMap<K,V,Ctx>::Branch::notifyParent(TreeMap<K,V,Ctx>* self) {
+template<typename K, typename V, typename Ctx, typename Pol>
+void TreeMap<K,V,Ctx,Pol>::Branch::notifyParent(TreeMap<K,V,Ctx,Pol>* self) {
 	if (Node::m_parent != null) {
 		Node::m_parent->isFull(self, this, false);
 
@@ -1281,8 +3160,8 @@ void TreeMap<K,V,Ctx>::Branch::notifyParent(TreeMap<K,V,Ctx>* self) {
 	}
 }
 
-template<typename K, typename V, typename Ctx>
-void TreeMap<K,V,Ctx>::Branch::isFull(TreeMap<K,V,Ctx>* self, Node* node, boolean sequential) {
+template<typename K, typename V, typename Ctx, typename Pol>
+void TreeMap<K,V,Ctx,Pol>::Branch::isFull(TreeMap<K,V,Ctx,Pol>* self, Node* node, boolean sequential) {
 	if (node->isLeaf() == true) {
 		Leaf* left = null;
 		Leaf* right = null;
@@ -1347,8 +3226,8 @@ void TreeMap<K,V,Ctx>::Branch::isFull(TreeMap<K,V,Ctx>* self, Node* node, boolea
 	}
 }
 
-template<typename K, typename V, typename Ctx>
-void TreeMap<K,V,Ctx>::Branch::isLow(TreeMap<K,V,Ctx>* self, Node* node) {
+template<typename K, typename V, typename Ctx, typename Pol>
+void TreeMap<K,V,Ctx,Pol>::Branch::isLow(TreeMap<K,V,Ctx,Pol>* self, Node* node) {
 	if (node->isLeaf() == true) {
 		Leaf* left = null;
 		Leaf* right = null;
@@ -1393,97 +3272,106 @@ void TreeMap<K,V,Ctx>::Branch::isLow(TreeMap<K,V,Ctx>* self, Node* node) {
 	}
 }
 
-template<typename K, typename V, typename Ctx>
-typename TreeMap<K,V,Ctx>::Leaf* TreeMap<K,V,Ctx>::Branch::firstLeaf(void) {
+template<typename K, typename V, typename Ctx, typename Pol>
+typename TreeMap<K,V,Ctx,Pol>::Leaf* TreeMap<K,V,Ctx,Pol>::Branch::firstLeaf(void) {
 	return getNode(0)->firstLeaf();
 }
 
-template<typename K, typename V, typename Ctx>
-typename TreeMap<K,V,Ctx>::Leaf* TreeMap<K,V,Ctx>::Branch::lastLeaf(void) {
+template<typename K, typename V, typename Ctx, typename Pol>
+typename TreeMap<K,V,Ctx,Pol>::Leaf* TreeMap<K,V,Ctx,Pol>::Branch::lastLeaf(void) {
 	return getNode(Node::m_lastIndex)->lastLeaf();
 }
 
-template<typename K, typename V, typename Ctx>
-void TreeMap<K,V,Ctx>::Branch::mergeWithRight(TreeMap<K,V,Ctx>* self, Branch* rNode, inttype pIndex) {
+template<typename K, typename V, typename Ctx, typename Pol>
+void TreeMap<K,V,Ctx,Pol>::Branch::mergeWithRight(TreeMap<K,V,Ctx,Pol>* self, Branch* rNode, inttype pIndex) {
 	if (rNode->getPhysicalEntries() > 0) {
 		rNode->pushLeft(rNode->getPhysicalEntries(), this, pIndex);
 	}
 
-	rNode->setObject(0, Node::m_parent->getObject(pIndex));
+	rNode->setObject(0, Node::m_parent->getSlot(pIndex));
 
 	appendFrom(rNode, 0, 0);
+	recount();
 
 	Node::m_parent->removeItem(self, pIndex);
 
-	delete rNode;
+	self->destroyNode(rNode);
 }
 
-template<typename K, typename V, typename Ctx>
-void TreeMap<K,V,Ctx>::Branch::pushLeft(inttype indexFromHere, Branch* lNode, inttype pIndex) {
-	setObject(0, Node::m_parent->getObject(pIndex));
+template<typename K, typename V, typename Ctx, typename Pol>
+void TreeMap<K,V,Ctx,Pol>::Branch::pushLeft(inttype indexFromHere, Branch* lNode, inttype pIndex) {
+	setObject(0, Node::m_parent->getSlot(pIndex));
 
 	lNode->appendFrom(this, 0, indexFromHere - 1);
 
 	shiftLeft(indexFromHere);
 
-	Node::m_parent->setObject(pIndex, getObject(0));
+	Node::m_parent->setObject(pIndex, getSlot(0));
+
+	recount();
+	lNode->recount();
 }
 
-template<typename K, typename V, typename Ctx>
-void TreeMap<K,V,Ctx>::Branch::pushRight(inttype indexFromHere, Branch* rNode, inttype pIndex) {
+template<typename K, typename V, typename Ctx, typename Pol>
+void TreeMap<K,V,Ctx,Pol>::Branch::pushRight(inttype indexFromHere, Branch* rNode, inttype pIndex) {
 	inttype begin = Node::m_lastIndex - indexFromHere + 1;
 	inttype target = rNode->m_lastIndex + indexFromHere;
 	inttype source = rNode->m_lastIndex;
 
 	rNode->m_lastIndex = target;
-	rNode->setObject(0, Node::m_parent->getObject(pIndex));
+	rNode->setObject(0, Node::m_parent->getSlot(pIndex));
 
 	while (source >= 0) {
-		#ifdef CXX_UTIL_TREE_SLOTTED
-		rNode->getItem(target).assign(target, rNode->getItem(source));
-		target--;
-		source--;
-		#else
-		rNode->getItem(target--) = rNode->getItem(source--);
-		#endif
+		if (Pol::SLOTTED_NODES == true) {
+			rNode->getItem(target).assign(target, rNode->getItem(source));
+			target--;
+			source--;
+
+		} else {
+			rNode->getItem(target--) = rNode->getItem(source--);
+		}
 	}
 
 	for (inttype i = Node::m_lastIndex; i >= begin; i-- ) {
 		rNode->setItem(target--, getItem(i));
 	}
 
-	Node::m_parent->setObject(pIndex, rNode->getObject(0));
+	Node::m_parent->setObject(pIndex, rNode->getSlot(0));
 
 	Node::m_lastIndex -= indexFromHere;
+
+	recount();
+	rNode->recount();
 }
 
-template<typename K, typename V, typename Ctx>
-void TreeMap<K,V,Ctx>::Branch::remove(TreeMap<K,V,Ctx>* self, inttype index) {
+template<typename K, typename V, typename Ctx, typename Pol>
+void TreeMap<K,V,Ctx,Pol>::Branch::remove(TreeMap<K,V,Ctx,Pol>* self, inttype index) {
 	Leaf* leaf = getNode(index)->firstLeaf();
 
-	setObject(index, leaf->m_objects[0]);
+	setObject(index, leaf->getSlot(0));
 
 	leaf->removeItem(self, 0);
 }
 
-template<typename K, typename V, typename Ctx>
-void TreeMap<K,V,Ctx>::Branch::removeItem(TreeMap<K,V,Ctx>* self, inttype index) {
+template<typename K, typename V, typename Ctx, typename Pol>
+void TreeMap<K,V,Ctx,Pol>::Branch::removeItem(TreeMap<K,V,Ctx,Pol>* self, inttype index) {
 	for (inttype to = index; to < Node::m_lastIndex; to++) {
-		#ifdef CXX_UTIL_TREE_SLOTTED
-		m_items[to].assign(to, m_items[to + 1]);
-		#else
-		m_items[to] = m_items[to + 1];
-		#endif
+		if (Pol::SLOTTED_NODES == true) {
+			m_items[to].assign(to, m_items[to + 1]);
+
+		} else {
+			m_items[to] = m_items[to + 1];
+		}
 
 		#ifdef DEEP_DEBUG
 		m_items[to + 1].m_node = null;
-		m_items[to + 1].m_object = null;
+		Entries::reset(m_items[to + 1].m_object);
 		#endif
 	}
 
 	#ifdef DEEP_DEBUG
 	m_items[Node::m_lastIndex].m_node = null;
-	m_items[Node::m_lastIndex].m_object = null;
+	Entries::reset(m_items[Node::m_lastIndex].m_object);
 	#endif
 
 	Node::m_lastIndex--;
@@ -1500,39 +3388,43 @@ void TreeMap<K,V,Ctx>::Branch::removeItem(TreeMap<K,V,Ctx>* self, inttype index)
 	}
 }
 
-template<typename K, typename V, typename Ctx>
-void TreeMap<K,V,Ctx>::Branch::shiftLeft(inttype count) {
+template<typename K, typename V, typename Ctx, typename Pol>
+void TreeMap<K,V,Ctx,Pol>::Branch::shiftLeft(inttype count) {
 	if (count <= 0) {
 		return;
 	}
 
 	for (inttype i = count; i <= Node::m_lastIndex; i++) {
-		#ifdef CXX_UTIL_TREE_SLOTTED
-		getItem(i - count).assign(i - count, getItem(i));
-		#else
-		getItem(i - count) = getItem(i);
-		#endif
+		if (Pol::SLOTTED_NODES == true) {
+			getItem(i - count).assign(i - count, getItem(i));
+
+		} else {
+			getItem(i - count) = getItem(i);
+		}
 	}
 
 	Node::m_lastIndex -= count;
 }
 
-template<typename K, typename V, typename Ctx>
-void TreeMap<K,V,Ctx>::Branch::split(TreeMap<K,V,Ctx>* self) {
-	Branch* nNode = new Branch(self, Node::m_parent);
+template<typename K, typename V, typename Ctx, typename Pol>
+void TreeMap<K,V,Ctx,Pol>::Branch::split(TreeMap<K,V,Ctx,Pol>* self) {
+	Branch* nNode = self->createBranch(Node::m_parent);
 
-	Node::m_parent->append(nNode, getObject(Node::m_lastIndex));
+	Node::m_parent->append(nNode, getSlot(Node::m_lastIndex));
 
 	nNode->appendFrom(this, Node::m_lastIndex, Node::m_lastIndex);
 
 	Node::m_lastIndex--;
 
 	balanceWithRight(nNode, 1);
+
+	recount();
+	nNode->recount();
 }
 
-template<typename K, typename V, typename Ctx>
-void TreeMap<K,V,Ctx>::Branch::splitWith(TreeMap<K,V,Ctx>* self, Branch* rNode, inttype kIndex) {
-	rNode->setObject(0, Node::m_parent->getObject(kIndex));
+template<typename K, typename V, typename Ctx, typename Pol>
+void TreeMap<K,V,Ctx,Pol>::Branch::splitWith(TreeMap<K,V,Ctx,Pol>* self, Branch* rNode, inttype kIndex) {
+	rNode->setObject(0, Node::m_parent->getSlot(kIndex));
 
 	inttype numberOfKeys = getPhysicalEntries() + rNode->getVirtualEntries();
 	inttype newSizeOne3rd = numberOfKeys / 3;
@@ -1541,10 +3433,10 @@ void TreeMap<K,V,Ctx>::Branch::splitWith(TreeMap<K,V,Ctx>* self, Branch* rNode,
 	inttype indexFromHere = getPhysicalEntries() - newSizeOne3rd;
 	inttype indexFromNode = rNode->getVirtualEntries() - newSizeOfNode;
 
-	Branch* nNode = new Branch(self, Node::m_parent);
+	Branch* nNode = self->createBranch(Node::m_parent);
 	if (indexFromHere > 0) {
 		nNode->append(getItem(Node::m_lastIndex));
-		Node::m_parent->insertElement(nNode, getObject(Node::m_lastIndex--), kIndex);
+		Node::m_parent->insertElement(nNode, getSlot(Node::m_lastIndex--), kIndex);
 
 		if (indexFromHere > 2) {
 			pushRight(indexFromHere - 1, nNode, kIndex);
@@ -1555,53 +3447,122 @@ void TreeMap<K,V,Ctx>::Branch::splitWith(TreeMap<K,V,Ctx>* self, Branch* rNode,
 	} else {
 		nNode->append(rNode->getItem(0));
 
-		Node::m_parent->insertElement(rNode, rNode->getObject(1), kIndex + 1);
+		Node::m_parent->insertElement(rNode, rNode->getSlot(1), kIndex + 1);
 
 		rNode->shiftLeft(1);
 		Node::m_parent->setNode(kIndex, nNode);
 		rNode->pushLeft(indexFromNode - 1, nNode, kIndex + 1);
 	}
 
+	recount();
+	nNode->recount();
+	rNode->recount();
+
 	if (Node::m_parent->isFull(self) == true) {
 		Node::m_parent->notifyParent(self);
 	}
 }
 
-template<typename K, typename V, typename Ctx>
-TreeMap<K,V,Ctx>::Leaf::Leaf(TreeMap<K,V,Ctx>* self, Branch* parent, const MapEntry<K,V,Ctx>* obj):
-	Node(parent, true) {
+template<typename K, typename V, typename Ctx, typename Pol>
+TreeMap<K,V,Ctx,Pol>::Leaf::Leaf(TreeMap<K,V,Ctx,Pol>* self, Branch* parent, const Slot* obj):
+	Node(parent, true),
+	m_prev(null),
+	m_next(null) {
 
-	inttype msize = (getMaxIndex(self) + 1) * sizeof(MapEntry<K,V,Ctx>*);
-	m_objects = (MapEntry<K,V,Ctx>**) malloc(msize);
-	memset(m_objects, 0, msize);
+	inttype msize = (getMaxIndex(self) + 1) * sizeof(Slot);
+	if (Pol::POOLED_NODES == true) {
+		// XXX: pooled blocks carry the entry array right behind the node (see createLeaf)
+		m_objects = (Slot*) (this + 1);
+
+	} else {
+		m_objects = (Slot*) malloc(msize);
+	}
+
+	// XXX: inline entries are always written before they are read, only pointer slots are cleared
+	if (Pol::INLINE_ENTRIES == false) {
+		memset((void*) m_objects, 0, msize);
+	}
 
 	if (obj != null) {
-		m_objects[++Node::m_lastIndex] = (MapEntry<K,V,Ctx>*) obj;
+		m_objects[++Node::m_lastIndex] = *obj;
 	}
 }
 
-template<typename K, typename V, typename Ctx>
-TreeMap<K,V,Ctx>::Leaf::~Leaf(void) {
-	free(m_objects);
+template<typename K, typename V, typename Ctx, typename Pol>
+TreeMap<K,V,Ctx,Pol>::Leaf::~Leaf(void) {
+	if ((Pol::SPILL_LEAVES == true) && (Node::m_spilled == true)) {
+		// XXX: never read back, only the page goes back to the file
+		TreeSpillPage* stub = (TreeSpillPage*) m_objects;
+		stub->m_spill->release(stub);
+
+	} else if (Pol::POOLED_NODES == false) {
+		free(m_objects);
+	}
 	#ifdef DEEP_DEBUG
 	m_objects = null;
 	#endif
 }
 
-template<typename K, typename V, typename Ctx>
-void TreeMap<K,V,Ctx>::Leaf::insert(TreeMap<K,V,Ctx>* self, const MapEntry<K,V,Ctx>* obj, inttype index, boolean sequential) {
+template<typename K, typename V, typename Ctx, typename Pol>
+void TreeMap<K,V,Ctx,Pol>::Leaf::fault(void) {
+	TreeSpillPage* stub = (TreeSpillPage*) m_objects;
+	TreeSpill* spill = stub->m_spill;
+
+	Slot* objects = (Slot*) malloc(spill->getPageSize());
+	spill->read(stub, objects);
+
+	m_objects = objects;
+	Node::m_spilled = false;
+}
+
+template<typename K, typename V, typename Ctx, typename Pol>
+void TreeMap<K,V,Ctx,Pol>::Leaf::insert(TreeMap<K,V,Ctx,Pol>* self, const Slot& obj, inttype index, boolean sequential) {
+	touch();
+
 	for (inttype i = Node::m_lastIndex + 1; i > index ; i--) {
 		m_objects[i] = m_objects[i - 1];
 		#ifdef DEEP_DEBUG
-		m_objects[i - 1] = null;
+		Entries::reset(m_objects[i - 1]);
 		#endif
 	}
 
-	m_objects[index] = (MapEntry<K,V,Ctx>*) obj;
+	m_objects[index] = obj;
 
 	Node::m_lastIndex++;
 
 	self->incrementEntries();
+	self->adjustCounts(Node::m_parent, 1);
+
+	if (isFull(self) == true) {
+		if (Node::m_parent != null) {
+			Node::m_parent->isFull(self, this, sequential);
+
+		} else {
+			self->notifyRootFull();
+		}
+	}
+}
+
+// XXX: objs[i] goes in front of the entry at indexes[i] (ascending, original positions), moved into place back to front in one pass
+template<typename K, typename V, typename Ctx, typename Pol>
+void TreeMap<K,V,Ctx,Pol>::Leaf::insert(TreeMap<K,V,Ctx,Pol>* self, const Slot* objs, const inttype* indexes, inttype count, boolean sequential) {
+	touch();
+
+	inttype source = Node::m_lastIndex;
+	inttype target = Node::m_lastIndex + count;
+
+	for (inttype i = count - 1; i >= 0; i--) {
+		for (; source >= indexes[i]; source--, target--) {
+			m_objects[target] = m_objects[source];
+		}
+
+		m_objects[target--] = objs[i];
+	}
+
+	Node::m_lastIndex += count;
+
+	self->incrementEntries(count);
+	self->adjustCounts(Node::m_parent, count);
 
 	if (isFull(self) == true) {
 		if (Node::m_parent != null) {
@@ -1613,65 +3574,116 @@ void TreeMap<K,V,Ctx>::Leaf::insert(TreeMap<K,V,Ctx>* self, const MapEntry<K,V,C
 	}
 }
 
-template<typename K, typename V, typename Ctx>
-void TreeMap<K,V,Ctx>::Leaf::appendFrom(Leaf* source, inttype begin, inttype end) {
+template<typename K, typename V, typename Ctx, typename Pol>
+void TreeMap<K,V,Ctx,Pol>::Leaf::appendFrom(Leaf* source, inttype begin, inttype end) {
 	if (begin > end) {
 		return;
 	}
 
+	touch();
+	source->touch();
+
 	for (inttype i = begin; i <= end; i++) {
 		m_objects[++Node::m_lastIndex] = source->m_objects[i];
 		#ifdef DEEP_DEBUG
-		source->m_objects[i] = null;
+		Entries::reset(source->m_objects[i]);
 		#endif
 	}
 }
 
-template<typename K, typename V, typename Ctx>
-void TreeMap<K,V,Ctx>::Leaf::append(MapEntry<K,V,Ctx>* obj) {
+template<typename K, typename V, typename Ctx, typename Pol>
+void TreeMap<K,V,Ctx,Pol>::Leaf::append(const Slot& obj) {
+	touch();
+
 	m_objects[++Node::m_lastIndex] = obj;
 }
 
-template<typename K, typename V, typename Ctx>
+template<typename K, typename V, typename Ctx, typename Pol>
 #ifdef COM_DEEPIS_DB_CARDINALITY /* || COM_DEEPIS_DB_INDEX_REF */
-const MapEntry<K,V,Ctx>* TreeMap<K,V,Ctx>::Leaf::find(const TreeMap<K,V,Ctx>* self, const K what, Node** block, inttype* location, inttype* pos, boolean* end) {
+const MapEntry<K,V,Ctx>* TreeMap<K,V,Ctx,Pol>::Leaf::find(const TreeMap<K,V,Ctx,Pol>* self, const K what, Node** block, inttype* location, inttype* pos, boolean* end) {
 #else
-const MapEntry<K,V,Ctx>* TreeMap<K,V,Ctx>::Leaf::find(const TreeMap<K,V,Ctx>* self, const K what, Node** block, inttype* location) {
+const MapEntry<K,V,Ctx>* TreeMap<K,V,Ctx,Pol>::Leaf::find(const TreeMap<K,V,Ctx,Pol>* self, const K what, Node** block, inttype* location) {
 #endif
+	touch();
+
+	if ((Pol::VECTOR_SEARCH == true) && (Pol::INLINE_ENTRIES == true) && (NodeSearch<K>::VECTORIZED == true)) {
+		// XXX: inline entries lead with their key, rank them in place (see NodeSearch)
+		inttype i = NodeSearch<K>::rank((const K*) m_objects, sizeof(Slot), Node::m_lastIndex + 1, what);
+
+		*block = this;
+		*location = i;
+
+		if (i <= Node::m_lastIndex) {
+			if (self->m_comparator->compare(getObject(i)->getKey(), what) == 0) {
+				return getObject(i);
+			}
+
+			return null;
+		}
 
-	#ifdef CXX_UTIL_TREE_BSEARCH
-	register inttype last = -1;
-	register inttype start = 0;
-	register inttype finish = Node::m_lastIndex;
-	while (start <= finish) {
-		inttype mid = (start + finish) >> 1;
 		#ifdef COM_DEEPIS_DB_CARDINALITY
-		inttype weight = self->m_comparator->compare(m_objects[mid]->getKey(), what, pos);
-		#else
-		inttype weight = self->m_comparator->compare(m_objects[mid]->getKey(), what);
-		#endif
-		if (weight == 0) {
-			*block = this;
-			*location = mid;
-			return m_objects[mid];
+		if (end != null) {
+			*end = true;
 		}
+		#endif
 
-		if (weight < 0) {
-			start = mid + 1;
+		return null;
+	}
 
-		} else {
-			last = finish;
-			finish = mid - 1;
+	if (Pol::BINARY_SEARCH == true) {
+		register inttype last = -1;
+		register inttype start = 0;
+		register inttype finish = Node::m_lastIndex;
+		while (start <= finish) {
+			inttype mid = (start + finish) >> 1;
+			#ifdef COM_DEEPIS_DB_CARDINALITY
+			inttype weight = self->m_comparator->compare(getObject(mid)->getKey(), what, pos);
+			#else
+			inttype weight = self->m_comparator->compare(getObject(mid)->getKey(), what);
+			#endif
+			if (weight == 0) {
+				*block = this;
+				*location = mid;
+				return getObject(mid);
+			}
+
+			if (weight < 0) {
+				start = mid + 1;
+
+			} else {
+				last = finish;
+				finish = mid - 1;
+			}
 		}
-	}
 
-	if (last != -1) {
-		for (inttype i = start; i <= last; i++) {
+		if (last != -1) {
+			for (inttype i = start; i <= last; i++) {
+				#ifdef COM_DEEPIS_DB_CARDINALITY
+				inttype weight = self->m_comparator->compare(getObject(i)->getKey(), what, pos);
+				#else
+				inttype weight = self->m_comparator->compare(getObject(i)->getKey(), what);
+				#endif
+				if (weight > 0) {
+					*block = this;
+					*location = i;
+					return null;
+				}
+			}
+		}
+
+	} else {
+		for (inttype i = 0; i <= Node::m_lastIndex; i++) {
 			#ifdef COM_DEEPIS_DB_CARDINALITY
-			inttype weight = self->m_comparator->compare(m_objects[i]->getKey(), what, pos);
+			inttype weight = self->m_comparator->compare(getObject(i)->getKey(), what, pos);
 			#else
-			inttype weight = self->m_comparator->compare(m_objects[i]->getKey(), what);
+			inttype weight = self->m_comparator->compare(getObject(i)->getKey(), what);
 			#endif
+			if (weight == 0) {
+				*block = this;
+				*location = i;
+				return getObject(i);
+			}
+
 			if (weight > 0) {
 				*block = this;
 				*location = i;
@@ -1679,26 +3691,6 @@ const MapEntry<K,V,Ctx>* TreeMap<K,V,Ctx>::Leaf::find(const TreeMap<K,V,Ctx>* se
 			}
 		}
 	}
-	#else
-	for (inttype i = 0; i <= Node::m_lastIndex; i++) {
-		#ifdef COM_DEEPIS_DB_CARDINALITY
-		inttype weight = self->m_comparator->compare(m_objects[i]->getKey(), what, pos);
-		#else
-		inttype weight = self->m_comparator->compare(m_objects[i]->getKey(), what);
-		#endif
-		if (weight == 0) {
-			*block = this;
-			*location = i;
-			return m_objects[i];
-		}
-
-		if (weight > 0) {
-			*block = this;
-			*location = i;
-			return null;
-		}
-	}
-	#endif
 
 	*block = this;
 	*location = Node::m_lastIndex + 1;
@@ -1712,18 +3704,18 @@ const MapEntry<K,V,Ctx>* TreeMap<K,V,Ctx>::Leaf::find(const TreeMap<K,V,Ctx>* se
 	return null;
 }
 
-template<typename K, typename V, typename Ctx>
-const MapEntry<K,V,Ctx>* TreeMap<K,V,Ctx>::Leaf::lower(const TreeMap<K,V,Ctx>* self, const K what, Node** block, inttype* location, MapEntry<K,V,Ctx>** next) {
+template<typename K, typename V, typename Ctx, typename Pol>
+const MapEntry<K,V,Ctx>* TreeMap<K,V,Ctx,Pol>::Leaf::lower(const TreeMap<K,V,Ctx,Pol>* self, const K what, Node** block, inttype* location, MapEntry<K,V,Ctx>** next) {
 	*next = null;
 	for (inttype i = Node::m_lastIndex; i >= 0; i--) {
-		inttype weight = self->m_comparator->compare(m_objects[i]->getKey(), what);
+		inttype weight = self->m_comparator->compare(getObject(i)->getKey(), what);
 		if (weight < 0) {
 			*block = this;
 			*location = i;
-			return m_objects[i];
+			return getObject(i);
 		}
 
-		*next = m_objects[i];
+		*next = getObject(i);
 	}
 
 	*block = this;
@@ -1731,18 +3723,18 @@ const MapEntry<K,V,Ctx>* TreeMap<K,V,Ctx>::Leaf::lower(const TreeMap<K,V,Ctx>* s
 	return null;
 }
 
-template<typename K, typename V, typename Ctx>
-const MapEntry<K,V,Ctx>* TreeMap<K,V,Ctx>::Leaf::higher(const TreeMap<K,V,Ctx>* self, const K what, Node** block, inttype* location, MapEntry<K,V,Ctx>** prev) {
+template<typename K, typename V, typename Ctx, typename Pol>
+const MapEntry<K,V,Ctx>* TreeMap<K,V,Ctx,Pol>::Leaf::higher(const TreeMap<K,V,Ctx,Pol>* self, const K what, Node** block, inttype* location, MapEntry<K,V,Ctx>** prev) {
 	*prev = null;
 	for (inttype i = 0; i <= Node::m_lastIndex; i++) {
-		inttype weight = self->m_comparator->compare(m_objects[i]->getKey(), what);
+		inttype weight = self->m_comparator->compare(getObject(i)->getKey(), what);
 		if (weight > 0) {
 			*block = this;
 			*location = i;
-			return m_objects[i];
+			return getObject(i);
 		}
 
-		*prev = m_objects[i];
+		*prev = getObject(i);
 	}
 
 	*block = this;
@@ -1750,8 +3742,8 @@ const MapEntry<K,V,Ctx>* TreeMap<K,V,Ctx>::Leaf::higher(const TreeMap<K,V,Ctx>*
 	return null;
 }
 
-template<typename K, typename V, typename Ctx>
-const MapEntry<K,V,Ctx>* TreeMap<K,V,Ctx>::Leaf::getEntry(inttype index) {
+template<typename K, typename V, typename Ctx, typename Pol>
+const MapEntry<K,V,Ctx>* TreeMap<K,V,Ctx,Pol>::Leaf::getEntry(inttype index) {
 	if ((index >= 0) && (index <= Node::m_lastIndex)) {
 		return getObject(index);
 	}
@@ -1759,12 +3751,12 @@ const MapEntry<K,V,Ctx>* TreeMap<K,V,Ctx>::Leaf::getEntry(inttype index) {
 	return null;
 }
 
-template<typename K, typename V, typename Ctx>
-const MapEntry<K,V,Ctx>* TreeMap<K,V,Ctx>::Leaf::nextEntry(inttype index, Node** block, inttype* location) {
+template<typename K, typename V, typename Ctx, typename Pol>
+const MapEntry<K,V,Ctx>* TreeMap<K,V,Ctx,Pol>::Leaf::nextEntry(inttype index, Node** block, inttype* location) {
 	if (index < Node::m_lastIndex) {
 		*block = this;
 		*location = ++index;
-		return m_objects[index];
+		return getObject(index);
 
 	}
 
@@ -1773,12 +3765,12 @@ const MapEntry<K,V,Ctx>* TreeMap<K,V,Ctx>::Leaf::nextEntry(inttype index, Node**
 	return null;
 }
 
-template<typename K, typename V, typename Ctx>
-const MapEntry<K,V,Ctx>* TreeMap<K,V,Ctx>::Leaf::previousEntry(inttype index, Node** block, inttype* location) {
+template<typename K, typename V, typename Ctx, typename Pol>
+const MapEntry<K,V,Ctx>* TreeMap<K,V,Ctx,Pol>::Leaf::previousEntry(inttype index, Node** block, inttype* location) {
 	if (index > 0) {
 		*block = this;
 		*location = --index;
-		return m_objects[index];
+		return getObject(index);
 
 	}
 
@@ -1787,10 +3779,44 @@ const MapEntry<K,V,Ctx>* TreeMap<K,V,Ctx>::Leaf::previousEntry(inttype index, No
 	return null;
 }
 
-template<typename K, typename V, typename Ctx>
-inttype TreeMap<K,V,Ctx>::Leaf::instanceIndex(const MapEntry<K,V,Ctx>* obj) const {
+template<typename K, typename V, typename Ctx, typename Pol>
+inttype TreeMap<K,V,Ctx,Pol>::Leaf::bound(const TreeMap<K,V,Ctx,Pol>* self, const K what) const {
+	inttype start = 0;
+	inttype finish = Node::m_lastIndex;
+	while (start <= finish) {
+		inttype mid = (start + finish) >> 1;
+		if (self->m_comparator->compare(getObject(mid)->getKey(), what) < 0) {
+			start = mid + 1;
+
+		} else {
+			finish = mid - 1;
+		}
+	}
+
+	return start;
+}
+
+template<typename K, typename V, typename Ctx, typename Pol>
+void TreeMap<K,V,Ctx,Pol>::Leaf::cut(inttype index, inttype count) {
+	touch();
+
+	for (inttype i = index + count; i <= Node::m_lastIndex; i++) {
+		m_objects[i - count] = m_objects[i];
+	}
+
+	#ifdef DEEP_DEBUG
+	for (inttype i = Node::m_lastIndex - count + 1; i <= Node::m_lastIndex; i++) {
+		Entries::reset(m_objects[i]);
+	}
+	#endif
+
+	Node::m_lastIndex -= count;
+}
+
+template<typename K, typename V, typename Ctx, typename Pol>
+inttype TreeMap<K,V,Ctx,Pol>::Leaf::instanceIndex(const MapEntry<K,V,Ctx>* obj) const {
 	for (inttype i = 0; i <= Node::m_lastIndex; i++) {
-		if (m_objects[i] == obj) {
+		if (getObject(i) == obj) {
 			return i;
 		}
 	}
@@ -1798,32 +3824,32 @@ inttype TreeMap<K,V,Ctx>::Leaf::instanceIndex(const MapEntry<K,V,Ctx>* obj) cons
 	throw new UnsupportedOperationException("reference not found");
 }
 
-template<typename K, typename V, typename Ctx>
-typename TreeMap<K,V,Ctx>::Leaf* TreeMap<K,V,Ctx>::Leaf::firstLeaf(void) {
+template<typename K, typename V, typename Ctx, typename Pol>
+typename TreeMap<K,V,Ctx,Pol>::Leaf* TreeMap<K,V,Ctx,Pol>::Leaf::firstLeaf(void) {
 	return this;
 }
 
-template<typename K, typename V, typename Ctx>
-typename TreeMap<K,V,Ctx>::Leaf* TreeMap<K,V,Ctx>::Leaf::lastLeaf (void) {
+template<typename K, typename V, typename Ctx, typename Pol>
+typename TreeMap<K,V,Ctx,Pol>::Leaf* TreeMap<K,V,Ctx,Pol>::Leaf::lastLeaf (void) {
 	return this;
 }
 
-template<typename K, typename V, typename Ctx>
-void TreeMap<K,V,Ctx>::Leaf::balanceWithLeft(Leaf* lNode, inttype pIndex) {
+template<typename K, typename V, typename Ctx, typename Pol>
+void TreeMap<K,V,Ctx,Pol>::Leaf::balanceWithLeft(Leaf* lNode, inttype pIndex) {
 	inttype newSize = (getVirtualEntries() + lNode->getPhysicalEntries()) / 2;
 	inttype indexFromHere = getPhysicalEntries() - newSize;
 	pushLeft(indexFromHere, lNode, pIndex);
 }
 
-template<typename K, typename V, typename Ctx>
-void TreeMap<K,V,Ctx>::Leaf::balanceWithRight(Leaf* rNode, inttype pIndex) {
+template<typename K, typename V, typename Ctx, typename Pol>
+void TreeMap<K,V,Ctx,Pol>::Leaf::balanceWithRight(Leaf* rNode, inttype pIndex) {
 	inttype newSize = (getPhysicalEntries() + rNode->getVirtualEntries()) / 2;
 	inttype indexFromHere = getPhysicalEntries() - newSize;
 	pushRight(indexFromHere, rNode, pIndex);
 }
 
-template<typename K, typename V, typename Ctx>
-void TreeMap<K,V,Ctx>::Leaf::balanceWith(Leaf* rNode, inttype pIndex) {
+template<typename K, typename V, typename Ctx, typename Pol>
+void TreeMap<K,V,Ctx,Pol>::Leaf::balanceWith(Leaf* rNode, inttype pIndex) {
 	if (getPhysicalEntries() < rNode->getVirtualEntries()) {
 		rNode->balanceWithLeft(this, pIndex);
 
@@ -1832,20 +3858,23 @@ void TreeMap<K,V,Ctx>::Leaf::balanceWith(Leaf* rNode, inttype pIndex) {
 	}
 }
 
-template<typename K, typename V, typename Ctx>
-void TreeMap<K,V,Ctx>::Leaf::mergeWithRight(TreeMap<K,V,Ctx>* self, Leaf* rNode, inttype pIndex) {
+template<typename K, typename V, typename Ctx, typename Pol>
+void TreeMap<K,V,Ctx,Pol>::Leaf::mergeWithRight(TreeMap<K,V,Ctx,Pol>* self, Leaf* rNode, inttype pIndex) {
 	rNode->pushLeft(rNode->getPhysicalEntries(), this, pIndex);
 
-	append(Node::m_parent->getObject(pIndex));
+	append(Node::m_parent->getSlot(pIndex));
 
 	Node::m_parent->removeItem(self, pIndex);
 
-	delete rNode;
+	rNode->unlink();
+	self->destroyNode(rNode);
 }
 
-template<typename K, typename V, typename Ctx>
-void TreeMap<K,V,Ctx>::Leaf::pushLeft(inttype indexFromHere, Leaf* lNode, inttype pIndex) {
-	lNode->append(Node::m_parent->getObject(pIndex));
+template<typename K, typename V, typename Ctx, typename Pol>
+void TreeMap<K,V,Ctx,Pol>::Leaf::pushLeft(inttype indexFromHere, Leaf* lNode, inttype pIndex) {
+	touch();
+
+	lNode->append(Node::m_parent->getSlot(pIndex));
 
 	if (indexFromHere > 1) {
 		lNode->appendFrom(this, 0, indexFromHere - 2);
@@ -1856,8 +3885,11 @@ void TreeMap<K,V,Ctx>::Leaf::pushLeft(inttype indexFromHere, Leaf* lNode, inttyp
 	shiftLeft(indexFromHere);
 }
 
-template<typename K, typename V, typename Ctx>
-void TreeMap<K,V,Ctx>::Leaf::pushRight(inttype indexFromHere, Leaf* rNode, inttype pIndex) {
+template<typename K, typename V, typename Ctx, typename Pol>
+void TreeMap<K,V,Ctx,Pol>::Leaf::pushRight(inttype indexFromHere, Leaf* rNode, inttype pIndex) {
+	touch();
+	rNode->touch();
+
 	inttype begin = Node::m_lastIndex - indexFromHere + 1;
 	inttype target = rNode->m_lastIndex + indexFromHere;
 	inttype source = rNode->m_lastIndex;
@@ -1867,16 +3899,16 @@ void TreeMap<K,V,Ctx>::Leaf::pushRight(inttype indexFromHere, Leaf* rNode, intty
 	while (source >= 0) {
 		rNode->m_objects[target--] = rNode->m_objects[source--];
 		#ifdef DEEP_DEBUG
-		rNode->m_objects[source + 1] = null;
+		Entries::reset(rNode->m_objects[source + 1]);
 		#endif
 	}
 
-	rNode->m_objects[target--] = Node::m_parent->getObject(pIndex);
+	rNode->m_objects[target--] = Node::m_parent->getSlot(pIndex);
 
 	for (inttype i = Node::m_lastIndex; i > begin; i--) {
 		rNode->m_objects[target--] = m_objects[i];
 		#ifdef DEEP_DEBUG
-		m_objects[i] = null;
+		Entries::reset(m_objects[i]);
 		#endif
 	}
 
@@ -1885,22 +3917,25 @@ void TreeMap<K,V,Ctx>::Leaf::pushRight(inttype indexFromHere, Leaf* rNode, intty
 	Node::m_lastIndex -= indexFromHere;
 }
 
-template<typename K, typename V, typename Ctx>
-void TreeMap<K,V,Ctx>::Leaf::remove(TreeMap<K,V,Ctx>* self, inttype index) {
+template<typename K, typename V, typename Ctx, typename Pol>
+void TreeMap<K,V,Ctx,Pol>::Leaf::remove(TreeMap<K,V,Ctx,Pol>* self, inttype index) {
+	touch();
+
 	for (inttype to = index; to < Node::m_lastIndex; to++) {
 		m_objects[to] = m_objects[to + 1];
 		#ifdef DEEP_DEBUG
-		m_objects[to + 1] = null;
+		Entries::reset(m_objects[to + 1]);
 		#endif
 	}
 
 	#ifdef DEEP_DEBUG
-	m_objects[Node::m_lastIndex] = null;
+	Entries::reset(m_objects[Node::m_lastIndex]);
 	#endif
 
 	Node::m_lastIndex--;
 
 	self->decrementEntries();
+	self->adjustCounts(Node::m_parent, -1);
 
 	if (isLow(self) == true) {
 		if (Node::m_parent != null) {
@@ -1914,33 +3949,38 @@ void TreeMap<K,V,Ctx>::Leaf::remove(TreeMap<K,V,Ctx>* self, inttype index) {
 	}
 }
 
-template<typename K, typename V, typename Ctx>
-void TreeMap<K,V,Ctx>::Leaf::shiftLeft(inttype count) {
+template<typename K, typename V, typename Ctx, typename Pol>
+void TreeMap<K,V,Ctx,Pol>::Leaf::shiftLeft(inttype count) {
 	if (count <= 0) {
 		return;
 	}
 
+	touch();
+
 	for (inttype i = count; i <= Node::m_lastIndex; i++) {
 		m_objects[i - count] = m_objects[i];
 		#ifdef DEEP_DEBUG
-		m_objects[i] = null;
+		Entries::reset(m_objects[i]);
 		#endif
 	}
 
 	Node::m_lastIndex -= count;
 }
 
-template<typename K, typename V, typename Ctx>
-void TreeMap<K,V,Ctx>::Leaf::split(TreeMap<K,V,Ctx>* self) {
-	Leaf* nNode = new Leaf(self, Node::m_parent, null);
+template<typename K, typename V, typename Ctx, typename Pol>
+void TreeMap<K,V,Ctx,Pol>::Leaf::split(TreeMap<K,V,Ctx,Pol>* self) {
+	touch();
+
+	Leaf* nNode = self->createLeaf(Node::m_parent, null);
+	nNode->linkAfter(this);
 
 	Node::m_parent->append(nNode, m_objects[Node::m_lastIndex--]);
 
 	balanceWithRight(nNode, 1);
 }
 
-template<typename K, typename V, typename Ctx>
-void TreeMap<K,V,Ctx>::Leaf::splitWith(TreeMap<K,V,Ctx>* self, Leaf* rNode, inttype kIndex) {
+template<typename K, typename V, typename Ctx, typename Pol>
+void TreeMap<K,V,Ctx,Pol>::Leaf::splitWith(TreeMap<K,V,Ctx,Pol>* self, Leaf* rNode, inttype kIndex) {
 	inttype numberOfKeys = getPhysicalEntries() + rNode->getVirtualEntries();
 	inttype newSizeOne3rd = numberOfKeys / 3;
 	inttype newSizeOneHalf = (numberOfKeys - newSizeOne3rd) / 2;
@@ -1948,8 +3988,10 @@ void TreeMap<K,V,Ctx>::Leaf::splitWith(TreeMap<K,V,Ctx>* self, Leaf* rNode, intt
 	inttype indexFromHere = getPhysicalEntries() - newSizeOne3rd;
 	inttype indexFromNode = rNode->getVirtualEntries() - newSizeOfNode;
 
-	Leaf* nNode = new Leaf(self, Node::m_parent, null);
+	Leaf* nNode = self->createLeaf(Node::m_parent, null);
+	nNode->linkAfter(this);
 
+	touch();
 	Node::m_parent->insertElement(nNode, m_objects[Node::m_lastIndex--], kIndex);
 
 	pushRight(indexFromHere - 1, nNode, kIndex);
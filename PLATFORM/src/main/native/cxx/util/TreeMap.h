@@ -31,44 +31,63 @@
 #include "cxx/lang/Comparable.h"
 #include "cxx/lang/UnsupportedOperationException.h"
 
+#include "cxx/util/CardinalitySketch.h"
 #include "cxx/util/Comparator.h"
+#include "cxx/util/FrozenTreeMap.h"
+#include "cxx/util/NodeSearch.h"
 #include "cxx/util/SortedMap.h"
 #include "cxx/util/SortedSet.h"
 #include "cxx/util/TreeIterator.h"
+#include "cxx/util/TreePolicy.h"
 
 namespace cxx { namespace util {
 
-template<typename K, typename V, typename Ctx = void*>
+class TreeSpill;
+
+template<typename K, typename V, typename Ctx = void*, typename Pol = TreePolicy>
 class TreeMap : /* public NavigableMap */ public SortedMap<K,V,Ctx> {
 	class Leaf;
 	class Branch;
 
+	typedef TreeEntries<K,V,Ctx,Pol::INLINE_ENTRIES> Entries;
+	typedef typename Entries::Slot Slot;
+
+	// XXX: inline entries already hold their key in the branch, pointer keys other than nbyte and CompositeKey would dereference anyway
+	static const boolean SEPARATORS = (Pol::INLINE_SEPARATORS == true) && (Pol::INLINE_ENTRIES == false) && ((TreeKeyByValue<K>::VALUE == true) || (TreeKeyPrefix<K>::VALUE == true));
+	typedef TreeSeparator<K,Entries,SEPARATORS> Separator;
+
 	class Node {
 
 		private:
 			Branch* m_parent;
 			shorttype m_lastIndex;
-			#ifdef CXX_UTIL_TREE_SLOTTED
+			// XXX: position within the parent, kept up to date by slotted policies only (see TreePolicy::SLOTTED_NODES)
 			shorttype m_slotIndex;
-			#endif
+			// XXX: other trees (snapshot generations) holding this node, a shared node is copied before it changes (see TreeMap::own);
+			//      its parent, slot, chain links and reference bit belong to the live map and are never read by a generation
+			ushorttype m_shares;
 			boolean m_isLeaf : 1;
 
+			// XXX: leaf entry array state under TreePolicy::SPILL_LEAVES (see Leaf::touch)
+			boolean m_spilled : 1;
+			boolean m_referenced : 1;
+
 		public:
 			Node(Branch* parent, boolean isleaf);
 
 			inline virtual ~Node(void) {
 			}
 
-			virtual void insert(TreeMap<K,V,Ctx>* self, const MapEntry<K,V,Ctx>* obj, inttype index, boolean sequential) = 0;
-			virtual void remove(TreeMap<K,V,Ctx>* self, inttype index) = 0;
+			virtual void insert(TreeMap<K,V,Ctx,Pol>* self, const Slot& obj, inttype index, boolean sequential) = 0;
+			virtual void remove(TreeMap<K,V,Ctx,Pol>* self, inttype index) = 0;
 
 			#ifdef COM_DEEPIS_DB_CARDINALITY /* || COM_DEEPIS_DB_INDEX_REF */
-			virtual const MapEntry<K,V,Ctx>* find(const TreeMap<K,V,Ctx>* self, const K, Node**, inttype*, inttype* pos = null, boolean* end = null) = 0;
+			virtual const MapEntry<K,V,Ctx>* find(const TreeMap<K,V,Ctx,Pol>* self, const K, Node**, inttype*, inttype* pos = null, boolean* end = null) = 0;
 			#else
-			virtual const MapEntry<K,V,Ctx>* find(const TreeMap<K,V,Ctx>* self, const K, Node**, inttype*) = 0;
+			virtual const MapEntry<K,V,Ctx>* find(const TreeMap<K,V,Ctx,Pol>* self, const K, Node**, inttype*) = 0;
 			#endif
-			virtual const MapEntry<K,V,Ctx>* lower(const TreeMap<K,V,Ctx>* self, const K, Node**, inttype*, MapEntry<K,V,Ctx>**) = 0;
-			virtual const MapEntry<K,V,Ctx>* higher(const TreeMap<K,V,Ctx>* self, const K, Node**, inttype*, MapEntry<K,V,Ctx>**) = 0;
+			virtual const MapEntry<K,V,Ctx>* lower(const TreeMap<K,V,Ctx,Pol>* self, const K, Node**, inttype*, MapEntry<K,V,Ctx>**) = 0;
+			virtual const MapEntry<K,V,Ctx>* higher(const TreeMap<K,V,Ctx,Pol>* self, const K, Node**, inttype*, MapEntry<K,V,Ctx>**) = 0;
 
 			virtual const MapEntry<K,V,Ctx>* getEntry(inttype index) = 0;
 			virtual const MapEntry<K,V,Ctx>* nextEntry(inttype index, Node** block, inttype* location) = 0;
@@ -77,7 +96,7 @@ class TreeMap : /* public NavigableMap */ public SortedMap<K,V,Ctx> {
 			virtual Leaf* firstLeaf(void) = 0;
 			virtual Leaf* lastLeaf(void) = 0;
 
-			virtual void split(TreeMap<K,V,Ctx>* self) = 0;
+			virtual void split(TreeMap<K,V,Ctx,Pol>* self) = 0;
 
 			FORCE_INLINE boolean isLeaf() const {
 				return m_isLeaf;
@@ -88,30 +107,34 @@ class TreeMap : /* public NavigableMap */ public SortedMap<K,V,Ctx> {
 		friend class Leaf;
 	};
 
-	class Item {
+	class Item : public Separator {
 
 		private:
 			Node* m_node;
-			MapEntry<K,V,Ctx>* m_object;
+			Slot m_object;
 
 		public:
-			Item(void):
-				m_node(null),
-				m_object(null) {
-			}
-
-			Item(Node* node, MapEntry<K,V,Ctx>* object):
+			Item(Node* node, const Slot& object):
 				m_node(node),
 				m_object(object) {
+
+				Separator::setKey(object);
+			}
+
+			FORCE_INLINE const K getKey(void) const {
+				return Separator::getKey(m_object);
+			}
+
+			FORCE_INLINE const K* getKeyAddress(void) const {
+				return Separator::getKeyAddress(m_object);
 			}
 
-			#ifdef CXX_UTIL_TREE_SLOTTED
 			FORCE_INLINE void assign(inttype index, Item& item) {
+				Separator::operator=(item);
 				m_node = item.m_node;
 				m_object = item.m_object;
 				m_node->m_slotIndex = index;
 			}
-			#endif
 
 		friend class Branch;
 	};
@@ -121,62 +144,72 @@ class TreeMap : /* public NavigableMap */ public SortedMap<K,V,Ctx> {
 		private:
 			Item* m_items;
 
+			// XXX: entries in this subtree, leaves count their own entries (see TreeMap::countOf)
+			inttype m_count;
+
 		public:
-			Branch(TreeMap<K,V,Ctx>* self, Branch* parent);
-			Branch(TreeMap<K,V,Ctx>* self, Branch* parent, Node* oldroot);
+			Branch(TreeMap<K,V,Ctx,Pol>* self, Branch* parent);
+			Branch(TreeMap<K,V,Ctx,Pol>* self, Branch* parent, Node* oldroot);
 
 			virtual ~Branch(void);
 
-			void insert(TreeMap<K,V,Ctx>* self, const MapEntry<K,V,Ctx>* obj, inttype index, boolean sequential);
-			void insert(TreeMap<K,V,Ctx>* self, Item& item, inttype index);
-			void insert(TreeMap<K,V,Ctx>* self, Node* node, MapEntry<K,V,Ctx>* obj, inttype index);
+			void insert(TreeMap<K,V,Ctx,Pol>* self, const Slot& obj, inttype index, boolean sequential);
+			void insert(TreeMap<K,V,Ctx,Pol>* self, Item& item, inttype index);
+			void insert(TreeMap<K,V,Ctx,Pol>* self, Node* node, const Slot& obj, inttype index);
 			void insertElement(Item& item, inttype index);
-			void insertElement(Node* node, MapEntry<K,V,Ctx>* obj, inttype index);
+			void insertElement(Node* node, const Slot& obj, inttype index);
 
-			void remove(TreeMap<K,V,Ctx>* self, inttype index);
-			void removeItem(TreeMap<K,V,Ctx>* self, inttype index);
+			void remove(TreeMap<K,V,Ctx,Pol>* self, inttype index);
+			void removeItem(TreeMap<K,V,Ctx,Pol>* self, inttype index);
 
 			#ifdef COM_DEEPIS_DB_CARDINALITY /* || COM_DEEPIS_DB_INDEX_REF */
-			const MapEntry<K,V,Ctx>* find(const TreeMap<K,V,Ctx>* self, const K, Node**, inttype*, inttype* pos = null, boolean* end = null);
+			const MapEntry<K,V,Ctx>* find(const TreeMap<K,V,Ctx,Pol>* self, const K, Node**, inttype*, inttype* pos = null, boolean* end = null);
 			#else
-			const MapEntry<K,V,Ctx>* find(const TreeMap<K,V,Ctx>* self, const K, Node**, inttype*);
+			const MapEntry<K,V,Ctx>* find(const TreeMap<K,V,Ctx,Pol>* self, const K, Node**, inttype*);
 			#endif
-			const MapEntry<K,V,Ctx>* lower(const TreeMap<K,V,Ctx>* self, const K, Node**, inttype*, MapEntry<K,V,Ctx>**);
-			const MapEntry<K,V,Ctx>* higher(const TreeMap<K,V,Ctx>* self, const K, Node**, inttype*, MapEntry<K,V,Ctx>**);
+			const MapEntry<K,V,Ctx>* lower(const TreeMap<K,V,Ctx,Pol>* self, const K, Node**, inttype*, MapEntry<K,V,Ctx>**);
+			const MapEntry<K,V,Ctx>* higher(const TreeMap<K,V,Ctx,Pol>* self, const K, Node**, inttype*, MapEntry<K,V,Ctx>**);
 
 			const MapEntry<K,V,Ctx>* getEntry(inttype index);
 			const MapEntry<K,V,Ctx>* nextEntry(inttype index, Node** block, inttype* location);
 			const MapEntry<K,V,Ctx>* previousEntry(inttype index, Node** block, inttype* location);
 
+			Node* step(const TreeMap<K,V,Ctx,Pol>* self, const K what, const MapEntry<K,V,Ctx>** entry) const;
+			inttype bound(const TreeMap<K,V,Ctx,Pol>* self, const K what) const;
+
 			FORCE_INLINE void setNode(inttype index, Node* node) {
-				#ifdef CXX_UTIL_TREE_SLOTTED
-				node->m_slotIndex = index;
-				#endif
+				if (Pol::SLOTTED_NODES == true) {
+					node->m_slotIndex = index;
+				}
 
 				m_items[index].m_node = node;
 				node->m_parent = this;
 			}
 
-			FORCE_INLINE void setObject(inttype index, MapEntry<K,V,Ctx>* obj) {
+			FORCE_INLINE void setObject(inttype index, const Slot& obj) {
 				m_items[index].m_object = obj;
+				m_items[index].setKey(obj);
 			}
 
 			FORCE_INLINE void setItem(inttype index, Item& item) {
-				#ifdef CXX_UTIL_TREE_SLOTTED
-				m_items[index].assign(index, item);
-				#else
-				m_items[index] = item;
-				#endif
+				if (Pol::SLOTTED_NODES == true) {
+					m_items[index].assign(index, item);
+
+				} else {
+					m_items[index] = item;
+				}
 
 				item.m_node->m_parent = this;
 			}
 
-			FORCE_INLINE void setItem(inttype index, MapEntry<K,V,Ctx>* obj, Node* node) {
+			FORCE_INLINE void setItem(inttype index, const Slot& obj, Node* node) {
 				setNode(index, node);
 				setObject(index, obj);
 			}
 
-			void notifyParent(TreeMap<K,V,Ctx>* self);
+			void notifyParent(TreeMap<K,V,Ctx,Pol>* self);
+
+			void recount(void);
 
 			Leaf* lastLeaf(void);
 			Leaf* firstLeaf(void);
@@ -190,20 +223,34 @@ class TreeMap : /* public NavigableMap */ public SortedMap<K,V,Ctx> {
 			}
 
 			FORCE_INLINE MapEntry<K,V,Ctx>* getObject(inttype index) const {
+				return Entries::entry(m_items[index].m_object);
+			}
+
+			FORCE_INLINE Slot& getSlot(inttype index) const {
 				return m_items[index].m_object;
 			}
 
+			// XXX: separator key of item index, read from the branch itself when separators are inline
+			FORCE_INLINE const K getKey(inttype index) const {
+				return m_items[index].getKey();
+			}
+
+			// XXX: orders separator index against what, probe is what's Separator::probe (prefixed separators read the entry on ties only)
+			FORCE_INLINE inttype compareKey(const TreeMap<K,V,Ctx,Pol>* self, inttype index, const K what, const typename Separator::Probe probe) const {
+				return m_items[index].Separator::compare(self->m_comparator, m_items[index].m_object, what, probe);
+			}
+
 			inttype instanceIndex(const Node* node) const;
 
-			void split(TreeMap<K,V,Ctx>* self);
+			void split(TreeMap<K,V,Ctx,Pol>* self);
 			void shiftLeft(inttype count);
-			void splitWith(TreeMap<K,V,Ctx>* self, Branch* node, inttype index);
+			void splitWith(TreeMap<K,V,Ctx,Pol>* self, Branch* node, inttype index);
 
 			void append(Item& item);
-			void append(Node* node, MapEntry<K,V,Ctx>* obj);
+			void append(Node* node, const Slot& obj);
 			void appendFrom(Branch* source, inttype begin, inttype end);
 
-			void mergeWithRight(TreeMap<K,V,Ctx>* self, Branch* rNode, inttype index);
+			void mergeWithRight(TreeMap<K,V,Ctx,Pol>* self, Branch* rNode, inttype index);
 
 			void balanceWithLeft(Branch* lNode, inttype index);
 			void balanceWithRight(Branch* rNode, inttype index);
@@ -212,7 +259,7 @@ class TreeMap : /* public NavigableMap */ public SortedMap<K,V,Ctx> {
 			void pushLeft(inttype count, Branch* lNode, inttype pIndex);
 			void pushRight(inttype count, Branch* rNode, inttype pIndex);
 
-			FORCE_INLINE inttype getMaxIndex(TreeMap<K,V,Ctx>* self) const {
+			FORCE_INLINE inttype getMaxIndex(TreeMap<K,V,Ctx,Pol>* self) const {
 				return self->m_branchMaxIndex;
 			}
 
@@ -224,23 +271,23 @@ class TreeMap : /* public NavigableMap */ public SortedMap<K,V,Ctx> {
 				return getPhysicalEntries() + 1;
 			}
 
-			FORCE_INLINE inttype getMaxPhysicalEntries(TreeMap<K,V,Ctx>* self) const {
+			FORCE_INLINE inttype getMaxPhysicalEntries(TreeMap<K,V,Ctx,Pol>* self) const {
 				return self->m_branchMaxIndex;
 			}
 
-			void isFull(TreeMap<K,V,Ctx>* self, Node* node, boolean sequential);
+			void isFull(TreeMap<K,V,Ctx,Pol>* self, Node* node, boolean sequential);
 
-			FORCE_INLINE inttype isFull(TreeMap<K,V,Ctx>* self) const {
+			FORCE_INLINE inttype isFull(TreeMap<K,V,Ctx,Pol>* self) const {
 				return Node::m_lastIndex == getMaxIndex(self);
 			}
 
-			FORCE_INLINE inttype isAlmostFull(TreeMap<K,V,Ctx>* self) const {
+			FORCE_INLINE inttype isAlmostFull(TreeMap<K,V,Ctx,Pol>* self) const {
 				return Node::m_lastIndex >= (getMaxIndex(self) - 1);
 			}
 
-			void isLow(TreeMap<K,V,Ctx>* self, Node* node);
+			void isLow(TreeMap<K,V,Ctx,Pol>* self, Node* node);
 
-			FORCE_INLINE inttype isLow(TreeMap<K,V,Ctx>* self) const {
+			FORCE_INLINE inttype isLow(TreeMap<K,V,Ctx,Pol>* self) const {
 				return Node::m_lastIndex < self->m_branchLowWater;
 			}
 
@@ -251,53 +298,107 @@ class TreeMap : /* public NavigableMap */ public SortedMap<K,V,Ctx> {
 	class Leaf : public Node {
 
 		private:
-			MapEntry<K,V,Ctx>** m_objects;
+			Slot* m_objects;
+
+			// XXX: leaves are chained in key order, branch rebalancing moves leaves between parents but never reorders them
+			Leaf* m_prev;
+			Leaf* m_next;
 
 		public:
-			Leaf(TreeMap* self, Branch* parent, const MapEntry<K,V,Ctx>* obj);
+			Leaf(TreeMap* self, Branch* parent, const Slot* obj);
 
 			virtual ~Leaf(void);
 
-			void insert(TreeMap<K,V,Ctx>* self, const MapEntry<K,V,Ctx>* obj, inttype index, boolean sequential);
+			void insert(TreeMap<K,V,Ctx,Pol>* self, const Slot& obj, inttype index, boolean sequential);
+			void insert(TreeMap<K,V,Ctx,Pol>* self, const Slot* objs, const inttype* indexes, inttype count, boolean sequential);
 
-			void remove(TreeMap<K,V,Ctx>* self, inttype index);
-			FORCE_INLINE void removeItem(TreeMap<K,V,Ctx>* self, inttype index) {
+			void remove(TreeMap<K,V,Ctx,Pol>* self, inttype index);
+			FORCE_INLINE void removeItem(TreeMap<K,V,Ctx,Pol>* self, inttype index) {
 				remove(self, index);
 			}
 
 			#ifdef COM_DEEPIS_DB_CARDINALITY /* || COM_DEEPIS_DB_INDEX_REF */
-			const MapEntry<K,V,Ctx>* find(const TreeMap<K,V,Ctx>* self, const K, Node**, inttype*, inttype* pos = null, boolean* end = null);
+			const MapEntry<K,V,Ctx>* find(const TreeMap<K,V,Ctx,Pol>* self, const K, Node**, inttype*, inttype* pos = null, boolean* end = null);
 			#else
-			const MapEntry<K,V,Ctx>* find(const TreeMap<K,V,Ctx>* self, const K, Node**, inttype*);
+			const MapEntry<K,V,Ctx>* find(const TreeMap<K,V,Ctx,Pol>* self, const K, Node**, inttype*);
 			#endif
-			const MapEntry<K,V,Ctx>* lower(const TreeMap<K,V,Ctx>* self, const K, Node**, inttype*, MapEntry<K,V,Ctx>**);
-			const MapEntry<K,V,Ctx>* higher(const TreeMap<K,V,Ctx>* self, const K, Node**, inttype*, MapEntry<K,V,Ctx>**);
+			const MapEntry<K,V,Ctx>* lower(const TreeMap<K,V,Ctx,Pol>* self, const K, Node**, inttype*, MapEntry<K,V,Ctx>**);
+			const MapEntry<K,V,Ctx>* higher(const TreeMap<K,V,Ctx,Pol>* self, const K, Node**, inttype*, MapEntry<K,V,Ctx>**);
 
 			const MapEntry<K,V,Ctx>* getEntry(inttype index);
 			const MapEntry<K,V,Ctx>* nextEntry(inttype index, Node** block, inttype* location);
 			const MapEntry<K,V,Ctx>* previousEntry(inttype index, Node** block, inttype* location);
 
-			FORCE_INLINE MapEntry<K,V,Ctx>* getObject(inttype index) {
+			inttype bound(const TreeMap<K,V,Ctx,Pol>* self, const K what) const;
+			void cut(inttype index, inttype count);
+
+			FORCE_INLINE MapEntry<K,V,Ctx>* getObject(inttype index) const {
+				touch();
+				return Entries::entry(m_objects[index]);
+			}
+
+			FORCE_INLINE Slot& getSlot(inttype index) const {
+				touch();
 				return m_objects[index];
 			}
 
-			FORCE_INLINE void setObject(inttype index, MapEntry<K,V,Ctx>* obj) {
+			FORCE_INLINE void setObject(inttype index, const Slot& obj) {
+				touch();
 				m_objects[index] = obj;
 			}
 
+			// XXX: a spilled leaf is read back on first touch, the reference bit spares it the next eviction sweep
+			FORCE_INLINE void touch(void) const {
+				if (Pol::SPILL_LEAVES == true) {
+					Leaf* leaf = const_cast<Leaf*>(this);
+					if (Node::m_spilled == true) {
+						leaf->fault();
+					}
+
+					leaf->m_referenced = true;
+				}
+			}
+
+			void fault(void);
+
 			Leaf* firstLeaf(void);
 			Leaf* lastLeaf(void);
 
+			FORCE_INLINE void linkAfter(Leaf* lNode) {
+				m_prev = lNode;
+				m_next = lNode->m_next;
+				if (m_next != null) {
+					m_next->m_prev = this;
+				}
+				lNode->m_next = this;
+			}
+
+			FORCE_INLINE void unlink(void) {
+				if (m_prev != null) {
+					m_prev->m_next = m_next;
+				}
+				if (m_next != null) {
+					m_next->m_prev = m_prev;
+				}
+				m_prev = null;
+				m_next = null;
+			}
+
+			FORCE_INLINE void prefetch(void) const {
+				__builtin_prefetch(this);
+				__builtin_prefetch(m_objects);
+			}
+
 			inttype instanceIndex(const MapEntry<K,V,Ctx>* obj) const;
 
-			void split(TreeMap<K,V,Ctx>* self);
+			void split(TreeMap<K,V,Ctx,Pol>* self);
 			void shiftLeft(inttype count);
-			void splitWith(TreeMap<K,V,Ctx>* self, Leaf* rNode, inttype index);
+			void splitWith(TreeMap<K,V,Ctx,Pol>* self, Leaf* rNode, inttype index);
 
-			void append(MapEntry<K,V,Ctx>* obj);
+			void append(const Slot& obj);
 			void appendFrom(Leaf* source, inttype begin, inttype end);
 
-			void mergeWithRight(TreeMap<K,V,Ctx>* self, Leaf* rNode, inttype index);
+			void mergeWithRight(TreeMap<K,V,Ctx,Pol>* self, Leaf* rNode, inttype index);
 
 			void balanceWith(Leaf* node, inttype index);
 			void balanceWithLeft(Leaf* lNode, inttype index);
@@ -306,7 +407,7 @@ class TreeMap : /* public NavigableMap */ public SortedMap<K,V,Ctx> {
 			void pushLeft(inttype count, Leaf* lNode, inttype pIndex);
 			void pushRight(inttype count, Leaf* rNode, inttype pIndex);
 
-			FORCE_INLINE inttype getMaxIndex(TreeMap<K,V,Ctx>* self) const {
+			FORCE_INLINE inttype getMaxIndex(TreeMap<K,V,Ctx,Pol>* self) const {
 				return self->m_leafMaxIndex;
 			}
 
@@ -318,19 +419,19 @@ class TreeMap : /* public NavigableMap */ public SortedMap<K,V,Ctx> {
 				return getPhysicalEntries() + 1;
 			}
 
-			FORCE_INLINE inttype getMaxPhysicalEntries(TreeMap<K,V,Ctx>* self) const {
+			FORCE_INLINE inttype getMaxPhysicalEntries(TreeMap<K,V,Ctx,Pol>* self) const {
 				return self->m_leafMaxIndex + 1;
 			}
 
-			FORCE_INLINE inttype isFull(TreeMap<K,V,Ctx>* self) const {
+			FORCE_INLINE inttype isFull(TreeMap<K,V,Ctx,Pol>* self) const {
 				return Node::m_lastIndex == getMaxIndex(self);
 			}
 
-			FORCE_INLINE inttype isAlmostFull(TreeMap<K,V,Ctx>* self) const {
+			FORCE_INLINE inttype isAlmostFull(TreeMap<K,V,Ctx,Pol>* self) const {
 				return Node::m_lastIndex >= (getMaxIndex(self) -1);
 			}
 
-			FORCE_INLINE inttype isLow(TreeMap<K,V,Ctx>* self) const {
+			FORCE_INLINE inttype isLow(TreeMap<K,V,Ctx,Pol>* self) const {
 				return Node::m_lastIndex < self->m_leafLowWater;
 			}
 
@@ -341,31 +442,65 @@ class TreeMap : /* public NavigableMap */ public SortedMap<K,V,Ctx> {
 	private:
 		Node* m_root;
 		const Comparator<K>* m_comparator;
+		SlabPool* m_nodePool;
+		SlabPool* m_entryPool;
 
 		inttype m_pEntries;
 		#ifdef COM_DEEPIS_DB_INDEX_REF
 		inttype m_vEntries;
 		volatile uinttype m_modification;
 		#endif
-		ubytetype m_leafLowWater;
-		ubytetype m_leafMaxIndex;
-		ubytetype m_branchLowWater;
-		ubytetype m_branchMaxIndex;
+		ushorttype m_leafLowWater;
+		ushorttype m_leafMaxIndex;
+		ushorttype m_branchLowWater;
+		ushorttype m_branchMaxIndex;
 		bytetype m_stateFlags;
 		#ifdef COM_DEEPIS_DB_CARDINALITY
 		bytetype m_keyParts;
 		inttype* m_cardinality;
+		CardinalitySketch* m_sketch;
 		#endif
 
 		Ctx m_ctx;
 
+		struct Lineage;
+
+		// XXX: generation of frozen trees shared with snapshots, the live map holds one reference until its next change
+		struct Shared {
+			TreeMap<K,V,Ctx,Pol>* m_map;
+			volatile inttype m_references;
+			Lineage* m_lineage;
+			Shared* m_next;
+		};
+
+		// XXX: generations sharing nodes with the live map; released ones wait on the retired stack for the live map to
+		//      free them (see reclaim), the last reference (map or generation) takes the node slabs down with it
+		struct Lineage {
+			Shared* volatile m_retired;
+			volatile inttype m_references;
+			// XXX: generations created and not yet reclaimed, only touched by the live map
+			inttype m_generations;
+			SlabPool* m_nodePool;
+			SlabPool* m_entryPool;
+		};
+
+		Shared* m_shared;
+		Lineage* m_lineage;
+		boolean m_frozen;
+
+		// XXX: backing file and CLOCK hand of spill mode (see setSpillFile), the hand walks the leaf chain
+		TreeSpill* m_spill;
+		Leaf* m_clock;
+
 		static const Comparator<K> COMPARATOR;
 
+		static const inttype PROBE_GROUP = 8;
+
 	private:
 		#ifdef COM_DEEPIS_DB_CARDINALITY
-		void initialize(bytetype order, boolean delkey, boolean delval, bytetype keyParts = -1);
+		void initialize(inttype order, boolean delkey, boolean delval, bytetype keyParts = -1);
 		#else
-		void initialize(bytetype order, boolean delkey, boolean delval);
+		void initialize(inttype order, boolean delkey, boolean delval);
 		#endif
 		void notifyRootFull(void);
 		void notifyRootEmpty(void);
@@ -394,9 +529,231 @@ class TreeMap : /* public NavigableMap */ public SortedMap<K,V,Ctx> {
 			#endif
 		}
 
+		FORCE_INLINE static inttype countOf(const Node* node) {
+			return (node->isLeaf() == true) ? (node->m_lastIndex + 1) : ((const Branch*) node)->m_count;
+		}
+
+		FORCE_INLINE static void adjustCounts(Branch* branch, inttype delta) {
+			for (; branch != null; branch = branch->m_parent) {
+				branch->m_count += delta;
+			}
+		}
+
+		FORCE_INLINE void incrementEntries(inttype count) {
+			m_pEntries += count;
+
+			#ifdef COM_DEEPIS_DB_INDEX_REF
+			if (getVirtualSizeEnabled() == true) {
+				m_vEntries += count;
+			}
+
+			m_modification++;
+			#endif
+		}
+
+		FORCE_INLINE void decrementEntries(inttype count) {
+			m_pEntries -= count;
+
+			#ifdef COM_DEEPIS_DB_INDEX_REF
+			if (getVirtualSizeEnabled() == true) {
+				m_vEntries -= count;
+			}
+
+			m_modification++;
+			#endif
+		}
+
+		FORCE_INLINE Leaf* createLeaf(Branch* parent, const Slot* obj) {
+			if (Pol::POOLED_NODES == true) {
+				return new (m_nodePool->allocate()) Leaf(this, parent, obj);
+			}
+
+			return new Leaf(this, parent, obj);
+		}
+
+		FORCE_INLINE Branch* createBranch(Branch* parent, Node* oldroot = null) {
+			if (Pol::POOLED_NODES == true) {
+				return (oldroot == null) ? new (m_nodePool->allocate()) Branch(this, parent) : new (m_nodePool->allocate()) Branch(this, parent, oldroot);
+			}
+
+			return (oldroot == null) ? new Branch(this, parent) : new Branch(this, parent, oldroot);
+		}
+
+		// XXX: only called on detached nodes without children, pooled nodes skip the destructor
+		FORCE_INLINE void destroyNode(Node* node) {
+			if (node == m_clock) {
+				m_clock = null;
+			}
+
+			if (Pol::POOLED_NODES == true) {
+				m_nodePool->release(node);
+
+			} else {
+				delete node;
+			}
+		}
+
+		// XXX: inline entries are copied into their node on insert, the copy stays at the insert position unless the
+		//      insert redistributed or split the leaf, only then is it located by a descent
+		FORCE_INLINE MapEntry<K,V,Ctx>* insertedEntry(const K key, const Slot& slot, Node* node, inttype index) const {
+			if (Pol::INLINE_ENTRIES == false) {
+				return Entries::entry(slot);
+			}
+
+			if ((node->isLeaf() == true) && (index <= node->m_lastIndex)) {
+				MapEntry<K,V,Ctx>* x = ((Leaf*) node)->getObject(index);
+				if (m_comparator->compare(x->getKey(), key) == 0) {
+					return x;
+				}
+			}
+
+			Node* n;
+			inttype i;
+			return (MapEntry<K,V,Ctx>*) m_root->find(this, key, &n, &i);
+		}
+
+		// XXX: right spine of a tree under bulk load, m_spine[0] is the rightmost leaf
+		struct BulkState {
+			Node* m_spine[64];
+			inttype m_leafTarget;
+			inttype m_branchTarget;
+			inttype m_count;
+			K m_lastKey;
+			K m_pendingKey;
+			V m_pendingVal;
+			boolean m_pending;
+		};
+
+		void bulkBegin(BulkState& state, doubletype fillFactor);
+		boolean bulkAppend(BulkState& state, K key, V val);
+		void bulkAttach(BulkState& state, inttype level, const Slot& obj, Node* node);
+		void bulkEnd(BulkState& state);
+
+		inttype recount(Node* node);
+
+		void reclaim(void);
+		static void release(Shared* shared);
+		static void leave(Lineage* lineage);
+		static void collect(Lineage* lineage);
+
+		Node* copyNode(Node* node);
+		Node* ownChild(Branch* parent, inttype index);
+		Node* own(Node* node);
+		void ownPath(const K key);
+
+		FORCE_INLINE void unshare(void) {
+			if (m_lineage != null) {
+				reclaim();
+			}
+		}
+
+		// XXX: the first changes after a snapshot copy only the nodes they reach, starting from the leaf of key
+		FORCE_INLINE void unshare(const K key) {
+			unshare();
+
+			if ((m_lineage != null) && (m_root != null)) {
+				ownPath(key);
+			}
+		}
+
+		const MapEntry<K,V,Ctx>* fingerFind(const K key, Node** finger) const;
+
+		FORCE_INLINE void checkSpill(void) {
+			if ((Pol::SPILL_LEAVES == true) && (m_spill != null)) {
+				relieve();
+			}
+		}
+
+		void relieve(void);
+		void spillLeaf(Leaf* leaf);
+
+		FORCE_INLINE void destroyEntry(MapEntry<K,V,Ctx>* x, boolean delkey, boolean delval) {
+			K key = x->getKey();
+			V val = x->getValue();
+
+			Entries::destroy(x, getMapContext(), m_entryPool);
+
+			if (delkey == true) {
+				Converter<K>::destroy(key);
+			}
+
+			if (delval == true) {
+				Converter<V>::destroy(val);
+			}
+		}
+
+		const MapEntry<K,V,Ctx>* ceilingPosition(const K key, Node** block, inttype* location);
+
+		V putEntry(K key, V val, K* retkey, boolean* status, MapEntry<K,V,Ctx>** retentry, Node** block, inttype* location);
+		V removeEntry(Node* node, inttype index, K* retkey);
+		void insertAt(Leaf* leaf, inttype index, K key, V val, boolean sequential);
+
+		// XXX: exact cardinality counts need the prefix position a descent computes, positioned inserts skip it
+		FORCE_INLINE boolean getPositionedInsert(void) const {
+			#ifdef COM_DEEPIS_DB_CARDINALITY
+			return (getCardinalityEnabled() == false) || (m_cardinality == null) || (m_sketch != null);
+			#else
+			return true;
+			#endif
+		}
+
+		inttype probeHint(Leaf* leaf, inttype index, const K key, boolean* exists) const;
+
+		void sortBatch(const K* keys, inttype* order, inttype* scratch, inttype count) const;
+		V replaceEntry(MapEntry<K,V,Ctx>* x, K key, V val, K firstKey);
+		#ifdef COM_DEEPIS_DB_CARDINALITY
+		inttype insertPosition(Leaf* leaf, inttype index, const K key, const K* previous);
+		#endif
+		inttype destroySubtree(Node* node, boolean delkey, boolean delval);
+		inttype removeUnit(Node* node, const K fromKey, const K toKey, boolean delkey, boolean delval);
+		#ifdef COM_DEEPIS_DB_CARDINALITY
+		void removeRangeCardinality(const K fromKey, const K toKey);
+		#endif
+		void probeGroup(const K* keys, inttype count, const MapEntry<K,V,Ctx>** entries) const;
+
+		// XXX: leaves share a depth, climb both sides of a leaf boundary in step to the parent holding their separator
+		FORCE_INLINE Branch* separator(Leaf* lNode, Leaf* rNode, inttype* index) const {
+			Node* left = lNode;
+			Node* right = rNode;
+			while (left->m_parent != right->m_parent) {
+				left = left->m_parent;
+				right = right->m_parent;
+			}
+
+			*index = right->m_parent->instanceIndex(right);
+			return right->m_parent;
+		}
+
 		const MapEntry<K,V,Ctx>* nextEntry(Node* node, inttype index, Node** block, inttype* location);
 		const MapEntry<K,V,Ctx>* previousEntry(Node* node, inttype index, Node** block, inttype* location);
 
+		#ifdef COM_DEEPIS_DB_CARDINALITY
+		// XXX: sketch mode hashes the key prefixes of each insert instead of counting its differing position
+		FORCE_INLINE void countCardinality(const K key, inttype pos) {
+			if (m_sketch != null) {
+				sketchKey(key);
+
+			} else {
+				m_cardinality[pos]++;
+			}
+		}
+
+		FORCE_INLINE void sketchKey(const K key) {
+			ulongtype hashes[128];
+			KeyPrefixHash<K>::hash(m_comparator, key, hashes, m_keyParts);
+
+			for (inttype i = 0; i < m_keyParts; i++) {
+				m_sketch[i].add(hashes[i]);
+			}
+		}
+
+		FORCE_INLINE void clearSketch(void) {
+			for (inttype i = 0; (m_sketch != null) && (i < m_keyParts); i++) {
+				m_sketch[i].clear();
+			}
+		}
+		#endif
+
 		const boolean hasNextEntry(Node* node, inttype index);
 		const boolean hasPreviousEntry(Node* node, inttype index);
 
@@ -473,6 +830,13 @@ class TreeMap : /* public NavigableMap */ public SortedMap<K,V,Ctx> {
 		FORCE_INLINE boolean getCardinalityEnabled() const {
 			return (m_stateFlags & 0x08) != 0;
 		}
+
+		// XXX: approximate statistics, inserts feed one HyperLogLog sketch per key prefix and removes do not touch them;
+		//      getCardinality() then keeps the values of the last recalculateCardinality() (which also rebuilds the sketches)
+		void setCardinalitySketchEnabled(boolean flag);
+		FORCE_INLINE boolean getCardinalitySketchEnabled() const {
+			return (m_sketch != null);
+		}
 		#endif
 
 		#if defined(COM_DEEPIS_DB_INDEX_REF) || defined(COM_DEEPIS_DB_CARDINALITY)
@@ -503,6 +867,13 @@ class TreeMap : /* public NavigableMap */ public SortedMap<K,V,Ctx> {
 
 		// XXX: used for extreme optimization
 		FORCE_INLINE void transfer(TreeMap* tree) {
+			unshare();
+
+			// XXX: generations still hold nodes carved from this map's slabs
+			if (m_lineage != null) {
+				throw new UnsupportedOperationException("Transfer of a map with snapshots");
+			}
+
 			tree->m_leafLowWater = m_leafLowWater;
 			tree->m_leafMaxIndex = m_leafMaxIndex;
 			tree->m_branchLowWater = m_branchLowWater;
@@ -521,6 +892,15 @@ class TreeMap : /* public NavigableMap */ public SortedMap<K,V,Ctx> {
 			tree->m_pEntries = m_pEntries;
 			tree->m_root = m_root;
 
+			// XXX: pooled nodes belong to the slabs they were carved from, hand the slabs over as well
+			SlabPool* pool = tree->m_nodePool;
+			tree->m_nodePool = m_nodePool;
+			m_nodePool = pool;
+
+			pool = tree->m_entryPool;
+			tree->m_entryPool = m_entryPool;
+			m_entryPool = pool;
+
 			#ifdef COM_DEEPIS_DB_INDEX_REF
 			if (getVirtualSizeEnabled() == true) {
 				m_vEntries = 0;
@@ -540,6 +920,19 @@ class TreeMap : /* public NavigableMap */ public SortedMap<K,V,Ctx> {
 					#endif
 				}
 			}
+
+			// XXX: registers follow the entries, this tree keeps sketching into the cleared set it gets back
+			if (m_sketch != null) {
+				if (tree->m_sketch == null) {
+					tree->m_sketch = new CardinalitySketch[m_keyParts];
+				}
+
+				CardinalitySketch* sketch = tree->m_sketch;
+				tree->m_sketch = m_sketch;
+				m_sketch = sketch;
+
+				clearSketch();
+			}
 			#endif
 
 			m_pEntries = 0;
@@ -548,17 +941,41 @@ class TreeMap : /* public NavigableMap */ public SortedMap<K,V,Ctx> {
 
 	public:
 		static const bytetype INITIAL_ORDER;
+		static const inttype MAXIMUM_ORDER;
+
+		// XXX: typical node byte targets, a cache line pair, a page and a huge page fraction
+		static const inttype NODE_BYTES_SMALL = 256;
+		static const inttype NODE_BYTES_PAGE = 4 * 1024;
+		static const inttype NODE_BYTES_LARGE = 16 * 1024;
+
+		/**
+		 * Order whose leaf entry array fills about nodeBytes, e.g. TreeMap(comparator, orderFor(NODE_BYTES_PAGE)).
+		 * Leaves hold 2 * (order + 1) slots, so the fanout follows sizeof(K) and sizeof(V) when entries are inline
+		 * and one pointer per entry otherwise; the result is clamped to [INITIAL_ORDER, MAXIMUM_ORDER].
+		 */
+		FORCE_INLINE static inttype orderFor(inttype nodeBytes) {
+			inttype order = (nodeBytes / (2 * (inttype) sizeof(Slot))) - 1;
+			if (order < INITIAL_ORDER) {
+				return INITIAL_ORDER;
+			}
+
+			return (order > MAXIMUM_ORDER) ? MAXIMUM_ORDER : order;
+		}
+
+		FORCE_INLINE inttype getOrder(void) const {
+			return m_branchMaxIndex;
+		}
 
 	public:
 
 		/*
 		TreeMap(const Map* map);
 		*/
-		TreeMap(bytetype order = INITIAL_ORDER /* XXX: purposely signed */, boolean delkey = false, boolean delval = false);
+		TreeMap(inttype order = INITIAL_ORDER /* XXX: purposely signed */, boolean delkey = false, boolean delval = false);
 		#ifdef COM_DEEPIS_DB_CARDINALITY
-		TreeMap(const Comparator<K>* comparator, bytetype order = INITIAL_ORDER, boolean delkey = false, boolean delval = false, bytetype keyParts = -1);
+		TreeMap(const Comparator<K>* comparator, inttype order = INITIAL_ORDER, boolean delkey = false, boolean delval = false, bytetype keyParts = -1);
 		#else
-		TreeMap(const Comparator<K>* comparator, bytetype order = INITIAL_ORDER, boolean delkey = false, boolean delval = false);
+		TreeMap(const Comparator<K>* comparator, inttype order = INITIAL_ORDER, boolean delkey = false, boolean delval = false);
 		#endif
 		virtual ~TreeMap();
 
@@ -607,9 +1024,38 @@ class TreeMap : /* public NavigableMap */ public SortedMap<K,V,Ctx> {
 		FORCE_INLINE V add(K key, V val, boolean* last, boolean replace) {
 			return add(key, val, null, last, replace, null);
 		}
+
+		// XXX: leaf position of the last hinted put, only trusted while the map is otherwise unchanged
+		class Hint {
+
+			private:
+				Node* m_node;
+				inttype m_index;
+				uinttype m_modification;
+
+			public:
+				Hint(void):
+					m_node(null),
+					m_index(-1),
+					m_modification(0) {
+				}
+
+				FORCE_INLINE void reset(void) {
+					m_node = null;
+					m_index = -1;
+				}
+
+			friend class TreeMap;
+		};
+
+		// XXX: starts at the hinted position and checks the key against its neighbors there, descending only when
+		//      the key falls outside them; clustered, nearly sorted loads insert in amortized O(1) (hint is updated)
+		V put(Hint* hint, K key, V val, boolean* status = null);
 		#endif
 
-		FORCE_INLINE V put(K key, V val, K* retkey, boolean* status, MapEntry<K,V,Ctx>** retentry = null);
+		FORCE_INLINE V put(K key, V val, K* retkey, boolean* status, MapEntry<K,V,Ctx>** retentry = null) {
+			return putEntry(key, val, retkey, status, retentry, null, null);
+		}
 		FORCE_INLINE V put(K key, V val, K* retkey) {
 			return put(key, val, retkey, null, null);
 		}
@@ -622,6 +1068,16 @@ class TreeMap : /* public NavigableMap */ public SortedMap<K,V,Ctx> {
 			putAll(map, null);
 		}
 
+		// XXX: bulk loads build leaves left to right (ascending unique keys) and branch levels above them,
+		//      fillFactor (0.0 - 1.0] sets how full nodes are packed; a non-empty tree or unsorted input falls back to put
+		void bulkLoad(const K* keys, const V* vals, inttype count, doubletype fillFactor = 1.0);
+		void bulkLoad(Iterator<MapEntry<K,V,Ctx>*>* iter, doubletype fillFactor = 1.0);
+
+		// XXX: applies an unsorted batch in one ordered pass, each leaf it reaches takes its keys in one fill and fills up
+		//      at most once (so splits at most once); later duplicates win as with repeated puts, replaced values go to
+		//      retvals (by batch position) when given and the number of added entries is returned
+		inttype putBatch(const K* keys, const V* vals, inttype count, V* retvals = null);
+
 		FORCE_INLINE V remove(const K key, K* retkey, boolean* status);
 		FORCE_INLINE V remove(const K key, K* retkey) {
 			return remove(key, retkey, null);
@@ -630,6 +1086,17 @@ class TreeMap : /* public NavigableMap */ public SortedMap<K,V,Ctx> {
 			return remove(key, null, null);
 		}
 
+		// XXX: order statistics over subtree counts, rank is the number of keys below key and select is zero based
+		inttype rank(const K key) const;
+		const MapEntry<K,V,Ctx>* select(inttype index) const;
+		inttype countRange(const K fromKey, const K toKey) const;
+
+		// XXX: removes keys in [fromKey, toKey), subtrees inside the range are released whole and only the boundary paths rebalance
+		inttype removeRange(const K fromKey, const K toKey, boolean delkey, boolean delval);
+		inttype removeRange(const K fromKey, const K toKey) {
+			return removeRange(fromKey, toKey, getDeleteKey(), getDeleteValue());
+		}
+
 		FORCE_INLINE const V get(const K key, K* retkey, boolean* status) const;
 		FORCE_INLINE const V get(const K key, K* retkey) const {
 			return get(key, retkey, null);
@@ -641,6 +1108,11 @@ class TreeMap : /* public NavigableMap */ public SortedMap<K,V,Ctx> {
 		virtual boolean containsKey(const K key) const;
 		virtual boolean containsValue(const V val) const;
 
+		// XXX: batch lookups, ascending keys resume each probe from the node the previous one ended in (finger search),
+		//      unsorted batches descend in interleaved groups prefetching the next level; getAll returns the number found
+		inttype getAll(const K* keys, inttype count, V* vals, boolean* found = null, boolean sorted = true) const;
+		boolean containsAll(const K* keys, inttype count, boolean sorted = true) const;
+
 		virtual boolean isEmpty() const {
 			return (size() == 0);
 		}
@@ -666,9 +1138,16 @@ class TreeMap : /* public NavigableMap */ public SortedMap<K,V,Ctx> {
 			return m_cardinality;
 		}
 
+		// XXX: fills cardinality as getCardinality() would read, from the sketches when enabled (exact counts otherwise)
+		void getCardinalityEstimate(inttype* cardinality) const;
+
+		// XXX: folds the sketches of a tree over the same key schema into this one (e.g. partitions of one index)
+		void mergeCardinality(const TreeMap* tree);
+
 		void recalculateCardinality() {
 			if (m_cardinality != null) {
 				memset(m_cardinality, 0, m_keyParts * sizeof(inttype));
+				clearSketch();
 
 				inttype pos = 0;
 				K lastKey = (K) Converter<K>::NULL_VALUE;
@@ -684,6 +1163,10 @@ class TreeMap : /* public NavigableMap */ public SortedMap<K,V,Ctx> {
 					m_cardinality[pos]++;
 					pos = 0;
 
+					if (m_sketch != null) {
+						sketchKey(x->getKey());
+					}
+
 					lastKey = x->getKey();
 				}
 			}
@@ -746,25 +1229,64 @@ class TreeMap : /* public NavigableMap */ public SortedMap<K,V,Ctx> {
 			return iterator(startKey, null);
 		}
 
+		// XXX: visits entries in [fromKey, toKey) in order without allocating, leaves below toKey are walked without comparing;
+		//      visitor is called as boolean visitor(const MapEntry<K,V,Ctx>*) and returns false to stop
+		template<typename F>
+		FORCE_INLINE inttype forEachInRange(const K fromKey, const K toKey, F&& visitor) {
+			return forEachInRange(fromKey, false, toKey, false, visitor);
+		}
+
+		// XXX: fromOpen or toOpen leaves that side unbounded and its key unread, every key value (NULL_KEY included) is a real bound
+		template<typename F>
+		inttype forEachInRange(const K fromKey, boolean fromOpen, const K toKey, boolean toOpen, F&& visitor);
+
+		class RangeCursor;
+
+		class Snapshot;
+
+		// XXX: read-only view of the current contents in O(1), later changes copy only the nodes they reach and leave
+		//      the rest shared (snapshots share keys and values with the map, maps deleting their keys or values cannot be snapshot)
+		Snapshot* snapshot(void);
+
+		// XXX: moves the entries into a read-only, contiguous FrozenTreeMap (same comparator, key and value ownership),
+		//      leaving this map empty; meant for maps that stop changing (e.g. sealed segments)
+		FrozenTreeMap<K,V,Ctx>* freeze(void);
+
+		// XXX: spill mode (TreePolicy::SPILL_LEAVES), once the process holds more than highWater bytes (see Memory::
+		//      getProcessAllocatedBytes) cold leaves are written to the file at path until about lowWater would be left,
+		//      a leaf touched by a search, iteration or change is read back first. Reads then modify the tree, so they
+		//      need the same serialization as writes. A null path reads every leaf back and closes the file.
+		void setSpillFile(const char* path, ulongtype highWater, ulongtype lowWater);
+
+		// XXX: evicts up to count leaves the CLOCK hand finds unreferenced, returns how many went to the file
+		inttype spill(inttype count);
+
+		longtype getSpilledLeaves(void) const;
+
 	template<typename E=MapEntry<K,V,Ctx>*>
 	class TreeMapIterator : public TreeIterator<E> {
 
 		private:
-			TreeMap<K,V,Ctx>* m_map;
+			TreeMap<K,V,Ctx,Pol>* m_map;
 			Node* m_cursorNode;
 			inttype m_cursorIndex;
+			// XXX: position of the entry last returned by next or previous, null once it is removed
+			Node* m_currentNode;
+			inttype m_currentIndex;
 			#ifdef COM_DEEPIS_DB_INDEX_REF
 			uinttype m_modification;
 			#endif
 
-			TreeMapIterator(TreeMap<K,V,Ctx>* map, const K startKey, boolean ceiling, boolean* exact) {
+			TreeMapIterator(TreeMap<K,V,Ctx,Pol>* map, const K startKey, boolean ceiling, boolean* exact) {
 				reset(map, startKey, ceiling, exact);
 			}
 
-			void reset(TreeMap<K,V,Ctx>* map, const K startKey, boolean ceiling, boolean* exact) {
+			void reset(TreeMap<K,V,Ctx,Pol>* map, const K startKey, boolean ceiling, boolean* exact) {
 				m_map = map;
 				m_cursorNode = null;
 				m_cursorIndex = -1;
+				m_currentNode = null;
+				m_currentIndex = -1;
 
 				#ifdef COM_DEEPIS_DB_INDEX_REF
 				m_modification = m_map->m_modification;
@@ -804,15 +1326,73 @@ class TreeMap : /* public NavigableMap */ public SortedMap<K,V,Ctx> {
 				m_cursorIndex = m_cursorNode->m_lastIndex + 1;
 			}
 
+			// XXX: places the cursor back on key after a change moved entries across nodes
+			FORCE_INLINE void seek(const K key, boolean end) {
+				if (m_map->m_root == null) {
+					m_cursorNode = null;
+					m_cursorIndex = -1;
+
+				} else if (end == true) {
+					setEnd();
+
+				} else {
+					m_map->m_root->find(m_map, key, &m_cursorNode, &m_cursorIndex);
+				}
+			}
+
+			FORCE_INLINE const K cursorKey(boolean end) const {
+				return (end == true) ? (K) Map<K,V,Ctx>::NULL_KEY : m_cursorNode->getEntry(m_cursorIndex)->getKey();
+			}
+
+			// XXX: a change to a map shared with snapshots copies the nodes around the cursor and the current entry,
+			//      carry the positions over by key
+			void unshare(void) {
+				if (m_map->m_lineage == null) {
+					return;
+				}
+
+				boolean end = isEnd();
+				K key = cursorKey(end);
+				K current = (m_currentNode != null) ? m_currentNode->getEntry(m_currentIndex)->getKey() : (K) Map<K,V,Ctx>::NULL_KEY;
+
+				m_map->unshare();
+
+				if ((m_map->m_lineage != null) && (m_map->m_root != null)) {
+					if (end == true) {
+						m_map->own(m_map->m_root->lastLeaf());
+
+					} else {
+						m_map->ownPath(key);
+					}
+
+					if (m_currentNode != null) {
+						m_map->ownPath(current);
+					}
+				}
+
+				seek(key, end);
+				if (m_currentNode != null) {
+					m_map->m_root->find(m_map, current, &m_currentNode, &m_currentIndex);
+				}
+			}
+
+			FORCE_INLINE void modified(void) {
+				#ifdef COM_DEEPIS_DB_INDEX_REF
+				m_modification = m_map->m_modification;
+				#endif
+			}
+
 		public:
 			TreeMapIterator(void):
 				m_map(null),
 				m_cursorNode(null),
-				#ifdef COM_DEEPIS_DB_INDEX_REF
 				m_cursorIndex(-1),
+				m_currentNode(null),
+				#ifdef COM_DEEPIS_DB_INDEX_REF
+				m_currentIndex(-1),
 				m_modification(0) {
 				#else
-				m_cursorIndex(-1) {
+				m_currentIndex(-1) {
 				#endif
 			}
 
@@ -829,8 +1409,8 @@ class TreeMap : /* public NavigableMap */ public SortedMap<K,V,Ctx> {
 				return m_modification;
 			}
 
-			FORCE_INLINE TreeMap<K,V,Ctx>* getContainer(boolean check) {
-				TreeMap<K,V,Ctx>* map = m_map;
+			FORCE_INLINE TreeMap<K,V,Ctx,Pol>* getContainer(boolean check) {
+				TreeMap<K,V,Ctx,Pol>* map = m_map;
 
 				if ((check == true) && (map != null) && (map->m_modification != m_modification)) {
 					map = null;
@@ -855,6 +1435,9 @@ class TreeMap : /* public NavigableMap */ public SortedMap<K,V,Ctx> {
 				if (isEnd() == false) {
 					nextEntry = (E) m_cursorNode->getEntry(m_cursorIndex);
 
+					m_currentNode = m_cursorNode;
+					m_currentIndex = m_cursorIndex;
+
 					m_map->nextEntry(m_cursorNode, m_cursorIndex, &m_cursorNode, &m_cursorIndex);
 
 					if (m_cursorNode == null) {
@@ -870,13 +1453,141 @@ class TreeMap : /* public NavigableMap */ public SortedMap<K,V,Ctx> {
 
 				if (hasPrevious() == true) {
 					previousEntry = (E) m_map->previousEntry(m_cursorNode, m_cursorIndex, &m_cursorNode, &m_cursorIndex);
+
+					m_currentNode = m_cursorNode;
+					m_currentIndex = m_cursorIndex;
 				}
 
 				return previousEntry;
 			}
 
+			// XXX: removes the entry last returned by next or previous from where it sits, without searching for it;
+			//      a leaf left above low water only shifts, otherwise the cursor is placed again on its successor
 			inline virtual void remove() {
-				throw new UnsupportedOperationException("Remove not supported");
+				if (m_currentNode == null) {
+					throw new UnsupportedOperationException("Remove without a current entry");
+				}
+
+				unshare();
+
+				Node* node = m_currentNode;
+				inttype index = m_currentIndex;
+				m_currentNode = null;
+
+				boolean local = (node->isLeaf() == true) && ((node == m_map->m_root) || (node->m_lastIndex > m_map->m_leafLowWater));
+
+				// XXX: after previous the cursor sits on the removed entry, at a leaf tail it has to move on to another node
+				if ((m_cursorNode == node) && (m_cursorIndex == index) && (index == node->m_lastIndex)) {
+					local = false;
+				}
+
+				Node* successorNode = null;
+				inttype successorIndex = -1;
+				const MapEntry<K,V,Ctx>* successor = null;
+				K key = Map<K,V,Ctx>::NULL_KEY;
+				if (local == false) {
+					successor = m_map->nextEntry(node, index, &successorNode, &successorIndex);
+					if (successor != null) {
+						key = successor->getKey();
+					}
+				}
+
+				V val = m_map->removeEntry(node, index, null);
+				if (m_map->getDeleteValue() == true) {
+					Converter<V>::destroy(val);
+				}
+
+				if (m_map->m_root == null) {
+					m_cursorNode = null;
+					m_cursorIndex = -1;
+
+				} else if (local == true) {
+					if ((m_cursorNode == node) && (m_cursorIndex > index)) {
+						m_cursorIndex--;
+					}
+
+				} else {
+					seek(key, (successor == null));
+				}
+
+				modified();
+			}
+
+			// XXX: replaces the value of the entry last returned by next or previous, returns the old value
+			inline V replaceValue(V val) {
+				if (m_currentNode == null) {
+					throw new UnsupportedOperationException("Replace without a current entry");
+				}
+
+				unshare();
+
+				MapEntry<K,V,Ctx>* x = (MapEntry<K,V,Ctx>*) m_currentNode->getEntry(m_currentIndex);
+				V retval = x->getValue();
+				x->setValue(val, m_map->getMapContext());
+
+				#ifdef COM_DEEPIS_DB_INDEX_REF
+				m_map->m_modification++;
+				#endif
+				modified();
+
+				return retval;
+			}
+
+			// XXX: inserts key right before the cursor (what next would return), checked against the neighbors there;
+			//      a key out of place there or a full leaf goes through put and the cursor is placed again
+			inline V insertBefore(K key, V val, boolean* status = null) {
+				unshare();
+
+				m_currentNode = null;
+
+				boolean end = isEnd();
+				if (m_cursorNode == null) {
+					V retval = m_map->put(key, val, null, status, null);
+					seek(key, true);
+					modified();
+
+					return retval;
+				}
+
+				K next = cursorKey(end);
+
+				if ((m_cursorNode->isLeaf() == true) && (m_cursorIndex > 0) && (m_map->getPositionedInsert() == true)) {
+					Leaf* leaf = (Leaf*) m_cursorNode;
+					inttype last = leaf->m_lastIndex;
+
+					boolean after = (m_map->m_comparator->compare(leaf->getObject(m_cursorIndex - 1)->getKey(), key) < 0);
+					boolean before = (end == true) ? (leaf->m_next == null) : (m_map->m_comparator->compare(key, next) < 0);
+
+					if ((after == true) && (before == true)) {
+						m_map->insertAt(leaf, m_cursorIndex, key, val, end);
+
+						if (leaf->m_lastIndex == (last + 1)) {
+							m_cursorIndex++;
+
+						} else {
+							seek(next, end);
+						}
+
+						if (status != null) {
+							*status = false;
+						}
+
+						modified();
+
+						return Map<K,V,Ctx>::NULL_VALUE;
+					}
+				}
+
+				// XXX: replacing the cursor entry itself may hand it the new key (and drop the old one)
+				if ((end == false) && (m_map->m_comparator->compare(key, next) == 0)) {
+					next = key;
+				}
+
+				V retval = m_map->put(key, val, null, status, null);
+				seek(next, end);
+				modified();
+
+				return retval;
 			}
 
 		friend class TreeMap;
@@ -884,6 +1595,159 @@ class TreeMap : /* public NavigableMap */ public SortedMap<K,V,Ctx> {
 
 	typedef TreeMapIterator<> TreeMapEntryIterator;
 
+	class Snapshot {
+
+		private:
+			Shared* m_shared;
+
+			Snapshot(Shared* shared):
+				m_shared(shared) {
+			}
+
+		public:
+			~Snapshot() {
+				TreeMap<K,V,Ctx,Pol>::release(m_shared);
+			}
+
+			FORCE_INLINE inttype size() const {
+				return m_shared->m_map->size();
+			}
+
+			FORCE_INLINE const V get(const K key, K* retkey = null, boolean* status = null) const {
+				return m_shared->m_map->get(key, retkey, status);
+			}
+
+			FORCE_INLINE boolean containsKey(const K key) const {
+				return m_shared->m_map->containsKey(key);
+			}
+
+			FORCE_INLINE const K firstKey(boolean* status = null) const {
+				return m_shared->m_map->firstKey(status);
+			}
+
+			FORCE_INLINE const K lastKey(boolean* status = null) const {
+				return m_shared->m_map->lastKey(status);
+			}
+
+			FORCE_INLINE Set<MapEntry<K,V,Ctx>*>* entrySet(Set<MapEntry<K,V,Ctx>*>* fillset = null) const {
+				return m_shared->m_map->entrySet(fillset);
+			}
+
+			FORCE_INLINE TreeIterator<MapEntry<K,V,Ctx>*>* iterator(const K startKey, TreeIterator<MapEntry<K,V,Ctx>*>* filliter = null) const {
+				return m_shared->m_map->iterator(startKey, filliter);
+			}
+
+		friend class TreeMap;
+	};
+
+	// XXX: stack allocated range scan handing out entries in batches, like iterators any change to the map invalidates it
+	class RangeCursor {
+
+		private:
+			TreeMap<K,V,Ctx,Pol>* m_map;
+			const MapEntry<K,V,Ctx>* m_entry;
+			Node* m_node;
+			inttype m_index;
+			K m_toKey;
+			boolean m_toOpen;
+
+		public:
+			RangeCursor(TreeMap<K,V,Ctx,Pol>* map, const K fromKey) {
+				reset(map, fromKey, false, fromKey, true);
+			}
+
+			RangeCursor(TreeMap<K,V,Ctx,Pol>* map, const K fromKey, const K toKey) {
+				reset(map, fromKey, false, toKey, false);
+			}
+
+			// XXX: open sides as in TreeMap::forEachInRange
+			RangeCursor(TreeMap<K,V,Ctx,Pol>* map, const K fromKey, boolean fromOpen, const K toKey, boolean toOpen) {
+				reset(map, fromKey, fromOpen, toKey, toOpen);
+			}
+
+			FORCE_INLINE void reset(TreeMap<K,V,Ctx,Pol>* map, const K fromKey) {
+				reset(map, fromKey, false, fromKey, true);
+			}
+
+			FORCE_INLINE void reset(TreeMap<K,V,Ctx,Pol>* map, const K fromKey, const K toKey) {
+				reset(map, fromKey, false, toKey, false);
+			}
+
+			void reset(TreeMap<K,V,Ctx,Pol>* map, const K fromKey, boolean fromOpen, const K toKey, boolean toOpen) {
+				m_map = map;
+				m_entry = null;
+				m_node = null;
+				m_index = -1;
+				m_toKey = toKey;
+				m_toOpen = toOpen;
+
+				if (m_map->m_root != null) {
+					if (fromOpen == false) {
+						m_entry = m_map->ceilingPosition(fromKey, &m_node, &m_index);
+
+					} else {
+						Leaf* leaf = m_map->m_root->firstLeaf();
+						m_entry = leaf->getObject(0);
+						m_node = leaf;
+						m_index = 0;
+					}
+				}
+			}
+
+			FORCE_INLINE boolean hasNext() const {
+				return (m_entry != null) && ((m_toOpen == true) || (m_map->m_comparator->compare(m_entry->getKey(), m_toKey) < 0));
+			}
+
+			// XXX: fills up to count entries and returns how many were filled, zero once the range is exhausted
+			inttype nextBatch(const MapEntry<K,V,Ctx>** entries, inttype count) {
+				boolean bounded = (m_toOpen == false);
+				inttype filled = 0;
+
+				while ((m_entry != null) && (filled < count)) {
+					if (m_node->isLeaf() == true) {
+						Leaf* leaf = (Leaf*) m_node;
+						inttype last = leaf->m_lastIndex;
+						if ((last - m_index) >= (count - filled)) {
+							last = m_index + (count - filled) - 1;
+						}
+
+						boolean inside = (bounded == false) || (m_map->m_comparator->compare(leaf->getObject(last)->getKey(), m_toKey) < 0);
+						for (; m_index <= last; m_index++) {
+							const MapEntry<K,V,Ctx>* x = leaf->getObject(m_index);
+							if ((inside == false) && (m_map->m_comparator->compare(x->getKey(), m_toKey) >= 0)) {
+								m_entry = null;
+								return filled;
+							}
+
+							entries[filled++] = x;
+						}
+
+						if (m_index <= leaf->m_lastIndex) {
+							m_entry = leaf->getObject(m_index);
+
+						} else {
+							m_entry = m_map->nextEntry(leaf, leaf->m_lastIndex, &m_node, &m_index);
+						}
+
+					} else {
+						if ((bounded == true) && (m_map->m_comparator->compare(m_entry->getKey(), m_toKey) >= 0)) {
+							m_entry = null;
+							break;
+						}
+
+						entries[filled++] = m_entry;
+						m_entry = m_map->nextEntry(m_node, m_index, &m_node, &m_index);
+					}
+				}
+
+				return filled;
+			}
+
+		friend class TreeMap;
+	};
+
+	friend class RangeCursor;
+	friend class Snapshot;
 	friend class TreeMapIterator<MapEntry<K,V,Ctx>*>;
 	friend class EntrySetIterator;
 	friend class KeySetIterator;
@@ -899,37 +1763,53 @@ class TreeMap : /* public NavigableMap */ public SortedMap<K,V,Ctx> {
 
 			private:
 				const MapEntry<K,V,Ctx>* m_entry;
-				TreeMap<K,V,Ctx>* m_map;
+				TreeMap<K,V,Ctx,Pol>* m_map;
 				Node* m_startNode;
 				Node* m_endNode;
 				inttype m_startIndex;
 				inttype m_endIndex;
 
-				EntrySetIterator() {
+				EntrySetIterator():
+					m_entry(null),
+					m_map(null),
+					m_startNode(null),
+					m_endNode(null),
+					m_startIndex(-1),
+					m_endIndex(-1) {
 				}
 
-				EntrySetIterator(TreeMap<K,V,Ctx>* map) {
+				EntrySetIterator(TreeMap<K,V,Ctx,Pol>* map):
+					m_entry(null),
+					m_map(null),
+					m_startNode(null),
+					m_endNode(null),
+					m_startIndex(-1),
+					m_endIndex(-1) {
 					reset(map);
 				}
 
-				EntrySetIterator(TreeMap<K,V,Ctx>* map, Node* startNode, inttype startIndex, Node* endNode, inttype endIndex) {
+				EntrySetIterator(TreeMap<K,V,Ctx,Pol>* map, Node* startNode, inttype startIndex, Node* endNode, inttype endIndex):
+					m_entry(null),
+					m_map(null),
+					m_startNode(null),
+					m_endNode(null),
+					m_startIndex(-1),
+					m_endIndex(-1) {
 					reset(map, startNode, startIndex, endNode, endIndex);
 				}
 
-				void reset(TreeMap<K,V,Ctx>* map) {
+				void reset(TreeMap<K,V,Ctx,Pol>* map) {
 					reset(map, null, -1);
 				}
 
-				void reset(TreeMap<K,V,Ctx>* map, Node* endNode, inttype endIndex) {
+				void reset(TreeMap<K,V,Ctx,Pol>* map, Node* endNode, inttype endIndex) {
 					reset(map, null, -1, endNode, endIndex);
 				}
 
-				void reset(TreeMap<K,V,Ctx>* map, Node* startNode, inttype startIndex, Node* endNode, inttype endIndex) {
+				void reset(TreeMap<K,V,Ctx,Pol>* map, Node* startNode, inttype startIndex, Node* endNode, inttype endIndex) {
 					if (startNode == null) {
 						m_startNode = map->m_root;
-						if (m_startNode != null) {
-							m_startIndex = m_startNode->isLeaf() ? -1 : 0;
-						}
+						m_startIndex = ((m_startNode != null) && (m_startNode->isLeaf() == false)) ? 0 : -1;
 
 					} else {
 						m_startNode = startNode;
@@ -971,14 +1851,16 @@ class TreeMap : /* public NavigableMap */ public SortedMap<K,V,Ctx> {
 				}
 
 				inline virtual void remove() {
-					const MapEntry<K,V,Ctx>* lowerEntry = m_map->lowerEntry(m_entry->getKey());
+					// XXX: capture the lower key up front, inline entries move during removal
+					boolean lower;
+					const K lowerKey = m_map->lowerKey(m_entry->getKey(), &lower);
 
 					m_map->remove(m_entry->getKey());
-					if (lowerEntry == null) {
+					if (lower == false) {
 						reset(m_map, m_endNode, m_endIndex);
 
 					} else {
-						m_map->m_root->find(m_map, lowerEntry->getKey(), &m_startNode, &m_startIndex);
+						m_map->m_root->find(m_map, lowerKey, &m_startNode, &m_startIndex);
 					}
 				}
 
@@ -1029,38 +1911,36 @@ class TreeMap : /* public NavigableMap */ public SortedMap<K,V,Ctx> {
 			EntrySet() {
 			}
 
-			EntrySet(TreeMap<K,V,Ctx>* map):
+			EntrySet(TreeMap<K,V,Ctx,Pol>* map):
 				m_reuse(false) {
 
 				reset(map);
 			}
 
-			EntrySet(TreeMap<K,V,Ctx>* map, Node* endNode, inttype endIndex):
+			EntrySet(TreeMap<K,V,Ctx,Pol>* map, Node* endNode, inttype endIndex):
 				m_reuse(false) {
 
 				reset(map, endNode, endIndex);
 			}
 
-			EntrySet(TreeMap<K,V,Ctx>* map, Node* startNode, inttype startIndex, Node* endNode, inttype endIndex):
+			EntrySet(TreeMap<K,V,Ctx,Pol>* map, Node* startNode, inttype startIndex, Node* endNode, inttype endIndex):
 				m_reuse(false) {
 
 				reset(map, startNode, startIndex, endNode, endIndex);
 			}
 
-			void reset(TreeMap<K,V,Ctx>* map) {
+			void reset(TreeMap<K,V,Ctx,Pol>* map) {
 				reset(map, null, -1);
 			}
 
-			void reset(TreeMap<K,V,Ctx>* map, Node* endNode, inttype endIndex) {
+			void reset(TreeMap<K,V,Ctx,Pol>* map, Node* endNode, inttype endIndex) {
 				reset(map, null, -1, endNode, endIndex);
 			}
 
-			void reset(TreeMap<K,V,Ctx>* map, Node* startNode, inttype startIndex, Node* endNode, inttype endIndex) {
+			void reset(TreeMap<K,V,Ctx,Pol>* map, Node* startNode, inttype startIndex, Node* endNode, inttype endIndex) {
 				if (startNode == null) {
 					m_startNode = map->m_root;
-					if (m_startNode != null) {
-						m_startIndex = m_startNode->isLeaf() ? -1 : 0;
-					}
+					m_startIndex = ((m_startNode != null) && (m_startNode->isLeaf() == false)) ? 0 : -1;
 
 				} else {
 					m_startNode = startNode;
@@ -1175,37 +2055,53 @@ class TreeMap : /* public NavigableMap */ public SortedMap<K,V,Ctx> {
 
 			private:
 				const MapEntry<K,V,Ctx>* m_entry;
-				TreeMap<K,V,Ctx>* m_map;
+				TreeMap<K,V,Ctx,Pol>* m_map;
 				Node* m_startNode;
 				Node* m_endNode;
 				inttype m_startIndex;
 				inttype m_endIndex;
 
-				KeySetIterator() {
+				KeySetIterator():
+					m_entry(null),
+					m_map(null),
+					m_startNode(null),
+					m_endNode(null),
+					m_startIndex(-1),
+					m_endIndex(-1) {
 				}
 
-				KeySetIterator(TreeMap<K,V,Ctx>* map) {
+				KeySetIterator(TreeMap<K,V,Ctx,Pol>* map):
+					m_entry(null),
+					m_map(null),
+					m_startNode(null),
+					m_endNode(null),
+					m_startIndex(-1),
+					m_endIndex(-1) {
 					reset(map);
 				}
 
-				KeySetIterator(TreeMap<K,V,Ctx>* map, Node* startNode, inttype startIndex, Node* endNode, inttype endIndex) {
+				KeySetIterator(TreeMap<K,V,Ctx,Pol>* map, Node* startNode, inttype startIndex, Node* endNode, inttype endIndex):
+					m_entry(null),
+					m_map(null),
+					m_startNode(null),
+					m_endNode(null),
+					m_startIndex(-1),
+					m_endIndex(-1) {
 					reset(map, startNode, startIndex, endNode, endIndex);
 				}
 
-				void reset(TreeMap<K,V,Ctx>* map) {
+				void reset(TreeMap<K,V,Ctx,Pol>* map) {
 					reset(map, null, -1);
 				}
 
-				void reset(TreeMap<K,V,Ctx>* map, Node* endNode, inttype endIndex) {
+				void reset(TreeMap<K,V,Ctx,Pol>* map, Node* endNode, inttype endIndex) {
 					reset(map, null, -1, endNode, endIndex);
 				}
 
-				void reset(TreeMap<K,V,Ctx>* map, Node* startNode, inttype startIndex, Node* endNode, inttype endIndex) {
+				void reset(TreeMap<K,V,Ctx,Pol>* map, Node* startNode, inttype startIndex, Node* endNode, inttype endIndex) {
 					if (startNode == null) {
 						m_startNode = map->m_root;
-						if (m_startNode != null) {
-							m_startIndex = m_startNode->isLeaf() ? -1 : 0;
-						}
+						m_startIndex = ((m_startNode != null) && (m_startNode->isLeaf() == false)) ? 0 : -1;
 
 					} else {
 						m_startNode = startNode;
@@ -1247,14 +2143,16 @@ class TreeMap : /* public NavigableMap */ public SortedMap<K,V,Ctx> {
 				}
 
 				inline virtual void remove() {
-					const MapEntry<K,V,Ctx>* lowerEntry = m_map->lowerEntry(m_entry->getKey());
+					// XXX: capture the lower key up front, inline entries move during removal
+					boolean lower;
+					const K lowerKey = m_map->lowerKey(m_entry->getKey(), &lower);
 
 					m_map->remove(m_entry->getKey());
-					if (lowerEntry == null) {
+					if (lower == false) {
 						reset(m_map, m_endNode, m_endIndex);
 
 					} else {
-						m_map->m_root->find(m_map, lowerEntry->getKey(), &m_startNode, &m_startIndex);
+						m_map->m_root->find(m_map, lowerKey, &m_startNode, &m_startIndex);
 					}
 				}
 
@@ -1273,35 +2171,33 @@ class TreeMap : /* public NavigableMap */ public SortedMap<K,V,Ctx> {
 			KeySet() {
 			}
 
-			KeySet(TreeMap<K,V,Ctx>* map):
+			KeySet(TreeMap<K,V,Ctx,Pol>* map):
 				m_reuse(false) {
 				reset(map);
 			}
 
-			KeySet(TreeMap<K,V,Ctx>* map, Node* endNode, inttype endIndex):
+			KeySet(TreeMap<K,V,Ctx,Pol>* map, Node* endNode, inttype endIndex):
 				m_reuse(false) {
 				reset(map, endNode, endIndex);
 			}
 
-			KeySet(TreeMap<K,V,Ctx>* map, Node* startNode, inttype startIndex, Node* endNode, inttype endIndex):
+			KeySet(TreeMap<K,V,Ctx,Pol>* map, Node* startNode, inttype startIndex, Node* endNode, inttype endIndex):
 				m_reuse(false) {
 				reset(map, startNode, startIndex, endNode, endIndex);
 			}
 
-			void reset(TreeMap<K,V,Ctx>* map) {
+			void reset(TreeMap<K,V,Ctx,Pol>* map) {
 				reset(map, null, -1);
 			}
 
-			void reset(TreeMap<K,V,Ctx>* map, Node* endNode, inttype endIndex) {
+			void reset(TreeMap<K,V,Ctx,Pol>* map, Node* endNode, inttype endIndex) {
 				reset(map, null, -1, endNode, endIndex);
 			}
 
-			void reset(TreeMap<K,V,Ctx>* map, Node* startNode, inttype startIndex, Node* endNode, inttype endIndex) {
+			void reset(TreeMap<K,V,Ctx,Pol>* map, Node* startNode, inttype startIndex, Node* endNode, inttype endIndex) {
 				if (startNode == null) {
 					m_startNode = map->m_root;
-					if (m_startNode != null) {
-						m_startIndex = m_startNode->isLeaf() ? -1 : 0;
-					}
+					m_startIndex = ((m_startNode != null) && (m_startNode->isLeaf() == false)) ? 0 : -1;
 
 				} else {
 					m_startNode = startNode;
@@ -1359,8 +2255,8 @@ class TreeMap : /* public NavigableMap */ public SortedMap<K,V,Ctx> {
 			inline virtual boolean contains(const K key) const {
 				boolean status = false;
 
-				inttype firstCmp = TreeMap<K,V,Ctx>::COMPARATOR.compare(key, first());
-				inttype lastCmp = TreeMap<K,V,Ctx>::COMPARATOR.compare(key, last());
+				inttype firstCmp = TreeMap<K,V,Ctx,Pol>::COMPARATOR.compare(key, first());
+				inttype lastCmp = TreeMap<K,V,Ctx,Pol>::COMPARATOR.compare(key, last());
 				if ((firstCmp >= 0) && (lastCmp <= 0)) {
 					status = m_iterator.m_map->containsKey(key);
 				}
@@ -1427,7 +2323,7 @@ class TreeMap : /* public NavigableMap */ public SortedMap<K,V,Ctx> {
 
 			EntryMap();
 
-			EntryMap(TreeMap<K,V,Ctx>* map):
+			EntryMap(TreeMap<K,V,Ctx,Pol>* map):
 				m_keySet((boolean) false),
 				m_entrySet((boolean) false),
 				m_reuse(false) {
@@ -1435,7 +2331,7 @@ class TreeMap : /* public NavigableMap */ public SortedMap<K,V,Ctx> {
 				reset(map);
 			}
 
-			EntryMap(TreeMap<K,V,Ctx>* map, Node* endNode, inttype endIndex):
+			EntryMap(TreeMap<K,V,Ctx,Pol>* map, Node* endNode, inttype endIndex):
 				m_keySet((boolean) false),
 				m_entrySet((boolean) false),
 				m_reuse(false) {
@@ -1443,7 +2339,7 @@ class TreeMap : /* public NavigableMap */ public SortedMap<K,V,Ctx> {
 				reset(map, endNode, endIndex);
 			}
 
-			EntryMap(TreeMap<K,V,Ctx>* map, Node* startNode, inttype startIndex, Node* endNode, inttype endIndex):
+			EntryMap(TreeMap<K,V,Ctx,Pol>* map, Node* startNode, inttype startIndex, Node* endNode, inttype endIndex):
 				m_keySet((boolean) false),
 				m_entrySet((boolean) false),
 				m_reuse(false) {
@@ -1451,20 +2347,18 @@ class TreeMap : /* public NavigableMap */ public SortedMap<K,V,Ctx> {
 				reset(map, startNode, startIndex, endNode, endIndex);
 			}
 
-			void reset(TreeMap<K,V,Ctx>* map) {
+			void reset(TreeMap<K,V,Ctx,Pol>* map) {
 				reset(map, null, -1);
 			}
 
-			void reset(TreeMap<K,V,Ctx>* map, Node* endNode, inttype endIndex) {
+			void reset(TreeMap<K,V,Ctx,Pol>* map, Node* endNode, inttype endIndex) {
 				reset(map, null, -1, endNode, endIndex);
 			}
 
-			void reset(TreeMap<K,V,Ctx>* map, Node* startNode, inttype startIndex, Node* endNode, inttype endIndex) {
+			void reset(TreeMap<K,V,Ctx,Pol>* map, Node* startNode, inttype startIndex, Node* endNode, inttype endIndex) {
 				if (startNode == null) {
 					m_startNode = map->m_root;
-					if (m_startNode != null) {
-						m_startIndex = m_startNode->isLeaf() ? -1 : 0;
-					}
+					m_startIndex = ((m_startNode != null) && (m_startNode->isLeaf() == false)) ? 0 : -1;
 
 				} else {
 					m_startNode = startNode;
@@ -0,0 +1,327 @@
+/**
+ *    Copyright (C) 2010 Deep Software Foundation
+ *
+ *    This program is free software: you can redistribute it and/or  modify
+ *    it under the terms of the GNU Affero General Public License, version 3,
+ *    as published by the Free Software Foundation.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU Affero General Public License for more details.
+ *
+ *    You should have received a copy of the GNU Affero General Public License
+ *    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *    As a special exception, the copyright holders give permission to link the
+ *    code of portions of this program with the OpenSSL library under certain
+ *    conditions as described in each individual source file and distribute
+ *    linked combinations including the program with the OpenSSL library. You
+ *    must comply with the GNU Affero General Public License in all respects for
+ *    all of the code used other than as permitted herein. If you modify file(s)
+ *    with this exception, you may extend this exception to your version of the
+ *    file(s), but you are not obligated to do so. If you do not wish to do so,
+ *    delete this exception statement from your version. If you delete this
+ *    exception statement from all source files in the program, then also delete
+ *    it in the license file.
+ */
+#ifndef CXX_UTIL_TREE_POLICY_H_
+#define CXX_UTIL_TREE_POLICY_H_
+
+#include <new>
+
+#include "cxx/lang/types.h"
+
+#include "cxx/util/Comparator.h"
+#include "cxx/util/MapEntry.h"
+#include "cxx/util/SlabPool.h"
+
+namespace cxx { namespace util {
+
+/**
+ * Default TreeMap policy. Derive from this class and hide the constants that need to change,
+ * then pass the derived class as the fourth TreeMap (or third TreeSet) template argument.
+ */
+class TreePolicy {
+	public:
+		// XXX: false - nodes reference individually allocated MapEntry objects (entry pointers are stable)
+		//      true  - nodes store MapEntry by value (entry pointers are views, valid until the next modification)
+		static const boolean INLINE_ENTRIES = false;
+
+		// XXX: true - nodes (and entries) are carved from per-tree slabs and recycled on free lists,
+		//             clear() releases whole slabs without visiting nodes
+		static const boolean POOLED_NODES = false;
+
+		// XXX: true - branches copy each separator key next to its child pointer, so descent compares without
+		//             leaving the branch (referenced entries only): value keys whole, nbyte and CompositeKey keys as
+		//             an order-preserving prefix that reads the entry on ties only (see TreeSeparator)
+		static const boolean INLINE_SEPARATORS = true;
+
+		// XXX: true - leaf entry arrays can be written to a backing file under memory pressure and are read back on
+		//             first touch (inline entries in unpooled nodes, see TreeMap::setSpillFile)
+		static const boolean SPILL_LEAVES = false;
+
+		// XXX: in-node search and slot bookkeeping, the defaults follow the build flags so existing builds keep their layout
+		//      true - nodes are searched by bisection, false - by a forward scan
+		#ifdef CXX_UTIL_TREE_BSEARCH
+		static const boolean BINARY_SEARCH = true;
+		#else
+		static const boolean BINARY_SEARCH = false;
+		#endif
+
+		// XXX: true - primitive keys are compared several at a time (see NodeSearch), otherwise the above applies
+		#ifdef CXX_UTIL_TREE_SIMD
+		static const boolean VECTOR_SEARCH = true;
+		#else
+		static const boolean VECTOR_SEARCH = false;
+		#endif
+
+		// XXX: true - each child records its position within the parent, so finding it is a load instead of a scan
+		#ifdef CXX_UTIL_TREE_SLOTTED
+		static const boolean SLOTTED_NODES = true;
+		#else
+		static const boolean SLOTTED_NODES = false;
+		#endif
+};
+
+class InlineTreePolicy : public TreePolicy {
+	public:
+		static const boolean INLINE_ENTRIES = true;
+};
+
+class PooledTreePolicy : public TreePolicy {
+	public:
+		static const boolean POOLED_NODES = true;
+};
+
+class PooledInlineTreePolicy : public InlineTreePolicy {
+	public:
+		static const boolean POOLED_NODES = true;
+};
+
+class SpillTreePolicy : public InlineTreePolicy {
+	public:
+		static const boolean SPILL_LEAVES = true;
+};
+
+/**
+ * Storage of TreeMap entries within leaf and branch nodes (see TreePolicy::INLINE_ENTRIES).
+ */
+template<typename K, typename V, typename Ctx, boolean INLINE>
+class TreeEntries {
+	public:
+		typedef MapEntry<K,V,Ctx>* Slot;
+
+		FORCE_INLINE static Slot create(K key, V val, Ctx ctx, SlabPool* pool) {
+			if (pool != null) {
+				return new (pool->allocate()) MapEntry<K,V,Ctx>(key, val, ctx);
+			}
+
+			return new MapEntry<K,V,Ctx>(key, val, ctx);
+		}
+
+		FORCE_INLINE static Slot copy(const Slot& slot, Ctx ctx, SlabPool* pool) {
+			return create(slot->getKey(), slot->getValue(), ctx, pool);
+		}
+
+		FORCE_INLINE static MapEntry<K,V,Ctx>* entry(const Slot& slot) {
+			return slot;
+		}
+
+		FORCE_INLINE static void destroy(MapEntry<K,V,Ctx>* entry, Ctx ctx, SlabPool* pool) {
+			if (pool != null) {
+				entry->~MapEntry<K,V,Ctx>();
+				pool->release(entry);
+
+			} else {
+				Converter<MapEntry<K,V,Ctx>*>::destroy(entry, ctx);
+			}
+		}
+
+		FORCE_INLINE static void reset(Slot& slot) {
+			slot = null;
+		}
+};
+
+template<typename K, typename V, typename Ctx>
+class TreeEntries<K,V,Ctx,true> {
+	public:
+		typedef MapEntry<K,V,Ctx> Slot;
+
+		FORCE_INLINE static Slot create(K key, V val, Ctx ctx, SlabPool* pool) {
+			return MapEntry<K,V,Ctx>(key, val, ctx);
+		}
+
+		FORCE_INLINE static Slot copy(const Slot& slot, Ctx ctx, SlabPool* pool) {
+			return slot;
+		}
+
+		FORCE_INLINE static MapEntry<K,V,Ctx>* entry(const Slot& slot) {
+			return const_cast<MapEntry<K,V,Ctx>*>(&slot);
+		}
+
+		FORCE_INLINE static void destroy(MapEntry<K,V,Ctx>* entry, Ctx ctx, SlabPool* pool) {
+			// XXX: entry memory is owned by the node
+		}
+
+		FORCE_INLINE static void reset(Slot& slot) {
+			// XXX: nothing to do
+		}
+};
+
+template<typename K>
+struct TreeKeyByValue {
+	static const boolean VALUE = true;
+};
+
+template<typename K>
+struct TreeKeyByValue<K*> {
+	static const boolean VALUE = false;
+};
+
+/**
+ * Order-preserving 64-bit prefixes of pointer keys: leading() captures a key without its comparator, prefix() turns
+ * the capture into a value whose unsigned order never contradicts the comparator (see Comparator<nbyte*>::prefix and
+ * Comparator<CompositeKey*>::prefix). Keys whose comparator offers no such prefix (e.g. String*) have none.
+ */
+template<typename K>
+struct TreeKeyPrefix {
+	static const boolean VALUE = false;
+};
+
+template<>
+struct TreeKeyPrefix<nbyte*> {
+	static const boolean VALUE = true;
+
+	FORCE_INLINE static ulongtype leading(const nbyte* key) {
+		return Comparator<nbyte*>::prefix(key);
+	}
+
+	FORCE_INLINE static ulongtype prefix(const Comparator<nbyte*>* comparator, ulongtype leading) {
+		return leading;
+	}
+};
+
+template<>
+struct TreeKeyPrefix<CompositeKey*> {
+	static const boolean VALUE = true;
+
+	// XXX: raw leading bytes, the comparator's part layout normalizes them at compare time
+	FORCE_INLINE static ulongtype leading(const CompositeKey* key) {
+		ulongtype leading = 0;
+		memcpy(&leading, (bytearray) *key, (key->length < (inttype) sizeof(ulongtype)) ? key->length : sizeof(ulongtype));
+		return leading;
+	}
+
+	FORCE_INLINE static ulongtype prefix(const Comparator<CompositeKey*>* comparator, ulongtype leading) {
+		return comparator->prefix((bytearray) &leading);
+	}
+};
+
+/**
+ * Separator key of a TreeMap branch item (see TreePolicy::INLINE_SEPARATORS). Without a copy the key is read
+ * through the slot, which for referenced entries is a dereference into the entry's own heap block.
+ */
+template<typename K, typename Entries, boolean COPIED, boolean PREFIXED = TreeKeyPrefix<K>::VALUE>
+class TreeSeparator {
+	public:
+		// XXX: what a probe key needs computed once per node, nothing here
+		typedef boolean Probe;
+
+		FORCE_INLINE static Probe probe(const Comparator<K>* comparator, const K key) {
+			return false;
+		}
+
+		FORCE_INLINE void setKey(const typename Entries::Slot& slot) {
+			// XXX: nothing to do
+		}
+
+		FORCE_INLINE const K getKey(const typename Entries::Slot& slot) const {
+			return Entries::entry(slot)->getKey();
+		}
+
+		// XXX: inline entries lead with their key (see NodeSearch)
+		FORCE_INLINE const K* getKeyAddress(const typename Entries::Slot& slot) const {
+			return (const K*) &slot;
+		}
+
+		FORCE_INLINE inttype compare(const Comparator<K>* comparator, const typename Entries::Slot& slot, const K key, const Probe probe) const {
+			return comparator->compare(getKey(slot), key);
+		}
+};
+
+template<typename K, typename Entries>
+class TreeSeparator<K,Entries,true,false> {
+	private:
+		K m_key;
+
+	public:
+		typedef boolean Probe;
+
+		FORCE_INLINE static Probe probe(const Comparator<K>* comparator, const K key) {
+			return false;
+		}
+
+		FORCE_INLINE void setKey(const typename Entries::Slot& slot) {
+			// XXX: the leftmost item of a branch carries a child only
+			if (Entries::entry(slot) != null) {
+				m_key = Entries::entry(slot)->getKey();
+			}
+		}
+
+		FORCE_INLINE const K getKey(const typename Entries::Slot& slot) const {
+			return m_key;
+		}
+
+		FORCE_INLINE const K* getKeyAddress(const typename Entries::Slot& slot) const {
+			return &m_key;
+		}
+
+		FORCE_INLINE inttype compare(const Comparator<K>* comparator, const typename Entries::Slot& slot, const K key, const Probe probe) const {
+			return comparator->compare(m_key, key);
+		}
+};
+
+// XXX: pointer keys keep an order-preserving prefix inline, differing prefixes settle the comparison and only ties read the entry
+template<typename K, typename Entries>
+class TreeSeparator<K,Entries,true,true> {
+	private:
+		ulongtype m_leading;
+
+	public:
+		// XXX: the probe key's prefix, computed once per node instead of once per separator
+		typedef ulongtype Probe;
+
+		FORCE_INLINE static Probe probe(const Comparator<K>* comparator, const K key) {
+			return TreeKeyPrefix<K>::prefix(comparator, TreeKeyPrefix<K>::leading(key));
+		}
+
+		FORCE_INLINE void setKey(const typename Entries::Slot& slot) {
+			// XXX: the leftmost item of a branch carries a child only
+			if (Entries::entry(slot) != null) {
+				m_leading = TreeKeyPrefix<K>::leading(Entries::entry(slot)->getKey());
+			}
+		}
+
+		FORCE_INLINE const K getKey(const typename Entries::Slot& slot) const {
+			return Entries::entry(slot)->getKey();
+		}
+
+		// XXX: never ranked in place, NodeSearch does not vectorize pointer keys
+		FORCE_INLINE const K* getKeyAddress(const typename Entries::Slot& slot) const {
+			return (const K*) &slot;
+		}
+
+		FORCE_INLINE inttype compare(const Comparator<K>* comparator, const typename Entries::Slot& slot, const K key, const Probe probe) const {
+			const ulongtype prefix = TreeKeyPrefix<K>::prefix(comparator, m_leading);
+			if (prefix != probe) {
+				return (prefix < probe) ? -1 : 1;
+			}
+
+			return comparator->compare(getKey(slot), key);
+		}
+};
+
+} } // namespace
+
+#endif /*CXX_UTIL_TREE_POLICY_H_*/
@@ -33,35 +33,39 @@
 
 using namespace cxx::util;
 
-template<typename E, typename Cmp>
-const bytetype TreeSet<E,Cmp>::INITIAL_ORDER = 3;
+template<typename E, typename Cmp, typename Pol>
+const bytetype TreeSet<E,Cmp,Pol>::INITIAL_ORDER = 3;
 
-template<typename E, typename Cmp>
-const Cmp TreeSet<E,Cmp>::COMPARATOR;
+template<typename E, typename Cmp, typename Pol>
+const Cmp TreeSet<E,Cmp,Pol>::COMPARATOR;
 
-template<typename E, typename Cmp>
-TreeSet<E,Cmp>::TreeSet(bytetype order, boolean delelem):
-	m_comparator(&TreeSet<E,Cmp>::COMPARATOR),
+template<typename E, typename Cmp, typename Pol>
+TreeSet<E,Cmp,Pol>::TreeSet(bytetype order, boolean delelem):
+	m_comparator(&TreeSet<E,Cmp,Pol>::COMPARATOR),
 	m_deleteValue(delelem) {
 
 	initialize(order);
 }
 
-template<typename E, typename Cmp>
-TreeSet<E,Cmp>::TreeSet(const Cmp* comparator, bytetype order, boolean delelem):
+template<typename E, typename Cmp, typename Pol>
+TreeSet<E,Cmp,Pol>::TreeSet(const Cmp* comparator, bytetype order, boolean delelem):
 	m_comparator(comparator),
 	m_deleteValue(delelem) {
 
 	initialize(order);
 }
 
-template<typename E, typename Cmp>
-TreeSet<E,Cmp>::~TreeSet() {
+template<typename E, typename Cmp, typename Pol>
+TreeSet<E,Cmp,Pol>::~TreeSet() {
 	clear();
+
+	if (m_nodePool != null) {
+		delete m_nodePool;
+	}
 }
 
-template<typename E, typename Cmp>
-void TreeSet<E,Cmp>::initialize(bytetype order) {
+template<typename E, typename Cmp, typename Pol>
+void TreeSet<E,Cmp,Pol>::initialize(bytetype order) {
 	if (order < INITIAL_ORDER) {
 		order = INITIAL_ORDER;
 	}
@@ -73,32 +77,42 @@ void TreeSet<E,Cmp>::initialize(bytetype order) {
 
 	m_pEntries = 0;
 	m_root = null;
+
+	if (Pol::POOLED_NODES == true) {
+		uinttype leafSize = sizeof(Leaf) + ((m_leafMaxIndex + 1) * sizeof(E));
+		uinttype branchSize = sizeof(Branch) + ((m_branchMaxIndex + 1) * sizeof(Item));
+
+		m_nodePool = new SlabPool((leafSize > branchSize) ? leafSize : branchSize);
+
+	} else {
+		m_nodePool = null;
+	}
 }
 
-template<typename E, typename Cmp>
-void TreeSet<E,Cmp>::notifyRootFull(void) {
+template<typename E, typename Cmp, typename Pol>
+void TreeSet<E,Cmp,Pol>::notifyRootFull(void) {
 	Node* oldroot = m_root;
-	m_root = new Branch(this, null, oldroot);
+	m_root = createBranch(null, oldroot);
 	oldroot->split(this);
 }
 
-template<typename E, typename Cmp>
-void TreeSet<E,Cmp>::notifyRootEmpty(void) {
+template<typename E, typename Cmp, typename Pol>
+void TreeSet<E,Cmp,Pol>::notifyRootEmpty(void) {
 	if (m_root->isLeaf() == true) {
 		Leaf* root = (Leaf*) m_root;
 		m_root = null;
-		delete root;
+		destroyNode(root);
 
 	} else {
 		Branch* root = (Branch*) m_root;
 		m_root = root->getNode(0);
 		m_root->m_parent = null;
-		delete root;
+		destroyNode(root);
 	}
 }
 
-template<typename E, typename Cmp>
-const E TreeSet<E,Cmp>::first(boolean* status) const {
+template<typename E, typename Cmp, typename Pol>
+const E TreeSet<E,Cmp,Pol>::first(boolean* status) const {
 	E retelem = Set<E>::NULL_VALUE;
 	boolean found = false;
 
@@ -114,8 +128,8 @@ const E TreeSet<E,Cmp>::first(boolean* status) const {
 	return retelem;
 }
 
-template<typename E, typename Cmp>
-const E TreeSet<E,Cmp>::last(boolean* status) const {
+template<typename E, typename Cmp, typename Pol>
+const E TreeSet<E,Cmp,Pol>::last(boolean* status) const {
 	E retelem = Set<E>::NULL_VALUE;
 	boolean found = false;
 
@@ -132,8 +146,8 @@ const E TreeSet<E,Cmp>::last(boolean* status) const {
 	return retelem;
 }
 
-template<typename E, typename Cmp>
-const E TreeSet<E,Cmp>::lower(const E e, boolean* status) const {
+template<typename E, typename Cmp, typename Pol>
+const E TreeSet<E,Cmp,Pol>::lower(const E e, boolean* status) const {
 	E retelem = Set<E>::NULL_VALUE;
 	boolean found = false;
 
@@ -153,8 +167,8 @@ const E TreeSet<E,Cmp>::lower(const E e, boolean* status) const {
 	return retelem;
 }
 
-template<typename E, typename Cmp>
-const E TreeSet<E,Cmp>::higher(const E e, boolean* status) const {
+template<typename E, typename Cmp, typename Pol>
+const E TreeSet<E,Cmp,Pol>::higher(const E e, boolean* status) const {
 	E retelem = Set<E>::NULL_VALUE;
 	boolean found = false;
 
@@ -174,8 +188,8 @@ const E TreeSet<E,Cmp>::higher(const E e, boolean* status) const {
 	return retelem;
 }
 
-template<typename E, typename Cmp>
-const E TreeSet<E,Cmp>::floor(const E e, boolean* status) const {
+template<typename E, typename Cmp, typename Pol>
+const E TreeSet<E,Cmp,Pol>::floor(const E e, boolean* status) const {
 	E retelem = Set<E>::NULL_VALUE;
 	boolean found = false;
 
@@ -202,8 +216,8 @@ const E TreeSet<E,Cmp>::floor(const E e, boolean* status) const {
 	return retelem;
 }
 
-template<typename E, typename Cmp>
-const E TreeSet<E,Cmp>::ceiling(const E e, boolean* status) const {
+template<typename E, typename Cmp, typename Pol>
+const E TreeSet<E,Cmp,Pol>::ceiling(const E e, boolean* status) const {
 	E retelem = Set<E>::NULL_VALUE;
 	boolean found = false;
 
@@ -230,8 +244,8 @@ const E TreeSet<E,Cmp>::ceiling(const E e, boolean* status) const {
 	return retelem;
 }
 
-template<typename E, typename Cmp>
-const E TreeSet<E,Cmp>::nextElement(Node* node, int index, Node** block, int* location) {
+template<typename E, typename Cmp, typename Pol>
+const E TreeSet<E,Cmp,Pol>::nextElement(Node* node, int index, Node** block, int* location) {
 	E elem = node->nextElement(index, block, location);
 	if (*block == null) {
 		boolean status = false;
@@ -250,8 +264,8 @@ const E TreeSet<E,Cmp>::nextElement(Node* node, int index, Node** block, int* lo
 	return elem;
 }
 
-template<typename E, typename Cmp>
-const boolean TreeSet<E,Cmp>::hasNextElement(Node* node, int index) {
+template<typename E, typename Cmp, typename Pol>
+const boolean TreeSet<E,Cmp,Pol>::hasNextElement(Node* node, int index) {
 	boolean hasNext = false;
 
 	if (node != null) {
@@ -278,8 +292,95 @@ const boolean TreeSet<E,Cmp>::hasNextElement(Node* node, int index) {
 	return hasNext;
 }
 
-template<typename E, typename Cmp>
-boolean TreeSet<E,Cmp>::add(E elem, E* retelem) {
+template<typename E, typename Cmp, typename Pol>
+const E TreeSet<E,Cmp,Pol>::ceilingPosition(const E elem, Node** block, int* location) {
+	boolean status = false;
+	E x = m_root->find(this, elem, block, location, &status);
+	if (status == false) {
+		// XXX: a miss ends in a leaf at the insertion index
+		Leaf* leaf = (Leaf*) *block;
+		if (*location <= leaf->m_lastIndex) {
+			x = leaf->getObject(*location);
+
+		} else {
+			x = nextElement(leaf, leaf->m_lastIndex, block, location);
+		}
+	}
+
+	return x;
+}
+
+template<typename E, typename Cmp, typename Pol>
+template<typename F>
+int TreeSet<E,Cmp,Pol>::forEachInRange(const E fromElement, boolean fromOpen, const E toElement, boolean toOpen, F&& visitor) {
+	if (m_root == null) {
+		return 0;
+	}
+
+	Node* node;
+	int index;
+	if (fromOpen == false) {
+		ceilingPosition(fromElement, &node, &index);
+
+	} else {
+		node = m_root->firstLeaf();
+		index = 0;
+	}
+
+	boolean bounded = (toOpen == false);
+	int count = 0;
+
+	while (node != null) {
+		if (node->isLeaf() == true) {
+			Leaf* leaf = (Leaf*) node;
+			int last = leaf->m_lastIndex;
+
+			// XXX: only the leaf holding toElement needs per element checks, every element after it is out of range
+			if ((bounded == true) && (m_comparator->compare(leaf->getObject(last), toElement) >= 0)) {
+				for (; index <= last; index++) {
+					E elem = leaf->getObject(index);
+					if (m_comparator->compare(elem, toElement) >= 0) {
+						break;
+					}
+
+					count++;
+					if (visitor(elem) == false) {
+						break;
+					}
+				}
+
+				return count;
+			}
+
+			for (; index <= last; index++) {
+				count++;
+				if (visitor(leaf->getObject(index)) == false) {
+					return count;
+				}
+			}
+
+			nextElement(leaf, last, &node, &index);
+
+		} else {
+			E elem = ((Branch*) node)->getObject(index);
+			if ((bounded == true) && (m_comparator->compare(elem, toElement) >= 0)) {
+				break;
+			}
+
+			count++;
+			if (visitor(elem) == false) {
+				break;
+			}
+
+			nextElement(node, index, &node, &index);
+		}
+	}
+
+	return count;
+}
+
+template<typename E, typename Cmp, typename Pol>
+boolean TreeSet<E,Cmp,Pol>::add(E elem, E* retelem) {
 	boolean found = false;
 
 	if (m_root != null) {
@@ -298,7 +399,7 @@ boolean TreeSet<E,Cmp>::add(E elem, E* retelem) {
 			}
 
 			if (m_root == null) {
-				m_root = new Leaf(this, null, elem);
+				m_root = createLeaf(null, elem);
 				incrementEntries();
 
 				return found;
@@ -313,21 +414,28 @@ boolean TreeSet<E,Cmp>::add(E elem, E* retelem) {
 		node->insert(this, elem, index);
 
 	} else {
-		m_root = new Leaf(this, null, elem);
+		m_root = createLeaf(null, elem);
 		incrementEntries();
 	}
 
 	return (found == false);
 }
 
-template<typename E, typename Cmp>
-boolean TreeSet<E,Cmp>::addAll(const Collection<E>* c, Collection<E>* fillc) {
+template<typename E, typename Cmp, typename Pol>
+boolean TreeSet<E,Cmp,Pol>::addAll(const Collection<E>* c, Collection<E>* fillc) {
 	if (c == null) {
 		return false;
 	}
 
 	boolean ret = false;
 	Iterator<E>* iter = const_cast<Collection<E>*>(c)->iterator();
+
+	// XXX: nothing can be replaced in an empty tree, build it bottom-up instead
+	if (m_root == null) {
+		bulkLoad(iter);
+		ret = (m_root != null);
+	}
+
 	while (iter->hasNext() == true) {
 		E v = iter->next();
 		if (contains(v) == false) {
@@ -339,8 +447,181 @@ boolean TreeSet<E,Cmp>::addAll(const Collection<E>* c, Collection<E>* fillc) {
 	return ret;
 }
 
-template<typename E, typename Cmp>
-boolean TreeSet<E,Cmp>::remove(const E e, E* retelem) {
+template<typename E, typename Cmp, typename Pol>
+void TreeSet<E,Cmp,Pol>::bulkLoad(const E* elems, int count, double fillFactor) {
+	int i = 0;
+
+	if (m_root == null) {
+		BulkState state;
+		bulkBegin(state, fillFactor);
+
+		for (; i < count; i++) {
+			if (bulkAppend(state, elems[i]) == false) {
+				break;
+			}
+		}
+
+		bulkEnd(state);
+	}
+
+	for (; i < count; i++) {
+		if (contains(elems[i]) == false) {
+			add(elems[i]);
+		}
+	}
+}
+
+template<typename E, typename Cmp, typename Pol>
+void TreeSet<E,Cmp,Pol>::bulkLoad(Iterator<E>* iter, double fillFactor) {
+	if (m_root == null) {
+		BulkState state;
+		bulkBegin(state, fillFactor);
+
+		while (iter->hasNext() == true) {
+			E elem = iter->next();
+			if (bulkAppend(state, elem) == false) {
+				bulkEnd(state);
+
+				if (contains(elem) == false) {
+					add(elem);
+				}
+				break;
+			}
+		}
+
+		bulkEnd(state);
+	}
+
+	while (iter->hasNext() == true) {
+		E elem = iter->next();
+		if (contains(elem) == false) {
+			add(elem);
+		}
+	}
+}
+
+template<typename E, typename Cmp, typename Pol>
+void TreeSet<E,Cmp,Pol>::bulkBegin(BulkState& state, double fillFactor) {
+	if ((fillFactor <= 0.0) || (fillFactor > 1.0)) {
+		fillFactor = 1.0;
+	}
+
+	// XXX: a node holding max index entries is one insert away from full, never pack beyond that
+	state.m_leafTarget = (int) (m_leafMaxIndex * fillFactor);
+	if (state.m_leafTarget <= m_leafLowWater) {
+		state.m_leafTarget = m_leafLowWater + 1;
+	}
+
+	state.m_branchTarget = (int) (m_branchMaxIndex * fillFactor);
+	if (state.m_branchTarget <= m_branchLowWater) {
+		state.m_branchTarget = m_branchLowWater + 1;
+	}
+	if (state.m_branchTarget < 2) {
+		state.m_branchTarget = 2;
+	}
+
+	memset(state.m_spine, 0, sizeof(state.m_spine));
+	state.m_count = 0;
+	state.m_pending = false;
+}
+
+template<typename E, typename Cmp, typename Pol>
+boolean TreeSet<E,Cmp,Pol>::bulkAppend(BulkState& state, E elem) {
+	if ((state.m_count != 0) && (m_comparator->compare(state.m_lastElem, elem) >= 0)) {
+		return false;
+	}
+
+	// XXX: the element following a packed leaf becomes its separator, held back until a new leaf can take its successor
+	if (state.m_pending == true) {
+		Leaf* leaf = createLeaf(null, elem);
+		bulkAttach(state, 1, state.m_pendingElem, leaf);
+		state.m_spine[0] = leaf;
+
+		state.m_pending = false;
+
+	} else if (state.m_spine[0] == null) {
+		state.m_spine[0] = createLeaf(null, elem);
+
+	} else if (((Leaf*) state.m_spine[0])->getPhysicalEntries() < state.m_leafTarget) {
+		((Leaf*) state.m_spine[0])->append(elem);
+
+	} else {
+		state.m_pendingElem = elem;
+		state.m_pending = true;
+	}
+
+	state.m_lastElem = elem;
+	state.m_count++;
+
+	return true;
+}
+
+template<typename E, typename Cmp, typename Pol>
+void TreeSet<E,Cmp,Pol>::bulkAttach(BulkState& state, int level, E obj, Node* node) {
+	Branch* branch = (Branch*) state.m_spine[level];
+	if (branch == null) {
+		branch = createBranch(null, state.m_spine[level - 1]);
+		state.m_spine[level] = branch;
+	}
+
+	if (branch->getVirtualEntries() < state.m_branchTarget) {
+		branch->append(node, obj);
+
+	} else {
+		Branch* next = createBranch(null, node);
+		bulkAttach(state, level + 1, obj, next);
+		state.m_spine[level] = next;
+	}
+}
+
+template<typename E, typename Cmp, typename Pol>
+void TreeSet<E,Cmp,Pol>::bulkEnd(BulkState& state) {
+	if (state.m_spine[0] == null) {
+		return;
+	}
+
+	int level = 0;
+	while ((level < 63) && (state.m_spine[level + 1] != null)) {
+		level++;
+	}
+
+	m_root = state.m_spine[level];
+	state.m_spine[0] = null;
+
+	m_pEntries += state.m_count - ((state.m_pending == true) ? 1 : 0);
+
+	// XXX: only the right edge can be under-filled, rebalance it top down until it settles
+	boolean settled = false;
+	while (settled == false) {
+		settled = true;
+
+		Node* node = m_root;
+		while (node->isLeaf() == false) {
+			Branch* branch = (Branch*) node;
+			Node* child = branch->getNode(branch->Node::m_lastIndex);
+
+			boolean low = (child->isLeaf() == true) ? ((Leaf*) child)->isLow(this) : ((Branch*) child)->isLow(this);
+			if ((low == true) && (branch->Node::m_lastIndex > 0)) {
+				branch->isLow(this, child);
+				settled = false;
+				break;
+			}
+
+			node = child;
+		}
+	}
+
+	// XXX: the trailing separator had no leaf to follow it, insert it through the regular path
+	if (state.m_pending == true) {
+		Leaf* leaf = m_root->lastLeaf();
+		leaf->insert(this, state.m_pendingElem, leaf->Node::m_lastIndex + 1);
+
+		state.m_pending = false;
+	}
+}
+
+template<typename E, typename Cmp, typename Pol>
+boolean TreeSet<E,Cmp,Pol>::remove(const E e, E* retelem) {
 	boolean found = false;
 
 	if (m_root != null) {
@@ -366,8 +647,8 @@ boolean TreeSet<E,Cmp>::remove(const E e, E* retelem) {
 	return found;
 }
 
-template<typename E, typename Cmp>
-boolean TreeSet<E,Cmp>::contains(const E e, E* retelem) const {
+template<typename E, typename Cmp, typename Pol>
+boolean TreeSet<E,Cmp,Pol>::contains(const E e, E* retelem) const {
 	boolean found = false;
 
 	if (m_root != null) {
@@ -382,8 +663,8 @@ boolean TreeSet<E,Cmp>::contains(const E e, E* retelem) const {
 	return found;
 }
 
-template<typename E, typename Cmp>
-SortedSet<E>* TreeSet<E,Cmp>::headSet(const E toElement, SortedSet<E>* fillset) {
+template<typename E, typename Cmp, typename Pol>
+SortedSet<E>* TreeSet<E,Cmp,Pol>::headSet(const E toElement, SortedSet<E>* fillset) {
 	int endIndex = -1;
 	Node* endNode = null;
 	if (m_root != null) {
@@ -402,8 +683,8 @@ SortedSet<E>* TreeSet<E,Cmp>::headSet(const E toElement, SortedSet<E>* fillset)
 	return fillset;
 }
 
-template<typename E, typename Cmp>
-SortedSet<E>* TreeSet<E,Cmp>::subSet(const E fromElement, const E toElement, SortedSet<E>* fillset) {
+template<typename E, typename Cmp, typename Pol>
+SortedSet<E>* TreeSet<E,Cmp,Pol>::subSet(const E fromElement, const E toElement, SortedSet<E>* fillset) {
 	int startIndex = -1;
 	int endIndex = -1;
 	Node* startNode = null;
@@ -426,8 +707,8 @@ SortedSet<E>* TreeSet<E,Cmp>::subSet(const E fromElement, const E toElement, Sor
 	return fillset;
 }
 
-template<typename E, typename Cmp>
-SortedSet<E>* TreeSet<E,Cmp>::tailSet(const E fromElement, SortedSet<E>* fillset) {
+template<typename E, typename Cmp, typename Pol>
+SortedSet<E>* TreeSet<E,Cmp,Pol>::tailSet(const E fromElement, SortedSet<E>* fillset) {
 	int startIndex = -1;
 	Node* startNode = null;
 	if (m_root != null) {
@@ -447,8 +728,8 @@ SortedSet<E>* TreeSet<E,Cmp>::tailSet(const E fromElement, SortedSet<E>* fillset
 	return fillset;
 }
 
-template<typename E, typename Cmp>
-void TreeSet<E,Cmp>::clear(boolean delelem) {
+template<typename E, typename Cmp, typename Pol>
+void TreeSet<E,Cmp,Pol>::clear(boolean delelem) {
 
 	if (m_root != null) {
 		if (delelem == true) {
@@ -459,53 +740,87 @@ void TreeSet<E,Cmp>::clear(boolean delelem) {
 		}
 
 		m_pEntries = 0;
-		delete m_root;
+
+		if (Pol::POOLED_NODES == true) {
+			// XXX: release whole slabs without visiting the nodes
+			m_nodePool->clear();
+
+		} else {
+			delete m_root;
+		}
 	}
 
 	m_root = null;
 }
 
-template<typename E, typename Cmp>
-Iterator<E>* TreeSet<E,Cmp>::iterator(void) {
+template<typename E, typename Cmp, typename Pol>
+Iterator<E>* TreeSet<E,Cmp,Pol>::iterator(void) {
 	return new KeySetIterator(this);
 }
 
-template<typename E, typename Cmp>
-TreeSet<E,Cmp>::Node::Node(Branch* parent, boolean isleaf):
+template<typename E, typename Cmp, typename Pol>
+FrozenTreeSet<E,Cmp>* TreeSet<E,Cmp,Pol>::freeze(void) {
+	KeySetIterator iter(this);
+	FrozenTreeSet<E,Cmp>* frozen = new FrozenTreeSet<E,Cmp>(m_comparator, &iter, size(), m_deleteValue);
+
+	// XXX: the elements belong to the frozen set now
+	clear(false);
+
+	return frozen;
+}
+
+template<typename E, typename Cmp, typename Pol>
+TreeSet<E,Cmp,Pol>::Node::Node(Branch* parent, boolean isleaf):
 	m_parent(parent),
 	m_lastIndex(-1),
-	#ifdef CXX_UTIL_TREE_SLOTTED
 	m_slotIndex(-1),
-	#endif
 	m_isLeaf(isleaf) {
 }
 
-template<typename E, typename Cmp>
-TreeSet<E,Cmp>::Branch::Branch(TreeSet<E,Cmp>* self, Branch* parent) :
+template<typename E, typename Cmp, typename Pol>
+TreeSet<E,Cmp,Pol>::Branch::Branch(TreeSet<E,Cmp,Pol>* self, Branch* parent) :
 	Node(parent, false) {
 
-	#ifdef DEEP_DEBUG
-	m_items = (Item*) calloc(1, sizeof(Item) * (getMaxIndex(self) + 1));
-	#else
-	m_items = (Item*) malloc(sizeof(Item) * (getMaxIndex(self) + 1));
-	#endif
+	if (Pol::POOLED_NODES == true) {
+		// XXX: pooled blocks carry the item array right behind the node (see createBranch)
+		m_items = (Item*) (this + 1);
+		#ifdef DEEP_DEBUG
+		memset(m_items, 0, sizeof(Item) * (getMaxIndex(self) + 1));
+		#endif
+
+	} else {
+		#ifdef DEEP_DEBUG
+		m_items = (Item*) calloc(1, sizeof(Item) * (getMaxIndex(self) + 1));
+		#else
+		m_items = (Item*) malloc(sizeof(Item) * (getMaxIndex(self) + 1));
+		#endif
+	}
 }
 
-template<typename E, typename Cmp>
-TreeSet<E,Cmp>::Branch::Branch(TreeSet<E,Cmp>* self, Branch* parent, Node* oldroot) :
+template<typename E, typename Cmp, typename Pol>
+TreeSet<E,Cmp,Pol>::Branch::Branch(TreeSet<E,Cmp,Pol>* self, Branch* parent, Node* oldroot) :
 	Node(parent, false) {
 
-	#ifdef DEEP_DEBUG
-	m_items = (Item*) calloc(1, sizeof(Item) * (getMaxIndex(self) + 1));
-	#else
-	m_items = (Item*) malloc(sizeof(Item) * (getMaxIndex(self) + 1));
-	#endif
+	if (Pol::POOLED_NODES == true) {
+		// XXX: pooled blocks carry the item array right behind the node (see createBranch)
+		m_items = (Item*) (this + 1);
+		#ifdef DEEP_DEBUG
+		memset(m_items, 0, sizeof(Item) * (getMaxIndex(self) + 1));
+		#endif
+
+	} else {
+		#ifdef DEEP_DEBUG
+		m_items = (Item*) calloc(1, sizeof(Item) * (getMaxIndex(self) + 1));
+		#else
+		m_items = (Item*) malloc(sizeof(Item) * (getMaxIndex(self) + 1));
+		#endif
+	}
 
 	append(oldroot, Set<E>::NULL_VALUE);
 }
 
-template<typename E, typename Cmp>
-TreeSet<E,Cmp>::Branch::~Branch(void) {
+template<typename E, typename Cmp, typename Pol>
+TreeSet<E,Cmp,Pol>::Branch::~Branch(void) {
 	if (Node::m_lastIndex > 0) {
 		delete m_items[0].m_node;
 	}
@@ -514,33 +829,36 @@ TreeSet<E,Cmp>::Branch::~Branch(void) {
 		delete m_items[i].m_node;
 	}
 
-	free(m_items);
+	if (Pol::POOLED_NODES == false) {
+		free(m_items);
+	}
 	#ifdef DEEP_DEBUG
 	m_items = null;
 	#endif
 }
 
-template<typename E, typename Cmp>
-void TreeSet<E,Cmp>::Branch::insert(TreeSet<E,Cmp>* self, const E obj, int index) {
+template<typename E, typename Cmp, typename Pol>
+void TreeSet<E,Cmp,Pol>::Branch::insert(TreeSet<E,Cmp,Pol>* self, const E obj, int index) {
 	Leaf* leaf = getNode(index - 1)->lastLeaf();
 	leaf->insert(self, obj, leaf->m_lastIndex + 1);
 }
 
-template<typename E, typename Cmp>
-void TreeSet<E,Cmp>::Branch::insert(TreeSet<E,Cmp>* self, Node* node, E obj, int index) {
+template<typename E, typename Cmp, typename Pol>
+void TreeSet<E,Cmp,Pol>::Branch::insert(TreeSet<E,Cmp,Pol>* self, Node* node, E obj, int index) {
 	Item newitem(node, obj);
 
 	insert(self, newitem, index);
 }
 
-template<typename E, typename Cmp>
-void TreeSet<E,Cmp>::Branch::insertElement(Item& item, int index) {
+template<typename E, typename Cmp, typename Pol>
+void TreeSet<E,Cmp,Pol>::Branch::insertElement(Item& item, int index) {
 	for (int i = Node::m_lastIndex + 1; i > index; i--) {
-		#ifdef CXX_UTIL_TREE_SLOTTED
-		getItem(i).assign(i, getItem(i - 1));
-		#else
-		getItem(i) = getItem(i - 1);
-		#endif
+		if (Pol::SLOTTED_NODES == true) {
+			getItem(i).assign(i, getItem(i - 1));
+
+		} else {
+			getItem(i) = getItem(i - 1);
+		}
 	}
 
 	setItem(index, item);
@@ -548,15 +866,15 @@ void TreeSet<E,Cmp>::Branch::insertElement(Item& item, int index) {
 	Node::m_lastIndex++;
 }
 
-template<typename E, typename Cmp>
-void TreeSet<E,Cmp>::Branch::insertElement(Node* node, E obj, int index) {
+template<typename E, typename Cmp, typename Pol>
+void TreeSet<E,Cmp,Pol>::Branch::insertElement(Node* node, E obj, int index) {
 	Item newitem(node, obj);
 
 	insertElement(newitem, index);
 }
 
-template<typename E, typename Cmp>
-void TreeSet<E,Cmp>::Branch::insert(TreeSet<E,Cmp>* self, Item& item, int index) {
+template<typename E, typename Cmp, typename Pol>
+void TreeSet<E,Cmp,Pol>::Branch::insert(TreeSet<E,Cmp,Pol>* self, Item& item, int index) {
 	insertElement(item, index);
 
 	if (isFull(self) == true) {
@@ -564,8 +882,8 @@ void TreeSet<E,Cmp>::Branch::insert(TreeSet<E,Cmp>* self, Item& item, int index)
 	}
 }
 
-template<typename E, typename Cmp>
-void TreeSet<E,Cmp>::Branch::appendFrom(TreeSet<E,Cmp>* self, Branch* source, int begin, int end) {
+template<typename E, typename Cmp, typename Pol>
+void TreeSet<E,Cmp,Pol>::Branch::appendFrom(TreeSet<E,Cmp,Pol>* self, Branch* source, int begin, int end) {
 	if (begin > end) {
 		return;
 	}
@@ -575,32 +893,32 @@ void TreeSet<E,Cmp>::Branch::appendFrom(TreeSet<E,Cmp>* self, Branch* source, in
 	}
 }
 
-template<typename E, typename Cmp>
-void TreeSet<E,Cmp>::Branch::append(Node* node, E obj) {
+template<typename E, typename Cmp, typename Pol>
+void TreeSet<E,Cmp,Pol>::Branch::append(Node* node, E obj) {
 	setItem(++Node::m_lastIndex, obj, node);
 }
 
-template<typename E, typename Cmp>
-void TreeSet<E,Cmp>::Branch::append(Item& item) {
+template<typename E, typename Cmp, typename Pol>
+void TreeSet<E,Cmp,Pol>::Branch::append(Item& item) {
 	setItem(++Node::m_lastIndex, item);
 }
 
-template<typename E, typename Cmp>
-void TreeSet<E,Cmp>::Branch::balanceWithLeft(TreeSet<E,Cmp>* self, Branch* lNode, int pIndex) {
+template<typename E, typename Cmp, typename Pol>
+void TreeSet<E,Cmp,Pol>::Branch::balanceWithLeft(TreeSet<E,Cmp,Pol>* self, Branch* lNode, int pIndex) {
 	int newSize = (getVirtualEntries() + lNode->getPhysicalEntries()) / 2;
 	int indexFromHere = getPhysicalEntries() - newSize;
 	pushLeft(self, indexFromHere, lNode, pIndex);
 }
 
-template<typename E, typename Cmp>
-void TreeSet<E,Cmp>::Branch::balanceWithRight(TreeSet<E,Cmp>* self, Branch* rNode, int pIndex) {
+template<typename E, typename Cmp, typename Pol>
+void TreeSet<E,Cmp,Pol>::Branch::balanceWithRight(TreeSet<E,Cmp,Pol>* self, Branch* rNode, int pIndex) {
 	int newSize = (getPhysicalEntries() + rNode->getVirtualEntries()) / 2;
 	int indexFromHere = getPhysicalEntries() - newSize;
 	pushRight(self, indexFromHere, rNode, pIndex);
 }
 
-template<typename E, typename Cmp>
-void TreeSet<E,Cmp>::Branch::balanceWith(TreeSet<E,Cmp>* self, Branch* rNode, int pindx) {
+template<typename E, typename Cmp, typename Pol>
+void TreeSet<E,Cmp,Pol>::Branch::balanceWith(TreeSet<E,Cmp,Pol>* self, Branch* rNode, int pindx) {
 	if (getPhysicalEntries() < rNode->getVirtualEntries()) {
 		rNode->balanceWithLeft(self, this, pindx);
 
@@ -609,61 +927,78 @@ void TreeSet<E,Cmp>::Branch::balanceWith(TreeSet<E,Cmp>* self, Branch* rNode, in
 	}
 }
 
-template<typename E, typename Cmp>
-const E TreeSet<E,Cmp>::Branch::find(const TreeSet<E,Cmp>* self, const E what, Node** block, int* location, boolean* status) {
+template<typename E, typename Cmp, typename Pol>
+const E TreeSet<E,Cmp,Pol>::Branch::find(const TreeSet<E,Cmp,Pol>* self, const E what, Node** block, int* location, boolean* status) {
 
-	#ifdef CXX_UTIL_TREE_BSEARCH
-	register int last = -1;
-	register int start = 1;
-	register int finish = Node::m_lastIndex;
-	while (start <= finish) {
-		int mid = (start + finish) >> 1;
-		int weight = self->m_comparator->compare(getObject(mid), what);
-		if (weight == 0) {
-			*block = this;
-			*location = mid;
-			*status = true;
-			return getObject(mid);
+	if ((Pol::VECTOR_SEARCH == true) && (NodeSearch<E,Cmp>::VECTORIZED == true)) {
+		int i = NodeSearch<E,Cmp>::rank(&m_items[1].m_object, sizeof(Item), Node::m_lastIndex, what) + 1;
+		if (i <= Node::m_lastIndex) {
+			if (self->m_comparator->compare(getObject(i), what) == 0) {
+				*block = this;
+				*location = i;
+				*status = true;
+				return getObject(i);
+			}
+
+			return getNode(i - 1)->find(self, what, block, location, status);
 		}
 
-		if (weight < 0) {
-			start = mid + 1;
+		return getNode(Node::m_lastIndex)->find(self, what, block, location, status);
+	}
 
-		} else {
-			last = finish;
-			finish = mid - 1;
+	if (Pol::BINARY_SEARCH == true) {
+		register int last = -1;
+		register int start = 1;
+		register int finish = Node::m_lastIndex;
+		while (start <= finish) {
+			int mid = (start + finish) >> 1;
+			int weight = self->m_comparator->compare(getObject(mid), what);
+			if (weight == 0) {
+				*block = this;
+				*location = mid;
+				*status = true;
+				return getObject(mid);
+			}
+
+			if (weight < 0) {
+				start = mid + 1;
+
+			} else {
+				last = finish;
+				finish = mid - 1;
+			}
 		}
-	}
 
-	if (last != -1) {
-		for (int i = start; i <= last; i++) {
+		if (last != -1) {
+			for (int i = start; i <= last; i++) {
+				int weight = self->m_comparator->compare(getObject(i), what);
+				if (weight > 0) {
+					return getNode(i - 1)->find(self, what, block, location, status);
+				}
+			}
+		}
+
+	} else {
+		for (int i = 1 ; i <= Node::m_lastIndex; i++) {
 			int weight = self->m_comparator->compare(getObject(i), what);
+			if (weight == 0) {
+				*block = this;
+				*location = i;
+				*status = true;
+				return getObject(i);
+			}
+
 			if (weight > 0) {
 				return getNode(i - 1)->find(self, what, block, location, status);
 			}
 		}
 	}
-	#else
-	for (int i = 1 ; i <= Node::m_lastIndex; i++) {
-		int weight = self->m_comparator->compare(getObject(i), what);
-		if (weight == 0) {
-			*block = this;
-			*location = i;
-			*status = true;
-			return getObject(i);
-		}
-
-		if (weight > 0) {
-			return getNode(i - 1)->find(self, what, block, location, status);
-		}
-	}
-	#endif
 
 	return getNode(Node::m_lastIndex)->find(self, what, block, location, status);
 }
 
-template<typename E, typename Cmp>
-const E TreeSet<E,Cmp>::Branch::lower(const TreeSet<E,Cmp>* self, const E what, Node** block, int* location, E* next, boolean* status, boolean* nextStatus) {
+template<typename E, typename Cmp, typename Pol>
+const E TreeSet<E,Cmp,Pol>::Branch::lower(const TreeSet<E,Cmp,Pol>* self, const E what, Node** block, int* location, E* next, boolean* status, boolean* nextStatus) {
 	for (int i = Node::m_lastIndex; i > 0; i--) {
 		int weight = self->m_comparator->compare(getObject(i), what);
 		if (weight < 0) {
@@ -694,8 +1029,8 @@ const E TreeSet<E,Cmp>::Branch::lower(const TreeSet<E,Cmp>* self, const E what,
 	return object;
 }
 
-template<typename E, typename Cmp>
-const E TreeSet<E,Cmp>::Branch::higher(const TreeSet<E,Cmp>* self, const E what, Node** block, int* location, E* prev, boolean* status, boolean* prevStatus) {
+template<typename E, typename Cmp, typename Pol>
+const E TreeSet<E,Cmp,Pol>::Branch::higher(const TreeSet<E,Cmp,Pol>* self, const E what, Node** block, int* location, E* prev, boolean* status, boolean* prevStatus) {
 	for (int i = 1 ; i <= Node::m_lastIndex; i++) {
 		int weight = self->m_comparator->compare(getObject(i), what);
 		if (weight > 0) {
@@ -726,8 +1061,8 @@ const E TreeSet<E,Cmp>::Branch::higher(const TreeSet<E,Cmp>* self, const E what,
 	return object;
 }
 
-template<typename E, typename Cmp>
-const E TreeSet<E,Cmp>::Branch::getElement(int index, boolean* status) {
+template<typename E, typename Cmp, typename Pol>
+const E TreeSet<E,Cmp,Pol>::Branch::getElement(int index, boolean* status) {
 	if ((index > 0) && (index <= Node::m_lastIndex)) {
 		*status = true;
 		return getObject(index);
@@ -736,8 +1071,8 @@ const E TreeSet<E,Cmp>::Branch::getElement(int index, boolean* status) {
 	return Set<E>::NULL_VALUE;
 }
 
-template<typename E, typename Cmp>
-const E TreeSet<E,Cmp>::Branch::nextElement(int index, Node** block, int* location) {
+template<typename E, typename Cmp, typename Pol>
+const E TreeSet<E,Cmp,Pol>::Branch::nextElement(int index, Node** block, int* location) {
 	if (index <= Node::m_lastIndex) {
 		*block = getNode(index)->firstLeaf();
 		*location = 0;
@@ -749,23 +1084,24 @@ const E TreeSet<E,Cmp>::Branch::nextElement(int index, Node** block, int* locati
 	return Set<E>::NULL_VALUE;
 }
 
-template<typename E, typename Cmp>
-int TreeSet<E,Cmp>::Branch::instanceIndex(const Node* node) const {
-	#ifdef CXX_UTIL_TREE_SLOTTED
-	return node->m_slotIndex;
-	#else
-	for (inttype i = 0; i <= Node::m_lastIndex; i++) {
-		if (getNode(i) == node) {
-			return i;
+template<typename E, typename Cmp, typename Pol>
+int TreeSet<E,Cmp,Pol>::Branch::instanceIndex(const Node* node) const {
+	if (Pol::SLOTTED_NODES == true) {
+		return node->m_slotIndex;
+
+	} else {
+		for (inttype i = 0; i <= Node::m_lastIndex; i++) {
+			if (getNode(i) == node) {
+				return i;
+			}
 		}
-	}
 
-	return 0;
-	#endif
+		return 0;
+	}
 }
 
-template<typename E, typename Cmp>
-void TreeSet<E,Cmp>::Branch::notifyParent(TreeSet<E,Cmp>* self) {
+template<typename E, typename Cmp, typename Pol>
+void TreeSet<E,Cmp,Pol>::Branch::notifyParent(TreeSet<E,Cmp,Pol>* self) {
 	if (Node::m_parent != null) {
 		Node::m_parent->isFull(self, this);
 
@@ -774,8 +1110,8 @@ void TreeSet<E,Cmp>::Branch::notifyParent(TreeSet<E,Cmp>* self) {
 	}
 }
 
-template<typename E, typename Cmp>
-void TreeSet<E,Cmp>::Branch::isFull(TreeSet<E,Cmp>* self, Node* node) {
+template<typename E, typename Cmp, typename Pol>
+void TreeSet<E,Cmp,Pol>::Branch::isFull(TreeSet<E,Cmp,Pol>* self, Node* node) {
 	if (node->isLeaf() == true) {
 		Leaf* left = null;
 		Leaf* right = null;
@@ -840,8 +1176,8 @@ void TreeSet<E,Cmp>::Branch::isFull(TreeSet<E,Cmp>* self, Node* node) {
 	}
 }
 
-template<typename E, typename Cmp>
-void TreeSet<E,Cmp>::Branch::isLow(TreeSet<E,Cmp>* self, Node* node) {
+template<typename E, typename Cmp, typename Pol>
+void TreeSet<E,Cmp,Pol>::Branch::isLow(TreeSet<E,Cmp,Pol>* self, Node* node) {
 	if (node->isLeaf() == true) {
 		Leaf* left = null;
 		Leaf* right = null;
@@ -886,18 +1222,18 @@ void TreeSet<E,Cmp>::Branch::isLow(TreeSet<E,Cmp>* self, Node* node) {
 	}
 }
 
-template<typename E, typename Cmp>
-typename TreeSet<E,Cmp>::Leaf* TreeSet<E,Cmp>::Branch::firstLeaf(void) {
+template<typename E, typename Cmp, typename Pol>
+typename TreeSet<E,Cmp,Pol>::Leaf* TreeSet<E,Cmp,Pol>::Branch::firstLeaf(void) {
 	return getNode(0)->firstLeaf();
 }
 
-template<typename E, typename Cmp>
-typename TreeSet<E,Cmp>::Leaf* TreeSet<E,Cmp>::Branch::lastLeaf(void) {
+template<typename E, typename Cmp, typename Pol>
+typename TreeSet<E,Cmp,Pol>::Leaf* TreeSet<E,Cmp,Pol>::Branch::lastLeaf(void) {
 	return getNode(Node::m_lastIndex)->lastLeaf();
 }
 
-template<typename E, typename Cmp>
-void TreeSet<E,Cmp>::Branch::mergeWithRight(TreeSet<E,Cmp>* self, Branch* rNode, int pIndex) {
+template<typename E, typename Cmp, typename Pol>
+void TreeSet<E,Cmp,Pol>::Branch::mergeWithRight(TreeSet<E,Cmp,Pol>* self, Branch* rNode, int pIndex) {
 	if (rNode->getPhysicalEntries() > 0) {
 		rNode->pushLeft(self, rNode->getPhysicalEntries(), this, pIndex);
 	}
@@ -908,11 +1244,11 @@ void TreeSet<E,Cmp>::Branch::mergeWithRight(TreeSet<E,Cmp>* self, Branch* rNode,
 
 	Node::m_parent->removeItem(self, pIndex);
 
-	delete rNode;
+	self->destroyNode(rNode);
 }
 
-template<typename E, typename Cmp>
-void TreeSet<E,Cmp>::Branch::pushLeft(TreeSet<E,Cmp>* self, int indexFromHere, Branch* lNode, int pIndex) {
+template<typename E, typename Cmp, typename Pol>
+void TreeSet<E,Cmp,Pol>::Branch::pushLeft(TreeSet<E,Cmp,Pol>* self, int indexFromHere, Branch* lNode, int pIndex) {
 	setObject(0, Node::m_parent->getObject(pIndex));
 
 	lNode->appendFrom(self, this, 0, indexFromHere - 1);
@@ -922,8 +1258,8 @@ void TreeSet<E,Cmp>::Branch::pushLeft(TreeSet<E,Cmp>* self, int indexFromHere, B
 	Node::m_parent->setObject(pIndex, getObject(0));
 }
 
-template<typename E, typename Cmp>
-void TreeSet<E,Cmp>::Branch::pushRight(TreeSet<E,Cmp>* self, int indexFromHere, Branch* rNode, int pIndex) {
+template<typename E, typename Cmp, typename Pol>
+void TreeSet<E,Cmp,Pol>::Branch::pushRight(TreeSet<E,Cmp,Pol>* self, int indexFromHere, Branch* rNode, int pIndex) {
 	int begin = Node::m_lastIndex - indexFromHere + 1;
 	int target = rNode->m_lastIndex + indexFromHere;
 	int source = rNode->m_lastIndex;
@@ -932,13 +1268,14 @@ void TreeSet<E,Cmp>::Branch::pushRight(TreeSet<E,Cmp>* self, int indexFromHere,
 	rNode->setObject(0, Node::m_parent->getObject(pIndex));
 
 	while (source >= 0) {
-		#ifdef CXX_UTIL_TREE_SLOTTED
-		rNode->getItem(target).assign(target, rNode->getItem(source));
-		target--;
-		source--;
-		#else
-		rNode->getItem(target--) = rNode->getItem(source--);
-		#endif
+		if (Pol::SLOTTED_NODES == true) {
+			rNode->getItem(target).assign(target, rNode->getItem(source));
+			target--;
+			source--;
+
+		} else {
+			rNode->getItem(target--) = rNode->getItem(source--);
+		}
 	}
 
 	for (int i = Node::m_lastIndex; i >= begin; i-- ) {
@@ -950,8 +1287,8 @@ void TreeSet<E,Cmp>::Branch::pushRight(TreeSet<E,Cmp>* self, int indexFromHere,
 	Node::m_lastIndex -= indexFromHere;
 }
 
-template<typename E, typename Cmp>
-void TreeSet<E,Cmp>::Branch::remove(TreeSet<E,Cmp>* self, int index) {
+template<typename E, typename Cmp, typename Pol>
+void TreeSet<E,Cmp,Pol>::Branch::remove(TreeSet<E,Cmp,Pol>* self, int index) {
 	Leaf* leaf = getNode(index)->firstLeaf();
 
 	setObject(index, leaf->m_objects[0]);
@@ -959,14 +1296,15 @@ void TreeSet<E,Cmp>::Branch::remove(TreeSet<E,Cmp>* self, int index) {
 	leaf->removeItem(self, 0);
 }
 
-template<typename E, typename Cmp>
-void TreeSet<E,Cmp>::Branch::removeItem(TreeSet<E,Cmp>* self, int index) {
+template<typename E, typename Cmp, typename Pol>
+void TreeSet<E,Cmp,Pol>::Branch::removeItem(TreeSet<E,Cmp,Pol>* self, int index) {
 	for (int to = index; to < Node::m_lastIndex; to++) {
-		#ifdef CXX_UTIL_TREE_SLOTTED
-		m_items[to].migrate(to, m_items[to + 1]);
-		#else
-		m_items[to] = m_items[to + 1];
-		#endif
+		if (Pol::SLOTTED_NODES == true) {
+			m_items[to].migrate(to, m_items[to + 1]);
+
+		} else {
+			m_items[to] = m_items[to + 1];
+		}
 
 		#ifdef DEEP_DEBUG
 		m_items[to + 1].m_node = null;
@@ -993,26 +1331,27 @@ void TreeSet<E,Cmp>::Branch::removeItem(TreeSet<E,Cmp>* self, int index) {
 	}
 }
 
-template<typename E, typename Cmp>
-void TreeSet<E,Cmp>::Branch::shiftLeft(TreeSet<E,Cmp>* self, int count) {
+template<typename E, typename Cmp, typename Pol>
+void TreeSet<E,Cmp,Pol>::Branch::shiftLeft(TreeSet<E,Cmp,Pol>* self, int count) {
 	if (count <= 0) {
 		return;
 	}
 
 	for (int i = count; i <= Node::m_lastIndex; i++) {
-		#ifdef CXX_UTIL_TREE_SLOTTED
-		getItem(i - count).assign(i - count, getItem(i));
-		#else
-		getItem(i - count) = getItem(i);
-		#endif
+		if (Pol::SLOTTED_NODES == true) {
+			getItem(i - count).assign(i - count, getItem(i));
+
+		} else {
+			getItem(i - count) = getItem(i);
+		}
 	}
 
 	Node::m_lastIndex -= count;
 }
 
-template<typename E, typename Cmp>
-void TreeSet<E,Cmp>::Branch::split(TreeSet<E,Cmp>* self) {
-	Branch* nNode = new Branch(self, Node::m_parent);
+template<typename E, typename Cmp, typename Pol>
+void TreeSet<E,Cmp,Pol>::Branch::split(TreeSet<E,Cmp,Pol>* self) {
+	Branch* nNode = self->createBranch(Node::m_parent);
 
 	Node::m_parent->append(nNode, getObject(Node::m_lastIndex));
 
@@ -1023,8 +1362,8 @@ void TreeSet<E,Cmp>::Branch::split(TreeSet<E,Cmp>* self) {
 	balanceWithRight(self, nNode, 1);
 }
 
-template<typename E, typename Cmp>
-void TreeSet<E,Cmp>::Branch::splitWith(TreeSet<E,Cmp>* self, Branch* rNode, int kIndex) {
+template<typename E, typename Cmp, typename Pol>
+void TreeSet<E,Cmp,Pol>::Branch::splitWith(TreeSet<E,Cmp,Pol>* self, Branch* rNode, int kIndex) {
 	rNode->setObject(0, Node::m_parent->getObject(kIndex));
 
 	int numberOfKeys = getPhysicalEntries() + rNode->getVirtualEntries();
@@ -1034,7 +1373,7 @@ void TreeSet<E,Cmp>::Branch::splitWith(TreeSet<E,Cmp>* self, Branch* rNode, int
 	int indexFromHere = getPhysicalEntries() - newSizeOne3rd;
 	int indexFromNode = rNode->getVirtualEntries() - newSizeOfNode;
 
-	Branch* nNode = new Branch(self, Node::m_parent);
+	Branch* nNode = self->createBranch(Node::m_parent);
 	if (indexFromHere > 0) {
 		nNode->append(getItem(Node::m_lastIndex));
 		Node::m_parent->insertElement(nNode, getObject(Node::m_lastIndex--), kIndex);
@@ -1060,12 +1399,18 @@ void TreeSet<E,Cmp>::Branch::splitWith(TreeSet<E,Cmp>* self, Branch* rNode, int
 	}
 }
 
-template<typename E, typename Cmp>
-TreeSet<E,Cmp>::Leaf::Leaf(TreeSet<E,Cmp>* self, Branch* parent, const E obj, boolean hasObj):
+template<typename E, typename Cmp, typename Pol>
+TreeSet<E,Cmp,Pol>::Leaf::Leaf(TreeSet<E,Cmp,Pol>* self, Branch* parent, const E obj, boolean hasObj):
 	Node(parent, true) {
 
 	int msize = (getMaxIndex(self) + 1) * sizeof(E);
-	m_objects = (E*) malloc(msize);
+	if (Pol::POOLED_NODES == true) {
+		// XXX: pooled blocks carry the element array right behind the node (see createLeaf)
+		m_objects = (E*) (this + 1);
+
+	} else {
+		m_objects = (E*) malloc(msize);
+	}
 	memset(m_objects, 0, msize);
 
 	if (hasObj == true) {
@@ -1073,16 +1418,18 @@ TreeSet<E,Cmp>::Leaf::Leaf(TreeSet<E,Cmp>* self, Branch* parent, const E obj, bo
 	}
 }
 
-template<typename E, typename Cmp>
-TreeSet<E,Cmp>::Leaf::~Leaf(void) {
-	free(m_objects);
+template<typename E, typename Cmp, typename Pol>
+TreeSet<E,Cmp,Pol>::Leaf::~Leaf(void) {
+	if (Pol::POOLED_NODES == false) {
+		free(m_objects);
+	}
 	#ifdef DEEP_DEBUG
 	m_objects = null;
 	#endif
 }
 
-template<typename E, typename Cmp>
-void TreeSet<E,Cmp>::Leaf::insert (TreeSet<E,Cmp>* self, const E obj, int index) {
+template<typename E, typename Cmp, typename Pol>
+void TreeSet<E,Cmp,Pol>::Leaf::insert (TreeSet<E,Cmp,Pol>* self, const E obj, int index) {
 	for (int i = Node::m_lastIndex + 1; i > index ; i--) {
 		m_objects[i] = m_objects[i - 1];
 		#ifdef DEEP_DEBUG
@@ -1105,8 +1452,8 @@ void TreeSet<E,Cmp>::Leaf::insert (TreeSet<E,Cmp>* self, const E obj, int index)
 	}
 }
 
-template<typename E, typename Cmp>
-void TreeSet<E,Cmp>::Leaf::appendFrom(TreeSet<E,Cmp>* self, Leaf* source, int begin, int end) {
+template<typename E, typename Cmp, typename Pol>
+void TreeSet<E,Cmp,Pol>::Leaf::appendFrom(TreeSet<E,Cmp,Pol>* self, Leaf* source, int begin, int end) {
 	if (begin > end) {
 		return;
 	}
@@ -1119,40 +1466,76 @@ void TreeSet<E,Cmp>::Leaf::appendFrom(TreeSet<E,Cmp>* self, Leaf* source, int be
 	}
 }
 
-template<typename E, typename Cmp>
-void TreeSet<E,Cmp>::Leaf::append(E obj) {
+template<typename E, typename Cmp, typename Pol>
+void TreeSet<E,Cmp,Pol>::Leaf::append(E obj) {
 	m_objects[++Node::m_lastIndex] = obj;
 }
 
-template<typename E, typename Cmp>
-const E TreeSet<E,Cmp>::Leaf::find(const TreeSet<E,Cmp>* self, const E what, Node** block, int* location, boolean* status) {
+template<typename E, typename Cmp, typename Pol>
+const E TreeSet<E,Cmp,Pol>::Leaf::find(const TreeSet<E,Cmp,Pol>* self, const E what, Node** block, int* location, boolean* status) {
 
-	#ifdef CXX_UTIL_TREE_BSEARCH
-	register int last = -1;
-	register int start = 0;
-	register int finish = Node::m_lastIndex;
-	while (start <= finish) {
-		int mid = (start + finish) >> 1;
-		int weight = self->m_comparator->compare(m_objects[mid], what);
-		if (weight == 0) {
-			*block = this;
-			*location = mid;
+	if ((Pol::VECTOR_SEARCH == true) && (NodeSearch<E,Cmp>::VECTORIZED == true)) {
+		int i = NodeSearch<E,Cmp>::rank(m_objects, sizeof(E), Node::m_lastIndex + 1, what);
+
+		*block = this;
+		*location = i;
+
+		if ((i <= Node::m_lastIndex) && (self->m_comparator->compare(m_objects[i], what) == 0)) {
 			*status = true;
-			return m_objects[mid];
+			return m_objects[i];
 		}
 
-		if (weight < 0) {
-			start = mid + 1;
-
-		} else {
-			last = finish;
-			finish = mid - 1;
+		if (status != null) {
+			*status = false;
 		}
+		return Set<E>::NULL_VALUE;
 	}
 
-	if (last != -1) {
-		for (int i = start; i <= last; i++) {
+	if (Pol::BINARY_SEARCH == true) {
+		register int last = -1;
+		register int start = 0;
+		register int finish = Node::m_lastIndex;
+		while (start <= finish) {
+			int mid = (start + finish) >> 1;
+			int weight = self->m_comparator->compare(m_objects[mid], what);
+			if (weight == 0) {
+				*block = this;
+				*location = mid;
+				*status = true;
+				return m_objects[mid];
+			}
+
+			if (weight < 0) {
+				start = mid + 1;
+
+			} else {
+				last = finish;
+				finish = mid - 1;
+			}
+		}
+
+		if (last != -1) {
+			for (int i = start; i <= last; i++) {
+				int weight = self->m_comparator->compare(m_objects[i], what);
+				if (weight > 0) {
+					*block = this;
+					*location = i;
+					*status = false;
+					return Set<E>::NULL_VALUE;
+				}
+			}
+		}
+
+	} else {
+		for (int i = 0; i <= Node::m_lastIndex; i++) {
 			int weight = self->m_comparator->compare(m_objects[i], what);
+			if (weight == 0) {
+				*block = this;
+				*location = i;
+				*status = true;
+				return m_objects[i];
+			}
+
 			if (weight > 0) {
 				*block = this;
 				*location = i;
@@ -1161,24 +1544,6 @@ const E TreeSet<E,Cmp>::Leaf::find(const TreeSet<E,Cmp>* self, const E what, Nod
 			}
 		}
 	}
-	#else
-	for (int i = 0; i <= Node::m_lastIndex; i++) {
-		int weight = self->m_comparator->compare(m_objects[i], what);
-		if (weight == 0) {
-			*block = this;
-			*location = i;
-			*status = true;
-			return m_objects[i];
-		}
-
-		if (weight > 0) {
-			*block = this;
-			*location = i;
-			*status = false;
-			return Set<E>::NULL_VALUE;
-		}
-	}
-	#endif
 
 	*block = this;
 	*location = Node::m_lastIndex + 1;
@@ -1188,8 +1553,8 @@ const E TreeSet<E,Cmp>::Leaf::find(const TreeSet<E,Cmp>* self, const E what, Nod
 	return Set<E>::NULL_VALUE;
 }
 
-template<typename E, typename Cmp>
-const E TreeSet<E,Cmp>::Leaf::lower(const TreeSet<E,Cmp>* self, const E what, Node** block, int* location, E* next, boolean* status, boolean* nextStatus) {
+template<typename E, typename Cmp, typename Pol>
+const E TreeSet<E,Cmp,Pol>::Leaf::lower(const TreeSet<E,Cmp,Pol>* self, const E what, Node** block, int* location, E* next, boolean* status, boolean* nextStatus) {
 	*next = Set<E>::NULL_VALUE;
 	*nextStatus = false;
 
@@ -1212,8 +1577,8 @@ const E TreeSet<E,Cmp>::Leaf::lower(const TreeSet<E,Cmp>* self, const E what, No
 	return Set<E>::NULL_VALUE;
 }
 
-template<typename E, typename Cmp>
-const E TreeSet<E,Cmp>::Leaf::higher(const TreeSet<E,Cmp>* self, const E what, Node** block, int* location, E* prev, boolean* status, boolean* prevStatus) {
+template<typename E, typename Cmp, typename Pol>
+const E TreeSet<E,Cmp,Pol>::Leaf::higher(const TreeSet<E,Cmp,Pol>* self, const E what, Node** block, int* location, E* prev, boolean* status, boolean* prevStatus) {
 	*prev = Set<E>::NULL_VALUE;
 	*prevStatus = false;
 
@@ -1236,8 +1601,8 @@ const E TreeSet<E,Cmp>::Leaf::higher(const TreeSet<E,Cmp>* self, const E what, N
 	return Set<E>::NULL_VALUE;
 }
 
-template<typename E, typename Cmp>
-const E TreeSet<E,Cmp>::Leaf::getElement(int index, boolean* status) {
+template<typename E, typename Cmp, typename Pol>
+const E TreeSet<E,Cmp,Pol>::Leaf::getElement(int index, boolean* status) {
 	if ((index >= 0) && (index <= Node::m_lastIndex)) {
 		*status = true;
 		return getObject(index);
@@ -1246,8 +1611,8 @@ const E TreeSet<E,Cmp>::Leaf::getElement(int index, boolean* status) {
 	return Set<E>::NULL_VALUE;
 }
 
-template<typename E, typename Cmp>
-const E TreeSet<E,Cmp>::Leaf::nextElement(int index, Node** block, int* location) {
+template<typename E, typename Cmp, typename Pol>
+const E TreeSet<E,Cmp,Pol>::Leaf::nextElement(int index, Node** block, int* location) {
 	if (index < Node::m_lastIndex) {
 		*block = this;
 		*location = ++index;
@@ -1260,8 +1625,8 @@ const E TreeSet<E,Cmp>::Leaf::nextElement(int index, Node** block, int* location
 	return Set<E>::NULL_VALUE;
 }
 
-template<typename E, typename Cmp>
-int TreeSet<E,Cmp>::Leaf::instanceIndex(const E node) const {
+template<typename E, typename Cmp, typename Pol>
+int TreeSet<E,Cmp,Pol>::Leaf::instanceIndex(const E node) const {
 	for (int i = 0; i <= Node::m_lastIndex; i++) {
 		if (m_objects[i] == node) {
 			return i;
@@ -1271,32 +1636,32 @@ int TreeSet<E,Cmp>::Leaf::instanceIndex(const E node) const {
 	throw new UnsupportedOperationException("reference not found");
 }
 
-template<typename E, typename Cmp>
-typename TreeSet<E,Cmp>::Leaf* TreeSet<E,Cmp>::Leaf::firstLeaf(void) {
+template<typename E, typename Cmp, typename Pol>
+typename TreeSet<E,Cmp,Pol>::Leaf* TreeSet<E,Cmp,Pol>::Leaf::firstLeaf(void) {
 	return this;
 }
 
-template<typename E, typename Cmp>
-typename TreeSet<E,Cmp>::Leaf* TreeSet<E,Cmp>::Leaf::lastLeaf (void) {
+template<typename E, typename Cmp, typename Pol>
+typename TreeSet<E,Cmp,Pol>::Leaf* TreeSet<E,Cmp,Pol>::Leaf::lastLeaf (void) {
 	return this;
 }
 
-template<typename E, typename Cmp>
-void TreeSet<E,Cmp>::Leaf::balanceWithLeft(TreeSet<E,Cmp>* self, Leaf* lNode, int pIndex) {
+template<typename E, typename Cmp, typename Pol>
+void TreeSet<E,Cmp,Pol>::Leaf::balanceWithLeft(TreeSet<E,Cmp,Pol>* self, Leaf* lNode, int pIndex) {
 	int newSize = (getVirtualEntries() + lNode->getPhysicalEntries()) / 2;
 	int indexFromHere = getPhysicalEntries() - newSize;
 	pushLeft(self, indexFromHere, lNode, pIndex);
 }
 
-template<typename E, typename Cmp>
-void TreeSet<E,Cmp>::Leaf::balanceWithRight(TreeSet<E,Cmp>* self, Leaf* rNode, int pIndex) {
+template<typename E, typename Cmp, typename Pol>
+void TreeSet<E,Cmp,Pol>::Leaf::balanceWithRight(TreeSet<E,Cmp,Pol>* self, Leaf* rNode, int pIndex) {
 	int newSize = (getPhysicalEntries() + rNode->getVirtualEntries()) / 2;
 	int indexFromHere = getPhysicalEntries() - newSize;
 	pushRight(self, indexFromHere, rNode, pIndex);
 }
 
-template<typename E, typename Cmp>
-void TreeSet<E,Cmp>::Leaf::balanceWith(TreeSet<E,Cmp>* self, Leaf* rNode, int pIndex) {
+template<typename E, typename Cmp, typename Pol>
+void TreeSet<E,Cmp,Pol>::Leaf::balanceWith(TreeSet<E,Cmp,Pol>* self, Leaf* rNode, int pIndex) {
 	if (getPhysicalEntries() < rNode->getVirtualEntries()) {
 		rNode->balanceWithLeft(self, this, pIndex);
 
@@ -1305,19 +1670,19 @@ void TreeSet<E,Cmp>::Leaf::balanceWith(TreeSet<E,Cmp>* self, Leaf* rNode, int pI
 	}
 }
 
-template<typename E, typename Cmp>
-void TreeSet<E,Cmp>::Leaf::mergeWithRight(TreeSet<E,Cmp>* self, Leaf* rNode, int pIndex) {
+template<typename E, typename Cmp, typename Pol>
+void TreeSet<E,Cmp,Pol>::Leaf::mergeWithRight(TreeSet<E,Cmp,Pol>* self, Leaf* rNode, int pIndex) {
 	rNode->pushLeft(self, rNode->getPhysicalEntries(), this, pIndex);
 
 	append(Node::m_parent->getObject(pIndex));
 
 	Node::m_parent->removeItem(self, pIndex);
 
-	delete rNode;
+	self->destroyNode(rNode);
 }
 
-template<typename E, typename Cmp>
-void TreeSet<E,Cmp>::Leaf::pushLeft(TreeSet<E,Cmp>* self, int indexFromHere, Leaf* lNode, int pIndex) {
+template<typename E, typename Cmp, typename Pol>
+void TreeSet<E,Cmp,Pol>::Leaf::pushLeft(TreeSet<E,Cmp,Pol>* self, int indexFromHere, Leaf* lNode, int pIndex) {
 	lNode->append(Node::m_parent->getObject(pIndex));
 
 	if (indexFromHere > 1) {
@@ -1329,8 +1694,8 @@ void TreeSet<E,Cmp>::Leaf::pushLeft(TreeSet<E,Cmp>* self, int indexFromHere, Lea
 	shiftLeft(self, indexFromHere);
 }
 
-template<typename E, typename Cmp>
-void TreeSet<E,Cmp>::Leaf::pushRight(TreeSet<E,Cmp>* self, int indexFromHere, Leaf* rNode, int pIndex) {
+template<typename E, typename Cmp, typename Pol>
+void TreeSet<E,Cmp,Pol>::Leaf::pushRight(TreeSet<E,Cmp,Pol>* self, int indexFromHere, Leaf* rNode, int pIndex) {
 	int begin = Node::m_lastIndex - indexFromHere + 1;
 	int target = rNode->m_lastIndex + indexFromHere;
 	int source = rNode->m_lastIndex;
@@ -1358,8 +1723,8 @@ void TreeSet<E,Cmp>::Leaf::pushRight(TreeSet<E,Cmp>* self, int indexFromHere, Le
 	Node::m_lastIndex -= indexFromHere;
 }
 
-template<typename E, typename Cmp>
-void TreeSet<E,Cmp>::Leaf::remove(TreeSet<E,Cmp>* self, int index) {
+template<typename E, typename Cmp, typename Pol>
+void TreeSet<E,Cmp,Pol>::Leaf::remove(TreeSet<E,Cmp,Pol>* self, int index) {
 	for (int to = index; to < Node::m_lastIndex; to++) {
 		m_objects[to] = m_objects[to + 1];
 		#ifdef DEEP_DEBUG
@@ -1387,8 +1752,8 @@ void TreeSet<E,Cmp>::Leaf::remove(TreeSet<E,Cmp>* self, int index) {
 	}
 }
 
-template<typename E, typename Cmp>
-void TreeSet<E,Cmp>::Leaf::shiftLeft(TreeSet<E,Cmp>* self, int count) {
+template<typename E, typename Cmp, typename Pol>
+void TreeSet<E,Cmp,Pol>::Leaf::shiftLeft(TreeSet<E,Cmp,Pol>* self, int count) {
 	if (count <= 0) {
 		return;
 	}
@@ -1403,17 +1768,17 @@ void TreeSet<E,Cmp>::Leaf::shiftLeft(TreeSet<E,Cmp>* self, int count) {
 	Node::m_lastIndex -= count;
 }
 
-template<typename E, typename Cmp>
-void TreeSet<E,Cmp>::Leaf::split(TreeSet<E,Cmp>* self) {
-	Leaf* nNode = new Leaf(self, Node::m_parent, Set<E>::NULL_VALUE, false);
+template<typename E, typename Cmp, typename Pol>
+void TreeSet<E,Cmp,Pol>::Leaf::split(TreeSet<E,Cmp,Pol>* self) {
+	Leaf* nNode = self->createLeaf(Node::m_parent, Set<E>::NULL_VALUE, false);
 
 	Node::m_parent->append(nNode, m_objects[Node::m_lastIndex--]);
 
 	balanceWithRight(self, nNode, 1);
 }
 
-template<typename E, typename Cmp>
-void TreeSet<E,Cmp>::Leaf::splitWith(TreeSet<E,Cmp>* self, Leaf* rNode, int kIndex) {
+template<typename E, typename Cmp, typename Pol>
+void TreeSet<E,Cmp,Pol>::Leaf::splitWith(TreeSet<E,Cmp,Pol>* self, Leaf* rNode, int kIndex) {
 	int numberOfKeys = getPhysicalEntries() + rNode->getVirtualEntries();
 	int newSizeOne3rd = numberOfKeys / 3;
 	int newSizeOneHalf = (numberOfKeys - newSizeOne3rd) / 2;
@@ -1421,7 +1786,7 @@ void TreeSet<E,Cmp>::Leaf::splitWith(TreeSet<E,Cmp>* self, Leaf* rNode, int kInd
 	int indexFromHere = getPhysicalEntries() - newSizeOne3rd;
 	int indexFromNode = rNode->getVirtualEntries() - newSizeOfNode;
 
-	Leaf* nNode = new Leaf(self, Node::m_parent, Set<E>::NULL_VALUE, false);
+	Leaf* nNode = self->createLeaf(Node::m_parent, Set<E>::NULL_VALUE, false);
 
 	Node::m_parent->insertElement(nNode, m_objects[Node::m_lastIndex--], kIndex);
 
@@ -33,10 +33,13 @@
 
 #include "cxx/util/SortedSet.h"
 #include "cxx/util/Comparator.h"
+#include "cxx/util/FrozenTreeSet.h"
+#include "cxx/util/NodeSearch.h"
+#include "cxx/util/TreePolicy.h"
 
 namespace cxx { namespace util {
 
-template<typename E, typename Cmp = Comparator<E> >
+template<typename E, typename Cmp = Comparator<E>, typename Pol = TreePolicy>
 class TreeSet : /* public NavigableSet */ public SortedSet<E> {
 	class Leaf;
 	class Branch;
@@ -46,9 +49,8 @@ class TreeSet : /* public NavigableSet */ public SortedSet<E> {
 		private:
 			Branch* m_parent;
 			shorttype m_lastIndex;
-			#ifdef CXX_UTIL_TREE_SLOTTED
+			// XXX: position within the parent, kept up to date by slotted policies only (see TreePolicy::SLOTTED_NODES)
 			shorttype m_slotIndex;
-			#endif
 			boolean m_isLeaf : 1;
 
 		public:
@@ -57,12 +59,12 @@ class TreeSet : /* public NavigableSet */ public SortedSet<E> {
 			virtual ~Node(void) {
 			}
 
-			virtual void insert(TreeSet<E,Cmp>* self, const E obj, int index) = 0;
-			virtual void remove(TreeSet<E,Cmp>* self, int index) = 0;
+			virtual void insert(TreeSet<E,Cmp,Pol>* self, const E obj, int index) = 0;
+			virtual void remove(TreeSet<E,Cmp,Pol>* self, int index) = 0;
 
-			virtual const E find(const TreeSet<E,Cmp>* self, const E elem, Node** node, int* index, boolean* status) = 0;
-			virtual const E lower(const TreeSet<E,Cmp>* self, const E elem, Node** node, int* index, E* next, boolean* status, boolean* nextStatus) = 0;
-			virtual const E higher(const TreeSet<E,Cmp>* self, const E elem, Node** node, int* index, E* prev, boolean* status, boolean* prevStatus) = 0;
+			virtual const E find(const TreeSet<E,Cmp,Pol>* self, const E elem, Node** node, int* index, boolean* status) = 0;
+			virtual const E lower(const TreeSet<E,Cmp,Pol>* self, const E elem, Node** node, int* index, E* next, boolean* status, boolean* nextStatus) = 0;
+			virtual const E higher(const TreeSet<E,Cmp,Pol>* self, const E elem, Node** node, int* index, E* prev, boolean* status, boolean* prevStatus) = 0;
 
 			virtual const E getElement(int index, boolean* status) = 0;
 			virtual const E nextElement(int index, Node** block, int* location) = 0;
@@ -70,7 +72,7 @@ class TreeSet : /* public NavigableSet */ public SortedSet<E> {
 			virtual Leaf* firstLeaf(void) = 0;
 			virtual Leaf* lastLeaf(void) = 0;
 
-			virtual void split(TreeSet<E,Cmp>* self) = 0;
+			virtual void split(TreeSet<E,Cmp,Pol>* self) = 0;
 
 			FORCE_INLINE boolean isLeaf() const {
 				return m_isLeaf;
@@ -98,7 +100,6 @@ class TreeSet : /* public NavigableSet */ public SortedSet<E> {
 				m_object(object) {
 			}
 
-			#ifdef CXX_UTIL_TREE_SLOTTED
 			FORCE_INLINE void assign(inttype index, Item& item) {
 				m_node = item.m_node;
 				m_object = item.m_object;
@@ -110,7 +111,6 @@ class TreeSet : /* public NavigableSet */ public SortedSet<E> {
 				item.m_node = null;
 				item.m_object = Set<E>::NULL_VALUE;
 			}
-			#endif
 
 		friend class TreeSet;
 		friend class Branch;
@@ -122,31 +122,31 @@ class TreeSet : /* public NavigableSet */ public SortedSet<E> {
 			Item* m_items;
 
 		public:
-			Branch(TreeSet<E,Cmp>* self, Branch* parent);
-			Branch(TreeSet<E,Cmp>* self, Branch* parent, Node* oldroot);
+			Branch(TreeSet<E,Cmp,Pol>* self, Branch* parent);
+			Branch(TreeSet<E,Cmp,Pol>* self, Branch* parent, Node* oldroot);
 
 			virtual ~Branch(void);
 
-			void insert(TreeSet<E,Cmp>* self, const E obj, int index);
-			void insert(TreeSet<E,Cmp>* self, Item& item, int index);
-			void insert(TreeSet<E,Cmp>* self, Node* node, E obj, int index);
+			void insert(TreeSet<E,Cmp,Pol>* self, const E obj, int index);
+			void insert(TreeSet<E,Cmp,Pol>* self, Item& item, int index);
+			void insert(TreeSet<E,Cmp,Pol>* self, Node* node, E obj, int index);
 			void insertElement(Item& item, int index);
 			void insertElement(Node* node, E obj, int index);
 
-			void remove(TreeSet<E,Cmp>* self, int index);
-			void removeItem(TreeSet<E,Cmp>* self, int index);
+			void remove(TreeSet<E,Cmp,Pol>* self, int index);
+			void removeItem(TreeSet<E,Cmp,Pol>* self, int index);
 
-			const E find(const TreeSet<E,Cmp>* self, const E elem, Node** node, int* index, boolean* status);
-			const E lower(const TreeSet<E,Cmp>* self, const E elem, Node** node, int* index, E* next, boolean* status, boolean* nextStatus);
-			const E higher(const TreeSet<E,Cmp>* self, const E elem, Node** node, int* index, E* prev, boolean* status, boolean* prevStatus);
+			const E find(const TreeSet<E,Cmp,Pol>* self, const E elem, Node** node, int* index, boolean* status);
+			const E lower(const TreeSet<E,Cmp,Pol>* self, const E elem, Node** node, int* index, E* next, boolean* status, boolean* nextStatus);
+			const E higher(const TreeSet<E,Cmp,Pol>* self, const E elem, Node** node, int* index, E* prev, boolean* status, boolean* prevStatus);
 
 			const E getElement(int index, boolean* status);
 			const E nextElement(int index, Node** block, int* location);
 
 			FORCE_INLINE void setNode(int index, Node* node) {
-				#ifdef CXX_UTIL_TREE_SLOTTED
-				node->m_slotIndex = index;
-				#endif
+				if (Pol::SLOTTED_NODES == true) {
+					node->m_slotIndex = index;
+				}
 
 				m_items[index].m_node = node;
 				node->m_parent = this;
@@ -157,11 +157,12 @@ class TreeSet : /* public NavigableSet */ public SortedSet<E> {
 			}
 
 			FORCE_INLINE void setItem(int index, Item& item) {
-				#ifdef CXX_UTIL_TREE_SLOTTED
-				m_items[index].assign(index, item);
-				#else
-				m_items[index] = item;
-				#endif
+				if (Pol::SLOTTED_NODES == true) {
+					m_items[index].assign(index, item);
+
+				} else {
+					m_items[index] = item;
+				}
 
 				item.m_node->m_parent = this;
 			}
@@ -171,7 +172,7 @@ class TreeSet : /* public NavigableSet */ public SortedSet<E> {
 				setObject(index, obj);
 			}
 
-			void notifyParent(TreeSet<E,Cmp>* self);
+			void notifyParent(TreeSet<E,Cmp,Pol>* self);
 
 			Leaf* lastLeaf(void);
 			Leaf* firstLeaf(void);
@@ -190,24 +191,24 @@ class TreeSet : /* public NavigableSet */ public SortedSet<E> {
 
 			int instanceIndex(const Node* node) const;
 
-			void split(TreeSet<E,Cmp>* self);
-			void shiftLeft(TreeSet<E,Cmp>* self, int count);
-			void splitWith(TreeSet<E,Cmp>* self, Branch* node, int index);
+			void split(TreeSet<E,Cmp,Pol>* self);
+			void shiftLeft(TreeSet<E,Cmp,Pol>* self, int count);
+			void splitWith(TreeSet<E,Cmp,Pol>* self, Branch* node, int index);
 
 			void append(Item& item);
 			void append(Node* node, E obj);
-			void appendFrom(TreeSet<E,Cmp>* self, Branch* source, int begin, int end);
+			void appendFrom(TreeSet<E,Cmp,Pol>* self, Branch* source, int begin, int end);
 
-			void mergeWithRight(TreeSet<E,Cmp>* self, Branch* rNode, int index);
+			void mergeWithRight(TreeSet<E,Cmp,Pol>* self, Branch* rNode, int index);
 
-			void balanceWithLeft(TreeSet<E,Cmp>* self, Branch* lNode, int index);
-			void balanceWithRight(TreeSet<E,Cmp>* self, Branch* rNode, int index);
-			void balanceWith(TreeSet<E,Cmp>* self, Branch* node, int index);
+			void balanceWithLeft(TreeSet<E,Cmp,Pol>* self, Branch* lNode, int index);
+			void balanceWithRight(TreeSet<E,Cmp,Pol>* self, Branch* rNode, int index);
+			void balanceWith(TreeSet<E,Cmp,Pol>* self, Branch* node, int index);
 
-			void pushLeft(TreeSet<E,Cmp>* self, int count, Branch* lNode, int pIndex);
-			void pushRight(TreeSet<E,Cmp>* self, int count, Branch* rNode, int pIndex);
+			void pushLeft(TreeSet<E,Cmp,Pol>* self, int count, Branch* lNode, int pIndex);
+			void pushRight(TreeSet<E,Cmp,Pol>* self, int count, Branch* rNode, int pIndex);
 
-			FORCE_INLINE int getMaxIndex(TreeSet<E,Cmp>* self) const {
+			FORCE_INLINE int getMaxIndex(TreeSet<E,Cmp,Pol>* self) const {
 				return self->m_branchMaxIndex;
 			}
 
@@ -219,23 +220,23 @@ class TreeSet : /* public NavigableSet */ public SortedSet<E> {
 				return getPhysicalEntries() + 1;
 			}
 
-			FORCE_INLINE int getMaxPhysicalEntries(TreeSet<E,Cmp>* self) const {
+			FORCE_INLINE int getMaxPhysicalEntries(TreeSet<E,Cmp,Pol>* self) const {
 				return self->m_branchMaxIndex;
 			}
 
-			void isFull(TreeSet<E,Cmp>* self, Node* node);
+			void isFull(TreeSet<E,Cmp,Pol>* self, Node* node);
 
-			FORCE_INLINE int isFull(TreeSet<E,Cmp>* self) const {
+			FORCE_INLINE int isFull(TreeSet<E,Cmp,Pol>* self) const {
 				return Node::m_lastIndex == getMaxIndex(self);
 			}
 
-			FORCE_INLINE int isAlmostFull(TreeSet<E,Cmp>* self) const {
+			FORCE_INLINE int isAlmostFull(TreeSet<E,Cmp,Pol>* self) const {
 				return Node::m_lastIndex >= (getMaxIndex(self) - 1);
 			}
 
-			void isLow(TreeSet<E,Cmp>* self, Node* node);
+			void isLow(TreeSet<E,Cmp,Pol>* self, Node* node);
 
-			FORCE_INLINE int isLow(TreeSet<E,Cmp>* self) const {
+			FORCE_INLINE int isLow(TreeSet<E,Cmp,Pol>* self) const {
 				return Node::m_lastIndex < self->m_branchLowWater;
 			}
 
@@ -253,16 +254,16 @@ class TreeSet : /* public NavigableSet */ public SortedSet<E> {
 
 			virtual ~Leaf(void);
 
-			void insert(TreeSet<E,Cmp>* self, const E obj, int index);
+			void insert(TreeSet<E,Cmp,Pol>* self, const E obj, int index);
 
-			void remove(TreeSet<E,Cmp>* self, int index);
-			FORCE_INLINE void removeItem(TreeSet<E,Cmp>* self, int index) {
+			void remove(TreeSet<E,Cmp,Pol>* self, int index);
+			FORCE_INLINE void removeItem(TreeSet<E,Cmp,Pol>* self, int index) {
 				remove(self, index);
 			}
 
-			const E find(const TreeSet<E,Cmp>* self, const E elem, Node** node, int* index, boolean* status);
-			const E lower(const TreeSet<E,Cmp>* self, const E elem, Node** node, int* index, E* next, boolean* status, boolean* nextStatus);
-			const E higher(const TreeSet<E,Cmp>* self, const E elem, Node** node, int* index, E* prev, boolean* status, boolean* prevStatus);
+			const E find(const TreeSet<E,Cmp,Pol>* self, const E elem, Node** node, int* index, boolean* status);
+			const E lower(const TreeSet<E,Cmp,Pol>* self, const E elem, Node** node, int* index, E* next, boolean* status, boolean* nextStatus);
+			const E higher(const TreeSet<E,Cmp,Pol>* self, const E elem, Node** node, int* index, E* prev, boolean* status, boolean* prevStatus);
 
 			const E getElement(int index, boolean* status);
 			const E nextElement(int index, Node** block, int* location);
@@ -280,23 +281,23 @@ class TreeSet : /* public NavigableSet */ public SortedSet<E> {
 
 			int instanceIndex(const E obj) const;
 
-			void split(TreeSet<E,Cmp>* self);
-			void shiftLeft(TreeSet<E,Cmp>* self, int count);
-			void splitWith(TreeSet<E,Cmp>* self, Leaf* rNode, int index);
+			void split(TreeSet<E,Cmp,Pol>* self);
+			void shiftLeft(TreeSet<E,Cmp,Pol>* self, int count);
+			void splitWith(TreeSet<E,Cmp,Pol>* self, Leaf* rNode, int index);
 
 			void append(E obj);
-			void appendFrom(TreeSet<E,Cmp>* self, Leaf* source, int begin, int end);
+			void appendFrom(TreeSet<E,Cmp,Pol>* self, Leaf* source, int begin, int end);
 
-			void mergeWithRight(TreeSet<E,Cmp>* self, Leaf* rNode, int index);
+			void mergeWithRight(TreeSet<E,Cmp,Pol>* self, Leaf* rNode, int index);
 
-			void balanceWith(TreeSet<E,Cmp>* self, Leaf* node, int index);
-			void balanceWithLeft(TreeSet<E,Cmp>* self, Leaf* lNode, int index);
-			void balanceWithRight(TreeSet<E,Cmp>* self, Leaf* rNode, int index);
+			void balanceWith(TreeSet<E,Cmp,Pol>* self, Leaf* node, int index);
+			void balanceWithLeft(TreeSet<E,Cmp,Pol>* self, Leaf* lNode, int index);
+			void balanceWithRight(TreeSet<E,Cmp,Pol>* self, Leaf* rNode, int index);
 
-			void pushLeft(TreeSet<E,Cmp>* self, int count, Leaf* lNode, int pIndex);
-			void pushRight(TreeSet<E,Cmp>* self, int count, Leaf* rNode, int pIndex);
+			void pushLeft(TreeSet<E,Cmp,Pol>* self, int count, Leaf* lNode, int pIndex);
+			void pushRight(TreeSet<E,Cmp,Pol>* self, int count, Leaf* rNode, int pIndex);
 
-			FORCE_INLINE int getMaxIndex(TreeSet<E,Cmp>* self) const {
+			FORCE_INLINE int getMaxIndex(TreeSet<E,Cmp,Pol>* self) const {
 				return self->m_leafMaxIndex;
 			}
 
@@ -308,19 +309,19 @@ class TreeSet : /* public NavigableSet */ public SortedSet<E> {
 				return getPhysicalEntries() + 1;
 			}
 
-			FORCE_INLINE int getMaxPhysicalEntries(TreeSet<E,Cmp>* self) const {
+			FORCE_INLINE int getMaxPhysicalEntries(TreeSet<E,Cmp,Pol>* self) const {
 				return self->m_leafMaxIndex + 1;
 			}
 
-			FORCE_INLINE int isFull(TreeSet<E,Cmp>* self) const {
+			FORCE_INLINE int isFull(TreeSet<E,Cmp,Pol>* self) const {
 				return Node::m_lastIndex == getMaxIndex(self);
 			}
 
-			FORCE_INLINE int isAlmostFull(TreeSet<E,Cmp>* self) const {
+			FORCE_INLINE int isAlmostFull(TreeSet<E,Cmp,Pol>* self) const {
 				return Node::m_lastIndex >= (getMaxIndex(self) -1);
 			}
 
-			FORCE_INLINE int isLow(TreeSet<E,Cmp>* self) const {
+			FORCE_INLINE int isLow(TreeSet<E,Cmp,Pol>* self) const {
 				return Node::m_lastIndex < self->m_leafLowWater;
 			}
 
@@ -331,6 +332,7 @@ class TreeSet : /* public NavigableSet */ public SortedSet<E> {
 	private:
 		Node* m_root;
 		const Cmp* m_comparator;
+		SlabPool* m_nodePool;
 
 		inttype m_pEntries;
 		ubytetype m_leafLowWater;
@@ -354,8 +356,51 @@ class TreeSet : /* public NavigableSet */ public SortedSet<E> {
 			m_pEntries--;
 		}
 
+		FORCE_INLINE Leaf* createLeaf(Branch* parent, const E obj, boolean hasObj = true) {
+			if (Pol::POOLED_NODES == true) {
+				return new (m_nodePool->allocate()) Leaf(this, parent, obj, hasObj);
+			}
+
+			return new Leaf(this, parent, obj, hasObj);
+		}
+
+		FORCE_INLINE Branch* createBranch(Branch* parent, Node* oldroot = null) {
+			if (Pol::POOLED_NODES == true) {
+				return (oldroot == null) ? new (m_nodePool->allocate()) Branch(this, parent) : new (m_nodePool->allocate()) Branch(this, parent, oldroot);
+			}
+
+			return (oldroot == null) ? new Branch(this, parent) : new Branch(this, parent, oldroot);
+		}
+
+		// XXX: only called on detached nodes without children, pooled nodes skip the destructor
+		FORCE_INLINE void destroyNode(Node* node) {
+			if (Pol::POOLED_NODES == true) {
+				m_nodePool->release(node);
+
+			} else {
+				delete node;
+			}
+		}
+
+		// XXX: right spine of a tree under bulk load, m_spine[0] is the rightmost leaf
+		struct BulkState {
+			Node* m_spine[64];
+			int m_leafTarget;
+			int m_branchTarget;
+			int m_count;
+			E m_lastElem;
+			E m_pendingElem;
+			boolean m_pending;
+		};
+
+		void bulkBegin(BulkState& state, double fillFactor);
+		boolean bulkAppend(BulkState& state, E elem);
+		void bulkAttach(BulkState& state, int level, E obj, Node* node);
+		void bulkEnd(BulkState& state);
+
 		const E nextElement(Node* node, int index, Node** block, int* location);
 		const boolean hasNextElement(Node* node, int index);
+		const E ceilingPosition(const E elem, Node** block, int* location);
 
 		int indexOf(const E obj) const;
 
@@ -372,6 +417,12 @@ class TreeSet : /* public NavigableSet */ public SortedSet<E> {
 		FORCE_INLINE void transfer(TreeSet* tree) {
 			tree->m_root = m_root;
 			tree->m_pEntries = m_pEntries;
+
+			// XXX: pooled nodes belong to the slabs they were carved from, hand the slabs over as well
+			SlabPool* pool = tree->m_nodePool;
+			tree->m_nodePool = m_nodePool;
+			m_nodePool = pool;
+
 			m_pEntries = 0;
 			m_root = null;
 		}
@@ -427,6 +478,11 @@ class TreeSet : /* public NavigableSet */ public SortedSet<E> {
 			return addAll(c, null);
 		}
 
+		// XXX: bulk loads build leaves left to right (ascending unique elements) and branch levels above them,
+		//      fillFactor (0.0 - 1.0] sets how full nodes are packed; a non-empty tree or unsorted input falls back to add
+		void bulkLoad(const E* elems, int count, double fillFactor = 1.0);
+		void bulkLoad(Iterator<E>* iter, double fillFactor = 1.0);
+
 		virtual boolean remove(const E key, E* retelem);
 		virtual boolean remove(const E key) {
 			return remove(key, null);
@@ -467,12 +523,124 @@ class TreeSet : /* public NavigableSet */ public SortedSet<E> {
 
 		virtual Iterator<E>* iterator();
 
+		// XXX: moves the elements into a read-only, contiguous FrozenTreeSet (same comparator and ownership), leaving this set empty
+		FrozenTreeSet<E,Cmp>* freeze(void);
+
+		// XXX: visits elements in [fromElement, toElement) in order without allocating, leaves below toElement are walked without comparing;
+		//      visitor is called as boolean visitor(const E) and returns false to stop
+		template<typename F>
+		FORCE_INLINE int forEachInRange(const E fromElement, const E toElement, F&& visitor) {
+			return forEachInRange(fromElement, false, toElement, false, visitor);
+		}
+
+		// XXX: fromOpen or toOpen leaves that side unbounded and its element unread, every element value (NULL_VALUE included) is a real bound
+		template<typename F>
+		int forEachInRange(const E fromElement, boolean fromOpen, const E toElement, boolean toOpen, F&& visitor);
+
+	// XXX: stack allocated range scan handing out elements in batches, like iterators any change to the set invalidates it
+	class RangeCursor {
+
+		private:
+			TreeSet<E,Cmp,Pol>* m_set;
+			Node* m_node;
+			int m_index;
+			E m_toElement;
+			boolean m_toOpen;
+
+		public:
+			RangeCursor(TreeSet<E,Cmp,Pol>* set, const E fromElement) {
+				reset(set, fromElement, false, fromElement, true);
+			}
+
+			RangeCursor(TreeSet<E,Cmp,Pol>* set, const E fromElement, const E toElement) {
+				reset(set, fromElement, false, toElement, false);
+			}
+
+			// XXX: open sides as in TreeSet::forEachInRange
+			RangeCursor(TreeSet<E,Cmp,Pol>* set, const E fromElement, boolean fromOpen, const E toElement, boolean toOpen) {
+				reset(set, fromElement, fromOpen, toElement, toOpen);
+			}
+
+			FORCE_INLINE void reset(TreeSet<E,Cmp,Pol>* set, const E fromElement) {
+				reset(set, fromElement, false, fromElement, true);
+			}
+
+			FORCE_INLINE void reset(TreeSet<E,Cmp,Pol>* set, const E fromElement, const E toElement) {
+				reset(set, fromElement, false, toElement, false);
+			}
+
+			void reset(TreeSet<E,Cmp,Pol>* set, const E fromElement, boolean fromOpen, const E toElement, boolean toOpen) {
+				m_set = set;
+				m_node = null;
+				m_index = -1;
+				m_toElement = toElement;
+				m_toOpen = toOpen;
+
+				if (m_set->m_root != null) {
+					if (fromOpen == false) {
+						m_set->ceilingPosition(fromElement, &m_node, &m_index);
+
+					} else {
+						m_node = m_set->m_root->firstLeaf();
+						m_index = 0;
+					}
+				}
+			}
+
+			// XXX: fills up to count elements and returns how many were filled, zero once the range is exhausted
+			int nextBatch(E* elems, int count) {
+				boolean bounded = (m_toOpen == false);
+				int filled = 0;
+
+				while ((m_node != null) && (filled < count)) {
+					if (m_node->isLeaf() == true) {
+						Leaf* leaf = (Leaf*) m_node;
+						int last = leaf->m_lastIndex;
+						if ((last - m_index) >= (count - filled)) {
+							last = m_index + (count - filled) - 1;
+						}
+
+						boolean inside = (bounded == false) || (m_set->m_comparator->compare(leaf->getObject(last), m_toElement) < 0);
+						for (; m_index <= last; m_index++) {
+							E elem = leaf->getObject(m_index);
+							if ((inside == false) && (m_set->m_comparator->compare(elem, m_toElement) >= 0)) {
+								m_node = null;
+								return filled;
+							}
+
+							elems[filled++] = elem;
+						}
+
+						if (m_index > leaf->m_lastIndex) {
+							m_set->nextElement(leaf, leaf->m_lastIndex, &m_node, &m_index);
+						}
+
+					} else {
+						E elem = ((Branch*) m_node)->getObject(m_index);
+						if ((bounded == true) && (m_set->m_comparator->compare(elem, m_toElement) >= 0)) {
+							m_node = null;
+							break;
+						}
+
+						elems[filled++] = elem;
+						m_set->nextElement(m_node, m_index, &m_node, &m_index);
+					}
+				}
+
+				return filled;
+			}
+
+		friend class TreeSet;
+	};
+
+	friend class RangeCursor;
+
 	class KeySet;
 
 	class KeySetIterator: public Iterator<E> {
 
 		private:
-			TreeSet<E,Cmp>* m_set;
+			TreeSet<E,Cmp,Pol>* m_set;
 			Node* m_startNode;
 			Node* m_endNode;
 			E m_elem;
@@ -488,30 +656,28 @@ class TreeSet : /* public NavigableSet */ public SortedSet<E> {
 				m_endIndex(-1) {
 			}
 
-			KeySetIterator(TreeSet<E,Cmp>* set) :
+			KeySetIterator(TreeSet<E,Cmp,Pol>* set) :
 				m_elem(Set<E>::NULL_VALUE) {
 				reset(set);
 			}
 
-			KeySetIterator(TreeSet<E,Cmp>* set, Node* startNode, int startIndex, Node* endNode, int endIndex) :
+			KeySetIterator(TreeSet<E,Cmp,Pol>* set, Node* startNode, int startIndex, Node* endNode, int endIndex) :
 				m_elem(Set<E>::NULL_VALUE) {
 				reset(set, startNode, startIndex, endNode, endIndex);
 			}
 
-			void reset(TreeSet<E,Cmp>* set) {
+			void reset(TreeSet<E,Cmp,Pol>* set) {
 				reset(set, null, -1);
 			}
 
-			void reset(TreeSet<E,Cmp>* set, Node* endNode, int endIndex) {
+			void reset(TreeSet<E,Cmp,Pol>* set, Node* endNode, int endIndex) {
 				reset(set, null, -1, endNode, endIndex);
 			}
 
-			void reset(TreeSet<E,Cmp>* set, Node* startNode, int startIndex, Node* endNode, int endIndex) {
+			void reset(TreeSet<E,Cmp,Pol>* set, Node* startNode, int startIndex, Node* endNode, int endIndex) {
 				if (startNode == null) {
 					m_startNode = set->m_root;
-					if (m_startNode != null) {
-						m_startIndex = m_startNode->isLeaf() ? -1 : 0;
-					}
+					m_startIndex = ((m_startNode != null) && (m_startNode->isLeaf() == false)) ? 0 : -1;
 
 				} else {
 					m_startNode = startNode;
@@ -581,30 +747,30 @@ class TreeSet : /* public NavigableSet */ public SortedSet<E> {
 
 			KeySet();
 
-			KeySet(TreeSet<E,Cmp>* set):
+			KeySet(TreeSet<E,Cmp,Pol>* set):
 				m_reuse(false) {
 				reset(set);
 			}
 
-			KeySet(TreeSet<E,Cmp>* set, Node* endNode, int endIndex):
+			KeySet(TreeSet<E,Cmp,Pol>* set, Node* endNode, int endIndex):
 				m_reuse(false) {
 				reset(set, endNode, endIndex);
 			}
 
-			KeySet(TreeSet<E,Cmp>* set, Node* startNode, int startIndex, Node* endNode, int endIndex):
+			KeySet(TreeSet<E,Cmp,Pol>* set, Node* startNode, int startIndex, Node* endNode, int endIndex):
 				m_reuse(false) {
 				reset(set, startNode, startIndex, endNode, endIndex);
 			}
 
-			void reset(TreeSet<E,Cmp>* set) {
+			void reset(TreeSet<E,Cmp,Pol>* set) {
 				reset(set, null, -1);
 			}
 
-			void reset(TreeSet<E,Cmp>* set, Node* endNode, int endIndex) {
+			void reset(TreeSet<E,Cmp,Pol>* set, Node* endNode, int endIndex) {
 				reset(set, null, -1, endNode, endIndex);
 			}
 
-			void reset(TreeSet<E,Cmp>* set, Node* startNode, int startIndex, Node* endNode, int endIndex) {
+			void reset(TreeSet<E,Cmp,Pol>* set, Node* startNode, int startIndex, Node* endNode, int endIndex) {
 				if (startNode == null) {
 					m_startNode = set->m_root;
 					if (m_startNode != null) {
@@ -665,8 +831,8 @@ class TreeSet : /* public NavigableSet */ public SortedSet<E> {
 			virtual boolean contains(const E elem) const {
 				boolean status = false;
 
-				inttype firstCmp = TreeSet<E,Cmp>::COMPARATOR.compare(elem, first());
-				inttype lastCmp = TreeSet<E,Cmp>::COMPARATOR.compare(elem, last());
+				inttype firstCmp = TreeSet<E,Cmp,Pol>::COMPARATOR.compare(elem, first());
+				inttype lastCmp = TreeSet<E,Cmp,Pol>::COMPARATOR.compare(elem, last());
 				if ((firstCmp >= 0) && (lastCmp <= 0)) {
 					status = m_iterator.m_set->contains(elem);
 				}
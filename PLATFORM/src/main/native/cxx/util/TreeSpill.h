@@ -0,0 +1,182 @@
+/**
+ *    Copyright (C) 2010 Deep Software Foundation
+ *
+ *    This program is free software: you can redistribute it and/or  modify
+ *    it under the terms of the GNU Affero General Public License, version 3,
+ *    as published by the Free Software Foundation.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU Affero General Public License for more details.
+ *
+ *    You should have received a copy of the GNU Affero General Public License
+ *    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *    As a special exception, the copyright holders give permission to link the
+ *    code of portions of this program with the OpenSSL library under certain
+ *    conditions as described in each individual source file and distribute
+ *    linked combinations including the program with the OpenSSL library. You
+ *    must comply with the GNU Affero General Public License in all respects for
+ *    all of the code used other than as permitted herein. If you modify file(s)
+ *    with this exception, you may extend this exception to your version of the
+ *    file(s), but you are not obligated to do so. If you do not wish to do so,
+ *    delete this exception statement from your version. If you delete this
+ *    exception statement from all source files in the program, then also delete
+ *    it in the license file.
+ */
+#ifndef CXX_UTIL_TREESPILL_H_
+#define CXX_UTIL_TREESPILL_H_
+
+#include <stdlib.h>
+
+#include "cxx/lang/nbyte.h"
+
+#include "cxx/io/RandomAccessFile.h"
+
+#include "cxx/util/SlabPool.h"
+
+using namespace cxx::io;
+
+namespace cxx { namespace util {
+
+class TreeSpill;
+
+// XXX: stands in for the entry array of a spilled leaf, naming the page that holds it
+struct TreeSpillPage {
+	TreeSpill* m_spill;
+	longtype m_page;
+};
+
+/**
+ * Backing file of TreeMap leaves evicted under memory pressure (see TreePolicy::SPILL_LEAVES). Every leaf entry
+ * array has the same size, so the file is an array of fixed pages and released pages are reused before it grows.
+ * Pages hold raw entry bytes, they are only meant to be read back by the process that wrote them. Not thread
+ * safe, the owning map serializes access.
+ */
+class TreeSpill {
+
+	private:
+		static const inttype FREE_INITIAL = 64;
+
+		// XXX: allocator statistics are not free, the owner samples them once per interval of modifications
+		static const uinttype SAMPLE_INTERVAL = 1024;
+
+		RandomAccessFile m_file;
+		SlabPool m_stubs;
+		inttype m_pageSize;
+
+		longtype m_pages;
+		longtype* m_free;
+		inttype m_freeCount;
+		inttype m_freeCapacity;
+
+		ulongtype m_highWater;
+		ulongtype m_lowWater;
+		uinttype m_ticks;
+
+		longtype m_spills;
+		longtype m_faults;
+
+	public:
+		TreeSpill(const char* path, inttype pageSize, ulongtype highWater, ulongtype lowWater):
+			m_file(path, "rw"),
+			m_stubs(sizeof(TreeSpillPage)),
+			m_pageSize(pageSize),
+			m_pages(0),
+			m_free((longtype*) malloc(FREE_INITIAL * sizeof(longtype))),
+			m_freeCount(0),
+			m_freeCapacity(FREE_INITIAL),
+			m_highWater(highWater),
+			m_lowWater(lowWater),
+			m_ticks(0),
+			m_spills(0),
+			m_faults(0) {
+
+			m_file.setLength(0);
+		}
+
+		~TreeSpill(void) {
+			free(m_free);
+			m_file.close();
+		}
+
+		TreeSpillPage* write(const void* data) {
+			longtype page = (m_freeCount > 0) ? m_free[--m_freeCount] : m_pages++;
+
+			// XXX: reads and writes share the stream, always reposition between them
+			nbyte bytes((voidarray) data, m_pageSize);
+			m_file.seek(page * m_pageSize, -1, true /* force */);
+			m_file.write(&bytes, 0, m_pageSize);
+
+			TreeSpillPage* stub = (TreeSpillPage*) m_stubs.allocate();
+			stub->m_spill = this;
+			stub->m_page = page;
+
+			m_spills++;
+
+			return stub;
+		}
+
+		// XXX: the page is free again once read, the leaf takes a fresh one when it is evicted next
+		void read(TreeSpillPage* stub, void* data) {
+			nbyte bytes((voidarray) data, m_pageSize);
+			m_file.seek(stub->m_page * m_pageSize, -1, true /* force */);
+			m_file.readFully(&bytes, 0, m_pageSize);
+
+			m_faults++;
+
+			release(stub);
+		}
+
+		void release(TreeSpillPage* stub) {
+			if (m_freeCount == m_freeCapacity) {
+				m_freeCapacity *= 2;
+				m_free = (longtype*) realloc(m_free, m_freeCapacity * sizeof(longtype));
+			}
+
+			m_free[m_freeCount++] = stub->m_page;
+			m_stubs.release(stub);
+		}
+
+		// XXX: only once every stub has been released (i.e. the map was cleared)
+		void clear(void) {
+			m_stubs.clear();
+			m_pages = 0;
+			m_freeCount = 0;
+
+			m_file.setLength(0);
+		}
+
+		FORCE_INLINE boolean sample(void) {
+			return ((++m_ticks & (SAMPLE_INTERVAL - 1)) == 0);
+		}
+
+		FORCE_INLINE inttype getPageSize(void) const {
+			return m_pageSize;
+		}
+
+		FORCE_INLINE ulongtype getHighWater(void) const {
+			return m_highWater;
+		}
+
+		FORCE_INLINE ulongtype getLowWater(void) const {
+			return m_lowWater;
+		}
+
+		FORCE_INLINE longtype getSpilledPages(void) const {
+			return m_pages - m_freeCount;
+		}
+
+		FORCE_INLINE longtype getSpills(void) const {
+			return m_spills;
+		}
+
+		FORCE_INLINE longtype getFaults(void) const {
+			return m_faults;
+		}
+};
+
+} } // namespace
+
+#endif /*CXX_UTIL_TREESPILL_H_*/
@@ -0,0 +1,756 @@
+/**
+ *    Copyright (C) 2010 Deep Software Foundation
+ *
+ *    This program is free software: you can redistribute it and/or  modify
+ *    it under the terms of the GNU Affero General Public License, version 3,
+ *    as published by the Free Software Foundation.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU Affero General Public License for more details.
+ *
+ *    You should have received a copy of the GNU Affero General Public License
+ *    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *    As a special exception, the copyright holders give permission to link the
+ *    code of portions of this program with the OpenSSL library under certain
+ *    conditions as described in each individual source file and distribute
+ *    linked combinations including the program with the OpenSSL library. You
+ *    must comply with the GNU Affero General Public License in all respects for
+ *    all of the code used other than as permitted herein. If you modify file(s)
+ *    with this exception, you may extend this exception to your version of the
+ *    file(s), but you are not obligated to do so. If you do not wish to do so,
+ *    delete this exception statement from your version. If you delete this
+ *    exception statement from all source files in the program, then also delete
+ *    it in the license file.
+ */
+#ifndef CXX_UTIL_CONCURRENT_CONCURRENTTREEMAP_H_
+#define CXX_UTIL_CONCURRENT_CONCURRENTTREEMAP_H_
+
+#include <string.h>
+
+#include "cxx/lang/Object.h"
+
+#include "cxx/util/Comparator.h"
+#include "cxx/util/Iterator.h"
+#include "cxx/util/MapEntry.h"
+
+#include "cxx/util/concurrent/atomic/AtomicInteger.h"
+#include "cxx/util/concurrent/locks/Lock.h"
+
+using namespace cxx::lang;
+using namespace cxx::util::concurrent::atomic;
+using namespace cxx::util::concurrent::locks;
+
+namespace cxx { namespace util { namespace concurrent {
+
+/*
+ * XXX: B-link flavor of the tree map, entries live in leaves and every node carries a version latch, a high key
+ *      and a right sibling link. Readers never write shared memory: they validate node versions and restart on
+ *      change, and a reader landing left of a concurrent split follows the right link instead of restarting.
+ *      Writers descend optimistically, latch only the nodes they modify and propagate splits bottom-up (child
+ *      before parent, left before right). Latch versions are read with acquire ordering and new nodes are
+ *      published through release stores of the sibling and root links, so the map holds on weakly ordered
+ *      targets as well as on x86.
+ *
+ *      Removal does not merge, borrow into or unlink nodes: a leaf emptied by removes stays in the sibling chain
+ *      and keeps its allocation, so delete-heavy workloads grow the node count until clear() or the destructor
+ *      reclaims everything. Neither of those may run concurrently with readers, writers or live iterators.
+ */
+template<typename K, typename V, typename Ctx = void*>
+class ConcurrentTreeMap : public Object {
+
+	private:
+		static const inttype MAX_LEVELS = 32;
+
+		class Node {
+			public:
+				// XXX: odd while write latched, bumped on every latch and release
+				volatile ulongtype m_version;
+				Node* volatile m_right;
+				K m_highKey;
+				volatile inttype m_count;
+				const ubytetype m_level;
+				K* m_keys;
+
+			public:
+				Node(inttype order, ubytetype level):
+					m_version(0),
+					m_right(null),
+					m_highKey((K) Converter<K>::NULL_VALUE),
+					m_count(0),
+					m_level(level),
+					m_keys(new K[order]) {
+				}
+
+				~Node() {
+					delete [] m_keys;
+				}
+
+				// XXX: pairs with publish(), a node reached through a loaded link is fully initialized on weakly ordered targets
+				template<typename N>
+				FORCE_INLINE static N* acquire(N* volatile const* link) {
+					return __atomic_load_n(link, __ATOMIC_ACQUIRE);
+				}
+
+				template<typename N>
+				FORCE_INLINE static void publish(N* volatile* link, N* node) {
+					__atomic_store_n(link, node, __ATOMIC_RELEASE);
+				}
+
+				FORCE_INLINE ulongtype readLock(boolean* restart) const {
+					ulongtype version = __atomic_load_n(&m_version, __ATOMIC_ACQUIRE);
+
+					if ((version & 1) != 0) {
+						*restart = true;
+					}
+
+					return version;
+				}
+
+				// XXX: the acquire fence keeps the optimistic reads above from sinking below the version re-read
+				FORCE_INLINE void validate(ulongtype version, boolean* restart) const {
+					__atomic_thread_fence(__ATOMIC_ACQUIRE);
+
+					if (__atomic_load_n(&m_version, __ATOMIC_RELAXED) != version) {
+						*restart = true;
+					}
+				}
+
+				// XXX: a full barrier (__sync), node writes made under the latch cannot become visible before the odd version
+				FORCE_INLINE boolean upgrade(ulongtype version) {
+					return __sync_bool_compare_and_swap(&m_version, version, version + 1);
+				}
+
+				FORCE_INLINE void writeLock(void) {
+					uinttype state = 1;
+					for (;;) {
+						ulongtype version = m_version;
+						if (((version & 1) == 0) && (upgrade(version) == true)) {
+							break;
+						}
+
+						Lock::yield(&state);
+					}
+				}
+
+				// XXX: a full barrier (__sync), node writes made under the latch are visible before the new even version that
+				//      readLock acquires
+				FORCE_INLINE void writeUnlock(void) {
+					__sync_fetch_and_add(&m_version, 1);
+				}
+
+				FORCE_INLINE boolean isLeaf(void) const {
+					return m_level == 0;
+				}
+
+				FORCE_INLINE inttype lowerBound(const Comparator<K>* comparator, const K key, inttype count) const {
+					inttype lo = 0;
+					inttype hi = count;
+					while (lo < hi) {
+						inttype mid = (lo + hi) >> 1;
+						if (comparator->compare(m_keys[mid], key) < 0) {
+							lo = mid + 1;
+
+						} else {
+							hi = mid;
+						}
+					}
+
+					return lo;
+				}
+
+				FORCE_INLINE inttype upperBound(const Comparator<K>* comparator, const K key, inttype count) const {
+					inttype lo = 0;
+					inttype hi = count;
+					while (lo < hi) {
+						inttype mid = (lo + hi) >> 1;
+						if (comparator->compare(key, m_keys[mid]) >= 0) {
+							lo = mid + 1;
+
+						} else {
+							hi = mid;
+						}
+					}
+
+					return lo;
+				}
+		};
+
+		class Branch : public Node {
+			public:
+				Node** m_children;
+
+			public:
+				Branch(inttype order, ubytetype level):
+					Node(order, level),
+					m_children(new Node*[order + 1]) {
+				}
+
+				~Branch() {
+					delete [] m_children;
+				}
+
+				// XXX: separator goes to key index, its right child just after it
+				void insert(inttype index, const K key, Node* child) {
+					for (inttype i = Node::m_count; i > index; i--) {
+						Node::m_keys[i] = Node::m_keys[i - 1];
+						m_children[i + 1] = m_children[i];
+					}
+
+					Node::m_keys[index] = key;
+					m_children[index + 1] = child;
+					Node::m_count++;
+				}
+		};
+
+		class Leaf : public Node {
+			public:
+				V* m_values;
+
+			public:
+				Leaf(inttype order):
+					Node(order, 0),
+					m_values(new V[order]) {
+				}
+
+				~Leaf() {
+					delete [] m_values;
+				}
+
+				void insert(inttype index, const K key, const V val) {
+					for (inttype i = Node::m_count; i > index; i--) {
+						Node::m_keys[i] = Node::m_keys[i - 1];
+						m_values[i] = m_values[i - 1];
+					}
+
+					Node::m_keys[index] = key;
+					m_values[index] = val;
+					Node::m_count++;
+				}
+
+				void remove(inttype index) {
+					for (inttype i = index + 1; i < Node::m_count; i++) {
+						Node::m_keys[i - 1] = Node::m_keys[i];
+						m_values[i - 1] = m_values[i];
+					}
+
+					Node::m_count--;
+				}
+		};
+
+	public:
+		class EntryIterator : public Iterator<MapEntry<K,V,Ctx>*> {
+			private:
+				typedef MapEntry<K,V,Ctx>* Entry;
+
+				ConcurrentTreeMap* m_map;
+				K* m_keys;
+				V* m_values;
+				inttype m_index;
+				inttype m_count;
+				Leaf* m_next;
+				boolean m_bounded;
+				boolean m_hasLast;
+				K m_lastKey;
+				MapEntry<K,V,Ctx> m_entry;
+
+				// XXX: copy a validated snapshot of one leaf, resuming after the last returned key
+				void fill(Leaf* leaf, boolean bounded, const K bound, boolean inclusive) {
+					for (uinttype state = 1; ; Lock::yield(&state)) {
+						boolean restart = false;
+
+						ulongtype version = leaf->readLock(&restart);
+						if (restart == true) {
+							continue;
+						}
+
+						inttype count = leaf->m_count;
+						if (count > m_map->m_order) {
+							continue;
+						}
+
+						inttype start = 0;
+						if (bounded == true) {
+							start = (inclusive == true) ? leaf->lowerBound(m_map->m_comparator, bound, count) : leaf->upperBound(m_map->m_comparator, bound, count);
+						}
+
+						for (inttype i = start; i < count; i++) {
+							m_keys[i - start] = leaf->m_keys[i];
+							m_values[i - start] = leaf->m_values[i];
+						}
+
+						Leaf* right = (Leaf*) Node::acquire(&leaf->m_right);
+
+						leaf->validate(version, &restart);
+						if (restart == true) {
+							continue;
+						}
+
+						m_index = 0;
+						m_count = count - start;
+						m_next = right;
+						break;
+					}
+				}
+
+			public:
+				EntryIterator(ConcurrentTreeMap* map, Leaf* leaf, boolean bounded, const K startKey):
+					m_map(map),
+					m_keys(new K[map->m_order]),
+					m_values(new V[map->m_order]),
+					m_index(0),
+					m_count(0),
+					m_next(null),
+					m_bounded(bounded),
+					m_hasLast(false),
+					m_lastKey(startKey),
+					m_entry((K) Converter<K>::NULL_VALUE, (V) Converter<V>::NULL_VALUE, Ctx()) {
+
+					fill(leaf, m_bounded, m_lastKey, true);
+				}
+
+				virtual ~EntryIterator() {
+					delete [] m_keys;
+					delete [] m_values;
+				}
+
+				virtual boolean hasNext() {
+					// XXX: leaves may have split since the last copy, keep bounding by the start or last returned key
+					while ((m_index >= m_count) && (m_next != null)) {
+						fill(m_next, m_bounded, m_lastKey, m_hasLast == false);
+					}
+
+					return (m_index < m_count);
+				}
+
+				virtual const Entry next() {
+					if (hasNext() == false) {
+						return null;
+					}
+
+					m_entry.setKey(m_keys[m_index], Ctx());
+					m_entry.setValue(m_values[m_index], Ctx());
+
+					m_lastKey = m_keys[m_index++];
+					m_bounded = true;
+					m_hasLast = true;
+
+					return &m_entry;
+				}
+
+				virtual void remove() {
+					if (m_hasLast == true) {
+						m_map->remove(m_lastKey);
+					}
+				}
+		};
+
+	friend class EntryIterator;
+
+	private:
+		Node* volatile m_root;
+		Leaf* m_head;
+		const Comparator<K>* m_comparator;
+		const inttype m_order;
+		AtomicInteger m_size;
+
+		static const Comparator<K> COMPARATOR;
+
+	private:
+		// XXX: optimistic descent to the node at level covering key, recording the branches passed on the way
+		Node* descend(const K key, ubytetype level, Node** path, ulongtype* retversion, boolean* restart) const {
+			Node* node = Node::acquire(&m_root);
+
+			ulongtype version = node->readLock(restart);
+			if (*restart == true) {
+				return null;
+			}
+
+			for (;;) {
+				Node* right = Node::acquire(&node->m_right);
+				if ((right != null) && (m_comparator->compare(key, node->m_highKey) >= 0)) {
+					node->validate(version, restart);
+					if (*restart == true) {
+						return null;
+					}
+
+					node = right;
+					version = node->readLock(restart);
+					if (*restart == true) {
+						return null;
+					}
+
+					continue;
+				}
+
+				if (node->m_level == level) {
+					break;
+				}
+
+				if (path != null) {
+					path[node->m_level] = node;
+				}
+
+				Branch* branch = (Branch*) node;
+				inttype count = branch->m_count;
+				if (count > m_order) {
+					*restart = true;
+					return null;
+				}
+
+				Node* child = branch->m_children[branch->upperBound(m_comparator, key, count)];
+
+				branch->validate(version, restart);
+				if (*restart == true) {
+					return null;
+				}
+
+				node = child;
+				version = node->readLock(restart);
+				if (*restart == true) {
+					return null;
+				}
+			}
+
+			*retversion = version;
+			return node;
+		}
+
+		// XXX: called with left write latched, which also guards the root while left is the root
+		void insertParent(Node** path, Node* left, const K key, Node* right) {
+			ubytetype level = left->m_level + 1;
+
+			if (m_root == left) {
+				Branch* root = new Branch(m_order, level);
+				root->m_keys[0] = key;
+				root->m_children[0] = left;
+				root->m_children[1] = right;
+				root->m_count = 1;
+
+				Node::publish(&m_root, (Node*) root);
+				return;
+			}
+
+			Branch* parent = (Branch*) path[level];
+			for (uinttype state = 1; parent == null; Lock::yield(&state)) {
+				boolean restart = false;
+				ulongtype version;
+				parent = (Branch*) descend(key, level, null, &version, &restart);
+			}
+
+			parent->writeLock();
+			while ((parent->m_right != null) && (m_comparator->compare(key, parent->m_highKey) >= 0)) {
+				Branch* next = (Branch*) parent->m_right;
+				next->writeLock();
+				parent->writeUnlock();
+				parent = next;
+			}
+
+			inttype index = parent->upperBound(m_comparator, key, parent->m_count);
+			if (parent->m_count < m_order) {
+				parent->insert(index, key, right);
+				parent->writeUnlock();
+				return;
+			}
+
+			inttype count = parent->m_count;
+			inttype mid = count / 2;
+			K up = parent->m_keys[mid];
+
+			Branch* sibling = new Branch(m_order, level);
+			for (inttype i = mid + 1; i < count; i++) {
+				sibling->m_keys[i - mid - 1] = parent->m_keys[i];
+			}
+			for (inttype i = mid + 1; i <= count; i++) {
+				sibling->m_children[i - mid - 1] = parent->m_children[i];
+			}
+			sibling->m_count = count - mid - 1;
+			sibling->m_highKey = parent->m_highKey;
+			sibling->m_right = parent->m_right;
+
+			parent->m_count = mid;
+			if (index <= mid) {
+				parent->insert(index, key, right);
+
+			} else {
+				sibling->insert(index - mid - 1, key, right);
+			}
+
+			parent->m_highKey = up;
+			Node::publish(&parent->m_right, (Node*) sibling);
+
+			insertParent(path, parent, up, sibling);
+			parent->writeUnlock();
+		}
+
+		void destroy(void) {
+			Node* first = m_root;
+			while (first != null) {
+				Node* down = (first->isLeaf() == false) ? ((Branch*) first)->m_children[0] : null;
+
+				Node* node = first;
+				while (node != null) {
+					Node* right = node->m_right;
+					if (node->isLeaf() == true) {
+						delete (Leaf*) node;
+
+					} else {
+						delete (Branch*) node;
+					}
+					node = right;
+				}
+
+				first = down;
+			}
+		}
+
+	public:
+		static const inttype INITIAL_ORDER = 64;
+
+	public:
+		ConcurrentTreeMap(const Comparator<K>* comparator = &COMPARATOR, inttype order = INITIAL_ORDER):
+			m_comparator(comparator),
+			m_order((order < 4) ? 4 : order) {
+
+			m_head = new Leaf(m_order);
+			m_root = m_head;
+		}
+
+		virtual ~ConcurrentTreeMap() {
+			destroy();
+		}
+
+		V put(K key, V val, K* retkey, boolean* status) {
+			Node* path[MAX_LEVELS];
+
+			for (uinttype state = 1; ; Lock::yield(&state)) {
+				boolean restart = false;
+				ulongtype version;
+
+				memset(path, 0, sizeof(path));
+				Leaf* leaf = (Leaf*) descend(key, 0, path, &version, &restart);
+				if ((restart == true) || (leaf->upgrade(version) == false)) {
+					continue;
+				}
+
+				inttype count = leaf->m_count;
+				inttype index = leaf->lowerBound(m_comparator, key, count);
+				if ((index < count) && (m_comparator->compare(leaf->m_keys[index], key) == 0)) {
+					V old = leaf->m_values[index];
+					if (retkey != null) {
+						*retkey = leaf->m_keys[index];
+					}
+
+					leaf->m_keys[index] = key;
+					leaf->m_values[index] = val;
+					leaf->writeUnlock();
+
+					if (status != null) {
+						*status = true;
+					}
+
+					return old;
+				}
+
+				if (count < m_order) {
+					leaf->insert(index, key, val);
+					leaf->writeUnlock();
+
+				} else {
+					inttype half = count / 2;
+
+					Leaf* sibling = new Leaf(m_order);
+					for (inttype i = half; i < count; i++) {
+						sibling->m_keys[i - half] = leaf->m_keys[i];
+						sibling->m_values[i - half] = leaf->m_values[i];
+					}
+					sibling->m_count = count - half;
+					sibling->m_highKey = leaf->m_highKey;
+					sibling->m_right = leaf->m_right;
+
+					K separator = sibling->m_keys[0];
+
+					leaf->m_count = half;
+					if (index <= half) {
+						leaf->insert(index, key, val);
+
+					} else {
+						sibling->insert(index - half, key, val);
+					}
+
+					leaf->m_highKey = separator;
+					Node::publish(&leaf->m_right, (Node*) sibling);
+
+					insertParent(path, leaf, separator, sibling);
+					leaf->writeUnlock();
+				}
+
+				m_size.incrementAndGet();
+
+				if (status != null) {
+					*status = false;
+				}
+
+				return (V) Converter<V>::NULL_VALUE;
+			}
+		}
+
+		V put(K key, V val) {
+			return put(key, val, null, null);
+		}
+
+		const V get(const K key, K* retkey, boolean* status) const {
+			for (uinttype state = 1; ; Lock::yield(&state)) {
+				boolean restart = false;
+				ulongtype version;
+
+				Leaf* leaf = (Leaf*) descend(key, 0, null, &version, &restart);
+				if (restart == true) {
+					continue;
+				}
+
+				inttype count = leaf->m_count;
+				if (count > m_order) {
+					continue;
+				}
+
+				inttype index = leaf->lowerBound(m_comparator, key, count);
+				boolean found = (index < count) && (m_comparator->compare(leaf->m_keys[index], key) == 0);
+
+				K k = (found == true) ? leaf->m_keys[index] : (K) Converter<K>::NULL_VALUE;
+				V v = (found == true) ? leaf->m_values[index] : (V) Converter<V>::NULL_VALUE;
+
+				leaf->validate(version, &restart);
+				if (restart == true) {
+					continue;
+				}
+
+				if (retkey != null) {
+					*retkey = k;
+				}
+
+				if (status != null) {
+					*status = found;
+				}
+
+				return v;
+			}
+		}
+
+		const V get(const K key) const {
+			return get(key, null, null);
+		}
+
+		boolean containsKey(const K key) const {
+			boolean status;
+			get(key, null, &status);
+
+			return status;
+		}
+
+		V remove(const K key, K* retkey, boolean* status) {
+			for (uinttype state = 1; ; Lock::yield(&state)) {
+				boolean restart = false;
+				ulongtype version;
+
+				Leaf* leaf = (Leaf*) descend(key, 0, null, &version, &restart);
+				if (restart == true) {
+					continue;
+				}
+
+				inttype count = leaf->m_count;
+				if (count > m_order) {
+					continue;
+				}
+
+				inttype index = leaf->lowerBound(m_comparator, key, count);
+				boolean found = (index < count) && (m_comparator->compare(leaf->m_keys[index], key) == 0);
+
+				// XXX: misses never latch
+				if (found == false) {
+					leaf->validate(version, &restart);
+					if (restart == true) {
+						continue;
+					}
+
+					if (status != null) {
+						*status = false;
+					}
+
+					return (V) Converter<V>::NULL_VALUE;
+				}
+
+				if (leaf->upgrade(version) == false) {
+					continue;
+				}
+
+				V old = leaf->m_values[index];
+				if (retkey != null) {
+					*retkey = leaf->m_keys[index];
+				}
+
+				leaf->remove(index);
+				leaf->writeUnlock();
+
+				m_size.decrementAndGet();
+
+				if (status != null) {
+					*status = true;
+				}
+
+				return old;
+			}
+		}
+
+		V remove(const K key) {
+			return remove(key, null, null);
+		}
+
+		inttype size() const {
+			return m_size.get();
+		}
+
+		boolean isEmpty() const {
+			return (size() == 0);
+		}
+
+		// XXX: weakly consistent, each leaf is copied atomically and entries are returned in key order
+		Iterator<MapEntry<K,V,Ctx>*>* iterator(const K startKey) {
+			for (uinttype state = 1; ; Lock::yield(&state)) {
+				boolean restart = false;
+				ulongtype version;
+
+				Leaf* leaf = (Leaf*) descend(startKey, 0, null, &version, &restart);
+				if (restart == false) {
+					return new EntryIterator(this, leaf, true, startKey);
+				}
+			}
+		}
+
+		Iterator<MapEntry<K,V,Ctx>*>* iterator() {
+			// XXX: splits keep the left half in place, so the first leaf never moves
+			return new EntryIterator(this, m_head, false, (K) Converter<K>::NULL_VALUE);
+		}
+
+		// XXX: frees every node outright, the caller must exclude all readers, writers and iterators for the duration
+		void clear(void) {
+			destroy();
+
+			m_head = new Leaf(m_order);
+			m_root = m_head;
+			m_size.set(0);
+		}
+
+		inttype getOrder(void) const {
+			return m_order;
+		}
+};
+
+template<typename K, typename V, typename Ctx>
+const Comparator<K> ConcurrentTreeMap<K,V,Ctx>::COMPARATOR;
+
+} } } // namespace
+
+#endif /*CXX_UTIL_CONCURRENT_CONCURRENTTREEMAP_H_*/
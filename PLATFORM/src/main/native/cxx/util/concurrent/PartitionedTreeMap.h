@@ -0,0 +1,623 @@
+/**
+ *    Copyright (C) 2010 Deep Software Foundation
+ *
+ *    This program is free software: you can redistribute it and/or  modify
+ *    it under the terms of the GNU Affero General Public License, version 3,
+ *    as published by the Free Software Foundation.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU Affero General Public License for more details.
+ *
+ *    You should have received a copy of the GNU Affero General Public License
+ *    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *    As a special exception, the copyright holders give permission to link the
+ *    code of portions of this program with the OpenSSL library under certain
+ *    conditions as described in each individual source file and distribute
+ *    linked combinations including the program with the OpenSSL library. You
+ *    must comply with the GNU Affero General Public License in all respects for
+ *    all of the code used other than as permitted herein. If you modify file(s)
+ *    with this exception, you may extend this exception to your version of the
+ *    file(s), but you are not obligated to do so. If you do not wish to do so,
+ *    delete this exception statement from your version. If you delete this
+ *    exception statement from all source files in the program, then also delete
+ *    it in the license file.
+ */
+#ifndef CXX_UTIL_CONCURRENT_PARTITIONEDTREEMAP_H_
+#define CXX_UTIL_CONCURRENT_PARTITIONEDTREEMAP_H_
+
+#include <string.h>
+
+#include "cxx/lang/Object.h"
+#include "cxx/lang/UnsupportedOperationException.h"
+
+#include "cxx/util/Comparator.h"
+#include "cxx/util/Iterator.h"
+#include "cxx/util/MapEntry.h"
+#include "cxx/util/TreeMap.h"
+
+#include "cxx/util/concurrent/locks/Lock.h"
+#include "cxx/util/concurrent/locks/UserSpaceReadWriteLock.h"
+
+using namespace cxx::lang;
+using namespace cxx::util::concurrent::locks;
+
+namespace cxx { namespace util { namespace concurrent {
+
+/*
+ * XXX: range partitioned tree map, the key space is cut by N - 1 bounds into N TreeMap shards with a lock each, so
+ *      writers into disjoint key regions do not serialize. Shard i holds [bound[i - 1], bound[i]), the outer shards
+ *      are open ended. Routing reads the bounds optimistically under a version which resplit() makes odd while it
+ *      holds every shard lock; an operation that locked a shard and still sees the version it routed under is in
+ *      the right shard. Locks are always taken in ascending shard order.
+ */
+template<typename K, typename V, typename Ctx = void*, typename Pol = TreePolicy>
+class PartitionedTreeMap : public Object {
+
+	public:
+		typedef TreeMap<K,V,Ctx,Pol> Tree;
+
+	private:
+		class Shard {
+			public:
+				UserSpaceReadWriteLock m_lock;
+				Tree* m_map;
+
+				// XXX: keep the locks of neighbouring shards off each other's cache lines
+				bytetype m_pad[64];
+
+			public:
+				Shard():
+					m_map(null) {
+				}
+		};
+
+	public:
+		class EntryIterator : public Iterator<MapEntry<K,V,Ctx>*> {
+			private:
+				typedef MapEntry<K,V,Ctx>* Entry;
+
+				static const inttype BATCH = 64;
+
+				class Collect {
+					private:
+						EntryIterator* m_iter;
+
+					public:
+						Collect(EntryIterator* iter):
+							m_iter(iter) {
+						}
+
+						FORCE_INLINE boolean operator()(const MapEntry<K,V,Ctx>* x) {
+							if ((m_iter->m_inclusive == false) && (m_iter->m_map->m_comparator->compare(x->getKey(), m_iter->m_from) == 0)) {
+								return true;
+							}
+
+							m_iter->m_keys[m_iter->m_count] = x->getKey();
+							m_iter->m_values[m_iter->m_count] = x->getValue();
+
+							return (++m_iter->m_count < BATCH);
+						}
+				};
+
+				friend class Collect;
+
+				PartitionedTreeMap* m_map;
+				K m_keys[BATCH];
+				V m_values[BATCH];
+				inttype m_index;
+				inttype m_count;
+				K m_from;
+				boolean m_open;
+				boolean m_inclusive;
+				boolean m_done;
+				boolean m_hasLast;
+				K m_lastKey;
+				MapEntry<K,V,Ctx> m_entry;
+
+				// XXX: copy the next batch under one shard lock, an exhausted shard continues from its upper bound
+				// XXX: m_open alone says where to start, any key (-1 included) is a valid resume point
+				void fill(void) {
+					m_index = 0;
+					m_count = 0;
+
+					while (m_done == false) {
+						inttype index = m_map->acquire(m_from, m_open, false);
+
+						Collect collect(this);
+						m_map->m_shard[index].m_map->forEachInRange(m_from, m_open, m_from, true, collect);
+
+						boolean last = (index == m_map->m_active);
+						K bound = (last == true) ? (K) Converter<K>::NULL_VALUE : m_map->m_bounds[index];
+
+						m_map->release(index, false);
+
+						if (m_count > 0) {
+							break;
+						}
+
+						if (last == true) {
+							m_done = true;
+							break;
+						}
+
+						m_from = bound;
+						m_open = false;
+						m_inclusive = true;
+					}
+				}
+
+			public:
+				EntryIterator(PartitionedTreeMap* map, boolean open, const K startKey):
+					m_map(map),
+					m_index(0),
+					m_count(0),
+					m_from(startKey),
+					m_open(open),
+					m_inclusive(true),
+					m_done(false),
+					m_hasLast(false),
+					m_lastKey((K) Converter<K>::NULL_VALUE),
+					m_entry((K) Converter<K>::NULL_VALUE, (V) Converter<V>::NULL_VALUE, Ctx()) {
+				}
+
+				virtual ~EntryIterator() {
+				}
+
+				virtual boolean hasNext() {
+					if ((m_index >= m_count) && (m_done == false)) {
+						fill();
+					}
+
+					return (m_index < m_count);
+				}
+
+				virtual const Entry next() {
+					if (hasNext() == false) {
+						return null;
+					}
+
+					m_entry.setKey(m_keys[m_index], Ctx());
+					m_entry.setValue(m_values[m_index], Ctx());
+
+					m_lastKey = m_keys[m_index++];
+					m_from = m_lastKey;
+					m_open = false;
+					m_inclusive = false;
+					m_hasLast = true;
+
+					return &m_entry;
+				}
+
+				virtual void remove() {
+					if (m_hasLast == true) {
+						// XXX: refill while the last key is still alive, the removal may destroy it
+						hasNext();
+
+						m_map->remove(m_lastKey);
+						m_hasLast = false;
+					}
+				}
+		};
+
+	friend class EntryIterator;
+
+	private:
+		const Comparator<K>* m_comparator;
+		const inttype m_shards;
+		Shard* m_shard;
+		K* m_bounds;
+		volatile inttype m_active;
+		volatile ulongtype m_version;
+
+		#ifdef COM_DEEPIS_DB_CARDINALITY
+		const bytetype m_keyParts;
+		#endif
+
+		static const Comparator<K> COMPARATOR;
+
+	private:
+		FORCE_INLINE static void fence(void) {
+			__asm volatile ("" ::: "memory");
+		}
+
+		// XXX: number of bounds at or below key
+		FORCE_INLINE inttype route(const K key) const {
+			inttype lo = 0;
+			inttype hi = m_active;
+			while (lo < hi) {
+				inttype mid = (lo + hi) >> 1;
+				if (m_comparator->compare(key, m_bounds[mid]) >= 0) {
+					lo = mid + 1;
+
+				} else {
+					hi = mid;
+				}
+			}
+
+			return lo;
+		}
+
+		inttype acquire(const K key, boolean first, boolean write) const {
+			for (uinttype state = 1; ; Lock::yield(&state)) {
+				ulongtype version = m_version;
+				fence();
+
+				if ((version & 1) != 0) {
+					continue;
+				}
+
+				inttype index = (first == true) ? 0 : route(key);
+				if (write == true) {
+					m_shard[index].m_lock.writeLock();
+
+				} else {
+					m_shard[index].m_lock.readLock();
+				}
+
+				__sync_synchronize();
+				if (m_version == version) {
+					return index;
+				}
+
+				release(index, write);
+			}
+		}
+
+		FORCE_INLINE void release(inttype index, boolean write) const {
+			if (write == true) {
+				m_shard[index].m_lock.writeUnlock();
+
+			} else {
+				m_shard[index].m_lock.readUnlock();
+			}
+		}
+
+		void acquireAll(boolean write) const {
+			for (inttype i = 0; i < m_shards; i++) {
+				if (write == true) {
+					m_shard[i].m_lock.writeLock();
+
+				} else {
+					m_shard[i].m_lock.readLock();
+				}
+			}
+		}
+
+		void releaseAll(boolean write) const {
+			for (inttype i = m_shards - 1; i >= 0; i--) {
+				release(i, write);
+			}
+		}
+
+		FORCE_INLINE void move(Tree* from, const K key) {
+			K retkey;
+			boolean status;
+			V val = from->remove(key, &retkey, &status);
+
+			m_shard[route(retkey)].m_map->put(retkey, val);
+		}
+
+		void validate(const K* bounds) const {
+			for (inttype i = 0; i < m_shards - 2; i++) {
+				if (m_comparator->compare(bounds[i], bounds[i + 1]) >= 0) {
+					throw new UnsupportedOperationException("Partition bounds out of order");
+				}
+			}
+		}
+
+		// XXX: called with every shard write locked, entries left outside their shard move to wherever the new bounds route them
+		void rebound(const K* bounds) {
+			__sync_fetch_and_add(&m_version, 1);
+
+			for (inttype i = 0; i < m_shards - 1; i++) {
+				m_bounds[i] = bounds[i];
+			}
+			m_active = m_shards - 1;
+
+			for (inttype i = 0; i < m_shards; i++) {
+				Tree* map = m_shard[i].m_map;
+
+				while ((i > 0) && (map->size() != 0) && (m_comparator->compare(map->firstKey(), m_bounds[i - 1]) < 0)) {
+					move(map, map->firstKey());
+				}
+
+				while ((i < m_shards - 1) && (map->size() != 0) && (m_comparator->compare(map->lastKey(), m_bounds[i]) >= 0)) {
+					move(map, map->lastKey());
+				}
+			}
+
+			__sync_fetch_and_add(&m_version, 1);
+		}
+
+		void initialize(inttype order, boolean delkey, boolean delval) {
+			m_shard = new Shard[m_shards];
+			m_bounds = new K[m_shards];
+
+			for (inttype i = 0; i < m_shards; i++) {
+				#ifdef COM_DEEPIS_DB_CARDINALITY
+				m_shard[i].m_map = new Tree(m_comparator, order, delkey, delval, m_keyParts);
+				#else
+				m_shard[i].m_map = new Tree(m_comparator, order, delkey, delval);
+				#endif
+			}
+		}
+
+	public:
+		static const inttype INITIAL_SHARDS = 16;
+
+	public:
+		// XXX: bounds (shards - 1 ascending keys) are copied, pointer keys must outlive the map; without them every key stays in the first shard until resplit()
+		#ifdef COM_DEEPIS_DB_CARDINALITY
+		PartitionedTreeMap(const Comparator<K>* comparator = &COMPARATOR, inttype shards = INITIAL_SHARDS, const K* bounds = null, inttype order = Tree::INITIAL_ORDER, boolean delkey = false, boolean delval = false, bytetype keyParts = -1):
+		#else
+		PartitionedTreeMap(const Comparator<K>* comparator = &COMPARATOR, inttype shards = INITIAL_SHARDS, const K* bounds = null, inttype order = Tree::INITIAL_ORDER, boolean delkey = false, boolean delval = false):
+		#endif
+			m_comparator(comparator),
+			m_shards((shards < 1) ? 1 : shards),
+			m_shard(null),
+			m_bounds(null),
+			m_active(0),
+			m_version(0)
+			#ifdef COM_DEEPIS_DB_CARDINALITY
+			, m_keyParts(keyParts)
+			#endif
+			{
+
+			initialize(order, delkey, delval);
+
+			if (bounds != null) {
+				validate(bounds);
+				rebound(bounds);
+			}
+		}
+
+		virtual ~PartitionedTreeMap() {
+			for (inttype i = 0; i < m_shards; i++) {
+				delete m_shard[i].m_map;
+			}
+
+			delete [] m_shard;
+			delete [] m_bounds;
+		}
+
+		V put(K key, V val, K* retkey, boolean* status) {
+			inttype index = acquire(key, false, true);
+			V old = m_shard[index].m_map->put(key, val, retkey, status);
+			release(index, true);
+
+			return old;
+		}
+
+		V put(K key, V val) {
+			return put(key, val, null, null);
+		}
+
+		const V get(const K key, K* retkey, boolean* status) const {
+			inttype index = acquire(key, false, false);
+			V val = m_shard[index].m_map->get(key, retkey, status);
+			release(index, false);
+
+			return val;
+		}
+
+		const V get(const K key) const {
+			return get(key, null, null);
+		}
+
+		boolean containsKey(const K key) const {
+			boolean status;
+			get(key, null, &status);
+
+			return status;
+		}
+
+		V remove(const K key, K* retkey, boolean* status) {
+			inttype index = acquire(key, false, true);
+			V old = m_shard[index].m_map->remove(key, retkey, status);
+			release(index, true);
+
+			return old;
+		}
+
+		V remove(const K key) {
+			boolean status;
+			return remove(key, null, &status);
+		}
+
+		// XXX: sum of the shard sizes, each read under its own lock
+		inttype size() const {
+			inttype count = 0;
+			for (inttype i = 0; i < m_shards; i++) {
+				count += getShardSize(i);
+			}
+
+			return count;
+		}
+
+		boolean isEmpty() const {
+			return (size() == 0);
+		}
+
+		inttype getShardCount(void) const {
+			return m_shards;
+		}
+
+		inttype getShardSize(inttype index) const {
+			m_shard[index].m_lock.readLock();
+			inttype count = m_shard[index].m_map->size();
+			m_shard[index].m_lock.readUnlock();
+
+			return count;
+		}
+
+		// XXX: largest shard over the average shard, a cue for callers to resplit()
+		doubletype getSkew(void) const {
+			inttype total = 0;
+			inttype largest = 0;
+			for (inttype i = 0; i < m_shards; i++) {
+				inttype count = getShardSize(i);
+				if (count > largest) {
+					largest = count;
+				}
+
+				total += count;
+			}
+
+			return (total == 0) ? 1.0 : ((doubletype) largest * m_shards) / total;
+		}
+
+		// XXX: moves the bounds to the given keys (shards - 1 ascending, copied), stalls every operation while entries migrate
+		void resplit(const K* bounds) {
+			validate(bounds);
+
+			acquireAll(true);
+			rebound(bounds);
+			releaseAll(true);
+		}
+
+		// XXX: moves the bounds to the quantiles of the current keys so every shard ends up with an equal share
+		void resplit(void) {
+			if (m_shard[0].m_map->getDeleteKey() == true) {
+				throw new UnsupportedOperationException("Resplit of a map owning its keys");
+			}
+
+			acquireAll(true);
+
+			inttype total = 0;
+			for (inttype i = 0; i < m_shards; i++) {
+				total += m_shard[i].m_map->size();
+			}
+
+			// XXX: not enough keys for distinct bounds
+			if (total < m_shards) {
+				releaseAll(true);
+				return;
+			}
+
+			K* bounds = new K[m_shards];
+
+			inttype shard = 0;
+			inttype offset = 0;
+			for (inttype i = 1; i < m_shards; i++) {
+				inttype target = (inttype) (((longtype) total * i) / m_shards);
+				while (target - offset >= m_shard[shard].m_map->size()) {
+					offset += m_shard[shard++].m_map->size();
+				}
+
+				bounds[i - 1] = m_shard[shard].m_map->select(target - offset)->getKey();
+			}
+
+			rebound(bounds);
+
+			delete [] bounds;
+
+			releaseAll(true);
+		}
+
+		// XXX: weakly consistent, entries are copied in batches under one shard lock each and returned in key order across shards
+		Iterator<MapEntry<K,V,Ctx>*>* iterator(const K startKey) {
+			return new EntryIterator(this, false, startKey);
+		}
+
+		Iterator<MapEntry<K,V,Ctx>*>* iterator() {
+			return new EntryIterator(this, true, (K) Converter<K>::NULL_VALUE);
+		}
+
+		void clear(void) {
+			acquireAll(true);
+
+			for (inttype i = 0; i < m_shards; i++) {
+				m_shard[i].m_map->clear();
+			}
+
+			releaseAll(true);
+		}
+
+		#ifdef COM_DEEPIS_DB_CARDINALITY
+		void setCardinalityEnabled(boolean flag) {
+			acquireAll(true);
+
+			for (inttype i = 0; i < m_shards; i++) {
+				m_shard[i].m_map->setCardinalityEnabled(flag);
+			}
+
+			releaseAll(true);
+		}
+
+		void setCardinalitySketchEnabled(boolean flag) {
+			acquireAll(true);
+
+			for (inttype i = 0; i < m_shards; i++) {
+				m_shard[i].m_map->setCardinalitySketchEnabled(flag);
+			}
+
+			releaseAll(true);
+		}
+
+		// XXX: exact counts add up once each shard's first key is recounted against the last key of the shard before it,
+		//      sketches merge into one
+		void getCardinalityEstimate(inttype* cardinality) const {
+			if (m_keyParts < 2) {
+				return;
+			}
+
+			memset(cardinality, 0, m_keyParts * sizeof(inttype));
+
+			acquireAll(false);
+
+			if (m_shard[0].m_map->getCardinalitySketchEnabled() == true) {
+				Tree merged(m_comparator, Tree::INITIAL_ORDER, false, false, m_keyParts);
+				merged.setCardinalityEnabled(true);
+				merged.setCardinalitySketchEnabled(true);
+
+				for (inttype i = 0; i < m_shards; i++) {
+					merged.mergeCardinality(m_shard[i].m_map);
+				}
+
+				merged.getCardinalityEstimate(cardinality);
+
+			} else {
+				inttype* counts = new inttype[m_keyParts];
+
+				boolean previous = false;
+				K lastKey = (K) Converter<K>::NULL_VALUE;
+				for (inttype i = 0; i < m_shards; i++) {
+					Tree* map = m_shard[i].m_map;
+					if (map->size() == 0) {
+						continue;
+					}
+
+					map->getCardinalityEstimate(counts);
+					for (inttype j = 0; j < m_keyParts; j++) {
+						cardinality[j] += counts[j];
+					}
+
+					if (previous == true) {
+						inttype pos = 0;
+						m_comparator->compare(lastKey, map->firstKey(), &pos);
+
+						cardinality[0]--;
+						cardinality[pos]++;
+					}
+
+					previous = true;
+					lastKey = map->lastKey();
+				}
+
+				delete [] counts;
+			}
+
+			releaseAll(false);
+		}
+		#endif
+};
+
+template<typename K, typename V, typename Ctx, typename Pol>
+const Comparator<K> PartitionedTreeMap<K,V,Ctx,Pol>::COMPARATOR;
+
+} } } // namespace
+
+#endif /*CXX_UTIL_CONCURRENT_PARTITIONEDTREEMAP_H_*/
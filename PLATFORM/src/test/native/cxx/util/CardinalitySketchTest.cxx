@@ -0,0 +1,201 @@
+/**
+ *    Copyright (C) 2010 Deep Software Foundation
+ *
+ *    This program is free software: you can redistribute it and/or  modify
+ *    it under the terms of the GNU Affero General Public License, version 3,
+ *    as published by the Free Software Foundation.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU Affero General Public License for more details.
+ *
+ *    You should have received a copy of the GNU Affero General Public License
+ *    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *    As a special exception, the copyright holders give permission to link the
+ *    code of portions of this program with the OpenSSL library under certain
+ *    conditions as described in each individual source file and distribute
+ *    linked combinations including the program with the OpenSSL library. You
+ *    must comply with the GNU Affero General Public License in all respects for
+ *    all of the code used other than as permitted herein. If you modify file(s)
+ *    with this exception, you may extend this exception to your version of the
+ *    file(s), but you are not obligated to do so. If you do not wish to do so,
+ *    delete this exception statement from your version. If you delete this
+ *    exception statement from all source files in the program, then also delete
+ *    it in the license file.
+ */
+#include "cxx/lang/System.h"
+
+#include "cxx/util/Logger.h"
+
+#include "cxx/util/CardinalitySketch.h"
+
+using namespace cxx::lang;
+using namespace cxx::util;
+
+static boolean within(longtype estimate, longtype exact) {
+	// XXX: four standard errors at the default precision, small counts are exact up to a couple of collisions
+	longtype slack = (exact * 13 / 100) + 2;
+	return (estimate >= exact - slack) && (estimate <= exact + slack);
+}
+
+int testEstimate(void) {
+	longtype COUNTS[] = { 0, 1, 10, 100, 1000, 10000, 100000, 1000000 };
+
+	for (int c = 0; c < (int) (sizeof(COUNTS) / sizeof(longtype)); c++) {
+		CardinalitySketch sketch;
+
+		for (longtype i = 0; i < COUNTS[c]; i++) {
+			sketch.add(CardinalitySketch::mix(i));
+
+			// XXX: repeats must not count
+			if ((i % 3) == 0) {
+				sketch.add(CardinalitySketch::mix(i));
+			}
+		}
+
+		if (within(sketch.estimate(), COUNTS[c]) == false) {
+			DEEP_LOG(ERROR, OTHER, "FAILED - estimate: %lld, expected: %lld\n", sketch.estimate(), COUNTS[c]);
+			return 1;
+		}
+	}
+
+	DEEP_LOG(INFO, OTHER, "estimate matched\n");
+
+	return 0;
+}
+
+int testMerge(void) {
+	const longtype COUNT = 200000;
+
+	CardinalitySketch whole;
+	CardinalitySketch low;
+	CardinalitySketch high;
+
+	// XXX: overlapping halves, the union has COUNT distinct hashes
+	for (longtype i = 0; i < COUNT; i++) {
+		whole.add(CardinalitySketch::mix(i));
+
+		if (i < (COUNT * 2 / 3)) {
+			low.add(CardinalitySketch::mix(i));
+		}
+
+		if (i >= (COUNT / 3)) {
+			high.add(CardinalitySketch::mix(i));
+		}
+	}
+
+	low.merge(&high);
+	if ((low.estimate() != whole.estimate()) || (within(low.estimate(), COUNT) == false)) {
+		DEEP_LOG(ERROR, OTHER, "FAILED - merged: %lld, whole: %lld\n", low.estimate(), whole.estimate());
+		return 1;
+	}
+
+	low.clear();
+	if (low.estimate() != 0) {
+		DEEP_LOG(ERROR, OTHER, "FAILED - cleared: %lld\n", low.estimate());
+		return 1;
+	}
+
+	DEEP_LOG(INFO, OTHER, "merge matched\n");
+
+	return 0;
+}
+
+int testPrefixHash(void) {
+	Comparator<CompositeKey*> comparator;
+	comparator.addKeyPart(KeyPart::INTEGER);
+	comparator.addKeyPart(KeyPart::LONG);
+
+	CompositeKey k1(4 + 8);
+	CompositeKey k2(4 + 8);
+
+	inttype i = 7;
+	longtype l1 = 11;
+	longtype l2 = 12;
+	memcpy((bytearray) k1, &i, 4);
+	memcpy((bytearray) k1 + 4, &l1, 8);
+	memcpy((bytearray) k2, &i, 4);
+	memcpy((bytearray) k2 + 4, &l2, 8);
+
+	ulongtype h1[3];
+	ulongtype h2[3];
+	KeyPrefixHash<CompositeKey*>::hash(&comparator, &k1, h1, 3);
+	KeyPrefixHash<CompositeKey*>::hash(&comparator, &k2, h2, 3);
+
+	// XXX: shared first part, distinct keys, and prefixes past the schema repeat the whole key
+	if ((h1[0] != h2[0]) || (h1[1] == h2[1]) || (h1[1] != h1[2]) || (h2[1] != h2[2])) {
+		DEEP_LOG(ERROR, OTHER, "FAILED - composite prefix hash\n");
+		return 1;
+	}
+
+	ulongtype s1[2];
+	ulongtype s2[2];
+	KeyPrefixHash<longtype>::hash(null, 5, s1, 2);
+	KeyPrefixHash<longtype>::hash(null, 6, s2, 2);
+	if ((s1[0] != s1[1]) || (s1[0] == s2[0])) {
+		DEEP_LOG(ERROR, OTHER, "FAILED - scalar prefix hash\n");
+		return 1;
+	}
+
+	// XXX: equal under the comparator, different bytes: garbage past a string terminator and a negative zero
+	Comparator<CompositeKey*> mixed;
+	mixed.addKeyPart(KeyPart::STRING, 8);
+	mixed.addKeyPart(KeyPart::DOUBLE);
+	mixed.addKeyPart(KeyPart::FLOAT);
+
+	CompositeKey m1(8 + 8 + 4);
+	CompositeKey m2(8 + 8 + 4);
+	memcpy((bytearray) m1, "abc\0xyzw", 8);
+	memcpy((bytearray) m2, "abc\0\0\0\0\0", 8);
+
+	doubletype d1 = 0.0;
+	doubletype d2 = -0.0;
+	floattype f1 = -0.0f;
+	floattype f2 = 0.0f;
+	memcpy((bytearray) m1 + 8, &d1, 8);
+	memcpy((bytearray) m2 + 8, &d2, 8);
+	memcpy((bytearray) m1 + 16, &f1, 4);
+	memcpy((bytearray) m2 + 16, &f2, 4);
+
+	ulongtype e1[3];
+	ulongtype e2[3];
+	KeyPrefixHash<CompositeKey*>::hash(&mixed, &m1, e1, 3);
+	KeyPrefixHash<CompositeKey*>::hash(&mixed, &m2, e2, 3);
+	if ((mixed.compare(&m1, &m2) != 0) || (memcmp(e1, e2, sizeof(e1)) != 0)) {
+		DEEP_LOG(ERROR, OTHER, "FAILED - equal composite keys hash apart\n");
+		return 1;
+	}
+
+	// XXX: the terminator still separates strings that do differ
+	memcpy((bytearray) m2, "abcd\0\0\0\0", 8);
+	KeyPrefixHash<CompositeKey*>::hash(&mixed, &m2, e2, 3);
+	if (e1[0] == e2[0]) {
+		DEEP_LOG(ERROR, OTHER, "FAILED - distinct strings hash together\n");
+		return 1;
+	}
+
+	DEEP_LOG(INFO, OTHER, "prefix hash matched\n");
+
+	return 0;
+}
+
+int main(int argc, char** argv) {
+	int result = testEstimate();
+	if (result) {
+		return result;
+	}
+
+	result = testMerge();
+	if (result) {
+		return result;
+	}
+
+	result = testPrefixHash();
+	if (result) {
+		return result;
+	}
+
+	return 0;
+}
@@ -0,0 +1,412 @@
+/**
+ *    Copyright (C) 2010 Deep Software Foundation
+ *
+ *    This program is free software: you can redistribute it and/or  modify
+ *    it under the terms of the GNU Affero General Public License, version 3,
+ *    as published by the Free Software Foundation.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU Affero General Public License for more details.
+ *
+ *    You should have received a copy of the GNU Affero General Public License
+ *    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *    As a special exception, the copyright holders give permission to link the
+ *    code of portions of this program with the OpenSSL library under certain
+ *    conditions as described in each individual source file and distribute
+ *    linked combinations including the program with the OpenSSL library. You
+ *    must comply with the GNU Affero General Public License in all respects for
+ *    all of the code used other than as permitted herein. If you modify file(s)
+ *    with this exception, you may extend this exception to your version of the
+ *    file(s), but you are not obligated to do so. If you do not wish to do so,
+ *    delete this exception statement from your version. If you delete this
+ *    exception statement from all source files in the program, then also delete
+ *    it in the license file.
+ */
+#include "cxx/lang/Long.h"
+#include "cxx/lang/System.h"
+
+#include "cxx/util/Logger.h"
+
+#include "cxx/util/HashMap.h"
+#include "cxx/util/HashMap.cxx"
+
+#include "cxx/util/FlatHashMap.h"
+#include "cxx/util/FlatHashMap.cxx"
+
+#include "cxx/util/ArrayList.h"
+
+using namespace cxx::lang;
+using namespace cxx::util;
+
+template class FlatHashMap<inttype,inttype>;
+template class FlatHashMap<Object*,inttype>;
+
+inttype NUM_KEYS = 1000000;
+inttype MAX_KEY = 100000000;
+
+int testReplaceFlatHashMap();
+int testReplaceFlatHashMapPrimitive();
+int testFlatHashMapChurn();
+int testFlatHashMapIterator();
+
+int main(int argc, char** argv) {
+	int result = testReplaceFlatHashMap();
+
+	if (result) {
+		return result;
+	}
+
+	result = testReplaceFlatHashMapPrimitive();
+
+	if (result) {
+		return result;
+	}
+
+	result = testFlatHashMapChurn();
+
+	if (result) {
+		return result;
+	}
+
+	result = testFlatHashMapIterator();
+
+	if (result) {
+		return result;
+	}
+
+	return 0;
+}
+
+int testReplaceFlatHashMap() {
+	FlatHashMap<Object*,inttype> map(256, false);
+
+	inttype expectedSize = 0;
+
+	ArrayList<Object*> keys;
+	ArrayList<Object*> removedKeys;
+
+	DEEP_LOG(INFO, OTHER, "\n\ntestReplaceFlatHashMap()\n\n");
+
+	for (inttype i=0; i<NUM_KEYS; i++) {
+		Object* key = new Object();
+
+		if (map.containsKey(key) == false) {
+			keys.add(key);
+
+		} else {
+			i--;
+			continue;
+		}
+
+		map.put(key, 1);
+	}
+
+	expectedSize = keys.size();
+
+	if ((map.size() != expectedSize) || (map.size() != NUM_KEYS)) {
+		DEEP_LOG(ERROR, OTHER, "FAILED - map size after init: %d, expectedSize: %d or %d\n", map.size(), expectedSize, NUM_KEYS);
+		return 1;
+	}
+
+	DEEP_LOG(INFO, OTHER, "Size after put: %d, expectedSize: %d\n", map.size(), expectedSize);
+
+	// remove every 5th key
+	for (inttype i=0; i<keys.size(); i+=5) {
+		Object* o = keys.get(i);
+
+		map.remove(o);
+		expectedSize--;
+
+		removedKeys.add(o);
+
+		if (map.size() != expectedSize) {
+			DEEP_LOG(ERROR, OTHER, "FAILED - map size after remove: %d, expectedSize: %d\n", map.size(), expectedSize);
+			return 1;
+		}
+	}
+
+	DEEP_LOG(INFO, OTHER, "Size after remove: %d, expectedSize: %d, numRemoved: %d\n", map.size(), expectedSize, removedKeys.size());
+
+	// put back half of the removed keys back
+	for (inttype i=removedKeys.size()-1; i>=removedKeys.size()/2; i--) {
+		Object* o = removedKeys.get(i);
+
+		map.put(o, 0);
+
+		expectedSize++;
+
+		if (map.size() != expectedSize) {
+			DEEP_LOG(ERROR, OTHER, "FAILED - map size after put back (%p): %d, expectedSize: %d\n", o, map.size(), expectedSize);
+			return 1;
+		}
+	}
+
+	// put back or replace all removed keys
+	for (inttype i=0; i<removedKeys.size(); i++) {
+		Object* o = removedKeys.get(i);
+
+		if (map.containsKey(o) == false) {
+			expectedSize++;
+		}
+
+		map.put(o, 2);
+
+		if (map.size() != expectedSize) {
+			DEEP_LOG(ERROR, OTHER, "FAILED - map size after replace or put back: %d, expectedSize: %d\n", map.size(), expectedSize);
+			return 1;
+		}
+	}
+
+	for (inttype i=0; i<keys.size(); i++) {
+		if (map.get(keys.get(i)) != ((i % 5) == 0 ? 2 : 1)) {
+			DEEP_LOG(ERROR, OTHER, "FAILED - value for key %d: %d\n", i, map.get(keys.get(i)));
+			return 1;
+		}
+	}
+
+	for (inttype i=0; i<keys.size(); i++) {
+		delete keys.get(i);
+	}
+
+	return 0;
+}
+
+int testReplaceFlatHashMapPrimitive() {
+
+	srand(time(0));
+
+	FlatHashMap<inttype,inttype> map(256, false);
+
+	inttype expectedSize = 0;
+
+	inttype numKeys = 0;
+	inttype* keys = new inttype[NUM_KEYS];
+
+	inttype numRemoved = 0;
+	inttype* removedKeys = new inttype[NUM_KEYS];
+
+	DEEP_LOG(INFO, OTHER, "\n\ntestReplaceFlatHashMapPrimitive()\n\n");
+
+	for (inttype i=0; i<NUM_KEYS; i++) {
+		inttype key = (rand() % MAX_KEY);
+
+		if (map.containsKey(key) == false) {
+			keys[numKeys++] = key;
+
+		} else {
+			i--;
+			continue;
+		}
+
+		map.put(key, 1);
+	}
+
+	expectedSize = numKeys;
+
+	if ((map.size() != expectedSize) || (map.size() != NUM_KEYS)) {
+		DEEP_LOG(ERROR, OTHER, "FAILED - map size after init: %d, expectedSize: %d or %d\n", map.size(), expectedSize, NUM_KEYS);
+		return 1;
+	}
+
+	DEEP_LOG(INFO, OTHER, "Size after put: %d, expectedSize: %d\n", map.size(), expectedSize);
+
+	// remove every 5th key
+	for (inttype i=0; i<numKeys; i+=5) {
+		inttype o = keys[i];
+
+		boolean status = false;
+		if ((map.remove(o, null, &status) != 1) || (status == false)) {
+			DEEP_LOG(ERROR, OTHER, "FAILED - remove of %d\n", o);
+			return 1;
+		}
+
+		expectedSize--;
+
+		removedKeys[numRemoved++] = o;
+
+		if (map.size() != expectedSize) {
+			DEEP_LOG(ERROR, OTHER, "FAILED - map size after remove: %d, expectedSize: %d\n", map.size(), expectedSize);
+			return 1;
+		}
+	}
+
+	DEEP_LOG(INFO, OTHER, "Size after remove: %d, expectedSize: %d, numRemoved: %d\n", map.size(), expectedSize, numRemoved);
+
+	// put back half of the removed keys back
+	for (inttype i=numRemoved-1; i>=numRemoved/2; i--) {
+		inttype o = removedKeys[i];
+
+		map.put(o, 0);
+
+		expectedSize++;
+
+		if (map.size() != expectedSize) {
+			DEEP_LOG(ERROR, OTHER, "FAILED - map size after put back (%d): %d, expectedSize: %d\n", o, map.size(), expectedSize);
+			return 1;
+		}
+	}
+
+	// put back or replace all removed keys
+	for (inttype i=0; i<numRemoved; i++) {
+		inttype o = removedKeys[i];
+
+		if (map.containsKey(o) == false) {
+			expectedSize++;
+		}
+
+		map.put(o, 2);
+
+		if (map.size() != expectedSize) {
+			DEEP_LOG(ERROR, OTHER, "FAILED - map size after replace or put back: %d, expectedSize: %d\n", map.size(), expectedSize);
+			return 1;
+		}
+	}
+
+	delete [] keys;
+	delete [] removedKeys;
+
+	return 0;
+}
+
+int testFlatHashMapChurn() {
+	FlatHashMap<inttype,inttype> map;
+	HashMap<inttype,inttype> check;
+
+	DEEP_LOG(INFO, OTHER, "\n\ntestFlatHashMapChurn()\n\n");
+
+	// XXX: sliding window of live keys, leaves deleted slots behind for the growth rehash to reclaim
+	const inttype window = 10000;
+	for (inttype i=0; i<(window * 50); i++) {
+		map.put(i, i * 3);
+		check.put(i, i * 3);
+
+		if (i >= window) {
+			boolean status = false;
+			if ((map.remove(i - window, null, &status) != ((i - window) * 3)) || (status == false)) {
+				DEEP_LOG(ERROR, OTHER, "FAILED - churn remove of %d\n", i - window);
+				return 1;
+			}
+
+			check.remove(i - window);
+		}
+
+		if (map.size() != check.size()) {
+			DEEP_LOG(ERROR, OTHER, "FAILED - churn size: %d, expected: %d\n", map.size(), check.size());
+			return 1;
+		}
+	}
+
+	for (inttype i=0; i<(window * 50); i++) {
+		boolean status = false;
+		inttype val = map.get(i, null, &status);
+		if ((status != check.containsKey(i)) || ((status == true) && (val != (i * 3)))) {
+			DEEP_LOG(ERROR, OTHER, "FAILED - churn get of %d: %d (%d)\n", i, val, status);
+			return 1;
+		}
+	}
+
+	if (map.capacity() > (window * 4)) {
+		DEEP_LOG(ERROR, OTHER, "FAILED - churn capacity: %d, live: %d\n", map.capacity(), map.size());
+		return 1;
+	}
+
+	DEEP_LOG(INFO, OTHER, "Churn size: %d, capacity: %d\n", map.size(), map.capacity());
+
+	// fixed maps rehash deleted slots away in place rather than shrinking
+	FlatHashMap<inttype,inttype> fixed(1024, false, false, true);
+	inttype cap = fixed.capacity();
+	for (inttype i=0; i<(cap * 20); i++) {
+		fixed.put(i, i);
+		if (i >= 100) {
+			fixed.remove(i - 100);
+		}
+	}
+
+	if ((fixed.capacity() != cap) || (fixed.size() != 100)) {
+		DEEP_LOG(ERROR, OTHER, "FAILED - fixed capacity: %d (%d), size: %d\n", fixed.capacity(), cap, fixed.size());
+		return 1;
+	}
+
+	return 0;
+}
+
+int testFlatHashMapIterator() {
+	FlatHashMap<inttype,inttype> map;
+
+	DEEP_LOG(INFO, OTHER, "\n\ntestFlatHashMapIterator()\n\n");
+
+	const inttype count = 50000;
+	for (inttype i=0; i<count; i++) {
+		map.put(i * 7, i);
+	}
+
+	longtype sum = 0;
+	inttype seen = 0;
+
+	Set<MapEntry<inttype,inttype>* >* set = map.entrySet();
+	Iterator<MapEntry<inttype,inttype>* >* iter = set->iterator();
+	while (iter->hasNext()) {
+		MapEntry<inttype,inttype>* entry = iter->next();
+		if (entry->getKey() != (entry->getValue() * 7)) {
+			DEEP_LOG(ERROR, OTHER, "FAILED - entry %d -> %d\n", entry->getKey(), entry->getValue());
+			return 1;
+		}
+
+		sum += entry->getValue();
+		seen++;
+
+		// remove odd values through the cursor
+		if ((entry->getValue() & 1) != 0) {
+			iter->remove();
+		}
+	}
+
+	delete iter;
+	delete set;
+
+	if ((seen != count) || (sum != (((longtype) count * (count - 1)) / 2)) || (map.size() != (count / 2))) {
+		DEEP_LOG(ERROR, OTHER, "FAILED - iterated: %d, sum: %lld, size after remove: %d\n", seen, sum, map.size());
+		return 1;
+	}
+
+	FlatHashMap<inttype,inttype> copy;
+	copy.putAll(&map);
+
+	Set<inttype>* keys = copy.keySet();
+	Iterator<inttype>* kiter = keys->iterator();
+	seen = 0;
+	while (kiter->hasNext()) {
+		inttype key = kiter->next();
+		if ((map.containsKey(key) == false) || (((key / 7) & 1) != 0)) {
+			DEEP_LOG(ERROR, OTHER, "FAILED - key %d\n", key);
+			return 1;
+		}
+
+		seen++;
+	}
+
+	delete kiter;
+	delete keys;
+
+	if (seen != (count / 2)) {
+		DEEP_LOG(ERROR, OTHER, "FAILED - copied keys: %d\n", seen);
+		return 1;
+	}
+
+	copy.clear();
+	if ((copy.isEmpty() == false) || (copy.containsKey(0) == true)) {
+		DEEP_LOG(ERROR, OTHER, "FAILED - clear\n");
+		return 1;
+	}
+
+	copy.put(0, 1);
+	if (copy.get(0) != 1) {
+		DEEP_LOG(ERROR, OTHER, "FAILED - put after clear\n");
+		return 1;
+	}
+
+	return 0;
+}
@@ -0,0 +1,233 @@
+/**
+ *    Copyright (C) 2010 Deep Software Foundation
+ *
+ *    This program is free software: you can redistribute it and/or  modify
+ *    it under the terms of the GNU Affero General Public License, version 3,
+ *    as published by the Free Software Foundation.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU Affero General Public License for more details.
+ *
+ *    You should have received a copy of the GNU Affero General Public License
+ *    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *    As a special exception, the copyright holders give permission to link the
+ *    code of portions of this program with the OpenSSL library under certain
+ *    conditions as described in each individual source file and distribute
+ *    linked combinations including the program with the OpenSSL library. You
+ *    must comply with the GNU Affero General Public License in all respects for
+ *    all of the code used other than as permitted herein. If you modify file(s)
+ *    with this exception, you may extend this exception to your version of the
+ *    file(s), but you are not obligated to do so. If you do not wish to do so,
+ *    delete this exception statement from your version. If you delete this
+ *    exception statement from all source files in the program, then also delete
+ *    it in the license file.
+ */
+#include "cxx/lang/Long.h"
+#include "cxx/lang/System.h"
+
+#include "cxx/util/Logger.h"
+
+#include "cxx/util/FrozenTreeMap.h"
+#include "cxx/util/TreeMap.h"
+#include "cxx/util/TreeMap.cxx"
+
+using namespace cxx::lang;
+using namespace cxx::util;
+
+template class FrozenTreeMap<long long,long long>;
+template class FrozenTreeMap<Long*,Long*>;
+
+Comparator<Long*> LongComparator;
+Comparator<long long> longlongComparator;
+
+struct FrozenRangeCounter {
+	long long m_sum;
+	int m_limit;
+
+	boolean operator()(const MapEntry<long long,long long>* entry) {
+		m_sum += entry->getKey();
+		return (--m_limit > 0);
+	}
+};
+
+static long long keyOf(const MapEntry<long long,long long>* entry) {
+	return (entry != null) ? entry->getKey() : -1;
+}
+
+int testFrozenTreeMap() {
+	int COUNTS[] = { 0, 1, 15, 16, 17, 100, 1000, 12345 };
+
+	for (int c = 0; c < (int) (sizeof(COUNTS) / sizeof(int)); c++) {
+		int count = COUNTS[c];
+
+		TreeMap<long long, long long> map(&longlongComparator, 3, false, false);
+		TreeMap<long long, long long> twin(&longlongComparator, 3, false, false);
+		for (int i = 0; i < count; i++) {
+			map.put((i * 2) + 1, i);
+			twin.put((i * 2) + 1, i);
+		}
+
+		FrozenTreeMap<long long, long long>* frozen = map.freeze();
+		if ((map.size() != 0) || (frozen->size() != count) || (frozen->firstKey() != twin.firstKey()) || (frozen->lastKey() != twin.lastKey())) {
+			DEEP_LOG(ERROR, OTHER, "FAILED - freeze size: %d, expected: %d\n", frozen->size(), count);
+			return 1;
+		}
+
+		// XXX: every key, every gap and both ends against the mutable tree
+		for (long long probe = 0; probe <= (count * 2) + 2; probe++) {
+			boolean status;
+			long long value = frozen->get(probe, null, &status);
+			if ((status != twin.containsKey(probe)) || ((status == true) && (value != twin.get(probe))) || (frozen->containsKey(probe) != status)) {
+				DEEP_LOG(ERROR, OTHER, "FAILED - frozen get: %lld\n", probe);
+				return 1;
+			}
+
+			if ((keyOf(frozen->floorEntry(probe)) != keyOf(twin.floorEntry(probe))) ||
+				(keyOf(frozen->ceilingEntry(probe)) != keyOf(twin.ceilingEntry(probe))) ||
+				(keyOf(frozen->higherEntry(probe)) != keyOf(twin.higherEntry(probe))) ||
+				(keyOf(frozen->lowerEntry(probe)) != keyOf(twin.lowerEntry(probe)))) {
+				DEEP_LOG(ERROR, OTHER, "FAILED - frozen navigation: %lld\n", probe);
+				return 1;
+			}
+		}
+
+		TreeIterator<MapEntry<long long,long long>*>* iter = frozen->iterator(count);
+		for (int i = count / 2; i < count; i++) {
+			if ((iter->hasNext() == false) || (iter->next()->getKey() != (i * 2) + 1)) {
+				DEEP_LOG(ERROR, OTHER, "FAILED - frozen iterator: %d\n", i);
+				return 1;
+			}
+		}
+
+		if ((iter->hasNext() == true) || ((count > 0) && (iter->previous()->getKey() != (count * 2) - 1))) {
+			DEEP_LOG(ERROR, OTHER, "FAILED - frozen iterator end: %d\n", count);
+			return 1;
+		}
+		delete iter;
+
+		Set<long long>* keys = frozen->keySet();
+		Iterator<long long>* kiter = keys->iterator();
+		for (int i = 0; i < count; i++) {
+			if (kiter->next() != (i * 2) + 1) {
+				DEEP_LOG(ERROR, OTHER, "FAILED - frozen key set: %d\n", i);
+				return 1;
+			}
+		}
+		if ((kiter->hasNext() == true) || (keys->size() != count)) {
+			DEEP_LOG(ERROR, OTHER, "FAILED - frozen key set size: %d\n", keys->size());
+			return 1;
+		}
+		delete kiter;
+		delete keys;
+
+		if (count >= 5) {
+			FrozenRangeCounter counter = { 0, count };
+			int visited = frozen->forEachInRange(4, 10, counter);
+
+			FrozenRangeCounter limited = { 0, 2 };
+			int stopped = frozen->forEachInRange(4, 10, limited);
+
+			if ((visited != 3) || (counter.m_sum != 5 + 7 + 9) || (stopped != 2) || (limited.m_sum != 5 + 7)) {
+				DEEP_LOG(ERROR, OTHER, "FAILED - frozen range: %d, %lld\n", visited, counter.m_sum);
+				return 1;
+			}
+		}
+
+		try {
+			frozen->put(1, 1);
+			DEEP_LOG(ERROR, OTHER, "FAILED - frozen put\n");
+			return 1;
+
+		} catch (UnsupportedOperationException* e) {
+			delete e;
+		}
+
+		delete frozen;
+	}
+
+	// XXX: -1 is a key like any other, it bounds a range on either side
+	TreeMap<long long, long long> signedMap(&longlongComparator, 3, false, false);
+	for (long long i = -100; i <= 100; i++) {
+		signedMap.put(i, i);
+	}
+
+	FrozenTreeMap<long long, long long>* signedFrozen = signedMap.freeze();
+
+	FrozenRangeCounter from = { 0, 1000 };
+	FrozenRangeCounter to = { 0, 1000 };
+	FrozenRangeCounter open = { 0, 1000 };
+	if ((signedFrozen->forEachInRange(-1, 5, from) != 6) || (from.m_sum != 9) ||
+		(signedFrozen->forEachInRange(-50, -1, to) != 49) || (to.m_sum != -1274) ||
+		(signedFrozen->forEachInRange(-1, true, -1, false, open) != 99)) {
+		DEEP_LOG(ERROR, OTHER, "FAILED - frozen signed range: %lld, %lld\n", from.m_sum, to.m_sum);
+		return 1;
+	}
+
+	TreeIterator<MapEntry<long long,long long>*>* signedIter = signedFrozen->iterator(-1);
+	if (signedIter->next()->getKey() != -1) {
+		DEEP_LOG(ERROR, OTHER, "FAILED - frozen signed iterator\n");
+		return 1;
+	}
+	delete signedIter;
+	delete signedFrozen;
+
+	DEEP_LOG(INFO, OTHER, "frozen map matched\n");
+
+	return 0;
+}
+
+int testFrozenTreeMapOwned() {
+	// XXX: keys and values move with the entries, the frozen map releases them
+	TreeMap<Long*, Long*> map(&LongComparator, 3, true, true);
+	for (int i = 0; i < 1000; i++) {
+		map.put(new Long(i), new Long(i * 10));
+	}
+
+	FrozenTreeMap<Long*, Long*>* frozen = map.freeze();
+	for (int i = 0; i < 1000; i++) {
+		Long key(i);
+		const Long* value = frozen->get(&key);
+		if ((value == null) || (value->longValue() != i * 10)) {
+			DEEP_LOG(ERROR, OTHER, "FAILED - frozen owned get: %d\n", i);
+			return 1;
+		}
+	}
+	delete frozen;
+
+	// XXX: entries must come in ascending key order
+	TreeMap<long long, long long> source(&longlongComparator, 3, false, false);
+	source.put(1, 1);
+	source.put(2, 2);
+
+	Set<MapEntry<long long,long long>*>* entries = source.entrySet();
+	Iterator<MapEntry<long long,long long>*>* iter = entries->iterator();
+	FrozenTreeMap<long long, long long> copy(&longlongComparator, iter, 2);
+	delete iter;
+	delete entries;
+
+	if ((copy.size() != 2) || (copy.get(2) != 2)) {
+		DEEP_LOG(ERROR, OTHER, "FAILED - frozen copy\n");
+		return 1;
+	}
+
+	DEEP_LOG(INFO, OTHER, "frozen owned map matched\n");
+
+	return 0;
+}
+
+int main(int argc, char** argv) {
+	int result = testFrozenTreeMap();
+	if (result) {
+		return result;
+	}
+
+	result = testFrozenTreeMapOwned();
+	if (result) {
+		return result;
+	}
+
+	return 0;
+}
@@ -0,0 +1,130 @@
+/**
+ *    Copyright (C) 2010 Deep Software Foundation
+ *
+ *    This program is free software: you can redistribute it and/or  modify
+ *    it under the terms of the GNU Affero General Public License, version 3,
+ *    as published by the Free Software Foundation.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU Affero General Public License for more details.
+ *
+ *    You should have received a copy of the GNU Affero General Public License
+ *    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *    As a special exception, the copyright holders give permission to link the
+ *    code of portions of this program with the OpenSSL library under certain
+ *    conditions as described in each individual source file and distribute
+ *    linked combinations including the program with the OpenSSL library. You
+ *    must comply with the GNU Affero General Public License in all respects for
+ *    all of the code used other than as permitted herein. If you modify file(s)
+ *    with this exception, you may extend this exception to your version of the
+ *    file(s), but you are not obligated to do so. If you do not wish to do so,
+ *    delete this exception statement from your version. If you delete this
+ *    exception statement from all source files in the program, then also delete
+ *    it in the license file.
+ */
+#include "cxx/lang/System.h"
+
+#include "cxx/util/Logger.h"
+
+#include "cxx/util/FrozenTreeSet.h"
+#include "cxx/util/TreeSet.h"
+#include "cxx/util/TreeSet.cxx"
+
+using namespace cxx::lang;
+using namespace cxx::util;
+
+template class FrozenTreeSet<long long>;
+
+int testFrozenTreeSet() {
+	int COUNTS[] = { 0, 1, 15, 16, 17, 100, 1000, 12345 };
+
+	for (int c = 0; c < (int) (sizeof(COUNTS) / sizeof(int)); c++) {
+		int count = COUNTS[c];
+
+		TreeSet<long long> set(3);
+		TreeSet<long long> twin(3);
+		for (int i = 0; i < count; i++) {
+			set.add((i * 2) + 1);
+			twin.add((i * 2) + 1);
+		}
+
+		FrozenTreeSet<long long>* frozen = set.freeze();
+		if ((set.size() != 0) || (frozen->size() != count)) {
+			DEEP_LOG(ERROR, OTHER, "FAILED - freeze size: %d, expected: %d\n", frozen->size(), count);
+			return 1;
+		}
+
+		// XXX: every element, every gap and both ends against the mutable tree
+		for (long long probe = 0; probe <= (count * 2) + 2; probe++) {
+			boolean expected;
+			boolean actual;
+
+			if (frozen->contains(probe) != twin.contains(probe)) {
+				DEEP_LOG(ERROR, OTHER, "FAILED - frozen contains: %lld\n", probe);
+				return 1;
+			}
+
+			if ((frozen->floor(probe, &actual) != twin.floor(probe, &expected)) || (actual != expected) ||
+				(frozen->ceiling(probe, &actual) != twin.ceiling(probe, &expected)) || (actual != expected) ||
+				(frozen->higher(probe, &actual) != twin.higher(probe, &expected)) || (actual != expected) ||
+				(frozen->lower(probe, &actual) != twin.lower(probe, &expected)) || (actual != expected)) {
+				DEEP_LOG(ERROR, OTHER, "FAILED - frozen navigation: %lld\n", probe);
+				return 1;
+			}
+		}
+
+		Iterator<long long>* iter = frozen->iterator();
+		for (int i = 0; i < count; i++) {
+			if (iter->next() != (i * 2) + 1) {
+				DEEP_LOG(ERROR, OTHER, "FAILED - frozen iterator: %d\n", i);
+				return 1;
+			}
+		}
+
+		if (iter->hasNext() == true) {
+			DEEP_LOG(ERROR, OTHER, "FAILED - frozen iterator end: %d\n", count);
+			return 1;
+		}
+		delete iter;
+
+		try {
+			frozen->add(1);
+			DEEP_LOG(ERROR, OTHER, "FAILED - frozen add\n");
+			return 1;
+
+		} catch (UnsupportedOperationException* e) {
+			delete e;
+		}
+
+		delete frozen;
+	}
+
+	// XXX: -1 is an element like any other, it bounds a range on either side
+	TreeSet<long long> signedSet(3);
+	for (long long i = -100; i <= 100; i++) {
+		signedSet.add(i);
+	}
+
+	FrozenTreeSet<long long>* signedFrozen = signedSet.freeze();
+
+	int visited = 0;
+	if ((signedFrozen->forEachInRange(-1, 5, [&visited](const long long elem) { visited++; return true; }) != 6) ||
+		(signedFrozen->forEachInRange(-50, -1, [&visited](const long long elem) { visited++; return true; }) != 49) ||
+		(signedFrozen->forEachInRange(-1, false, -1, true, [&visited](const long long elem) { visited++; return true; }) != 102) ||
+		(visited != 6 + 49 + 102)) {
+		DEEP_LOG(ERROR, OTHER, "FAILED - frozen signed range: %d\n", visited);
+		return 1;
+	}
+	delete signedFrozen;
+
+	DEEP_LOG(INFO, OTHER, "frozen set matched\n");
+
+	return 0;
+}
+
+int main(int argc, char** argv) {
+	return testFrozenTreeSet();
+}
@@ -49,6 +49,8 @@ inttype MAX_KEY = 100000000;
 
 int testReplaceHashMap();
 int testReplaceHashMapPrimitive();
+int testIncrementalHashMap();
+int testHashMapShrinkHysteresis();
 
 int main(int argc, char** argv) {
 	int result = testReplaceHashMap();
@@ -63,6 +65,18 @@ int main(int argc, char** argv) {
 		return result;
 	}
 
+	result = testIncrementalHashMap();
+
+	if (result) {
+		return result;
+	}
+
+	result = testHashMapShrinkHysteresis();
+
+	if (result) {
+		return result;
+	}
+
 	return 0;
 }
 
@@ -241,3 +255,135 @@ int testReplaceHashMapPrimitive() {
 
 	return 0;
 }
+
+int testIncrementalHashMap() {
+	HashMap<inttype,inttype> map(16, false, false, false, true /* incremental */);
+
+	DEEP_LOG(INFO, OTHER, "\n\ntestIncrementalHashMap()\n\n");
+
+	inttype resizes = 0;
+	boolean resizing = false;
+
+	for (inttype i=0; i<NUM_KEYS; i++) {
+		map.put(i, i);
+
+		if (map.isResizing() != resizing) {
+			resizing = map.isResizing();
+			if (resizing == true) {
+				resizes++;
+			}
+		}
+
+		// while both tables are live, keys from before the resize must still be found
+		if ((resizing == true) && ((i % 97) == 0)) {
+			for (inttype j=i; j>=0; j-=(i / 64) + 1) {
+				if (map.get(j) != j) {
+					DEEP_LOG(ERROR, OTHER, "FAILED - get during resize of %d: %d\n", j, map.get(j));
+					return 1;
+				}
+			}
+		}
+
+		// replace a key that may still sit in the old table
+		if ((resizing == true) && (i > 0)) {
+			boolean status = false;
+			map.put(i - 1, i - 1, null, &status);
+			if (status == false) {
+				DEEP_LOG(ERROR, OTHER, "FAILED - replace during resize of %d\n", i - 1);
+				return 1;
+			}
+		}
+	}
+
+	if ((map.size() != NUM_KEYS) || (resizes == 0)) {
+		DEEP_LOG(ERROR, OTHER, "FAILED - size after put: %d, resizes: %d\n", map.size(), resizes);
+		return 1;
+	}
+
+	DEEP_LOG(INFO, OTHER, "Size after put: %d, resizes: %d, capacity: %d\n", map.size(), resizes, map.capacity());
+
+	inttype seen = 0;
+	Set<MapEntry<inttype,inttype>* >* set = map.entrySet();
+	Iterator<MapEntry<inttype,inttype>* >* iter = set->iterator();
+	while (iter->hasNext()) {
+		MapEntry<inttype,inttype>* entry = iter->next();
+		if (entry->getKey() != entry->getValue()) {
+			DEEP_LOG(ERROR, OTHER, "FAILED - entry %d -> %d\n", entry->getKey(), entry->getValue());
+			return 1;
+		}
+
+		seen++;
+	}
+
+	delete iter;
+	delete set;
+
+	if (seen != NUM_KEYS) {
+		DEEP_LOG(ERROR, OTHER, "FAILED - iterated: %d, expected: %d\n", seen, NUM_KEYS);
+		return 1;
+	}
+
+	// remove most keys, shrinking incrementally
+	for (inttype i=0; i<NUM_KEYS; i++) {
+		if ((i % 100) != 0) {
+			boolean status = false;
+			if ((map.remove(i, null, &status) != i) || (status == false)) {
+				DEEP_LOG(ERROR, OTHER, "FAILED - remove of %d\n", i);
+				return 1;
+			}
+		}
+	}
+
+	for (inttype i=0; i<NUM_KEYS; i++) {
+		if (map.containsKey(i) != ((i % 100) == 0)) {
+			DEEP_LOG(ERROR, OTHER, "FAILED - containsKey after remove of %d\n", i);
+			return 1;
+		}
+	}
+
+	if ((map.size() != (NUM_KEYS / 100)) || (map.capacity() > ((NUM_KEYS / 100) * 16))) {
+		DEEP_LOG(ERROR, OTHER, "FAILED - size after remove: %d, capacity: %d\n", map.size(), map.capacity());
+		return 1;
+	}
+
+	DEEP_LOG(INFO, OTHER, "Size after remove: %d, capacity: %d\n", map.size(), map.capacity());
+
+	map.clear();
+	if ((map.size() != 0) || (map.isResizing() == true) || (map.containsKey(0) == true)) {
+		DEEP_LOG(ERROR, OTHER, "FAILED - clear\n");
+		return 1;
+	}
+
+	return 0;
+}
+
+int testHashMapShrinkHysteresis() {
+	HashMap<inttype,inttype> map;
+
+	DEEP_LOG(INFO, OTHER, "\n\ntestHashMapShrinkHysteresis()\n\n");
+
+	for (inttype i=0; i<10000; i++) {
+		map.put(i, i);
+	}
+
+	// remove until the first shrink
+	inttype cap = map.capacity();
+	inttype next = 0;
+	while (map.capacity() == cap) {
+		map.remove(next++);
+	}
+
+	// oscillating around the size that triggered the shrink must not resize again
+	cap = map.capacity();
+	for (inttype round=0; round<1000; round++) {
+		map.put(next - 1, 0);
+		map.remove(next - 1);
+
+		if (map.capacity() != cap) {
+			DEEP_LOG(ERROR, OTHER, "FAILED - capacity after shrink: %d, now: %d (round %d)\n", cap, map.capacity(), round);
+			return 1;
+		}
+	}
+
+	return 0;
+}
@@ -0,0 +1,187 @@
+/**
+ *    Copyright (C) 2010 Deep Software Foundation
+ *
+ *    This program is free software: you can redistribute it and/or  modify
+ *    it under the terms of the GNU Affero General Public License, version 3,
+ *    as published by the Free Software Foundation.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU Affero General Public License for more details.
+ *
+ *    You should have received a copy of the GNU Affero General Public License
+ *    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *    As a special exception, the copyright holders give permission to link the
+ *    code of portions of this program with the OpenSSL library under certain
+ *    conditions as described in each individual source file and distribute
+ *    linked combinations including the program with the OpenSSL library. You
+ *    must comply with the GNU Affero General Public License in all respects for
+ *    all of the code used other than as permitted herein. If you modify file(s)
+ *    with this exception, you may extend this exception to your version of the
+ *    file(s), but you are not obligated to do so. If you do not wish to do so,
+ *    delete this exception statement from your version. If you delete this
+ *    exception statement from all source files in the program, then also delete
+ *    it in the license file.
+ */
+#include "cxx/lang/System.h"
+
+#include "cxx/util/Logger.h"
+
+#include "cxx/util/NodeSearch.h"
+
+using namespace cxx::lang;
+using namespace cxx::util;
+
+template<typename T>
+struct Strided {
+	void* m_node;
+	T m_key;
+};
+
+template<typename T>
+inttype reference(const T* keys, inttype count, const T what) {
+	inttype i = 0;
+	while ((i < count) && (keys[i] < what)) {
+		i++;
+	}
+
+	return i;
+}
+
+template<typename T>
+int testRank(const char* name, T low, T step) {
+	const inttype MAX = 300;
+
+	T keys[MAX];
+	Strided<T> items[MAX];
+
+	for (inttype count = 0; count <= MAX; count += (count < 40) ? 1 : 37) {
+		for (inttype i = 0; i < count; i++) {
+			keys[i] = (T) (low + (i * step));
+			items[i].m_key = keys[i];
+		}
+
+		for (inttype j = -1; j <= count; j++) {
+			// XXX: probe each key, the gaps in between and both ends
+			T probes[3];
+			probes[0] = (T) (low + (j * step));
+			probes[1] = (T) (low + (j * step) + (step / 2));
+			probes[2] = (T) (low + (j * step) - (step / 2));
+
+			for (int p = 0; p < 3; p++) {
+				inttype expect = reference(keys, count, probes[p]);
+				inttype contiguous = NodeSearch<T>::rank(keys, sizeof(T), count, probes[p]);
+				inttype strided = NodeSearch<T>::rank(&items[0].m_key, sizeof(Strided<T>), count, probes[p]);
+
+				if ((contiguous != expect) || (strided != expect)) {
+					DEEP_LOG(ERROR, OTHER, "FAILED - %s rank count: %d, probe: %d, expect: %d, contiguous: %d, strided: %d\n", name, count, j, expect, contiguous, strided);
+					return 1;
+				}
+			}
+		}
+	}
+
+	DEEP_LOG(INFO, OTHER, "%s rank matched\n", name);
+
+	return 0;
+}
+
+// XXX: page sized nodes (see TreeMap::orderFor) are bisected before the vector pass, cover counts around the block edges
+template<typename T>
+int testRankPage(const char* name, T low, T step) {
+	const inttype COUNTS[] = { 4095, 4096, 8191, 8192 };
+	const inttype MAX = 8192;
+
+	T* keys = new T[MAX];
+	Strided<T>* items = new Strided<T>[MAX];
+
+	for (inttype c = 0; c < (inttype) (sizeof(COUNTS) / sizeof(inttype)); c++) {
+		inttype count = COUNTS[c];
+		for (inttype i = 0; i < count; i++) {
+			keys[i] = (T) (low + (i * step));
+			items[i].m_key = keys[i];
+		}
+
+		for (inttype j = -1; j <= count; j += ((j < 70) || (j > (count - 70))) ? 1 : 13) {
+			T probes[2];
+			probes[0] = (T) (low + (j * step));
+			probes[1] = (T) (low + (j * step) + (step / 2));
+
+			for (int p = 0; p < 2; p++) {
+				inttype expect = reference(keys, count, probes[p]);
+				inttype contiguous = NodeSearch<T>::rank(keys, sizeof(T), count, probes[p]);
+				inttype strided = NodeSearch<T>::rank(&items[0].m_key, sizeof(Strided<T>), count, probes[p]);
+
+				if ((contiguous != expect) || (strided != expect)) {
+					DEEP_LOG(ERROR, OTHER, "FAILED - %s page rank count: %d, probe: %d, expect: %d, contiguous: %d, strided: %d\n", name, count, j, expect, contiguous, strided);
+					delete [] keys;
+					delete [] items;
+					return 1;
+				}
+			}
+		}
+	}
+
+	delete [] keys;
+	delete [] items;
+
+	DEEP_LOG(INFO, OTHER, "%s page rank matched\n", name);
+
+	return 0;
+}
+
+int main(int argc, char** argv) {
+	int result = testRank<longtype>("longtype", -1000000000000LL, 4000000000LL);
+	if (result) {
+		return result;
+	}
+
+	result = testRank<ulongtype>("ulongtype", 0x7FFFFFFFFFFFF000ULL, 32);
+	if (result) {
+		return result;
+	}
+
+	result = testRank<inttype>("inttype", -1000, 8);
+	if (result) {
+		return result;
+	}
+
+	result = testRank<shorttype>("shorttype", -600, 4);
+	if (result) {
+		return result;
+	}
+
+	result = testRank<doubletype>("doubletype", -10.5, 0.25);
+	if (result) {
+		return result;
+	}
+
+	result = testRankPage<longtype>("longtype", -1000000000000LL, 4000000000LL);
+	if (result) {
+		return result;
+	}
+
+	result = testRankPage<ulongtype>("ulongtype", 0x7FFFFFFFFFFFE000ULL, 2);
+	if (result) {
+		return result;
+	}
+
+	result = testRankPage<inttype>("inttype", -100000, 8);
+	if (result) {
+		return result;
+	}
+
+	result = testRankPage<shorttype>("shorttype", -30000, 4);
+	if (result) {
+		return result;
+	}
+
+	result = testRankPage<doubletype>("doubletype", -1000.5, 0.25);
+	if (result) {
+		return result;
+	}
+
+	return 0;
+}
@@ -0,0 +1,277 @@
+/**
+ *    Copyright (C) 2010 Deep Software Foundation
+ *
+ *    This program is free software: you can redistribute it and/or  modify
+ *    it under the terms of the GNU Affero General Public License, version 3,
+ *    as published by the Free Software Foundation.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU Affero General Public License for more details.
+ *
+ *    You should have received a copy of the GNU Affero General Public License
+ *    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *    As a special exception, the copyright holders give permission to link the
+ *    code of portions of this program with the OpenSSL library under certain
+ *    conditions as described in each individual source file and distribute
+ *    linked combinations including the program with the OpenSSL library. You
+ *    must comply with the GNU Affero General Public License in all respects for
+ *    all of the code used other than as permitted herein. If you modify file(s)
+ *    with this exception, you may extend this exception to your version of the
+ *    file(s), but you are not obligated to do so. If you do not wish to do so,
+ *    delete this exception statement from your version. If you delete this
+ *    exception statement from all source files in the program, then also delete
+ *    it in the license file.
+ */
+#include <stdio.h>
+#include <unistd.h>
+
+#include "cxx/lang/System.h"
+
+#include "cxx/util/Logger.h"
+
+#include "cxx/util/SortedRun.h"
+#include "cxx/util/TreeMap.h"
+#include "cxx/util/TreeMap.cxx"
+
+using namespace cxx::lang;
+using namespace cxx::util;
+
+template class SortedRunWriter<long long,long long>;
+template class SortedRunReader<long long,long long>;
+
+Comparator<long long> longlongComparator;
+
+static const char* RUN_PATH = "sorted.run";
+
+struct SortedRunCounter {
+	long long m_sum;
+	long long m_last;
+	int m_limit;
+
+	boolean operator()(const long long key, const long long value) {
+		if ((key <= m_last) || (value != key * 10)) {
+			m_sum = -1;
+			return false;
+		}
+
+		m_last = key;
+		m_sum += key;
+		return (--m_limit > 0);
+	}
+};
+
+int testSortedRun(boolean bloom) {
+	int COUNTS[] = { 0, 1, 127, 128, 129, 1000, 54321 };
+
+	for (int c = 0; c < (int) (sizeof(COUNTS) / sizeof(int)); c++) {
+		int count = COUNTS[c];
+
+		TreeMap<long long,long long> map(&longlongComparator);
+		for (int i = 0; i < count; i++) {
+			map.put((i * 2) + 1, ((i * 2) + 1) * 10);
+		}
+
+		{
+			SortedRunWriter<long long,long long> writer(RUN_PATH, map.size(), bloom);
+			writer.append(&map);
+			writer.finish();
+
+			if (writer.size() != count) {
+				DEEP_LOG(ERROR, OTHER, "FAILED - run written: %lld, expected: %d\n", writer.size(), count);
+				return 1;
+			}
+		}
+
+		SortedRunReader<long long,long long> reader(RUN_PATH, &longlongComparator);
+		if ((reader.size() != count) || (reader.getBlockCount() != (count + SortedRunHeader::BLOCK_ENTRIES - 1) / SortedRunHeader::BLOCK_ENTRIES)) {
+			DEEP_LOG(ERROR, OTHER, "FAILED - run size: %lld, expected: %d\n", reader.size(), count);
+			return 1;
+		}
+
+		// XXX: every key, every gap and both ends against the tree it came from
+		int misses = 0;
+		for (long long probe = 0; probe <= (count * 2) + 2; probe++) {
+			boolean expected;
+			boolean actual;
+
+			long long value = reader.get(probe, &actual);
+			map.get(probe, null, &expected);
+			if ((actual != expected) || ((actual == true) && (value != probe * 10))) {
+				DEEP_LOG(ERROR, OTHER, "FAILED - run get: %lld\n", probe);
+				return 1;
+			}
+
+			if ((expected == false) && (reader.mightContain(probe) == true)) {
+				misses++;
+			}
+
+			long long ceiling = reader.ceilingKey(probe, &actual);
+			long long twin = map.ceilingKey(probe, &expected);
+			if ((actual != expected) || ((actual == true) && (ceiling != twin))) {
+				DEEP_LOG(ERROR, OTHER, "FAILED - run ceiling: %lld\n", probe);
+				return 1;
+			}
+		}
+
+		// XXX: ten bits per key leaves about one percent false positives
+		if ((bloom == true) && (misses > (count / 20) + 1)) {
+			DEEP_LOG(ERROR, OTHER, "FAILED - run bloom misses: %d of %d\n", misses, count);
+			return 1;
+		}
+
+		SortedRunCounter counter = { 0, 0, count + 1 };
+		long long visited = reader.forEachInRange(Converter<long long>::NULL_VALUE, true, Converter<long long>::NULL_VALUE, true, counter);
+		if ((visited != count) || (counter.m_sum != (long long) count * count)) {
+			DEEP_LOG(ERROR, OTHER, "FAILED - run scan: %lld, %lld\n", visited, counter.m_sum);
+			return 1;
+		}
+
+		if (count >= 5) {
+			SortedRunCounter range = { 0, 0, count };
+			visited = reader.forEachInRange(4, 10, range);
+
+			SortedRunCounter limited = { 0, 0, 2 };
+			long long stopped = reader.forEachInRange(4, 10, limited);
+
+			if ((visited != 3) || (range.m_sum != 5 + 7 + 9) || (stopped != 2) || (limited.m_sum != 5 + 7)) {
+				DEEP_LOG(ERROR, OTHER, "FAILED - run range: %lld, %lld\n", visited, range.m_sum);
+				return 1;
+			}
+		}
+	}
+
+	unlink(RUN_PATH);
+
+	DEEP_LOG(INFO, OTHER, "sorted run matched, bloom: %d\n", bloom);
+
+	return 0;
+}
+
+// XXX: -1 bounds a range like any other key, only the open flags leave a side unbounded
+int testSortedRunSigned() {
+	TreeMap<long long,long long> map(&longlongComparator);
+	for (long long i = -100; i <= 100; i++) {
+		map.put(i, i * 10);
+	}
+
+	{
+		SortedRunWriter<long long,long long> writer(RUN_PATH, map.size());
+		writer.append(&map);
+		writer.finish();
+	}
+
+	SortedRunReader<long long,long long> reader(RUN_PATH, &longlongComparator);
+
+	SortedRunCounter closed = { 0, -1000, 1000 };
+	long long visited = reader.forEachInRange(-1, 5, closed);
+	if ((visited != 6) || (closed.m_sum != -1 + 0 + 1 + 2 + 3 + 4)) {
+		DEEP_LOG(ERROR, OTHER, "FAILED - signed run range: %lld, %lld\n", visited, closed.m_sum);
+		return 1;
+	}
+
+	SortedRunCounter below = { 0, -1000, 1000 };
+	visited = reader.forEachInRange(-1, true, -1, false, below);
+	if ((visited != 99) || (below.m_sum != -5049)) {
+		DEEP_LOG(ERROR, OTHER, "FAILED - signed run below: %lld, %lld\n", visited, below.m_sum);
+		return 1;
+	}
+
+	SortedRunCounter above = { 0, -1000, 1000 };
+	visited = reader.forEachInRange(-1, false, -1, true, above);
+	if ((visited != 102) || (above.m_sum != 5049)) {
+		DEEP_LOG(ERROR, OTHER, "FAILED - signed run above: %lld, %lld\n", visited, above.m_sum);
+		return 1;
+	}
+
+	unlink(RUN_PATH);
+
+	return 0;
+}
+
+static boolean openFails(void) {
+	boolean thrown = false;
+	try {
+		SortedRunReader<long long,long long> reader(RUN_PATH, &longlongComparator);
+
+	} catch (IOException* e) {
+		delete e;
+		thrown = true;
+	}
+
+	return thrown;
+}
+
+int testSortedRunInvalid() {
+	FILE* file = fopen(RUN_PATH, "wb");
+	fputs("not a sorted run, but longer than its header would be if it were one", file);
+	fclose(file);
+
+	if (openFails() == false) {
+		unlink(RUN_PATH);
+		DEEP_LOG(ERROR, OTHER, "FAILED - invalid run opened\n");
+		return 1;
+	}
+
+	TreeMap<long long,long long> map(&longlongComparator);
+	for (long long i = 0; i < 1000; i++) {
+		map.put(i, i * 10);
+	}
+
+	// XXX: valid magic over offsets and counts that do not fit the file must be rejected before the run is mapped
+	for (int c = 0; c < 7; c++) {
+		{
+			SortedRunWriter<long long,long long> writer(RUN_PATH, map.size());
+			writer.append(&map);
+			writer.finish();
+		}
+
+		int fd = open(RUN_PATH, O_RDWR);
+		SortedRunHeader header;
+		if ((fd == -1) || (pread(fd, &header, sizeof(header), 0) != (ssize_t) sizeof(header))) {
+			DEEP_LOG(ERROR, OTHER, "FAILED - run header read\n");
+			return 1;
+		}
+
+		switch (c) {
+			case 0: header.m_count = header.m_count + 1; break;
+			case 1: header.m_count = 1LL << 60; header.m_blockCount = (header.m_count + header.m_blockEntries - 1) / header.m_blockEntries; break;
+			case 2: header.m_count = -1; break;
+			case 3: header.m_indexOffset = header.m_indexOffset - 1; break;
+			case 4: header.m_indexOffset = 1LL << 62; break;
+			case 5: header.m_bloomOffset = header.m_bloomOffset + 1; break;
+			case 6: header.m_blockEntries = 0; break;
+		}
+
+		boolean written = (pwrite(fd, &header, sizeof(header), 0) == (ssize_t) sizeof(header));
+		close(fd);
+
+		if ((written == false) || (openFails() == false)) {
+			unlink(RUN_PATH);
+			DEEP_LOG(ERROR, OTHER, "FAILED - corrupt run header opened: %d\n", c);
+			return 1;
+		}
+	}
+
+	unlink(RUN_PATH);
+
+	return 0;
+}
+
+int main(int argc, char** argv) {
+	if (testSortedRun(true) != 0) {
+		return 1;
+	}
+
+	if (testSortedRun(false) != 0) {
+		return 1;
+	}
+
+	if (testSortedRunSigned() != 0) {
+		return 1;
+	}
+
+	return testSortedRunInvalid();
+}
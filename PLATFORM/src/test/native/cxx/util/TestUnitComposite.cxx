@@ -31,6 +31,7 @@
 
 #include "cxx/util/Logger.h"
 
+#include "cxx/util/CompositeComparator.h"
 #include "cxx/util/HashMap.h"
 #include "cxx/util/TreeMap.h"
 #include "cxx/util/TreeSet.h"
@@ -45,9 +46,21 @@ using namespace cxx::util;
 
 template class TreeMap<CompositeKey*, CompositeKey*>;
 
+typedef CompositeComparator<StaticKeyPart<KeyPart::INTEGER>, StaticKeyPart<KeyPart::LONG>, StaticKeyPart<KeyPart::STRING,8>, StaticKeyPart<KeyPart::SHORT> > StaticComparator;
+typedef StaticKeyPart<KeyPart::INTEGER> IntPart;
+typedef CompositeComparator<IntPart, IntPart, IntPart, IntPart, IntPart, IntPart, IntPart, IntPart, IntPart, IntPart, IntPart, IntPart> WideComparator;
+
+template class TreeMap<StaticCompositeKey<StaticComparator>*, longtype>;
+template class TreeSet<CompositeKey*, StaticComparator>;
+
 static int COUNT = 1000000;
 
 void testTreeMap();
+void testNormalized();
+void testStatic();
+void testPrefixed();
+void testSketch();
+void testBatch();
 
 Comparator<CompositeKey*> compositeKeyComparator;
 
@@ -63,6 +76,23 @@ int main(int argc, char** argv) {
 	DEEP_LOG(INFO, OTHER, "---------------------------- TEST TREE-MAP\n");
 	testTreeMap();
 
+	DEEP_LOG(INFO, OTHER, "---------------------------- TEST NORMALIZED\n");
+	testNormalized();
+
+	DEEP_LOG(INFO, OTHER, "---------------------------- TEST STATIC\n");
+	testStatic();
+
+	DEEP_LOG(INFO, OTHER, "---------------------------- TEST PREFIXED\n");
+	testPrefixed();
+
+	#ifdef COM_DEEPIS_DB_CARDINALITY
+	DEEP_LOG(INFO, OTHER, "---------------------------- TEST SKETCH\n");
+	testSketch();
+
+	DEEP_LOG(INFO, OTHER, "---------------------------- TEST BATCH\n");
+	testBatch();
+	#endif
+
 	return 0;
 }
 
@@ -193,3 +223,575 @@ void testTreeMap() {
 	#endif
 
 }
+
+static inttype sign(inttype cmp) {
+	return (cmp < 0) ? -1 : ((cmp > 0) ? 1 : 0);
+}
+
+static void fillNormalizedKey(bytearray bytes) {
+	// XXX: narrow value ranges so keys share prefixes and hit every part
+	inttype i = (rand() % 5) - 2;
+	longtype l = ((longtype) ((rand() % 5) - 2)) << 40;
+	shorttype s = (rand() % 5) - 2;
+	doubletype d = ((rand() % 5) - 2) * 0.5;
+	floattype f = ((rand() % 5) - 2) * 0.25f;
+	if ((d == 0) && ((rand() % 2) == 0)) {
+		d = -0.0;
+	}
+
+	memcpy(bytes, &i, 4);
+	memcpy(bytes + 4, &l, 8);
+	memcpy(bytes + 12, &s, 2);
+	memcpy(bytes + 14, &d, 8);
+	memcpy(bytes + 22, &f, 4);
+
+	memset(bytes + 26, 'x', 8);
+	bytes[26] = 'a' + (rand() % 3);
+	bytes[27 + (rand() % 7)] = 0;
+
+	for (int j = 0; j < 4; j++) {
+		bytes[34 + j] = (bytetype) (((rand() % 2) == 0) ? 0x7f : 0x80);
+	}
+}
+
+void testNormalized() {
+	Comparator<CompositeKey*> rawComparator;
+	Comparator<CompositeKey*> normalizedComparator;
+
+	bytetype types[] = { KeyPart::INTEGER, KeyPart::LONG, KeyPart::SHORT, KeyPart::DOUBLE, KeyPart::FLOAT, KeyPart::STRING, KeyPart::BYTEARRAY };
+	int sizes[] = { -1, -1, -1, -1, -1, 8, 4 };
+	for (int i = 0; i < 7; i++) {
+		rawComparator.addKeyPart(types[i], sizes[i]);
+		normalizedComparator.addKeyPart(types[i], sizes[i]);
+	}
+	normalizedComparator.setNormalized(true);
+
+	if (normalizedComparator.getKeySize() != 38) {
+		DEEP_LOG(ERROR, OTHER, "FAILED !!! normalized key size: %d\n", normalizedComparator.getKeySize());
+		exit(-1);
+	}
+
+	CompositeKey k1(38);
+	CompositeKey k2(38);
+	CompositeKey n1(38);
+	CompositeKey n2(38);
+
+	for (int i = 0; i < 200000; i++) {
+		fillNormalizedKey(k1);
+		fillNormalizedKey(k2);
+		if ((i % 4) == 0) {
+			memcpy((bytearray) k2, (bytearray) k1, 26);
+		}
+
+		normalizedComparator.normalize(&k1, &n1);
+		normalizedComparator.normalize(&k2, &n2);
+
+		#ifdef COM_DEEPIS_DB_CARDINALITY
+		inttype rawPos = 0;
+		inttype normalizedPos = 0;
+		inttype raw = rawComparator.compare(&k1, &k2, &rawPos);
+		inttype normalized = normalizedComparator.compare(&n1, &n2, &normalizedPos);
+		#else
+		inttype raw = rawComparator.compare(&k1, &k2);
+		inttype normalized = normalizedComparator.compare(&n1, &n2);
+		#endif
+
+		if (sign(raw) != sign(normalized)) {
+			DEEP_LOG(ERROR, OTHER, "FAILED !!! normalized compare: %d, expected: %d\n", normalized, raw);
+			exit(-1);
+		}
+
+		#ifdef COM_DEEPIS_DB_CARDINALITY
+		if (rawPos != normalizedPos) {
+			DEEP_LOG(ERROR, OTHER, "FAILED !!! normalized position: %d, expected: %d\n", normalizedPos, rawPos);
+			exit(-1);
+		}
+		#endif
+	}
+
+	// XXX: a tree over normalized keys, probed with normalized keys
+	#ifdef COM_DEEPIS_DB_CARDINALITY
+	TreeMap<CompositeKey*, CompositeKey*> map(&normalizedComparator, 23, true, false, 7);
+	#else
+	TreeMap<CompositeKey*, CompositeKey*> map(&normalizedComparator, 23, true, false);
+	#endif
+
+	for (int i = -1000; i < 1000; i++) {
+		memset((bytearray) k1, 0, 38);
+		longtype l = i * 3;
+		memcpy((bytearray) k1 + 4, &l, 8);
+
+		map.put(normalizedComparator.normalize(&k1), null);
+	}
+
+	longtype last = -3003;
+	MapEntry<CompositeKey*, CompositeKey*>* entry;
+	Set<MapEntry<CompositeKey*, CompositeKey*>*>* entrySet = map.entrySet();
+	Iterator<MapEntry<CompositeKey*, CompositeKey*>*>* iter = entrySet->iterator();
+	while (iter->hasNext() == true) {
+		entry = iter->next();
+
+		// XXX: decode the big-endian, sign flipped long
+		ulongtype value = 0;
+		for (int j = 0; j < 8; j++) {
+			value = (value << 8) | (ubytetype) ((bytearray) *entry->getKey())[4 + j];
+		}
+		longtype l = (longtype) (value ^ (((ulongtype) 1) << 63));
+
+		if (l != last + 3) {
+			DEEP_LOG(ERROR, OTHER, "FAILED !!! normalized order: %lld, expected: %lld\n", l, last + 3);
+			exit(-1);
+		}
+		last = l;
+	}
+	delete entrySet;
+	delete iter;
+
+	memset((bytearray) k1, 0, 38);
+	longtype l = -3;
+	memcpy((bytearray) k1 + 4, &l, 8);
+	normalizedComparator.normalize(&k1, &n1);
+	if ((map.containsKey(&n1) == false) || (map.size() != 2000)) {
+		DEEP_LOG(ERROR, OTHER, "FAILED !!! normalized get: %d\n", map.size());
+		exit(-1);
+	}
+}
+
+static void fillStaticKey(bytearray bytes, int seed) {
+	inttype i = seed % 3;
+	longtype l = (seed / 3) % 5 - 2;
+	shorttype s = seed % 2;
+	memcpy(bytes, &i, 4);
+	memcpy(bytes + 4, &l, 8);
+	memset(bytes + 12, 0, 8);
+	bytes[12] = 'a' + ((seed / 15) % 3);
+	memcpy(bytes + 20, &s, 2);
+}
+
+void testStatic() {
+	Comparator<CompositeKey*> dynamicComparator;
+	dynamicComparator.addKeyPart(KeyPart::INTEGER);
+	dynamicComparator.addKeyPart(KeyPart::LONG);
+	dynamicComparator.addKeyPart(KeyPart::STRING, 8);
+	dynamicComparator.addKeyPart(KeyPart::SHORT);
+
+	StaticComparator staticComparator;
+
+	if ((StaticComparator::PARTS != 4) || (StaticComparator::SIZE != 22)) {
+		DEEP_LOG(ERROR, OTHER, "FAILED !!! static schema: %d, %d\n", StaticComparator::PARTS, StaticComparator::SIZE);
+		exit(-1);
+	}
+
+	// XXX: schemas are not capped in width, parts past the eighth compare (and report positions) too
+	if ((WideComparator::PARTS != 12) || (WideComparator::SIZE != 48)) {
+		DEEP_LOG(ERROR, OTHER, "FAILED !!! wide schema: %d, %d\n", WideComparator::PARTS, WideComparator::SIZE);
+		exit(-1);
+	}
+
+	WideComparator wideComparator;
+	CompositeKey w1(WideComparator::SIZE);
+	CompositeKey w2(WideComparator::SIZE);
+	for (int i = 0; i < WideComparator::PARTS; i++) {
+		int v = i;
+		memcpy(((bytearray) w1) + (i * 4), &v, 4);
+		memcpy(((bytearray) w2) + (i * 4), &v, 4);
+	}
+
+	int last = 100;
+	memcpy(((bytearray) w2) + ((WideComparator::PARTS - 1) * 4), &last, 4);
+
+	#ifdef COM_DEEPIS_DB_CARDINALITY
+	inttype widePos = 0;
+	inttype wide = wideComparator.compare(&w1, &w2, &widePos);
+	if (widePos != (WideComparator::PARTS - 1)) {
+		DEEP_LOG(ERROR, OTHER, "FAILED !!! wide position: %d\n", widePos);
+		exit(-1);
+	}
+	#else
+	inttype wide = wideComparator.compare(&w1, &w2);
+	#endif
+
+	if ((wide >= 0) || (wideComparator.compare(&w2, &w1) <= 0) || (wideComparator.compare(&w1, &w1) != 0)) {
+		DEEP_LOG(ERROR, OTHER, "FAILED !!! wide compare: %d\n", wide);
+		exit(-1);
+	}
+
+	CompositeKey k1(StaticComparator::SIZE);
+	CompositeKey k2(StaticComparator::SIZE);
+
+	for (int i = 0; i < 90; i++) {
+		for (int j = 0; j < 90; j++) {
+			fillStaticKey(k1, i);
+			fillStaticKey(k2, j);
+
+			#ifdef COM_DEEPIS_DB_CARDINALITY
+			inttype dynamicPos = 0;
+			inttype staticPos = 0;
+			inttype expected = dynamicComparator.compare(&k1, &k2, &dynamicPos);
+			inttype actual = staticComparator.compare(&k1, &k2, &staticPos);
+			#else
+			inttype expected = dynamicComparator.compare(&k1, &k2);
+			inttype actual = staticComparator.compare(&k1, &k2);
+			#endif
+
+			if (sign(expected) != sign(actual)) {
+				DEEP_LOG(ERROR, OTHER, "FAILED !!! static compare: %d, expected: %d\n", actual, expected);
+				exit(-1);
+			}
+
+			#ifdef COM_DEEPIS_DB_CARDINALITY
+			if (dynamicPos != staticPos) {
+				DEEP_LOG(ERROR, OTHER, "FAILED !!! static position: %d, expected: %d\n", staticPos, dynamicPos);
+				exit(-1);
+			}
+			#endif
+		}
+	}
+
+	// XXX: the key type selects Comparator<StaticCompositeKey<StaticComparator>*>
+	TreeMap<StaticCompositeKey<StaticComparator>*, longtype> map(23, true, false);
+
+	TreeSet<CompositeKey*, StaticComparator> set(&staticComparator);
+
+	for (int i = 0; i < 90; i++) {
+		StaticCompositeKey<StaticComparator>* key = new StaticCompositeKey<StaticComparator>();
+		fillStaticKey(*key, (i * 7) % 90);
+		map.put(key, (i * 7) % 90);
+		set.add(key);
+	}
+
+	for (int i = 0; i < 90; i++) {
+		bytetype k[StaticComparator::SIZE];
+		fillStaticKey(k, i);
+
+		StaticCompositeKey<StaticComparator> key(k);
+		if ((map.get(&key) != i) || (set.contains(&key) == false)) {
+			DEEP_LOG(ERROR, OTHER, "FAILED !!! static get: %d\n", i);
+			exit(-1);
+		}
+	}
+
+	set.clear();
+}
+
+#ifdef COM_DEEPIS_DB_CARDINALITY
+static void fillPrefixedKey(bytearray bytes) {
+	// XXX: short, string (5), double cut by the 8 byte prefix, integer; narrow ranges so prefixes tie often
+	shorttype s = (rand() % 3) - 1;
+	doubletype d = ((rand() % 3) - 1) * 0.5;
+	inttype i = (rand() % 7) - 3;
+	if ((d == 0) && ((rand() % 2) == 0)) {
+		d = -0.0;
+	}
+
+	memcpy(bytes, &s, 2);
+	for (int j = 0; j < 5; j++) {
+		bytes[2 + j] = 'a' + (rand() % 2);
+	}
+	bytes[2 + (rand() % 5)] = ((rand() % 2) == 0) ? 0 : bytes[2];
+	memcpy(bytes + 7, &d, 8);
+	memcpy(bytes + 15, &i, 4);
+}
+
+void testPrefixed() {
+	Comparator<CompositeKey*> rawComparator;
+	rawComparator.addKeyPart(KeyPart::SHORT);
+	rawComparator.addKeyPart(KeyPart::STRING, 5);
+	rawComparator.addKeyPart(KeyPart::DOUBLE);
+	rawComparator.addKeyPart(KeyPart::INTEGER);
+
+	Comparator<CompositeKey*> normalizedComparator;
+	normalizedComparator.addKeyPart(KeyPart::SHORT);
+	normalizedComparator.addKeyPart(KeyPart::STRING, 5);
+	normalizedComparator.addKeyPart(KeyPart::DOUBLE);
+	normalizedComparator.addKeyPart(KeyPart::INTEGER);
+	normalizedComparator.setNormalized(true);
+
+	// XXX: a prefix may tie where compare does not, but never contradict it
+	CompositeKey k1(19);
+	CompositeKey k2(19);
+	CompositeKey n1(19);
+	CompositeKey n2(19);
+	for (int i = 0; i < 100000; i++) {
+		fillPrefixedKey(k1);
+		fillPrefixedKey(k2);
+		normalizedComparator.normalize(&k1, &n1);
+		normalizedComparator.normalize(&k2, &n2);
+
+		inttype raw = sign(rawComparator.compare(&k1, &k2));
+		inttype normalized = sign(normalizedComparator.compare(&n1, &n2));
+
+		ulongtype p1 = TreeKeyPrefix<CompositeKey*>::prefix(&rawComparator, TreeKeyPrefix<CompositeKey*>::leading(&k1));
+		ulongtype p2 = TreeKeyPrefix<CompositeKey*>::prefix(&rawComparator, TreeKeyPrefix<CompositeKey*>::leading(&k2));
+		ulongtype q1 = TreeKeyPrefix<CompositeKey*>::prefix(&normalizedComparator, TreeKeyPrefix<CompositeKey*>::leading(&n1));
+		ulongtype q2 = TreeKeyPrefix<CompositeKey*>::prefix(&normalizedComparator, TreeKeyPrefix<CompositeKey*>::leading(&n2));
+
+		if (((p1 != p2) && (raw != ((p1 < p2) ? -1 : 1))) || ((q1 != q2) && (normalized != ((q1 < q2) ? -1 : 1)))) {
+			DEEP_LOG(ERROR, OTHER, "FAILED !!! composite prefix order: %d\n", i);
+			exit(-1);
+		}
+	}
+
+	// XXX: prefixed separators descend like full ones, ties included
+	const int KEYS = 20000;
+	CompositeKey** keys = new CompositeKey*[KEYS];
+
+	#ifdef COM_DEEPIS_DB_CARDINALITY
+	TreeMap<CompositeKey*, CompositeKey*> map(&rawComparator, 23, false, false, 4);
+	#else
+	TreeMap<CompositeKey*, CompositeKey*> map(&rawComparator, 23, false, false);
+	#endif
+
+	for (int i = 0; i < KEYS; i++) {
+		keys[i] = new CompositeKey(19);
+		fillPrefixedKey(*keys[i]);
+		map.put(keys[i], keys[i]);
+	}
+
+	for (int i = 0; i < KEYS; i++) {
+		CompositeKey* value = map.get(keys[i]);
+		if ((value == null) || (rawComparator.compare(value, keys[i]) != 0)) {
+			DEEP_LOG(ERROR, OTHER, "FAILED !!! prefixed get: %d\n", i);
+			exit(-1);
+		}
+	}
+
+	CompositeKey* last = null;
+	Set<MapEntry<CompositeKey*, CompositeKey*>*>* entrySet = map.entrySet();
+	Iterator<MapEntry<CompositeKey*, CompositeKey*>*>* iter = entrySet->iterator();
+	while (iter->hasNext() == true) {
+		CompositeKey* key = iter->next()->getKey();
+		if ((last != null) && (rawComparator.compare(last, key) >= 0)) {
+			DEEP_LOG(ERROR, OTHER, "FAILED !!! prefixed order\n");
+			exit(-1);
+		}
+		last = key;
+	}
+	delete entrySet;
+	delete iter;
+
+	map.clear();
+	for (int i = 0; i < KEYS; i++) {
+		delete keys[i];
+	}
+	delete [] keys;
+
+	// XXX: nbyte orders by length first, lengths and the first four bytes decide most comparisons
+	Comparator<nbyte*> byteComparator;
+	TreeMap<nbyte*, longtype> bytes(&byteComparator, 23, false, false);
+
+	nbyte* values[KEYS];
+	for (int i = 0; i < KEYS; i++) {
+		values[i] = new nbyte(1 + (i % 7));
+		for (int j = 0; j < values[i]->length; j++) {
+			((bytearray) *values[i])[j] = (bytetype) ((j < 3) ? (i % 3) : ((i * 31) >> j));
+		}
+		bytes.put(values[i], i);
+	}
+
+	for (int i = 0; i < KEYS; i++) {
+		boolean found = false;
+		bytes.get(values[i], null, &found);
+		if (found == false) {
+			DEEP_LOG(ERROR, OTHER, "FAILED !!! prefixed nbyte get: %d\n", i);
+			exit(-1);
+		}
+	}
+
+	nbyte* previous = null;
+	Set<MapEntry<nbyte*, longtype>*>* byteSet = bytes.entrySet();
+	Iterator<MapEntry<nbyte*, longtype>*>* byteIter = byteSet->iterator();
+	while (byteIter->hasNext() == true) {
+		nbyte* key = byteIter->next()->getKey();
+		if ((previous != null) && (previous->compareTo(key) >= 0)) {
+			DEEP_LOG(ERROR, OTHER, "FAILED !!! prefixed nbyte order\n");
+			exit(-1);
+		}
+		previous = key;
+	}
+	delete byteSet;
+	delete byteIter;
+
+	bytes.clear();
+	for (int i = 0; i < KEYS; i++) {
+		delete values[i];
+	}
+}
+
+static void fillSketchKey(bytearray bytes, int i) {
+	int key1 = i % 7;
+	int key2 = i % 3;
+	int key3 = i;
+	memcpy(bytes, &key1, 4);
+	memcpy(bytes + 4, &key2, 4);
+	memcpy(bytes + 8, &key3, 4);
+}
+
+static boolean withinSketchError(inttype estimate, inttype exact) {
+	// XXX: a few standard errors of the default precision
+	inttype slack = (exact / 10) + 2;
+	return (estimate >= exact - slack) && (estimate <= exact + slack);
+}
+
+void testSketch() {
+	const int SKETCH_COUNT = 50000;
+
+	TreeMap<CompositeKey*, CompositeKey*> exact(&compositeKeyComparator, 23, true, false, 3);
+	TreeMap<CompositeKey*, CompositeKey*> sketched(&compositeKeyComparator, 23, true, false, 3);
+	TreeMap<CompositeKey*, CompositeKey*> even(&compositeKeyComparator, 23, true, false, 3);
+	TreeMap<CompositeKey*, CompositeKey*> odd(&compositeKeyComparator, 23, true, false, 3);
+	exact.setStatisticsEnabled(true);
+	sketched.setStatisticsEnabled(true);
+	even.setStatisticsEnabled(true);
+	odd.setStatisticsEnabled(true);
+	sketched.setCardinalitySketchEnabled(true);
+	even.setCardinalitySketchEnabled(true);
+	odd.setCardinalitySketchEnabled(true);
+
+	for (int i = 0; i < SKETCH_COUNT; i++) {
+		CompositeKey* key = new CompositeKey(4 + 4 + 4);
+		fillSketchKey(*key, i);
+		exact.put(key, null);
+
+		key = new CompositeKey(4 + 4 + 4);
+		fillSketchKey(*key, i);
+		sketched.put(key, null);
+
+		key = new CompositeKey(4 + 4 + 4);
+		fillSketchKey(*key, i);
+		if ((i % 2) == 0) {
+			even.put(key, null);
+
+		} else {
+			odd.put(key, null);
+		}
+	}
+
+	inttype estimate[3];
+	const inttype* counts = exact.getCardinality();
+
+	// XXX: partitions of one index merge into the statistics of the whole
+	even.mergeCardinality(&odd);
+
+	for (int m = 0; m < 2; m++) {
+		((m == 0) ? sketched : even).getCardinalityEstimate(estimate);
+
+		for (int i = 0; i < 3; i++) {
+			if (withinSketchError(estimate[i], counts[i]) == false) {
+				DEEP_LOG(ERROR, OTHER, "FAILED !!! sketch %d part %d: %d, exact: %d\n", m, i, estimate[i], counts[i]);
+				exit(-1);
+			}
+		}
+	}
+
+	// XXX: removes leave the sketches alone, recalculating brings back exact counts
+	for (int i = 0; i < SKETCH_COUNT; i += 4) {
+		bytetype k[4 + 4 + 4];
+		fillSketchKey(k, i);
+
+		CompositeKey key((const bytearray) k, 4 + 4 + 4);
+		exact.remove(&key);
+		sketched.remove(&key);
+	}
+
+	sketched.recalculateCardinality();
+	sketched.getCardinalityEstimate(estimate);
+
+	counts = exact.getCardinality();
+	const inttype* recounts = sketched.getCardinality();
+	for (int i = 0; i < 3; i++) {
+		if ((recounts[i] != counts[i]) || (withinSketchError(estimate[i], counts[i]) == false)) {
+			DEEP_LOG(ERROR, OTHER, "FAILED !!! recalculated part %d: %d / %d, exact: %d\n", i, recounts[i], estimate[i], counts[i]);
+			exit(-1);
+		}
+	}
+
+	// XXX: turning sketches off goes back to exact maintenance
+	sketched.setCardinalitySketchEnabled(false);
+	sketched.getCardinalityEstimate(estimate);
+	if ((sketched.getCardinalitySketchEnabled() == true) || (memcmp(estimate, exact.getCardinality(), sizeof(estimate)) != 0)) {
+		DEEP_LOG(ERROR, OTHER, "FAILED !!! sketch disable\n");
+		exit(-1);
+	}
+
+	// XXX: static schemas hash their prefixes exactly like the dynamic comparator does
+	Comparator<CompositeKey*> dynamicComparator;
+	dynamicComparator.addKeyPart(KeyPart::INTEGER);
+	dynamicComparator.addKeyPart(KeyPart::LONG);
+	dynamicComparator.addKeyPart(KeyPart::STRING, 8);
+	dynamicComparator.addKeyPart(KeyPart::SHORT);
+
+	Comparator<StaticCompositeKey<StaticComparator>*> staticComparator;
+
+	for (int i = 0; i < 90; i++) {
+		StaticCompositeKey<StaticComparator> key;
+		fillStaticKey(key, i);
+
+		ulongtype dynamicHashes[5];
+		ulongtype staticHashes[5];
+		KeyPrefixHash<CompositeKey*>::hash(&dynamicComparator, &key, dynamicHashes, 5);
+		KeyPrefixHash<StaticCompositeKey<StaticComparator>*>::hash(&staticComparator, &key, staticHashes, 5);
+
+		if ((memcmp(dynamicHashes, staticHashes, sizeof(dynamicHashes)) != 0) || (staticHashes[3] != staticHashes[4])) {
+			DEEP_LOG(ERROR, OTHER, "FAILED !!! static prefix hash: %d\n", i);
+			exit(-1);
+		}
+	}
+}
+#endif
+
+#ifdef COM_DEEPIS_DB_CARDINALITY
+void testBatch() {
+	const int BATCH_COUNT = 20000;
+	const int BATCH = 700;
+
+	TreeMap<CompositeKey*, CompositeKey*> exact(&compositeKeyComparator, 23, true, false, 3);
+	TreeMap<CompositeKey*, CompositeKey*> batched(&compositeKeyComparator, 23, true, false, 3);
+	exact.setStatisticsEnabled(true);
+	batched.setStatisticsEnabled(true);
+
+	CompositeKey* keys[BATCH];
+	CompositeKey* vals[BATCH];
+
+	srand(1357);
+
+	// XXX: unsorted batches with repeats, the first lands in the empty tree and the rest merge into it
+	for (int done = 0; done < BATCH_COUNT; done += BATCH) {
+		for (int i = 0; i < BATCH; i++) {
+			int k = rand() % BATCH_COUNT;
+
+			CompositeKey* key = new CompositeKey(4 + 4 + 4);
+			fillSketchKey(*key, k);
+			exact.put(key, null);
+
+			keys[i] = new CompositeKey(4 + 4 + 4);
+			fillSketchKey(*keys[i], k);
+			vals[i] = null;
+		}
+
+		batched.putBatch(keys, vals, BATCH);
+
+		const inttype* expected = exact.getCardinality();
+		const inttype* actual = batched.getCardinality();
+		if ((batched.size() != exact.size()) || (memcmp(expected, actual, 3 * sizeof(inttype)) != 0)) {
+			DEEP_LOG(ERROR, OTHER, "FAILED !!! batch %d size: %d / %d, cardinality: %d %d %d, exact: %d %d %d\n", done, batched.size(), exact.size(), actual[0], actual[1], actual[2], expected[0], expected[1], expected[2]);
+			exit(-1);
+		}
+	}
+
+	// XXX: removes take back what the batches counted
+	for (int i = 0; i < BATCH_COUNT; i += 3) {
+		bytetype k[4 + 4 + 4];
+		fillSketchKey(k, i);
+
+		CompositeKey key((const bytearray) k, 4 + 4 + 4);
+		exact.remove(&key);
+		batched.remove(&key);
+	}
+
+	if (memcmp(exact.getCardinality(), batched.getCardinality(), 3 * sizeof(inttype)) != 0) {
+		DEEP_LOG(ERROR, OTHER, "FAILED !!! batch remove cardinality\n");
+		exit(-1);
+	}
+}
+#endif
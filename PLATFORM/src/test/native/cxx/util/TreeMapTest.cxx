@@ -38,10 +38,36 @@
 using namespace cxx::lang;
 using namespace cxx::util;
 
+// XXX: separators read through the entries, the layout before INLINE_SEPARATORS
+class ReferencedSeparatorTreePolicy : public TreePolicy {
+	public:
+		static const boolean INLINE_SEPARATORS = false;
+};
+
+// XXX: forward scans within nodes, whatever the build flags default to
+class LinearSearchTreePolicy : public TreePolicy {
+	public:
+		static const boolean BINARY_SEARCH = false;
+		static const boolean VECTOR_SEARCH = false;
+};
+
+// XXX: children record their position within the parent
+class SlottedTreePolicy : public PooledInlineTreePolicy {
+	public:
+		static const boolean SLOTTED_NODES = true;
+};
+
 template class TreeMap<int,int>;
 template class TreeMap<long long,long long>;
 template class TreeMap<Long*,Long*>;
 template class TreeMap<String*,String*>;
+template class TreeMap<long long,long long,void*,InlineTreePolicy>;
+template class TreeMap<long long,long long,void*,PooledTreePolicy>;
+template class TreeMap<long long,long long,void*,PooledInlineTreePolicy>;
+template class TreeMap<long long,long long,void*,ReferencedSeparatorTreePolicy>;
+template class TreeMap<long long,long long,void*,LinearSearchTreePolicy>;
+template class TreeMap<long long,long long,void*,SlottedTreePolicy>;
+template class TreeMap<long long,long long,void*,SpillTreePolicy>;
 
 Comparator<Long*> LongComparator;
 Comparator<int> intComparator;
@@ -54,6 +80,20 @@ int testTreeMapRandomRemove();
 int testTreeMapPrimLong();
 int testTreeMapPrimInt();
 int testTreeMapSize();
+int testTreeMapInline();
+template<typename P> int testTreeMapPooled(const char* name);
+template<typename P> int testTreeMapBulkLoad(const char* name);
+template<typename P> int testTreeMapLeafChain(const char* name);
+template<typename P> int testTreeMapGetAll(const char* name);
+template<typename P> int testTreeMapRemoveRange(const char* name);
+template<typename P> int testTreeMapRank(const char* name);
+template<typename P> int testTreeMapSnapshot(const char* name);
+template<typename P> int testTreeMapRangeScan(const char* name);
+template<typename P> int testTreeMapNodeBytes(const char* name);
+template<typename P> int testTreeMapHint(const char* name);
+template<typename P> int testTreeMapCursor(const char* name);
+template<typename P> int testTreeMapBatch(const char* name, int order);
+int testTreeMapSpill();
 
 int main(int argc, char** argv) {
 	int result = testTreeMapPrimInt();
@@ -82,6 +122,206 @@ int main(int argc, char** argv) {
 		return result;
 	}
 
+	result = testTreeMapInline();
+	if (result) {
+		return result;
+	}
+
+	result = testTreeMapPooled<PooledTreePolicy>("POOLED");
+	if (result) {
+		return result;
+	}
+
+	result = testTreeMapPooled<PooledInlineTreePolicy>("POOLED INLINE");
+	if (result) {
+		return result;
+	}
+
+	result = testTreeMapBulkLoad<TreePolicy>("BULK");
+	if (result) {
+		return result;
+	}
+
+	result = testTreeMapBulkLoad<PooledInlineTreePolicy>("BULK POOLED INLINE");
+	if (result) {
+		return result;
+	}
+
+	result = testTreeMapLeafChain<TreePolicy>("CHAIN");
+	if (result) {
+		return result;
+	}
+
+	result = testTreeMapLeafChain<PooledInlineTreePolicy>("CHAIN POOLED INLINE");
+	if (result) {
+		return result;
+	}
+
+	result = testTreeMapGetAll<TreePolicy>("GETALL");
+	if (result) {
+		return result;
+	}
+
+	result = testTreeMapGetAll<InlineTreePolicy>("GETALL INLINE");
+	if (result) {
+		return result;
+	}
+
+	result = testTreeMapRemoveRange<TreePolicy>("REMOVE RANGE");
+	if (result) {
+		return result;
+	}
+
+	result = testTreeMapRemoveRange<PooledTreePolicy>("REMOVE RANGE POOLED");
+	if (result) {
+		return result;
+	}
+
+	result = testTreeMapRemoveRange<PooledInlineTreePolicy>("REMOVE RANGE POOLED INLINE");
+	if (result) {
+		return result;
+	}
+
+	result = testTreeMapRank<TreePolicy>("RANK");
+	if (result) {
+		return result;
+	}
+
+	result = testTreeMapRank<PooledInlineTreePolicy>("RANK POOLED INLINE");
+	if (result) {
+		return result;
+	}
+
+	result = testTreeMapRank<ReferencedSeparatorTreePolicy>("RANK REFERENCED SEPARATORS");
+	if (result) {
+		return result;
+	}
+
+	result = testTreeMapSnapshot<TreePolicy>("SNAPSHOT");
+	if (result) {
+		return result;
+	}
+
+	result = testTreeMapSnapshot<PooledTreePolicy>("SNAPSHOT POOLED");
+	if (result) {
+		return result;
+	}
+
+	result = testTreeMapSnapshot<PooledInlineTreePolicy>("SNAPSHOT POOLED INLINE");
+	if (result) {
+		return result;
+	}
+
+	result = testTreeMapRangeScan<TreePolicy>("RANGE SCAN");
+	if (result) {
+		return result;
+	}
+
+	result = testTreeMapRangeScan<PooledInlineTreePolicy>("RANGE SCAN POOLED INLINE");
+	if (result) {
+		return result;
+	}
+
+	result = testTreeMapRangeScan<ReferencedSeparatorTreePolicy>("RANGE SCAN REFERENCED SEPARATORS");
+	if (result) {
+		return result;
+	}
+
+	result = testTreeMapNodeBytes<TreePolicy>("NODE BYTES");
+	if (result) {
+		return result;
+	}
+
+	result = testTreeMapNodeBytes<PooledInlineTreePolicy>("NODE BYTES POOLED INLINE");
+	if (result) {
+		return result;
+	}
+
+	result = testTreeMapHint<TreePolicy>("HINT");
+	if (result) {
+		return result;
+	}
+
+	result = testTreeMapHint<PooledInlineTreePolicy>("HINT POOLED INLINE");
+	if (result) {
+		return result;
+	}
+
+	result = testTreeMapCursor<TreePolicy>("CURSOR");
+	if (result) {
+		return result;
+	}
+
+	result = testTreeMapCursor<InlineTreePolicy>("CURSOR INLINE");
+	if (result) {
+		return result;
+	}
+
+	result = testTreeMapBatch<TreePolicy>("BATCH", 3);
+	if (result) {
+		return result;
+	}
+
+	result = testTreeMapBatch<TreePolicy>("BATCH PAGE", TreeMap<long long, long long>::orderFor(TreeMap<long long, long long>::NODE_BYTES_PAGE));
+	if (result) {
+		return result;
+	}
+
+	result = testTreeMapBatch<PooledInlineTreePolicy>("BATCH POOLED INLINE", 11);
+	if (result) {
+		return result;
+	}
+
+	result = testTreeMapBatch<ReferencedSeparatorTreePolicy>("BATCH REFERENCED SEPARATOR", 7);
+	if (result) {
+		return result;
+	}
+
+	result = testTreeMapRank<LinearSearchTreePolicy>("RANK LINEAR SEARCH");
+	if (result) {
+		return result;
+	}
+
+	result = testTreeMapRank<SlottedTreePolicy>("RANK SLOTTED");
+	if (result) {
+		return result;
+	}
+
+	result = testTreeMapRangeScan<LinearSearchTreePolicy>("RANGE SCAN LINEAR SEARCH");
+	if (result) {
+		return result;
+	}
+
+	result = testTreeMapRangeScan<SlottedTreePolicy>("RANGE SCAN SLOTTED");
+	if (result) {
+		return result;
+	}
+
+	result = testTreeMapHint<LinearSearchTreePolicy>("HINT LINEAR SEARCH");
+	if (result) {
+		return result;
+	}
+
+	result = testTreeMapHint<SlottedTreePolicy>("HINT SLOTTED");
+	if (result) {
+		return result;
+	}
+
+	result = testTreeMapBatch<LinearSearchTreePolicy>("BATCH LINEAR SEARCH", 5);
+	if (result) {
+		return result;
+	}
+
+	result = testTreeMapBatch<SlottedTreePolicy>("BATCH SLOTTED", 5);
+	if (result) {
+		return result;
+	}
+
+	result = testTreeMapSpill();
+	if (result) {
+		return result;
+	}
+
 	/*
 	for (int i=1; i<=5; i++) {
 		DEEP_LOG(INFO, OTHER, " Random test %d of %d\n", i, 5);
@@ -1143,3 +1383,1527 @@ int testTreeMapSize() {
 }
 
 
+
+int testTreeMapInline() {
+	TreeMap<long long, long long, void*, InlineTreePolicy> map(&longlongComparator, 3, false, false);
+
+	int COUNT = 100000;
+	int size = 0;
+	long long retkey;
+	boolean status;
+
+	for (int i = COUNT; i >= 0; i -= 2) {
+		MapEntry<long long, long long>* entry = null;
+		map.put(i, i * 10, null, null, &entry);
+		size++;
+
+		if ((entry == null) || (entry->getKey() != i) || (entry->getValue() != i * 10)) {
+			DEEP_LOG(ERROR, OTHER, "FAILED - inline put entry view for key: %d\n", i);
+			return 1;
+		}
+	}
+
+	for (int i = 1; i <= COUNT; i += 2) {
+		map.put(i, i * 10);
+		size++;
+	}
+
+	for (int i = 0; i <= COUNT; i += 3) {
+		long long val = map.remove(i, &retkey, &status);
+		if ((status == false) || (retkey != i) || (val != i * 10)) {
+			DEEP_LOG(ERROR, OTHER, "FAILED - inline remove key: %d, retkey: %lld, value: %lld\n", i, retkey, val);
+			return 1;
+		}
+		size--;
+	}
+
+	DEEP_LOG(INFO, OTHER, "INLINE MAP SIZE: %d, EXPECT: %d\n", map.size(), size);
+
+	if (size != map.size()) {
+		DEEP_LOG(ERROR, OTHER, "FAILED - inline map size: %d, expected: %d\n", map.size(), size);
+		return 1;
+	}
+
+	long long last = -1;
+	int count = 0;
+	TreeMap<long long, long long, void*, InlineTreePolicy>::TreeMapEntryIterator* iter = (TreeMap<long long, long long, void*, InlineTreePolicy>::TreeMapEntryIterator*) map.iterator(map.firstKey());
+	while (iter->hasNext()) {
+		MapEntry<long long, long long>* entry = iter->next();
+		if ((entry->getKey() <= last) || ((entry->getKey() % 3) == 0) || (entry->getValue() != entry->getKey() * 10)) {
+			DEEP_LOG(ERROR, OTHER, "FAILED - inline iteration at key: %lld, last: %lld\n", entry->getKey(), last);
+			return 1;
+		}
+
+		last = entry->getKey();
+		count++;
+	}
+	delete iter;
+
+	if (count != size) {
+		DEEP_LOG(ERROR, OTHER, "FAILED - inline iteration count: %d, expected: %d\n", count, size);
+		return 1;
+	}
+
+	Set<MapEntry<long long, long long>*>* eset = map.entrySet();
+	Iterator<MapEntry<long long, long long>*>* eiter = eset->iterator();
+	while (eiter->hasNext()) {
+		MapEntry<long long, long long>* entry = eiter->next();
+		if ((entry->getKey() % 2) == 0) {
+			eiter->remove();
+			size--;
+		}
+	}
+	delete eiter;
+	delete eset;
+
+	if ((size != map.size()) || (map.containsKey(4) == true) || (map.get(5) != 50)) {
+		DEEP_LOG(ERROR, OTHER, "FAILED - inline iterator remove, size: %d, expected: %d\n", map.size(), size);
+		return 1;
+	}
+
+	map.clear();
+	if (map.size() != 0) {
+		DEEP_LOG(ERROR, OTHER, "FAILED - inline clear size: %d\n", map.size());
+		return 1;
+	}
+
+	return 0;
+}
+
+template<typename P>
+int testTreeMapPooled(const char* name) {
+	TreeMap<long long, long long, void*, P> map(&longlongComparator, 7, false, false);
+	TreeMap<long long, long long, void*, P> other(&longlongComparator, 7, false, false);
+
+	int COUNT = 200000;
+
+	for (int round = 0; round < 3; round++) {
+		int size = 0;
+
+		for (int i = 0; i < COUNT; i++) {
+			long long key = (i * 7919LL) % COUNT;
+			map.put(key, key + round);
+			size++;
+		}
+
+		// XXX: removal merges nodes back onto the free lists, reinsertion recycles them
+		for (int i = 0; i < COUNT; i += 2) {
+			map.remove(i);
+			size--;
+		}
+
+		for (int i = 0; i < COUNT; i += 4) {
+			map.put(i, i + round);
+			size++;
+		}
+
+		if (map.size() != size) {
+			DEEP_LOG(ERROR, OTHER, "FAILED - %s map size: %d, expected: %d\n", name, map.size(), size);
+			return 1;
+		}
+
+		for (int i = 0; i < COUNT; i++) {
+			boolean status;
+			long long val = map.get(i, null, &status);
+			boolean expected = ((i % 2) == 1) || ((i % 4) == 0);
+			if ((status != expected) || ((status == true) && (val != i + round))) {
+				DEEP_LOG(ERROR, OTHER, "FAILED - %s map get key: %d, status: %d, value: %lld\n", name, i, status, val);
+				return 1;
+			}
+		}
+
+		DEEP_LOG(INFO, OTHER, "%s MAP ROUND %d SIZE: %d\n", name, round, map.size());
+
+		// XXX: release whole slabs, the map must be reusable afterwards
+		map.clear();
+		if ((map.size() != 0) || (map.containsKey(1) == true)) {
+			DEEP_LOG(ERROR, OTHER, "FAILED - %s map clear size: %d\n", name, map.size());
+			return 1;
+		}
+	}
+
+	for (int i = 0; i < 1000; i++) {
+		map.put(i, i);
+	}
+
+	map.transfer(&other);
+	map.put(5, 5);
+
+	if ((other.size() != 1000) || (other.get(999) != 999) || (map.size() != 1)) {
+		DEEP_LOG(ERROR, OTHER, "FAILED - %s map transfer size: %d\n", name, other.size());
+		return 1;
+	}
+
+	return 0;
+}
+
+template<typename P>
+int testTreeMapBulkLoad(const char* name) {
+	int COUNTS[] = { 0, 1, 2, 7, 8, 9, 15, 16, 17, 100, 12345 };
+	double FILLS[] = { 1.0, 0.75, 0.5, 0.1 };
+
+	int COUNT = 12345;
+	long long* keys = new long long[COUNT];
+	long long* vals = new long long[COUNT];
+	for (int i = 0; i < COUNT; i++) {
+		keys[i] = i * 2;
+		vals[i] = i * 20;
+	}
+
+	for (int c = 0; c < (int) (sizeof(COUNTS) / sizeof(int)); c++) {
+		for (int f = 0; f < (int) (sizeof(FILLS) / sizeof(double)); f++) {
+			int count = COUNTS[c];
+
+			TreeMap<long long, long long, void*, P> map(&longlongComparator, 3, false, false, 2);
+			map.setStatisticsEnabled(true);
+			map.bulkLoad(keys, vals, count, FILLS[f]);
+
+			if ((map.size() != count) || (map.vsize() != count) || (map.getCardinality()[0] != count)) {
+				DEEP_LOG(ERROR, OTHER, "FAILED - %s load size: %d, expected: %d, fill: %f\n", name, map.size(), count, FILLS[f]);
+				return 1;
+			}
+
+			Set<MapEntry<long long,long long>* >* entrySet = map.entrySet();
+			Iterator<MapEntry<long long,long long>* >* iter = entrySet->iterator();
+			for (int i = 0; i < count; i++) {
+				MapEntry<long long,long long>* entry = (MapEntry<long long,long long>*) iter->next();
+				if ((entry->getKey() != keys[i]) || (entry->getValue() != vals[i])) {
+					DEEP_LOG(ERROR, OTHER, "FAILED - %s load iterator: %lld, expected: %lld\n", name, entry->getKey(), keys[i]);
+					return 1;
+				}
+			}
+			if (iter->hasNext() == true) {
+				DEEP_LOG(ERROR, OTHER, "FAILED - %s load iterator overrun, count: %d\n", name, count);
+				return 1;
+			}
+			delete entrySet;
+			delete iter;
+
+			// XXX: the loaded tree must keep rebalancing through the regular paths
+			for (int i = 0; i < count; i++) {
+				map.put(keys[i] + 1, vals[i] + 1);
+			}
+			for (int i = 0; i < count; i += 2) {
+				map.remove(keys[i]);
+			}
+
+			int size = count + (count / 2);
+			if ((map.size() != size) || (map.vsize() != size)) {
+				DEEP_LOG(ERROR, OTHER, "FAILED - %s reload size: %d, expected: %d\n", name, map.size(), size);
+				return 1;
+			}
+
+			for (int i = 0; i < count; i++) {
+				boolean status;
+				long long val = map.get(keys[i], null, &status);
+				if ((status != ((i % 2) == 1)) || ((status == true) && (val != vals[i]))) {
+					DEEP_LOG(ERROR, OTHER, "FAILED - %s reload get key: %lld, status: %d\n", name, keys[i], status);
+					return 1;
+				}
+
+				if (map.get(keys[i] + 1) != vals[i] + 1) {
+					DEEP_LOG(ERROR, OTHER, "FAILED - %s reload get key: %lld\n", name, keys[i] + 1);
+					return 1;
+				}
+			}
+		}
+	}
+
+	// XXX: out of order input finishes the bulk part and falls back to put
+	TreeMap<long long, long long, void*, P> map(&longlongComparator, 3, false, false);
+	long long unsorted[] = { 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14, 15, 16, 17, 0, 5, 20 };
+	map.bulkLoad(unsorted, unsorted, 20);
+	if ((map.size() != 19) || (map.firstKey() != 0) || (map.lastKey() != 20)) {
+		DEEP_LOG(ERROR, OTHER, "FAILED - %s unsorted load size: %d\n", name, map.size());
+		return 1;
+	}
+
+	// XXX: putAll into an empty tree loads bottom-up
+	TreeMap<long long, long long, void*, P> copy(&longlongComparator, 3, false, false);
+	copy.putAll(&map);
+	if ((copy.size() != map.size()) || (copy.get(17) != 17) || (copy.lastKey() != 20)) {
+		DEEP_LOG(ERROR, OTHER, "FAILED - %s putAll size: %d\n", name, copy.size());
+		return 1;
+	}
+
+	delete [] keys;
+	delete [] vals;
+
+	DEEP_LOG(INFO, OTHER, "%s LOAD SUCCESS\n", name);
+
+	return 0;
+}
+
+template<typename P>
+int testTreeMapLeafChain(const char* name) {
+	const int MAX_KEY = 20000;
+	const int ROUNDS = 4;
+
+	boolean* present = new boolean[MAX_KEY];
+	memset(present, 0, MAX_KEY * sizeof(boolean));
+
+	TreeMap<long long, long long, void*, P> map(&longlongComparator, 3, false, false);
+
+	srand(1234);
+
+	for (int r = 0; r < ROUNDS; r++) {
+		// XXX: alternate growing and shrinking so leaves split, merge and rebalance with their siblings
+		for (int i = 0; i < MAX_KEY; i++) {
+			int key = rand() % MAX_KEY;
+			if ((r % 2) == 0) {
+				map.put(key, key * 10);
+				present[key] = true;
+
+			} else {
+				map.remove(key);
+				present[key] = false;
+			}
+		}
+
+		int count = 0;
+		for (int i = 0; i < MAX_KEY; i++) {
+			if (present[i] == true) {
+				count++;
+			}
+		}
+
+		if (map.size() != count) {
+			DEEP_LOG(ERROR, OTHER, "FAILED - %s chain size: %d, expected: %d\n", name, map.size(), count);
+			return 1;
+		}
+
+		Set<MapEntry<long long,long long>* >* entrySet = map.entrySet();
+		Iterator<MapEntry<long long,long long>* >* iter = entrySet->iterator();
+		for (int i = 0; i < MAX_KEY; i++) {
+			if (present[i] == false) {
+				continue;
+			}
+
+			if (iter->hasNext() == false) {
+				DEEP_LOG(ERROR, OTHER, "FAILED - %s chain forward underrun at: %d\n", name, i);
+				return 1;
+			}
+
+			MapEntry<long long,long long>* entry = (MapEntry<long long,long long>*) iter->next();
+			if ((entry->getKey() != i) || (entry->getValue() != i * 10)) {
+				DEEP_LOG(ERROR, OTHER, "FAILED - %s chain forward: %lld, expected: %d\n", name, entry->getKey(), i);
+				return 1;
+			}
+		}
+		if (iter->hasNext() == true) {
+			DEEP_LOG(ERROR, OTHER, "FAILED - %s chain forward overrun\n", name);
+			return 1;
+		}
+		delete entrySet;
+		delete iter;
+
+		if (count == 0) {
+			continue;
+		}
+
+		TreeIterator<MapEntry<long long,long long>*>* titer = map.iterator(map.lastKey());
+		for (int i = map.lastKey() - 1; i >= 0; i--) {
+			if (present[i] == false) {
+				continue;
+			}
+
+			if (titer->hasPrevious() == false) {
+				DEEP_LOG(ERROR, OTHER, "FAILED - %s chain backward underrun at: %d\n", name, i);
+				return 1;
+			}
+
+			MapEntry<long long,long long>* entry = (MapEntry<long long,long long>*) titer->previous();
+			if ((entry->getKey() != i) || (entry->getValue() != i * 10)) {
+				DEEP_LOG(ERROR, OTHER, "FAILED - %s chain backward: %lld, expected: %d\n", name, entry->getKey(), i);
+				return 1;
+			}
+		}
+		if (titer->hasPrevious() == true) {
+			DEEP_LOG(ERROR, OTHER, "FAILED - %s chain backward overrun\n", name);
+			return 1;
+		}
+		delete titer;
+	}
+
+	delete [] present;
+
+	DEEP_LOG(INFO, OTHER, "%s LEAF CHAIN SUCCESS\n", name);
+
+	return 0;
+}
+
+template<typename P>
+int testTreeMapGetAll(const char* name) {
+	const int COUNT = 10000;
+	const int PROBES = COUNT * 2;
+
+	long long* keys = new long long[PROBES];
+	long long* vals = new long long[PROBES];
+	boolean* found = new boolean[PROBES];
+
+	TreeMap<long long, long long, void*, P> map(&longlongComparator, 3, false, false);
+	if ((map.getAll(keys, 0, vals, found) != 0) || (map.containsAll(keys, 0) == false)) {
+		DEEP_LOG(ERROR, OTHER, "FAILED - %s empty batch\n", name);
+		return 1;
+	}
+
+	for (int i = 0; i < COUNT; i++) {
+		map.put(i * 2, i * 20);
+	}
+
+	// XXX: sorted, reversed and shuffled batches over present (even) and missing (odd) keys
+	for (int pass = 0; pass < 3; pass++) {
+		for (int i = 0; i < PROBES; i++) {
+			keys[i] = (pass == 1) ? (PROBES - 1 - i) : i;
+		}
+
+		if (pass == 2) {
+			srand(4321);
+			for (int i = PROBES - 1; i > 0; i--) {
+				int j = rand() % (i + 1);
+				long long t = keys[i];
+				keys[i] = keys[j];
+				keys[j] = t;
+			}
+		}
+
+		for (int sorted = 0; sorted < 2; sorted++) {
+			memset(found, 0, PROBES * sizeof(boolean));
+
+			int hits = map.getAll(keys, PROBES, vals, found, sorted == 1);
+			if (hits != COUNT) {
+				DEEP_LOG(ERROR, OTHER, "FAILED - %s getAll hits: %d, expected: %d, pass: %d\n", name, hits, COUNT, pass);
+				return 1;
+			}
+
+			for (int i = 0; i < PROBES; i++) {
+				boolean expected = ((keys[i] % 2) == 0);
+				if ((found[i] != expected) || ((expected == true) && (vals[i] != keys[i] * 10))) {
+					DEEP_LOG(ERROR, OTHER, "FAILED - %s getAll key: %lld, found: %d, pass: %d\n", name, keys[i], found[i], pass);
+					return 1;
+				}
+			}
+
+			if (map.containsAll(keys, PROBES, sorted == 1) == true) {
+				DEEP_LOG(ERROR, OTHER, "FAILED - %s containsAll with missing keys, pass: %d\n", name, pass);
+				return 1;
+			}
+		}
+	}
+
+	for (int i = 0; i < COUNT; i++) {
+		keys[i] = i * 2;
+	}
+
+	if ((map.containsAll(keys, COUNT) == false) || (map.containsAll(keys, COUNT, false) == false)) {
+		DEEP_LOG(ERROR, OTHER, "FAILED - %s containsAll with present keys\n", name);
+		return 1;
+	}
+
+	delete [] keys;
+	delete [] vals;
+	delete [] found;
+
+	DEEP_LOG(INFO, OTHER, "%s SUCCESS\n", name);
+
+	return 0;
+}
+
+template<typename P>
+int testTreeMapRemoveRange(const char* name) {
+	const int COUNT = 20000;
+	const int ROUNDS = 40;
+
+	srand(5678);
+
+	// XXX: the range removal must land exactly where per key removal from the top of the range lands
+	TreeMap<long long, long long, void*, P> map(&longlongComparator, 3, false, false, 2);
+	TreeMap<long long, long long, void*, P> twin(&longlongComparator, 3, false, false, 2);
+	map.setStatisticsEnabled(true);
+	twin.setStatisticsEnabled(true);
+
+	for (int r = 0; r < ROUNDS; r++) {
+		for (int i = 0; i < COUNT / 10; i++) {
+			long long key = rand() % COUNT;
+			map.put(key, key * 10);
+			twin.put(key, key * 10);
+		}
+
+		long long from = rand() % COUNT;
+		long long to = from + (rand() % ((r % 4 == 0) ? COUNT : 200));
+		if (r == ROUNDS - 1) {
+			from = 0;
+			to = COUNT;
+		}
+
+		int expected = 0;
+		for (long long key = to - 1; key >= from; key--) {
+			boolean status;
+			twin.remove(key, null, &status);
+			if (status == true) {
+				expected++;
+			}
+		}
+
+		int removed = map.removeRange(from, to);
+		if ((removed != expected) || (map.size() != twin.size()) || (map.vsize() != twin.vsize())) {
+			DEEP_LOG(ERROR, OTHER, "FAILED - %s removed: %d, expected: %d, size: %d / %d\n", name, removed, expected, map.size(), twin.size());
+			return 1;
+		}
+
+		if ((map.getCardinality()[0] != twin.getCardinality()[0]) || (map.getCardinality()[1] != twin.getCardinality()[1])) {
+			DEEP_LOG(ERROR, OTHER, "FAILED - %s cardinality: %d %d, expected: %d %d\n", name, map.getCardinality()[0], map.getCardinality()[1], twin.getCardinality()[0], twin.getCardinality()[1]);
+			return 1;
+		}
+
+		Set<MapEntry<long long,long long>* >* entrySet = twin.entrySet();
+		Iterator<MapEntry<long long,long long>* >* iter = entrySet->iterator();
+		while (iter->hasNext() == true) {
+			MapEntry<long long,long long>* entry = (MapEntry<long long,long long>*) iter->next();
+			boolean status;
+			long long val = map.get(entry->getKey(), null, &status);
+			if ((status == false) || (val != entry->getValue())) {
+				DEEP_LOG(ERROR, OTHER, "FAILED - %s missing key: %lld\n", name, entry->getKey());
+				return 1;
+			}
+		}
+		delete entrySet;
+		delete iter;
+
+		// XXX: walk the survivors backwards to check the leaf chain around released subtrees
+		if (map.size() > 0) {
+			int count = 1;
+			TreeIterator<MapEntry<long long,long long>*>* titer = map.iterator(map.lastKey());
+			long long last = map.lastKey();
+			while (titer->hasPrevious() == true) {
+				MapEntry<long long,long long>* entry = (MapEntry<long long,long long>*) titer->previous();
+				if ((entry->getKey() >= last) || ((entry->getKey() >= from) && (entry->getKey() < to))) {
+					DEEP_LOG(ERROR, OTHER, "FAILED - %s backward key: %lld\n", name, entry->getKey());
+					return 1;
+				}
+
+				last = entry->getKey();
+				count++;
+			}
+			delete titer;
+
+			if (count != map.size()) {
+				DEEP_LOG(ERROR, OTHER, "FAILED - %s backward count: %d, expected: %d\n", name, count, map.size());
+				return 1;
+			}
+		}
+	}
+
+	if ((map.size() != 0) || (map.removeRange(0, COUNT) != 0)) {
+		DEEP_LOG(ERROR, OTHER, "FAILED - %s final size: %d\n", name, map.size());
+		return 1;
+	}
+
+	// XXX: owned keys and values are released with the range
+	TreeMap<Long*, Long*> owned(&LongComparator, 3, true, true);
+	for (int i = 0; i < 1000; i++) {
+		owned.put(new Long(i), new Long(i));
+	}
+
+	Long from(100);
+	Long to(900);
+	if ((owned.removeRange(&from, &to) != 800) || (owned.size() != 200) || (owned.containsKey(&from) == true)) {
+		DEEP_LOG(ERROR, OTHER, "FAILED - %s owned size: %d\n", name, owned.size());
+		return 1;
+	}
+
+	// XXX: thinned leaves sit at low water, each unit trims a whole slice and rebalances the leaf once
+	TreeMap<long long, long long, void*, P> thin(&longlongComparator, 32, false, false);
+	for (int i = 0; i < COUNT; i++) {
+		thin.put(i, i * 10);
+	}
+	for (int i = 1; i < COUNT; i += 2) {
+		thin.remove(i);
+	}
+
+	int thinned = thin.removeRange(COUNT / 4, (3 * COUNT) / 4);
+	if ((thinned != (COUNT / 4)) || (thin.size() != (COUNT / 4))) {
+		DEEP_LOG(ERROR, OTHER, "FAILED - %s thinned removed: %d, size: %d\n", name, thinned, thin.size());
+		return 1;
+	}
+
+	for (int i = 0; i < COUNT; i++) {
+		boolean status;
+		long long val = thin.get(i, null, &status);
+		boolean expect = ((i % 2) == 0) && ((i < (COUNT / 4)) || (i >= ((3 * COUNT) / 4)));
+		if ((status != expect) || ((status == true) && (val != (i * 10)))) {
+			DEEP_LOG(ERROR, OTHER, "FAILED - %s thinned key: %d\n", name, i);
+			return 1;
+		}
+	}
+
+	DEEP_LOG(INFO, OTHER, "%s SUCCESS\n", name);
+
+	return 0;
+}
+
+template<typename P>
+int verifyTreeMapRank(const char* name, TreeMap<long long, long long, void*, P>& map, const boolean* present, int max) {
+	int rank = 0;
+	for (int key = 0; key < max; key++) {
+		if (map.rank(key) != rank) {
+			DEEP_LOG(ERROR, OTHER, "FAILED - %s rank: %d, expected: %d, key: %d\n", name, map.rank(key), rank, key);
+			return 1;
+		}
+
+		if (present[key] == true) {
+			const MapEntry<long long,long long>* entry = map.select(rank);
+			if ((entry == null) || (entry->getKey() != key) || (entry->getValue() != key * 10)) {
+				DEEP_LOG(ERROR, OTHER, "FAILED - %s select: %d, expected: %d\n", name, rank, key);
+				return 1;
+			}
+
+			rank++;
+		}
+	}
+
+	if ((rank != map.size()) || (map.select(rank) != null) || (map.select(-1) != null) || (map.countRange(0, max) != rank)) {
+		DEEP_LOG(ERROR, OTHER, "FAILED - %s rank bounds, size: %d, expected: %d\n", name, map.size(), rank);
+		return 1;
+	}
+
+	for (int i = 0; i < 100; i++) {
+		int from = rand() % max;
+		int to = from + (rand() % (max / 4));
+
+		int expected = 0;
+		for (int key = from; (key < to) && (key < max); key++) {
+			if (present[key] == true) {
+				expected++;
+			}
+		}
+
+		if (map.countRange(from, to) != expected) {
+			DEEP_LOG(ERROR, OTHER, "FAILED - %s countRange: %d, expected: %d\n", name, map.countRange(from, to), expected);
+			return 1;
+		}
+	}
+
+	return 0;
+}
+
+template<typename P>
+int testTreeMapRank(const char* name) {
+	const int MAX_KEY = 5000;
+
+	boolean* present = new boolean[MAX_KEY];
+	memset(present, 0, MAX_KEY * sizeof(boolean));
+
+	srand(8765);
+
+	TreeMap<long long, long long, void*, P> map(&longlongComparator, 3, false, false);
+	if ((map.rank(10) != 0) || (map.select(0) != null) || (map.countRange(0, 10) != 0)) {
+		DEEP_LOG(ERROR, OTHER, "FAILED - %s empty rank\n", name);
+		return 1;
+	}
+
+	// XXX: counts follow inserts, removals and the rebalancing they trigger
+	for (int r = 0; r < 6; r++) {
+		for (int i = 0; i < MAX_KEY; i++) {
+			int key = rand() % MAX_KEY;
+			if ((r % 3) != 2) {
+				map.put(key, key * 10);
+				present[key] = true;
+
+			} else {
+				map.remove(key);
+				present[key] = false;
+			}
+		}
+
+		if (verifyTreeMapRank<P>(name, map, present, MAX_KEY) != 0) {
+			return 1;
+		}
+	}
+
+	int from = MAX_KEY / 5;
+	int to = MAX_KEY / 2;
+	map.removeRange(from, to);
+	for (int key = from; key < to; key++) {
+		present[key] = false;
+	}
+
+	if (verifyTreeMapRank<P>(name, map, present, MAX_KEY) != 0) {
+		return 1;
+	}
+
+	// XXX: bulk loaded trees count their branches once the spine is complete
+	long long* keys = new long long[MAX_KEY];
+	long long* vals = new long long[MAX_KEY];
+	for (int i = 0; i < MAX_KEY; i++) {
+		keys[i] = i;
+		vals[i] = i * 10;
+		present[i] = ((i % 3) != 0);
+	}
+
+	TreeMap<long long, long long, void*, P> loaded(&longlongComparator, 3, false, false);
+	loaded.bulkLoad(keys, vals, MAX_KEY, 0.75);
+	for (int i = 0; i < MAX_KEY; i += 3) {
+		loaded.remove(i);
+	}
+
+	if (verifyTreeMapRank<P>(name, loaded, present, MAX_KEY) != 0) {
+		return 1;
+	}
+
+	delete [] keys;
+	delete [] vals;
+	delete [] present;
+
+	DEEP_LOG(INFO, OTHER, "%s SUCCESS\n", name);
+
+	return 0;
+}
+
+template<typename P>
+int verifyTreeMapSnapshot(const char* name, typename TreeMap<long long, long long, void*, P>::Snapshot* snapshot, int count, int scale) {
+	if (snapshot->size() != count) {
+		DEEP_LOG(ERROR, OTHER, "FAILED - %s snapshot size: %d, expected: %d\n", name, snapshot->size(), count);
+		return 1;
+	}
+
+	int i = 0;
+	Set<MapEntry<long long,long long>* >* entrySet = snapshot->entrySet();
+	Iterator<MapEntry<long long,long long>* >* iter = entrySet->iterator();
+	while (iter->hasNext() == true) {
+		MapEntry<long long,long long>* entry = (MapEntry<long long,long long>*) iter->next();
+		if ((entry->getKey() != i) || (entry->getValue() != i * scale)) {
+			DEEP_LOG(ERROR, OTHER, "FAILED - %s snapshot entry: %lld, expected: %d\n", name, entry->getKey(), i);
+			return 1;
+		}
+
+		i++;
+	}
+	delete entrySet;
+	delete iter;
+
+	if ((i != count) || ((count > 0) && (snapshot->get(count - 1) != (count - 1) * scale))) {
+		DEEP_LOG(ERROR, OTHER, "FAILED - %s snapshot walk: %d, expected: %d\n", name, i, count);
+		return 1;
+	}
+
+	TreeIterator<MapEntry<long long,long long>* >* titer = snapshot->iterator(count);
+	while (titer->hasPrevious() == true) {
+		MapEntry<long long,long long>* entry = (MapEntry<long long,long long>*) titer->previous();
+		if (entry->getKey() != --i) {
+			DEEP_LOG(ERROR, OTHER, "FAILED - %s snapshot reverse entry: %lld, expected: %d\n", name, entry->getKey(), i);
+			return 1;
+		}
+	}
+	delete titer;
+
+	if (i != 0) {
+		DEEP_LOG(ERROR, OTHER, "FAILED - %s snapshot reverse walk: %d\n", name, i);
+		return 1;
+	}
+
+	return 0;
+}
+
+template<typename P>
+int testTreeMapSnapshot(const char* name) {
+	typedef TreeMap<long long, long long, void*, P> Tree;
+
+	const int COUNT = 5000;
+
+	Tree map(&longlongComparator, 3, false, false, 2);
+	map.setStatisticsEnabled(true);
+	for (int i = 0; i < COUNT; i++) {
+		map.put(i, i);
+	}
+
+	// XXX: snapshots taken without a change in between share one frozen tree
+	typename Tree::Snapshot* first = map.snapshot();
+	typename Tree::Snapshot* second = map.snapshot();
+
+	map.put(0, 0);
+	for (int i = 0; i < COUNT; i++) {
+		map.put(i, i * 2);
+	}
+	map.removeRange(COUNT / 2, COUNT);
+
+	typename Tree::Snapshot* third = map.snapshot();
+
+	for (int i = COUNT; i < COUNT * 2; i++) {
+		map.put(i, i * 3);
+	}
+
+	if ((verifyTreeMapSnapshot<P>(name, first, COUNT, 1) != 0) || (verifyTreeMapSnapshot<P>(name, second, COUNT, 1) != 0) || (verifyTreeMapSnapshot<P>(name, third, COUNT / 2, 2) != 0)) {
+		return 1;
+	}
+
+	if ((map.size() != COUNT + (COUNT / 2)) || (map.vsize() != COUNT + (COUNT / 2)) || (map.get(1) != 2) || (map.containsKey(COUNT - 1) == true) || (map.get(COUNT) != COUNT * 3)) {
+		DEEP_LOG(ERROR, OTHER, "FAILED - %s live size: %d\n", name, map.size());
+		return 1;
+	}
+
+	delete first;
+	delete second;
+
+	// XXX: clearing hands the nodes over, the last snapshot still sees them
+	map.clear();
+	if ((map.size() != 0) || (verifyTreeMapSnapshot<P>(name, third, COUNT / 2, 2) != 0)) {
+		return 1;
+	}
+	delete third;
+
+	// XXX: a released snapshot leaves nothing to copy on the next change
+	for (int i = 0; i < COUNT; i++) {
+		map.put(i, i);
+	}
+
+	typename Tree::Snapshot* unused = map.snapshot();
+	delete unused;
+	map.remove(0);
+
+	typename Tree::Snapshot* last = map.snapshot();
+	map.put(0, 0);
+	if ((map.size() != COUNT) || (last->size() != COUNT - 1) || (last->containsKey(0) == true) || (last->get(1) != 1)) {
+		DEEP_LOG(ERROR, OTHER, "FAILED - %s snapshot without key 0\n", name);
+		return 1;
+	}
+	delete last;
+
+	// XXX: snapshots outliving their map keep the frozen tree alive
+	Tree* scratch = new Tree(&longlongComparator, 3, false, false);
+	for (int i = 0; i < COUNT; i++) {
+		scratch->put(i, i);
+	}
+
+	typename Tree::Snapshot* orphan = scratch->snapshot();
+	delete scratch;
+	if (verifyTreeMapSnapshot<P>(name, orphan, COUNT, 1) != 0) {
+		return 1;
+	}
+	delete orphan;
+
+	// XXX: every change after a snapshot starts another generation, each keeps the nodes the later changes copied
+	const int GENERATIONS = 8;
+	typename Tree::Snapshot* generations[GENERATIONS];
+
+	scratch = new Tree(&longlongComparator, 3, false, false);
+	for (int i = 0; i < COUNT; i++) {
+		scratch->put(i, i);
+	}
+
+	for (int g = 0; g < GENERATIONS; g++) {
+		generations[g] = scratch->snapshot();
+		scratch->removeRange(COUNT - (COUNT / 4) + 1, COUNT);
+		scratch->put(g * (COUNT / GENERATIONS), g * (COUNT / GENERATIONS));
+	}
+
+	for (int g = 1; g < GENERATIONS; g += 2) {
+		delete generations[g];
+	}
+
+	scratch->put(COUNT, COUNT);
+
+	for (int g = 0; g < GENERATIONS; g += 2) {
+		if (verifyTreeMapSnapshot<P>(name, generations[g], (g == 0) ? COUNT : (COUNT - (COUNT / 4) + 1), 1) != 0) {
+			return 1;
+		}
+	}
+
+	delete scratch;
+
+	for (int g = 0; g < GENERATIONS; g += 2) {
+		delete generations[g];
+	}
+
+	TreeMap<Long*, Long*> owned(&LongComparator, 3, true, true);
+	try {
+		owned.snapshot();
+		DEEP_LOG(ERROR, OTHER, "FAILED - %s snapshot of owning map\n", name);
+		return 1;
+
+	} catch (UnsupportedOperationException* e) {
+		delete e;
+	}
+
+	DEEP_LOG(INFO, OTHER, "%s SUCCESS\n", name);
+
+	return 0;
+}
+
+struct TreeMapRangeCollector {
+	long long* m_keys;
+	int m_count;
+	int m_limit;
+
+	boolean operator()(const MapEntry<long long,long long>* entry) {
+		m_keys[m_count++] = entry->getKey();
+		return (m_count < m_limit);
+	}
+};
+
+template<typename P>
+int testTreeMapRangeScan(const char* name) {
+	typedef TreeMap<long long, long long, void*, P> Tree;
+
+	const int COUNT = 3000;
+
+	long long* keys = new long long[COUNT];
+	long long* found = new long long[COUNT];
+	const MapEntry<long long,long long>* batch[64];
+
+	Tree map(&longlongComparator, 3, false, false);
+	TreeMapRangeCollector collector = { found, 0, COUNT };
+	if (map.forEachInRange(1, 10, collector) != 0) {
+		DEEP_LOG(ERROR, OTHER, "FAILED - %s empty scan\n", name);
+		return 1;
+	}
+
+	// XXX: odd keys in ascending order, keys[] holds them sorted for the expected ranges
+	int size = 0;
+	for (int i = 0; i < COUNT; i++) {
+		if ((i % 7) != 3) {
+			keys[size++] = (i * 2) + 1;
+			map.put((i * 2) + 1, i);
+		}
+	}
+
+	// XXX: visitors may be temporaries, e.g. a lambda passed inline
+	long long sum = 0;
+	long long expectedSum = 0;
+	for (int i = 0; (i < size) && (keys[i] < 41); i++) {
+		expectedSum += keys[i];
+	}
+
+	map.forEachInRange(1, 41, [&sum](const MapEntry<long long,long long>* entry) { sum += entry->getKey(); return true; });
+	if (sum != expectedSum) {
+		DEEP_LOG(ERROR, OTHER, "FAILED - %s lambda scan: %lld, expected: %lld\n", name, sum, expectedSum);
+		return 1;
+	}
+
+	srand(4321);
+
+	int BATCHES[] = { 1, 5, 64 };
+	for (int r = 0; r < 500; r++) {
+		boolean fromOpen = (r % 50 == 0);
+		boolean toOpen = (r % 60 == 0);
+		long long fromKey = (rand() % (COUNT * 2 + 4)) + 1;
+		long long toKey = fromKey + (rand() % ((r % 3 == 0) ? COUNT : 200)) + 1;
+
+		int begin = 0;
+		while ((begin < size) && (fromOpen == false) && (keys[begin] < fromKey)) {
+			begin++;
+		}
+
+		int end = begin;
+		while ((end < size) && ((toOpen == true) || (keys[end] < toKey))) {
+			end++;
+		}
+
+		collector.m_count = 0;
+		collector.m_limit = COUNT;
+		int visited = map.forEachInRange(fromKey, fromOpen, toKey, toOpen, collector);
+		if ((visited != end - begin) || (collector.m_count != end - begin)) {
+			DEEP_LOG(ERROR, OTHER, "FAILED - %s scan [%lld, %lld): %d, expected: %d\n", name, fromKey, toKey, visited, end - begin);
+			return 1;
+		}
+
+		for (int i = 0; i < visited; i++) {
+			if (found[i] != keys[begin + i]) {
+				DEEP_LOG(ERROR, OTHER, "FAILED - %s scan key: %lld, expected: %lld\n", name, found[i], keys[begin + i]);
+				return 1;
+			}
+		}
+
+		// XXX: the visitor stops the scan early
+		collector.m_count = 0;
+		collector.m_limit = (r % 10) + 1;
+		visited = map.forEachInRange(fromKey, fromOpen, toKey, toOpen, collector);
+		if (visited != (((end - begin) < collector.m_limit) ? (end - begin) : collector.m_limit)) {
+			DEEP_LOG(ERROR, OTHER, "FAILED - %s limited scan: %d\n", name, visited);
+			return 1;
+		}
+
+		int step = BATCHES[r % 3];
+		typename Tree::RangeCursor cursor(&map, fromKey, fromOpen, toKey, toOpen);
+		int total = 0;
+		int filled;
+		while ((filled = cursor.nextBatch(batch, step)) != 0) {
+			for (int i = 0; i < filled; i++) {
+				if ((begin + total >= end) || (batch[i]->getKey() != keys[begin + total])) {
+					DEEP_LOG(ERROR, OTHER, "FAILED - %s cursor key: %lld\n", name, batch[i]->getKey());
+					return 1;
+				}
+
+				total++;
+			}
+		}
+
+		if ((total != end - begin) || (cursor.hasNext() == true)) {
+			DEEP_LOG(ERROR, OTHER, "FAILED - %s cursor [%lld, %lld): %d, expected: %d\n", name, fromKey, toKey, total, end - begin);
+			return 1;
+		}
+	}
+
+	// XXX: -1 is a key like any other, it bounds a range on either side
+	Tree signedMap(&longlongComparator, 3, false, false);
+	for (long long i = -100; i <= 100; i++) {
+		signedMap.put(i, i);
+	}
+
+	long long BOUNDS[][3] = { { -1, 5, 6 }, { -50, -1, 49 }, { -1, 0, 1 }, { -2, -1, 1 } };
+	for (int b = 0; b < 4; b++) {
+		collector.m_count = 0;
+		collector.m_limit = COUNT;
+		int visited = signedMap.forEachInRange(BOUNDS[b][0], BOUNDS[b][1], collector);
+
+		typename Tree::RangeCursor cursor(&signedMap, BOUNDS[b][0], BOUNDS[b][1]);
+		int total = 0;
+		int filled;
+		while ((filled = cursor.nextBatch(batch, 4)) != 0) {
+			total += filled;
+		}
+
+		if ((visited != BOUNDS[b][2]) || (found[0] != BOUNDS[b][0]) || (total != BOUNDS[b][2])) {
+			DEEP_LOG(ERROR, OTHER, "FAILED - %s signed scan [%lld, %lld): %d / %d, expected: %lld\n", name, BOUNDS[b][0], BOUNDS[b][1], visited, total, BOUNDS[b][2]);
+			return 1;
+		}
+	}
+
+	collector.m_count = 0;
+	if ((signedMap.forEachInRange(-1, true, -1, false, collector) != 99) || (found[0] != -100)) {
+		DEEP_LOG(ERROR, OTHER, "FAILED - %s open scan below -1: %d\n", name, collector.m_count);
+		return 1;
+	}
+
+	collector.m_count = 0;
+	if ((signedMap.forEachInRange(-1, false, -1, true, collector) != 102) || (found[101] != 100)) {
+		DEEP_LOG(ERROR, OTHER, "FAILED - %s open scan from -1: %d\n", name, collector.m_count);
+		return 1;
+	}
+
+	delete [] keys;
+	delete [] found;
+
+	DEEP_LOG(INFO, OTHER, "%s SUCCESS\n", name);
+
+	return 0;
+}
+
+template<typename P>
+int testTreeMapNodeBytes(const char* name) {
+	typedef TreeMap<long long, long long, void*, P> Tree;
+
+	const int MAX_KEY = 40000;
+	const int TARGETS[] = { Tree::NODE_BYTES_SMALL, Tree::NODE_BYTES_PAGE, Tree::NODE_BYTES_LARGE };
+
+	if ((Tree::orderFor(1) != Tree::INITIAL_ORDER) || (Tree::orderFor(1 << 30) != Tree::MAXIMUM_ORDER)) {
+		DEEP_LOG(ERROR, OTHER, "FAILED - %s order clamp: %d, %d\n", name, Tree::orderFor(1), Tree::orderFor(1 << 30));
+		return 1;
+	}
+
+	Tree clamped(&longlongComparator, Tree::MAXIMUM_ORDER + 1000, false, false);
+	if (clamped.getOrder() != Tree::MAXIMUM_ORDER) {
+		DEEP_LOG(ERROR, OTHER, "FAILED - %s order above maximum: %d\n", name, clamped.getOrder());
+		return 1;
+	}
+
+	boolean* present = new boolean[MAX_KEY];
+
+	for (int t = 0; t < (int) (sizeof(TARGETS) / sizeof(int)); t++) {
+		inttype order = Tree::orderFor(TARGETS[t]);
+
+		// XXX: page sized leaves hold more entries than a byte index could address
+		if ((TARGETS[t] >= Tree::NODE_BYTES_PAGE) && ((2 * (order + 1)) <= 255)) {
+			DEEP_LOG(ERROR, OTHER, "FAILED - %s fanout for %d bytes: %d\n", name, TARGETS[t], order);
+			return 1;
+		}
+
+		Tree map(&longlongComparator, order, false, false);
+		if (map.getOrder() != order) {
+			DEEP_LOG(ERROR, OTHER, "FAILED - %s order: %d, expected: %d\n", name, map.getOrder(), order);
+			return 1;
+		}
+
+		memset(present, 0, MAX_KEY * sizeof(boolean));
+		srand(4321 + t);
+
+		// XXX: enough keys for several levels, removals force merges and rebalancing across wide nodes
+		for (int r = 0; r < 3; r++) {
+			for (int i = 0; i < MAX_KEY; i++) {
+				int key = rand() % MAX_KEY;
+				if (r != 2) {
+					map.put(key, key * 10);
+					present[key] = true;
+
+				} else if ((key % 3) != 0) {
+					map.remove(key);
+					present[key] = false;
+				}
+			}
+
+			if (verifyTreeMapRank<P>(name, map, present, MAX_KEY) != 0) {
+				return 1;
+			}
+		}
+
+		for (int key = 0; key < MAX_KEY; key++) {
+			boolean status;
+			long long value = map.get(key, null, &status);
+			if ((status != present[key]) || ((status == true) && (value != key * 10))) {
+				DEEP_LOG(ERROR, OTHER, "FAILED - %s get %d for %d bytes\n", name, key, TARGETS[t]);
+				return 1;
+			}
+		}
+	}
+
+	delete [] present;
+
+	DEEP_LOG(INFO, OTHER, "%s SUCCESS\n", name);
+
+	return 0;
+}
+
+template<typename P>
+int verifyTreeMapTwin(const char* name, TreeMap<long long, long long, void*, P>& map, TreeMap<long long, long long>& twin) {
+	if (map.size() != twin.size()) {
+		DEEP_LOG(ERROR, OTHER, "FAILED - %s size: %d, expected: %d\n", name, map.size(), twin.size());
+		return 1;
+	}
+
+	Set<MapEntry<long long,long long>*>* expectedSet = twin.entrySet();
+	Set<MapEntry<long long,long long>*>* actualSet = map.entrySet();
+	Iterator<MapEntry<long long,long long>*>* expected = expectedSet->iterator();
+	Iterator<MapEntry<long long,long long>*>* actual = actualSet->iterator();
+
+	int result = 0;
+	while (expected->hasNext() == true) {
+		MapEntry<long long,long long>* x = expected->next();
+		MapEntry<long long,long long>* y = actual->next();
+		if ((y == null) || (x->getKey() != y->getKey()) || (x->getValue() != y->getValue())) {
+			DEEP_LOG(ERROR, OTHER, "FAILED - %s entry: %lld\n", name, x->getKey());
+			result = 1;
+			break;
+		}
+	}
+
+	delete expected;
+	delete actual;
+	delete expectedSet;
+	delete actualSet;
+
+	return result;
+}
+
+template<typename P>
+int testTreeMapHint(const char* name) {
+	typedef TreeMap<long long, long long, void*, P> Tree;
+
+	const int CLUSTERS = 400;
+	const int RUN = 50;
+
+	srand(2468);
+
+	Tree map(&longlongComparator, 3, false, false);
+	TreeMap<long long, long long> twin(&longlongComparator, 3, false, false);
+	typename Tree::Hint hint;
+
+	// XXX: clustered, nearly sorted runs starting anywhere, with repeats that replace in place
+	for (int c = 0; c < CLUSTERS; c++) {
+		long long key = ((rand() % 100000) * 16) + 1;
+		for (int i = 0; i < RUN; i++) {
+			key += (rand() % 5) + ((i % 7) == 3 ? -3 : 0);
+
+			boolean status;
+			boolean expected;
+			map.put(&hint, key, key * 10 + c, &status);
+			twin.put(key, key * 10 + c, null, &expected);
+
+			if (status != expected) {
+				DEEP_LOG(ERROR, OTHER, "FAILED - %s hinted status: %lld\n", name, key);
+				return 1;
+			}
+		}
+
+		// XXX: other changes make the hint stale, the next hinted put has to notice and descend
+		if ((c % 10) == 0) {
+			long long removed = twin.firstKey();
+			map.remove(removed);
+			twin.remove(removed);
+		}
+	}
+
+	if (verifyTreeMapTwin<P>(name, map, twin) != 0) {
+		return 1;
+	}
+
+	// XXX: descending runs only ever hint at the left neighbor
+	for (long long key = 2000000; key > 1990000; key -= 3) {
+		map.put(&hint, key, key);
+		twin.put(key, key);
+	}
+
+	if (verifyTreeMapTwin<P>(name, map, twin) != 0) {
+		return 1;
+	}
+
+	// XXX: a hint from before clear() names released nodes, the stamp has to reject it before they are touched
+	map.clear();
+	twin.clear();
+
+	for (long long key = 1; key < 2000; key += 2) {
+		map.put(&hint, key, key);
+		twin.put(key, key);
+	}
+
+	if (verifyTreeMapTwin<P>(name, map, twin) != 0) {
+		return 1;
+	}
+
+	DEEP_LOG(INFO, OTHER, "%s SUCCESS\n", name);
+
+	return 0;
+}
+
+template<typename P>
+int testTreeMapCursor(const char* name) {
+	typedef TreeMap<long long, long long, void*, P> Tree;
+	typedef typename Tree::TreeMapEntryIterator Cursor;
+
+	const int COUNT = 3000;
+
+	Tree map(&longlongComparator, 3, false, false);
+	TreeMap<long long, long long> twin(&longlongComparator, 3, false, false);
+	for (int i = 1; i <= COUNT; i++) {
+		map.put(i * 4, i);
+		twin.put(i * 4, i);
+	}
+
+	// XXX: one pass mixing every positioned change, next keeps walking the original keys
+	Cursor cursor;
+	map.iterator(4, &cursor);
+
+	long long expect = 4;
+	while (cursor.hasNext() == true) {
+		const MapEntry<long long,long long>* entry = cursor.next();
+		long long key = entry->getKey();
+		if (key != expect) {
+			DEEP_LOG(ERROR, OTHER, "FAILED - %s cursor walk: %lld, expected: %lld\n", name, key, expect);
+			return 1;
+		}
+		expect += 4;
+
+		switch ((key / 4) % 5) {
+			case 0:
+				cursor.remove();
+				twin.remove(key);
+				break;
+
+			case 1:
+				if (cursor.replaceValue(-key) != key / 4) {
+					DEEP_LOG(ERROR, OTHER, "FAILED - %s replace: %lld\n", name, key);
+					return 1;
+				}
+				twin.put(key, -key);
+				break;
+
+			case 2:
+				// XXX: in place right after the current entry
+				cursor.insertBefore(key + 1, key + 1);
+				twin.put(key + 1, key + 1);
+				break;
+
+			case 3:
+				// XXX: out of place, lands elsewhere through put
+				cursor.insertBefore(key - 2, key - 2);
+				twin.put(key - 2, key - 2);
+				break;
+
+			default:
+				cursor.remove();
+				twin.remove(key);
+				if (cursor.hasNext() == true) {
+					cursor.insertBefore(key, 7);
+					twin.put(key, 7);
+				}
+				break;
+		}
+	}
+
+	if (expect != (COUNT * 4) + 4) {
+		DEEP_LOG(ERROR, OTHER, "FAILED - %s cursor ended early: %lld\n", name, expect);
+		return 1;
+	}
+
+	if (verifyTreeMapTwin<P>(name, map, twin) != 0) {
+		return 1;
+	}
+
+	// XXX: walking backwards, previous leaves the cursor on the entry it removes
+	map.iterator(map.lastKey(), &cursor);
+	cursor.next();
+	int removed = 0;
+	while (cursor.hasPrevious() == true) {
+		long long key = cursor.previous()->getKey();
+		if ((key % 3) == 0) {
+			cursor.remove();
+			twin.remove(key);
+			removed++;
+		}
+	}
+
+	if ((removed == 0) || (verifyTreeMapTwin<P>(name, map, twin) != 0)) {
+		return 1;
+	}
+
+	// XXX: a snapshot shares the nodes, the first positioned change copies them and carries the cursor over
+	typename Tree::Snapshot* snapshot = map.snapshot();
+	int before = map.size();
+
+	map.iterator(map.firstKey(), &cursor);
+	cursor.next();
+	long long second = cursor.next()->getKey();
+	cursor.remove();
+	twin.remove(second);
+
+	if ((snapshot->size() != before) || (snapshot->containsKey(second) == false) || (verifyTreeMapTwin<P>(name, map, twin) != 0)) {
+		DEEP_LOG(ERROR, OTHER, "FAILED - %s cursor on shared map\n", name);
+		return 1;
+	}
+	delete snapshot;
+
+	// XXX: removing everything through the cursor empties the map
+	map.iterator(map.firstKey(), &cursor);
+	while (cursor.hasNext() == true) {
+		cursor.next();
+		cursor.remove();
+	}
+
+	if (map.size() != 0) {
+		DEEP_LOG(ERROR, OTHER, "FAILED - %s cursor drain: %d\n", name, map.size());
+		return 1;
+	}
+
+	DEEP_LOG(INFO, OTHER, "%s SUCCESS\n", name);
+
+	return 0;
+}
+
+template<typename P>
+int testTreeMapBatch(const char* name, int order) {
+	typedef TreeMap<long long, long long, void*, P> Tree;
+
+	const int ROUNDS = 60;
+	const int BATCH = 1000;
+	const int RANGE = 40000;
+
+	srand(97531);
+
+	Tree map(&longlongComparator, order, false, false);
+	TreeMap<long long, long long> twin(&longlongComparator, 3, false, false);
+
+	long long keys[BATCH];
+	long long vals[BATCH];
+	long long retvals[BATCH];
+
+	for (int r = 0; r < ROUNDS; r++) {
+		// XXX: mostly random, some rounds clustered into one region or already ascending, repeats within a batch
+		for (int i = 0; i < BATCH; i++) {
+			switch (r % 3) {
+				case 0:
+					keys[i] = rand() % RANGE;
+					break;
+				case 1:
+					keys[i] = (r * 500) + (rand() % 700);
+					break;
+				default:
+					keys[i] = (r * BATCH) + (i * 3);
+					break;
+			}
+
+			vals[i] = (r * BATCH) + i;
+		}
+
+		int added = map.putBatch(keys, vals, BATCH, retvals);
+
+		int expectedAdded = 0;
+		for (int i = 0; i < BATCH; i++) {
+			boolean status;
+			long long old = twin.put(keys[i], vals[i], null, &status);
+			if (status == false) {
+				expectedAdded++;
+				old = Converter<long long>::NULL_VALUE;
+			}
+
+			if (retvals[i] != old) {
+				DEEP_LOG(ERROR, OTHER, "FAILED - %s round %d retval %d: %lld, expected: %lld\n", name, r, i, retvals[i], old);
+				return 1;
+			}
+		}
+
+		if (added != expectedAdded) {
+			DEEP_LOG(ERROR, OTHER, "FAILED - %s round %d added: %d, expected: %d\n", name, r, added, expectedAdded);
+			return 1;
+		}
+
+		if (verifyTreeMapTwin<P>(name, map, twin) != 0) {
+			return 1;
+		}
+
+		// XXX: counts kept per subtree have to agree with the entries merged under them
+		if ((map.rank(twin.lastKey()) != twin.size() - 1) || (map.select(map.size() / 2)->getKey() != twin.select(twin.size() / 2)->getKey())) {
+			DEEP_LOG(ERROR, OTHER, "FAILED - %s round %d rank\n", name, r);
+			return 1;
+		}
+
+		if ((r % 10) == 9) {
+			for (int k = 0; k < RANGE; k += 2) {
+				map.remove(k);
+				twin.remove(k);
+			}
+		}
+	}
+
+	DEEP_LOG(INFO, OTHER, "%s SUCCESS\n", name);
+
+	return 0;
+}
+
+int testTreeMapSpill() {
+	typedef TreeMap<long long, long long, void*, SpillTreePolicy> Tree;
+
+	const char* SPILL_PATH = "treemap.spill";
+	const int COUNT = 20000;
+
+	srand(8642);
+
+	Tree map(&longlongComparator, 7, false, false);
+	TreeMap<long long, long long> twin(&longlongComparator, 3, false, false);
+
+	// XXX: no sampled threshold is ever crossed, leaves only go to disk on request
+	map.setSpillFile(SPILL_PATH, (ulongtype) -1, 0);
+
+	for (int i = 0; i < COUNT; i++) {
+		long long key = rand() % (COUNT * 4);
+		map.put(key, i);
+		twin.put(key, i);
+	}
+
+	// XXX: every leaf was just referenced, the first lap clears the bits and the second evicts
+	int spilled = map.spill(COUNT);
+	if ((spilled == 0) || (map.getSpilledLeaves() != spilled)) {
+		DEEP_LOG(ERROR, OTHER, "FAILED - spill count: %d, %lld\n", spilled, map.getSpilledLeaves());
+		return 1;
+	}
+
+	// XXX: every leaf holds an entry, looking them all up faults the whole tree back in
+	for (long long key = 0; key < COUNT * 4; key++) {
+		boolean status;
+		boolean expected;
+		long long value = map.get(key, null, &status);
+		long long other = twin.get(key, null, &expected);
+		if ((status != expected) || ((status == true) && (value != other))) {
+			DEEP_LOG(ERROR, OTHER, "FAILED - spill get: %lld\n", key);
+			return 1;
+		}
+	}
+
+	if (map.getSpilledLeaves() != 0) {
+		DEEP_LOG(ERROR, OTHER, "FAILED - spill fault: %lld\n", map.getSpilledLeaves());
+		return 1;
+	}
+
+	map.spill(COUNT);
+	if (verifyTreeMapTwin<SpillTreePolicy>("SPILL ITERATE", map, twin) != 0) {
+		return 1;
+	}
+
+	// XXX: changes land on spilled and resident leaves alike, splits and merges pull their neighbors back in
+	for (int i = 0; i < COUNT * 2; i++) {
+		long long key = rand() % (COUNT * 4);
+		if ((i % 3) == 0) {
+			map.remove(key);
+			twin.remove(key);
+
+		} else {
+			map.put(key, -i);
+			twin.put(key, -i);
+		}
+
+		if ((i % 500) == 0) {
+			map.spill(100);
+		}
+	}
+
+	map.spill(COUNT);
+	map.removeRange(COUNT, COUNT * 2, false, false);
+	twin.removeRange(COUNT, COUNT * 2, false, false);
+
+	if ((verifyTreeMapTwin<SpillTreePolicy>("SPILL CHANGE", map, twin) != 0) || (map.rank(twin.lastKey()) != twin.size() - 1)) {
+		DEEP_LOG(ERROR, OTHER, "FAILED - spill change\n");
+		return 1;
+	}
+
+	boolean thrown = false;
+	try {
+		map.snapshot();
+
+	} catch (UnsupportedOperationException* e) {
+		delete e;
+		thrown = true;
+	}
+
+	if (thrown == false) {
+		DEEP_LOG(ERROR, OTHER, "FAILED - spill snapshot\n");
+		return 1;
+	}
+
+	// XXX: turning spill mode off reads every leaf back before the file goes away
+	map.spill(COUNT);
+	map.setSpillFile(null, 0, 0);
+	if ((map.getSpilledLeaves() != 0) || (verifyTreeMapTwin<SpillTreePolicy>("SPILL OFF", map, twin) != 0)) {
+		DEEP_LOG(ERROR, OTHER, "FAILED - spill off\n");
+		return 1;
+	}
+
+	// XXX: any allocation crosses this threshold, the sampled check then keeps evicting while the map grows
+	map.setSpillFile(SPILL_PATH, 1, 0);
+	for (int i = 0; i < COUNT; i++) {
+		long long key = (COUNT * 4) + i;
+		map.put(key, i);
+		twin.put(key, i);
+	}
+
+	if (verifyTreeMapTwin<SpillTreePolicy>("SPILL PRESSURE", map, twin) != 0) {
+		return 1;
+	}
+
+	map.spill(COUNT);
+	map.clear();
+	if ((map.getSpilledLeaves() != 0) || (map.size() != 0)) {
+		DEEP_LOG(ERROR, OTHER, "FAILED - spill clear: %lld\n", map.getSpilledLeaves());
+		return 1;
+	}
+
+	map.setSpillFile(null, 0, 0);
+
+	TreeMap<long long, long long> plain(&longlongComparator, 3, false, false);
+	thrown = false;
+	try {
+		plain.setSpillFile(SPILL_PATH, 0, 0);
+
+	} catch (UnsupportedOperationException* e) {
+		delete e;
+		thrown = true;
+	}
+
+	unlink(SPILL_PATH);
+
+	if (thrown == false) {
+		DEEP_LOG(ERROR, OTHER, "FAILED - spill policy\n");
+		return 1;
+	}
+
+	DEEP_LOG(INFO, OTHER, "SPILL SUCCESS\n");
+
+	return 0;
+}
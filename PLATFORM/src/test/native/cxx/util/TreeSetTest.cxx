@@ -40,11 +40,25 @@ using namespace cxx::util;
 template class TreeSet<int>;
 template class TreeSet<long long>;
 template class TreeSet<Long*>;
+template class TreeSet<long long, Comparator<long long>, PooledTreePolicy>;
+
+// XXX: forward scans within nodes and children that record their position within the parent
+class SlottedLinearTreePolicy : public PooledTreePolicy {
+	public:
+		static const boolean BINARY_SEARCH = false;
+		static const boolean VECTOR_SEARCH = false;
+		static const boolean SLOTTED_NODES = true;
+};
+
+template class TreeSet<long long, Comparator<long long>, SlottedLinearTreePolicy>;
 
 
 int testTreeSet();
 int testTreeSetPrimitive();
 int testTreeSetSize();
+template<typename P> int testTreeSetPooled(const char* name);
+int testTreeSetBulkLoad();
+int testTreeSetRangeScan();
 
 int main(int argc, char** argv) {
 	int result = testTreeSet();
@@ -52,6 +66,18 @@ int main(int argc, char** argv) {
 		result = testTreeSetPrimitive();
 		if (result == 0) {
 			result = testTreeSetSize();
+			if (result == 0) {
+				result = testTreeSetPooled<PooledTreePolicy>("POOLED");
+				if (result == 0) {
+					result = testTreeSetPooled<SlottedLinearTreePolicy>("POOLED SLOTTED LINEAR");
+				}
+				if (result == 0) {
+					result = testTreeSetBulkLoad();
+					if (result == 0) {
+						result = testTreeSetRangeScan();
+					}
+				}
+			}
 		}
 	}
 
@@ -588,3 +614,239 @@ int testTreeSetSize() {
 	return 0;
 }
 
+
+template<typename P>
+int testTreeSetPooled(const char* name) {
+	TreeSet<long long, Comparator<long long>, P> set(7);
+
+	int COUNT = 200000;
+
+	for (int round = 0; round < 3; round++) {
+		int size = 0;
+
+		for (int i = 0; i < COUNT; i++) {
+			set.add((i * 7919LL) % COUNT);
+			size++;
+		}
+
+		for (int i = 0; i < COUNT; i += 2) {
+			set.remove(i);
+			size--;
+		}
+
+		for (int i = 0; i < COUNT; i += 4) {
+			set.add(i);
+			size++;
+		}
+
+		if (set.size() != size) {
+			DEEP_LOG(ERROR, OTHER, "  !   <FAILED> %s SIZE: %d, EXPECTED: %d\n", name, set.size(), size);
+			return 1;
+		}
+
+		for (int i = 0; i < COUNT; i++) {
+			boolean expected = ((i % 2) == 1) || ((i % 4) == 0);
+			if (set.contains(i) != expected) {
+				DEEP_LOG(ERROR, OTHER, "  !   <FAILED> %s CONTAINS: %d\n", name, i);
+				return 1;
+			}
+		}
+
+		set.clear();
+		if ((set.size() != 0) || (set.contains(1) == true)) {
+			DEEP_LOG(ERROR, OTHER, "  !   <FAILED> %s CLEAR SIZE: %d\n", name, set.size());
+			return 1;
+		}
+	}
+
+	return 0;
+}
+
+int testTreeSetBulkLoad() {
+	int COUNTS[] = { 0, 1, 2, 7, 8, 9, 15, 16, 17, 100, 12345 };
+	double FILLS[] = { 1.0, 0.75, 0.5, 0.1 };
+
+	int COUNT = 12345;
+	long long* elems = new long long[COUNT];
+	for (int i = 0; i < COUNT; i++) {
+		elems[i] = i * 2;
+	}
+
+	for (int c = 0; c < (int) (sizeof(COUNTS) / sizeof(int)); c++) {
+		for (int f = 0; f < (int) (sizeof(FILLS) / sizeof(double)); f++) {
+			int count = COUNTS[c];
+
+			TreeSet<long long, Comparator<long long>, PooledTreePolicy> set(3);
+			set.bulkLoad(elems, count, FILLS[f]);
+
+			if (set.size() != count) {
+				DEEP_LOG(ERROR, OTHER, "  !   <FAILED> LOAD SIZE: %d, EXPECTED: %d, FILL: %f\n", set.size(), count, FILLS[f]);
+				return 1;
+			}
+
+			Iterator<long long>* iter = set.iterator();
+			for (int i = 0; i < count; i++) {
+				long long elem = iter->next();
+				if (elem != elems[i]) {
+					DEEP_LOG(ERROR, OTHER, "  !   <FAILED> LOAD ITERATOR: %lld, EXPECTED: %lld\n", elem, elems[i]);
+					return 1;
+				}
+			}
+			if (iter->hasNext() == true) {
+				DEEP_LOG(ERROR, OTHER, "  !   <FAILED> LOAD ITERATOR OVERRUN: %d\n", count);
+				return 1;
+			}
+			delete iter;
+
+			// XXX: the loaded tree must keep rebalancing through the regular paths
+			for (int i = 0; i < count; i++) {
+				set.add(elems[i] + 1);
+			}
+			for (int i = 0; i < count; i += 2) {
+				set.remove(elems[i]);
+			}
+
+			if (set.size() != count + (count / 2)) {
+				DEEP_LOG(ERROR, OTHER, "  !   <FAILED> RELOAD SIZE: %d\n", set.size());
+				return 1;
+			}
+
+			for (int i = 0; i < count; i++) {
+				if ((set.contains(elems[i]) != ((i % 2) == 1)) || (set.contains(elems[i] + 1) == false)) {
+					DEEP_LOG(ERROR, OTHER, "  !   <FAILED> RELOAD CONTAINS: %lld\n", elems[i]);
+					return 1;
+				}
+			}
+		}
+	}
+
+	// XXX: out of order input finishes the bulk part and falls back to add
+	TreeSet<long long> set(3);
+	long long unsorted[] = { 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14, 15, 16, 17, 0, 5, 20 };
+	set.bulkLoad(unsorted, 20);
+	if ((set.size() != 19) || (set.first() != 0) || (set.last() != 20)) {
+		DEEP_LOG(ERROR, OTHER, "  !   <FAILED> UNSORTED LOAD SIZE: %d\n", set.size());
+		return 1;
+	}
+
+	delete [] elems;
+
+	return 0;
+}
+
+struct TreeSetRangeCollector {
+	long long* m_elems;
+	int m_count;
+	int m_limit;
+
+	boolean operator()(const long long elem) {
+		m_elems[m_count++] = elem;
+		return (m_count < m_limit);
+	}
+};
+
+int testTreeSetRangeScan() {
+	const int COUNT = 3000;
+
+	long long* elems = new long long[COUNT];
+	long long* found = new long long[COUNT];
+	long long batch[64];
+
+	TreeSet<long long, Comparator<long long>, PooledTreePolicy> set(3);
+
+	int size = 0;
+	for (int i = 0; i < COUNT; i++) {
+		if ((i % 5) != 2) {
+			elems[size++] = (i * 2) + 1;
+			set.add((i * 2) + 1);
+		}
+	}
+
+	srand(1234);
+
+	int BATCHES[] = { 1, 7, 64 };
+	for (int r = 0; r < 500; r++) {
+		boolean fromOpen = (r % 50 == 0);
+		boolean toOpen = (r % 60 == 0);
+		long long fromElement = (rand() % (COUNT * 2 + 4)) + 1;
+		long long toElement = fromElement + (rand() % ((r % 3 == 0) ? COUNT : 200)) + 1;
+
+		int begin = 0;
+		while ((begin < size) && (fromOpen == false) && (elems[begin] < fromElement)) {
+			begin++;
+		}
+
+		int end = begin;
+		while ((end < size) && ((toOpen == true) || (elems[end] < toElement))) {
+			end++;
+		}
+
+		TreeSetRangeCollector collector = { found, 0, COUNT };
+		int visited = set.forEachInRange(fromElement, fromOpen, toElement, toOpen, collector);
+		if (visited != end - begin) {
+			DEEP_LOG(ERROR, OTHER, "  !   <FAILED> SCAN [%lld, %lld): %d, EXPECTED: %d\n", fromElement, toElement, visited, end - begin);
+			return 1;
+		}
+
+		for (int i = 0; i < visited; i++) {
+			if (found[i] != elems[begin + i]) {
+				DEEP_LOG(ERROR, OTHER, "  !   <FAILED> SCAN ELEMENT: %lld, EXPECTED: %lld\n", found[i], elems[begin + i]);
+				return 1;
+			}
+		}
+
+		TreeSet<long long, Comparator<long long>, PooledTreePolicy>::RangeCursor cursor(&set, fromElement, fromOpen, toElement, toOpen);
+		int total = 0;
+		int filled;
+		while ((filled = cursor.nextBatch(batch, BATCHES[r % 3])) != 0) {
+			for (int i = 0; i < filled; i++) {
+				if ((begin + total >= end) || (batch[i] != elems[begin + total])) {
+					DEEP_LOG(ERROR, OTHER, "  !   <FAILED> CURSOR ELEMENT: %lld\n", batch[i]);
+					return 1;
+				}
+
+				total++;
+			}
+		}
+
+		if (total != end - begin) {
+			DEEP_LOG(ERROR, OTHER, "  !   <FAILED> CURSOR [%lld, %lld): %d, EXPECTED: %d\n", fromElement, toElement, total, end - begin);
+			return 1;
+		}
+	}
+
+	// XXX: -1 is an element like any other, it bounds a range on either side
+	TreeSet<long long, Comparator<long long>, PooledTreePolicy> signedSet(3);
+	for (long long i = -100; i <= 100; i++) {
+		signedSet.add(i);
+	}
+
+	TreeSetRangeCollector collector = { found, 0, COUNT };
+	if ((signedSet.forEachInRange(-1, 5, collector) != 6) || (found[0] != -1)) {
+		DEEP_LOG(ERROR, OTHER, "  !   <FAILED> SIGNED SCAN FROM -1: %d\n", collector.m_count);
+		return 1;
+	}
+
+	collector.m_count = 0;
+	if ((signedSet.forEachInRange(-50, -1, collector) != 49) || (found[48] != -2)) {
+		DEEP_LOG(ERROR, OTHER, "  !   <FAILED> SIGNED SCAN TO -1: %d\n", collector.m_count);
+		return 1;
+	}
+
+	TreeSet<long long, Comparator<long long>, PooledTreePolicy>::RangeCursor cursor(&signedSet, -1);
+	int total = 0;
+	int filled;
+	while ((filled = cursor.nextBatch(batch, 7)) != 0) {
+		total += filled;
+	}
+
+	if (total != 102) {
+		DEEP_LOG(ERROR, OTHER, "  !   <FAILED> SIGNED CURSOR FROM -1: %d\n", total);
+		return 1;
+	}
+
+	delete [] elems;
+	delete [] found;
+
+	return 0;
+}
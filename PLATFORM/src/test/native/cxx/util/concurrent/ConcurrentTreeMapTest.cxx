@@ -0,0 +1,375 @@
+/**
+ *    Copyright (C) 2010 Deep Software Foundation
+ *
+ *    This program is free software: you can redistribute it and/or  modify
+ *    it under the terms of the GNU Affero General Public License, version 3,
+ *    as published by the Free Software Foundation.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU Affero General Public License for more details.
+ *
+ *    You should have received a copy of the GNU Affero General Public License
+ *    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *    As a special exception, the copyright holders give permission to link the
+ *    code of portions of this program with the OpenSSL library under certain
+ *    conditions as described in each individual source file and distribute
+ *    linked combinations including the program with the OpenSSL library. You
+ *    must comply with the GNU Affero General Public License in all respects for
+ *    all of the code used other than as permitted herein. If you modify file(s)
+ *    with this exception, you may extend this exception to your version of the
+ *    file(s), but you are not obligated to do so. If you do not wish to do so,
+ *    delete this exception statement from your version. If you delete this
+ *    exception statement from all source files in the program, then also delete
+ *    it in the license file.
+ */
+#include "cxx/lang/Long.h"
+#include "cxx/lang/System.h"
+#include "cxx/lang/Thread.h"
+#include "cxx/lang/Runnable.h"
+
+#include "cxx/util/Logger.h"
+#include "cxx/util/concurrent/ConcurrentTreeMap.h"
+#include "cxx/util/concurrent/atomic/AtomicInteger.h"
+
+using namespace cxx::lang;
+using namespace cxx::util;
+using namespace cxx::util::concurrent;
+using namespace cxx::util::concurrent::atomic;
+
+template class ConcurrentTreeMap<long long,long long>;
+template class ConcurrentTreeMap<Long*,Long*>;
+
+Comparator<long long> longlongComparator;
+
+static const int NUM_THREADS = 8;
+static const int COUNT = 200000;
+
+static AtomicInteger CLIENTS_RUNNING;
+
+int testConcurrentTreeMapBasic();
+int testConcurrentTreeMapObject();
+int testConcurrentTreeMapIterator();
+int testConcurrentTreeMapThreads(int order);
+
+int main(int argc, char** argv) {
+	int result = testConcurrentTreeMapBasic();
+	if (result == 0) {
+		result = testConcurrentTreeMapObject();
+		if (result == 0) {
+			result = testConcurrentTreeMapIterator();
+			if (result == 0) {
+				result = testConcurrentTreeMapThreads(4);
+				if (result == 0) {
+					result = testConcurrentTreeMapThreads(ConcurrentTreeMap<long long,long long>::INITIAL_ORDER);
+				}
+			}
+		}
+	}
+
+	return result;
+}
+
+int testConcurrentTreeMapBasic() {
+	ConcurrentTreeMap<long long,long long> map(&longlongComparator, 4);
+
+	for (int i = 0; i < COUNT; i++) {
+		long long key = (i * 7919LL) % COUNT;
+		map.put(key, key * 10);
+	}
+
+	if (map.size() != COUNT) {
+		DEEP_LOG(ERROR, OTHER, "  !   <FAILED> BASIC SIZE: %d, EXPECTED: %d\n", map.size(), COUNT);
+		return 1;
+	}
+
+	for (int i = 0; i < COUNT; i += 2) {
+		boolean status;
+		long long retkey;
+		long long val = map.remove(i, &retkey, &status);
+		if ((status == false) || (retkey != i) || (val != i * 10LL)) {
+			DEEP_LOG(ERROR, OTHER, "  !   <FAILED> BASIC REMOVE: %d\n", i);
+			return 1;
+		}
+	}
+
+	boolean status;
+	long long old = map.put(1, 11, null, &status);
+	if ((status == false) || (old != 10) || (map.get(1) != 11)) {
+		DEEP_LOG(ERROR, OTHER, "  !   <FAILED> BASIC REPLACE: %lld\n", old);
+		return 1;
+	}
+	map.put(1, 10);
+
+	if (map.size() != COUNT / 2) {
+		DEEP_LOG(ERROR, OTHER, "  !   <FAILED> BASIC SIZE: %d, EXPECTED: %d\n", map.size(), COUNT / 2);
+		return 1;
+	}
+
+	for (int i = 0; i < COUNT; i++) {
+		long long val = map.get(i, null, &status);
+		if ((status != ((i % 2) == 1)) || ((status == true) && (val != i * 10LL))) {
+			DEEP_LOG(ERROR, OTHER, "  !   <FAILED> BASIC GET: %d\n", i);
+			return 1;
+		}
+	}
+
+	map.remove(2, null, &status);
+	if (status == true) {
+		DEEP_LOG(ERROR, OTHER, "  !   <FAILED> BASIC REMOVE MISSING\n");
+		return 1;
+	}
+
+	map.clear();
+	if ((map.size() != 0) || (map.containsKey(1) == true)) {
+		DEEP_LOG(ERROR, OTHER, "  !   <FAILED> BASIC CLEAR: %d\n", map.size());
+		return 1;
+	}
+
+	return 0;
+}
+
+int testConcurrentTreeMapObject() {
+	Comparator<Long*> comparator;
+	ConcurrentTreeMap<Long*,Long*> map(&comparator, 8);
+
+	int count = 10000;
+	Long** keys = new Long*[count];
+	for (int i = 0; i < count; i++) {
+		keys[i] = new Long(i);
+	}
+
+	for (int i = count - 1; i >= 0; i--) {
+		map.put(keys[i], keys[i]);
+	}
+
+	for (int i = 0; i < count; i++) {
+		Long key(i);
+		if (map.get(&key) != keys[i]) {
+			DEEP_LOG(ERROR, OTHER, "  !   <FAILED> OBJECT GET: %d\n", i);
+			return 1;
+		}
+	}
+
+	map.clear();
+
+	for (int i = 0; i < count; i++) {
+		delete keys[i];
+	}
+	delete [] keys;
+
+	return 0;
+}
+
+int testConcurrentTreeMapIterator() {
+	ConcurrentTreeMap<long long,long long> map(&longlongComparator, 4);
+
+	Iterator<MapEntry<long long,long long>*>* iter = map.iterator();
+	if (iter->hasNext() == true) {
+		DEEP_LOG(ERROR, OTHER, "  !   <FAILED> ITERATOR EMPTY\n");
+		return 1;
+	}
+	delete iter;
+
+	for (int i = 0; i < 10000; i++) {
+		map.put(i * 2, i);
+	}
+
+	// XXX: leave a run of empty leaves behind, they must be skipped
+	for (int i = 1000; i < 2000; i++) {
+		map.remove(i * 2);
+	}
+
+	int expected = 0;
+	iter = map.iterator();
+	while (iter->hasNext() == true) {
+		MapEntry<long long,long long>* entry = iter->next();
+		if ((entry->getKey() != expected * 2) || (entry->getValue() != expected)) {
+			DEEP_LOG(ERROR, OTHER, "  !   <FAILED> ITERATOR: %lld, EXPECTED: %d\n", entry->getKey(), expected * 2);
+			return 1;
+		}
+
+		expected = (expected == 999) ? 2000 : expected + 1;
+	}
+	delete iter;
+
+	if (expected != 10000) {
+		DEEP_LOG(ERROR, OTHER, "  !   <FAILED> ITERATOR END: %d\n", expected);
+		return 1;
+	}
+
+	// XXX: start key between entries positions at the next one
+	iter = map.iterator(4001);
+	MapEntry<long long,long long>* entry = iter->next();
+	if (entry->getKey() != 4002) {
+		DEEP_LOG(ERROR, OTHER, "  !   <FAILED> ITERATOR START: %lld\n", entry->getKey());
+		return 1;
+	}
+
+	iter->remove();
+	delete iter;
+
+	if ((map.containsKey(4002) == true) || (map.size() != 8999)) {
+		DEEP_LOG(ERROR, OTHER, "  !   <FAILED> ITERATOR REMOVE: %d\n", map.size());
+		return 1;
+	}
+
+	return 0;
+}
+
+class TreeMapWriter : public Runnable {
+	private:
+		ConcurrentTreeMap<long long,long long>* m_map;
+		int m_id;
+		boolean m_remove;
+
+	public:
+		TreeMapWriter(ConcurrentTreeMap<long long,long long>* map, int id, boolean remove):
+			m_map(map),
+			m_id(id),
+			m_remove(remove) {
+		}
+
+		virtual ~TreeMapWriter() {
+		}
+
+		virtual void run() {
+			// XXX: interleave keys across writers so they contend on the same leaves
+			for (int i = m_id; i < COUNT; i += NUM_THREADS) {
+				long long key = (i * 7919LL) % COUNT;
+				if (m_remove == false) {
+					m_map->put(key, key);
+
+				} else if ((key % 2) == 0) {
+					m_map->remove(key);
+				}
+			}
+
+			CLIENTS_RUNNING.getAndDecrement();
+		}
+};
+
+class TreeMapReader : public Runnable {
+	private:
+		ConcurrentTreeMap<long long,long long>* m_map;
+		volatile boolean* m_done;
+
+	public:
+		int m_errors;
+
+	public:
+		TreeMapReader(ConcurrentTreeMap<long long,long long>* map, volatile boolean* done):
+			m_map(map),
+			m_done(done),
+			m_errors(0) {
+		}
+
+		virtual void run() {
+			long long key = 0;
+			while (*m_done == false) {
+				boolean status;
+				long long val = m_map->get(key, null, &status);
+				if ((status == true) && (val != key)) {
+					m_errors++;
+				}
+
+				Iterator<MapEntry<long long,long long>*>* iter = m_map->iterator(key);
+				long long last = key - 1;
+				for (int i = 0; (i < 100) && (iter->hasNext() == true); i++) {
+					MapEntry<long long,long long>* entry = iter->next();
+					if ((entry->getKey() <= last) || (entry->getValue() != entry->getKey())) {
+						m_errors++;
+					}
+					last = entry->getKey();
+				}
+				delete iter;
+
+				key = (key + 7) % COUNT;
+			}
+
+			CLIENTS_RUNNING.getAndDecrement();
+		}
+};
+
+int runConcurrentTreeMapThreads(ConcurrentTreeMap<long long,long long>* map, boolean remove) {
+	volatile boolean done = false;
+
+	TreeMapReader reader(map, &done);
+	Thread readerThread(&reader);
+
+	TreeMapWriter* writers[NUM_THREADS];
+	Thread* threads[NUM_THREADS];
+
+	CLIENTS_RUNNING.set(NUM_THREADS + 1);
+	readerThread.start();
+	for (int i = 0; i < NUM_THREADS; i++) {
+		writers[i] = new TreeMapWriter(map, i, remove);
+		threads[i] = new Thread(writers[i]);
+		threads[i]->start();
+	}
+
+	// XXX: the reader keeps running until every writer is done
+	while (CLIENTS_RUNNING.get() > 1) {
+		Thread::sleep(1);
+	}
+
+	done = true;
+	while (CLIENTS_RUNNING.get() > 0) {
+		Thread::sleep(1);
+	}
+
+	for (int i = 0; i < NUM_THREADS; i++) {
+		delete threads[i];
+		delete writers[i];
+	}
+
+	return reader.m_errors;
+}
+
+int testConcurrentTreeMapThreads(int order) {
+	ConcurrentTreeMap<long long,long long> map(&longlongComparator, order);
+
+	long start = System::currentTimeMillis();
+	if (runConcurrentTreeMapThreads(&map, false) != 0) {
+		DEEP_LOG(ERROR, OTHER, "  !   <FAILED> THREADS READ DURING PUT, ORDER: %d\n", order);
+		return 1;
+	}
+	long stop = System::currentTimeMillis();
+	DEEP_LOG(INFO, OTHER, "CONCURRENT PUT TIME: %d, %d, %ld\n", order, map.size(), (stop - start));
+
+	if (map.size() != COUNT) {
+		DEEP_LOG(ERROR, OTHER, "  !   <FAILED> THREADS SIZE: %d, EXPECTED: %d\n", map.size(), COUNT);
+		return 1;
+	}
+
+	int expected = 0;
+	Iterator<MapEntry<long long,long long>*>* iter = map.iterator();
+	while (iter->hasNext() == true) {
+		if (iter->next()->getKey() != expected++) {
+			DEEP_LOG(ERROR, OTHER, "  !   <FAILED> THREADS ITERATOR: %d\n", expected - 1);
+			return 1;
+		}
+	}
+	delete iter;
+
+	if (runConcurrentTreeMapThreads(&map, true) != 0) {
+		DEEP_LOG(ERROR, OTHER, "  !   <FAILED> THREADS READ DURING REMOVE, ORDER: %d\n", order);
+		return 1;
+	}
+
+	if (map.size() != COUNT / 2) {
+		DEEP_LOG(ERROR, OTHER, "  !   <FAILED> THREADS SIZE: %d, EXPECTED: %d\n", map.size(), COUNT / 2);
+		return 1;
+	}
+
+	for (int i = 0; i < COUNT; i++) {
+		if (map.containsKey(i) != ((i % 2) == 1)) {
+			DEEP_LOG(ERROR, OTHER, "  !   <FAILED> THREADS CONTAINS: %d\n", i);
+			return 1;
+		}
+	}
+
+	return 0;
+}
@@ -0,0 +1,383 @@
+/**
+ *    Copyright (C) 2010 Deep Software Foundation
+ *
+ *    This program is free software: you can redistribute it and/or  modify
+ *    it under the terms of the GNU Affero General Public License, version 3,
+ *    as published by the Free Software Foundation.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU Affero General Public License for more details.
+ *
+ *    You should have received a copy of the GNU Affero General Public License
+ *    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *    As a special exception, the copyright holders give permission to link the
+ *    code of portions of this program with the OpenSSL library under certain
+ *    conditions as described in each individual source file and distribute
+ *    linked combinations including the program with the OpenSSL library. You
+ *    must comply with the GNU Affero General Public License in all respects for
+ *    all of the code used other than as permitted herein. If you modify file(s)
+ *    with this exception, you may extend this exception to your version of the
+ *    file(s), but you are not obligated to do so. If you do not wish to do so,
+ *    delete this exception statement from your version. If you delete this
+ *    exception statement from all source files in the program, then also delete
+ *    it in the license file.
+ */
+#include "cxx/lang/Long.h"
+#include "cxx/lang/System.h"
+#include "cxx/lang/Thread.h"
+#include "cxx/lang/Runnable.h"
+
+#include "cxx/util/Logger.h"
+#include "cxx/util/TreeMap.h"
+#include "cxx/util/TreeMap.cxx"
+#include "cxx/util/concurrent/PartitionedTreeMap.h"
+#include "cxx/util/concurrent/atomic/AtomicInteger.h"
+
+using namespace cxx::lang;
+using namespace cxx::util;
+using namespace cxx::util::concurrent;
+using namespace cxx::util::concurrent::atomic;
+
+template class PartitionedTreeMap<long long,long long>;
+
+Comparator<long long> longlongComparator;
+
+static const int NUM_THREADS = 8;
+static const int COUNT = 200000;
+static const int SHARDS = 8;
+
+static AtomicInteger CLIENTS_RUNNING;
+
+int testPartitionedTreeMapBasic();
+int testPartitionedTreeMapSigned();
+int testPartitionedTreeMapCardinality();
+int testPartitionedTreeMapThreads();
+
+int main(int argc, char** argv) {
+	int result = testPartitionedTreeMapBasic();
+	if (result == 0) {
+		result = testPartitionedTreeMapSigned();
+	}
+	if (result == 0) {
+		result = testPartitionedTreeMapCardinality();
+		if (result == 0) {
+			result = testPartitionedTreeMapThreads();
+		}
+	}
+
+	return result;
+}
+
+int verifyPartitionedTreeMap(PartitionedTreeMap<long long,long long>* map, int step, const char* name) {
+	int expected = 0;
+	Iterator<MapEntry<long long,long long>*>* iter = map->iterator();
+	while (iter->hasNext() == true) {
+		MapEntry<long long,long long>* entry = iter->next();
+		if ((entry->getKey() != expected) || (entry->getValue() != expected * 10LL)) {
+			DEEP_LOG(ERROR, OTHER, "  !   <FAILED> %s ITERATOR: %lld, EXPECTED: %d\n", name, entry->getKey(), expected);
+			delete iter;
+			return 1;
+		}
+		expected += step;
+	}
+	delete iter;
+
+	if ((expected / step != COUNT / step) || (map->size() != COUNT / step)) {
+		DEEP_LOG(ERROR, OTHER, "  !   <FAILED> %s SIZE: %d, EXPECTED: %d\n", name, map->size(), COUNT / step);
+		return 1;
+	}
+
+	return 0;
+}
+
+int testPartitionedTreeMapBasic() {
+	PartitionedTreeMap<long long,long long> map(&longlongComparator, SHARDS);
+
+	for (int i = 0; i < COUNT; i++) {
+		long long key = (i * 7919LL) % COUNT;
+		map.put(key, key * 10);
+	}
+
+	// XXX: no bounds yet, everything lands in the first shard
+	if ((map.getShardSize(0) != COUNT) || (map.getSkew() != SHARDS)) {
+		DEEP_LOG(ERROR, OTHER, "  !   <FAILED> BASIC UNSPLIT: %d\n", map.getShardSize(0));
+		return 1;
+	}
+
+	map.resplit();
+
+	for (int i = 0; i < SHARDS; i++) {
+		if (map.getShardSize(i) != COUNT / SHARDS) {
+			DEEP_LOG(ERROR, OTHER, "  !   <FAILED> BASIC RESPLIT SHARD %d: %d\n", i, map.getShardSize(i));
+			return 1;
+		}
+	}
+
+	if (verifyPartitionedTreeMap(&map, 1, "BASIC") != 0) {
+		return 1;
+	}
+
+	// XXX: remove the odd keys through the merged iterator, crossing every shard bound
+	Iterator<MapEntry<long long,long long>*>* iter = map.iterator(1);
+	while (iter->hasNext() == true) {
+		if ((iter->next()->getKey() % 2) == 1) {
+			iter->remove();
+		}
+	}
+	delete iter;
+
+	if (verifyPartitionedTreeMap(&map, 2, "BASIC REMOVE") != 0) {
+		return 1;
+	}
+
+	// XXX: skew the bounds into the top of the key space, entries migrate down to the first shards
+	long long bounds[SHARDS - 1];
+	for (int i = 0; i < SHARDS - 1; i++) {
+		bounds[i] = COUNT - ((SHARDS - 1 - i) * 100);
+	}
+	map.resplit(bounds);
+
+	if ((map.getShardSize(0) != (COUNT - ((SHARDS - 1) * 100)) / 2) || (map.getShardSize(SHARDS - 1) != 50)) {
+		DEEP_LOG(ERROR, OTHER, "  !   <FAILED> BASIC SKEWED: %d, %d\n", map.getShardSize(0), map.getShardSize(SHARDS - 1));
+		return 1;
+	}
+
+	if (verifyPartitionedTreeMap(&map, 2, "BASIC SKEWED") != 0) {
+		return 1;
+	}
+
+	for (int i = 0; i < COUNT; i++) {
+		boolean status;
+		long long val = map.get(i, null, &status);
+		if ((status != ((i % 2) == 0)) || ((status == true) && (val != i * 10LL))) {
+			DEEP_LOG(ERROR, OTHER, "  !   <FAILED> BASIC GET: %d\n", i);
+			return 1;
+		}
+	}
+
+	boolean status;
+	long long old = map.put(COUNT - 2, 1, null, &status);
+	if ((status == false) || (old != (COUNT - 2) * 10LL) || (map.get(COUNT - 2) != 1)) {
+		DEEP_LOG(ERROR, OTHER, "  !   <FAILED> BASIC REPLACE: %lld\n", old);
+		return 1;
+	}
+
+	map.clear();
+	if (map.isEmpty() == false) {
+		DEEP_LOG(ERROR, OTHER, "  !   <FAILED> BASIC CLEAR: %d\n", map.size());
+		return 1;
+	}
+
+	return 0;
+}
+
+// XXX: -1 is a key like any other, a batch or a shard ending on it resumes right after it
+int testPartitionedTreeMapSigned() {
+	const int SIGNED_SHARDS = 4;
+	long long BOUNDS[][SIGNED_SHARDS - 1] = { { 0, 40, 80 }, { -1, 30, 70 }, { -63, -1, 62 } };
+
+	for (int b = 0; b < 3; b++) {
+		PartitionedTreeMap<long long,long long> map(&longlongComparator, SIGNED_SHARDS);
+		map.resplit(BOUNDS[b]);
+
+		for (long long key = -64; key <= 100; key++) {
+			map.put(key, key * 10);
+		}
+
+		long long START[] = { -64, -1, 0 };
+		for (int s = 0; s < 3; s++) {
+			long long expected = START[s];
+			Iterator<MapEntry<long long,long long>*>* iter = (s == 0) ? map.iterator() : map.iterator(START[s]);
+			while (iter->hasNext() == true) {
+				MapEntry<long long,long long>* entry = iter->next();
+				if ((entry->getKey() != expected) || (entry->getValue() != expected * 10LL)) {
+					DEEP_LOG(ERROR, OTHER, "  !   <FAILED> SIGNED ITERATOR %d/%d: %lld, EXPECTED: %lld\n", b, s, entry->getKey(), expected);
+					delete iter;
+					return 1;
+				}
+				expected++;
+			}
+			delete iter;
+
+			if (expected != 101) {
+				DEEP_LOG(ERROR, OTHER, "  !   <FAILED> SIGNED ITERATOR %d/%d END: %lld\n", b, s, expected);
+				return 1;
+			}
+		}
+
+		if (map.size() != 165) {
+			DEEP_LOG(ERROR, OTHER, "  !   <FAILED> SIGNED SIZE: %d\n", map.size());
+			return 1;
+		}
+	}
+
+	return 0;
+}
+
+int testPartitionedTreeMapCardinality() {
+	#ifdef COM_DEEPIS_DB_CARDINALITY
+	PartitionedTreeMap<long long,long long> map(&longlongComparator, SHARDS, null, TreeMap<long long,long long>::INITIAL_ORDER, false, false, 2);
+	TreeMap<long long,long long> twin(&longlongComparator, TreeMap<long long,long long>::INITIAL_ORDER, false, false, 2);
+	map.setCardinalityEnabled(true);
+	twin.setCardinalityEnabled(true);
+
+	for (int i = 0; i < COUNT; i++) {
+		map.put(i, i);
+		twin.put(i, i);
+	}
+	map.resplit();
+
+	for (int i = 0; i < COUNT; i += 3) {
+		map.remove(i);
+		twin.remove(i);
+	}
+
+	inttype cardinality[2];
+	map.getCardinalityEstimate(cardinality);
+
+	const inttype* expected = twin.getCardinality();
+	for (int i = 0; i < 2; i++) {
+		if (cardinality[i] != expected[i]) {
+			DEEP_LOG(ERROR, OTHER, "  !   <FAILED> CARDINALITY PART %d: %d, EXPECTED: %d\n", i, cardinality[i], expected[i]);
+			return 1;
+		}
+	}
+	#endif
+
+	return 0;
+}
+
+class PartitionedWriter : public Runnable {
+	private:
+		PartitionedTreeMap<long long,long long>* m_map;
+		int m_id;
+
+	public:
+		PartitionedWriter(PartitionedTreeMap<long long,long long>* map, int id):
+			m_map(map),
+			m_id(id) {
+		}
+
+		virtual ~PartitionedWriter() {
+		}
+
+		virtual void run() {
+			// XXX: every writer owns one region of the key space
+			const int range = COUNT / NUM_THREADS;
+			for (int i = 0; i < range; i++) {
+				long long key = (m_id * range) + ((i * 7919LL) % range);
+				m_map->put(key, key * 10);
+			}
+
+			CLIENTS_RUNNING.getAndDecrement();
+		}
+};
+
+class PartitionedObserver : public Runnable {
+	private:
+		PartitionedTreeMap<long long,long long>* m_map;
+		volatile boolean* m_done;
+
+	public:
+		int m_errors;
+		int m_resplits;
+
+	public:
+		PartitionedObserver(PartitionedTreeMap<long long,long long>* map, volatile boolean* done):
+			m_map(map),
+			m_done(done),
+			m_errors(0),
+			m_resplits(0) {
+		}
+
+		virtual void run() {
+			long long key = 0;
+			while (*m_done == false) {
+				boolean status;
+				long long val = m_map->get(key, null, &status);
+				if ((status == true) && (val != key * 10)) {
+					m_errors++;
+				}
+
+				Iterator<MapEntry<long long,long long>*>* iter = m_map->iterator(key);
+				long long last = key - 1;
+				for (int i = 0; (i < 1000) && (iter->hasNext() == true); i++) {
+					MapEntry<long long,long long>* entry = iter->next();
+					if ((entry->getKey() <= last) || (entry->getValue() != entry->getKey() * 10)) {
+						m_errors++;
+					}
+					last = entry->getKey();
+				}
+				delete iter;
+
+				// XXX: rebalance while the writers keep going
+				if ((key % 13) == 0) {
+					m_map->resplit();
+					m_resplits++;
+				}
+
+				key = (key + 7919) % COUNT;
+			}
+
+			CLIENTS_RUNNING.getAndDecrement();
+		}
+};
+
+int testPartitionedTreeMapThreads() {
+	PartitionedTreeMap<long long,long long> map(&longlongComparator, SHARDS);
+
+	volatile boolean done = false;
+
+	PartitionedObserver observer(&map, &done);
+	Thread observerThread(&observer);
+
+	PartitionedWriter* writers[NUM_THREADS];
+	Thread* threads[NUM_THREADS];
+
+	long start = System::currentTimeMillis();
+
+	CLIENTS_RUNNING.set(NUM_THREADS + 1);
+	observerThread.start();
+	for (int i = 0; i < NUM_THREADS; i++) {
+		writers[i] = new PartitionedWriter(&map, i);
+		threads[i] = new Thread(writers[i]);
+		threads[i]->start();
+	}
+
+	while (CLIENTS_RUNNING.get() > 1) {
+		Thread::sleep(1);
+	}
+
+	done = true;
+	while (CLIENTS_RUNNING.get() > 0) {
+		Thread::sleep(1);
+	}
+
+	long stop = System::currentTimeMillis();
+	DEEP_LOG(INFO, OTHER, "PARTITIONED PUT TIME: %d, %d, %ld\n", map.size(), observer.m_resplits, (stop - start));
+
+	for (int i = 0; i < NUM_THREADS; i++) {
+		delete threads[i];
+		delete writers[i];
+	}
+
+	if (observer.m_errors != 0) {
+		DEEP_LOG(ERROR, OTHER, "  !   <FAILED> THREADS OBSERVER ERRORS: %d\n", observer.m_errors);
+		return 1;
+	}
+
+	if (verifyPartitionedTreeMap(&map, 1, "THREADS") != 0) {
+		return 1;
+	}
+
+	map.resplit();
+	if (map.getSkew() > 1.01) {
+		DEEP_LOG(ERROR, OTHER, "  !   <FAILED> THREADS SKEW: %f\n", map.getSkew());
+		return 1;
+	}
+
+	return 0;
+}
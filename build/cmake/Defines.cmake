@@ -18,10 +18,13 @@ set(CMAKE_CXX_FLAGS "${CMAKE_CXX_FLAGS} -DTCMALLOC")
 # Logging system (this includes, INFO, WARN, ERROR, and DEBUG)
 set(CMAKE_CXX_FLAGS "${CMAKE_CXX_FLAGS} -DCXX_UTIL_LOGGING")
 
-# Turn this flag on to use binary-search-b+tree (i.e. tree::get)
+# Turn this flag on to use binary-search-b+tree (i.e. tree::get, default of TreePolicy::BINARY_SEARCH)
 set(CMAKE_CXX_FLAGS "${CMAKE_CXX_FLAGS} -DCXX_UTIL_TREE_BSEARCH")
 
-# Turn this flag on to use slotted-node-b+tree (i.e. tree::next)
+# Turn this flag on to use vectorized in-node search for primitive keys (i.e. tree::get, default of TreePolicy::VECTOR_SEARCH)
+set(CMAKE_CXX_FLAGS "${CMAKE_CXX_FLAGS} -DCXX_UTIL_TREE_SIMD")
+
+# Turn this flag on to use slotted-node-b+tree (i.e. tree::next, default of TreePolicy::SLOTTED_NODES)
 #set(CMAKE_CXX_FLAGS "${CMAKE_CXX_FLAGS} -DCXX_UTIL_TREE_SLOTTED")
 
 # Turn this flag on to support rekeying (i.e. case insensitive strings)